@@ -182,22 +182,17 @@ void freeReadoutChannels(ReadoutChannels* rc){
 void freeImodTab(ImodTab* tab, int gr){
 	if (tab != NULL){
 		for(int g=0; g<gr;g++){
+			// the pointer levels of the matrix are allocated as contiguous blocks
 			if (tab[g].matrix!=NULL){
-				for(int kk=0; kk < tab[g].n_freq ; kk++){ //  --- freq --- //
-					if (tab[g].matrix[kk]!=NULL){
-						for(int ii=0; ii < tab[g].n_dt ; ii++){ // --- dt --- //
-							if (tab[g].matrix[kk][ii]!=NULL){
-								for(int jj=0; jj < tab[g].n_ampl ; jj++){
-									free(tab[g].matrix[kk][ii][jj]);
-								}
-								free(tab[g].matrix[kk][ii]);
-							}
-						}  // --- END dt --- //
-						free(tab[g].matrix[kk]);
-					}
-				}   //  --- END freq --- //
+				if (tab[g].n_freq>0 && tab[g].n_dt>0){
+					free(tab[g].matrix[0][0]);
+				}
+				if (tab[g].n_freq>0){
+					free(tab[g].matrix[0]);
+				}
 				free(tab[g].matrix);
 			}
+			free(tab[g].data);
 			free(tab[g].ampl);
 			free(tab[g].dt);
 			free(tab[g].freq);
@@ -230,23 +225,18 @@ void freeElecTab(ElecTab* tab,int gr){
 	}
 }
 
-//TODO Check if this is good
 void freeTDMTab(TDMTab* tab, int gr){
 	if (tab!=NULL){
 		for(int g=0; g<gr;g++){
+			// the pointer levels of the matrix are allocated as contiguous blocks
 			if (tab[g].matrix!=NULL){
-				for(int kk=0; kk < tab[g].n_samples ; kk++){ //  --- samples --- //
-					if (tab[g].matrix[kk]!=NULL){
-						for(int ii=0; ii < tab[g].n_ener_p ; ii++){ // --- ener_p --- //
-							if (tab[g].matrix[kk][ii]!=NULL){
-								free(tab[g].matrix[kk][ii]);
-							}
-						}   // --- END ener_p --- //
-						free(tab[g].matrix[kk]);
-					}
-				}   //  --- END samples --- //
+				if (tab[g].n_samples>0){
+					free(tab[g].matrix[0]);
+				}
+				free(tab[g].matrix);
 			}
-			free(tab[g].matrix);
+			free(tab[g].data);
+			free(tab[g].t0_slice);
 			free(tab[g].samples);
 			free(tab[g].ener_p);
 			free(tab[g].ener_v);
@@ -334,6 +324,7 @@ AdvDet* newAdvDet(int* const status){
 
   // Initialize all pointers with NULL.
   det->pix=NULL;
+  det->pixindex=NULL;
   det->filename=NULL;
   det->filepath=NULL;
   det->sx=0.;
@@ -399,6 +390,7 @@ void destroyAdvDet(AdvDet **det){
 			}
 			free((*det)->pix);
 		}
+		freeAdvPixIndex(&(*det)->pixindex);
 		if(NULL!=(*det)->filename){
 			free((*det)->filename);
 		}
@@ -416,19 +408,22 @@ void destroyAdvDet(AdvDet **det){
 	}
 }
 
-int CheckAdvPixImpact(AdvPix pix, Impact *imp){
+/** Check if the position (in detector coordinates) lies in the
+    rectangular pixel. */
+static inline int isInAdvPix(const AdvPix* const pix,
+			     const double x, const double y){
 
   // Calculate impact coordinates in respect to the
   // pixel coordinate system
   double u, v;
 
-  u = imp->position.x - pix.sx;
-  v = imp->position.y - pix.sy;
+  u = x - pix->sx;
+  v = y - pix->sy;
 
   // Calculate half width and height of the rectangular pixel
   double deltu, deltv;
-  deltu=pix.width/2.;
-  deltv=pix.height/2.;
+  deltu=pix->width/2.;
+  deltv=pix->height/2.;
 
   // Check if the impact lies in the rectangular pixel.
   // Return 1 if yes, 0 if not.
@@ -439,6 +434,10 @@ int CheckAdvPixImpact(AdvPix pix, Impact *imp){
   }
 }
 
+int CheckAdvPixImpact(AdvPix pix, Impact *imp){
+  return isInAdvPix(&pix, imp->position.x, imp->position.y);
+}
+
 void CalcAdvPixImpact(AdvPix pix, Impact *imp, PixImpact *piximp){
 
   // Calculate impact coordinates in respect to the
@@ -459,6 +458,203 @@ void CalcAdvPixImpact(AdvPix pix, Impact *imp, PixImpact *piximp){
   piximp->pixposition.y = v;
 }
 
+/** Determine the cell of the spatial index in one dimension. Positions
+    outside the grid are assigned to the boundary cells. */
+static inline int getAdvPixIndexCell(const double dx,
+				     const double cellsize,
+				     const int n){
+  if (dx<=0.) return(0);
+  double cell=floor(dx/cellsize);
+  if (cell>=n) return(n-1);
+  return((int)cell);
+}
+
+/** Determine the range of cells overlapping with the given
+    rectangle. The rectangle is enlarged by a small margin, such that
+    round-off errors in the pixel boundaries cannot lead to missing
+    cells. */
+static void getAdvPixIndexRange(const AdvPixIndex* const index,
+				const double x0, const double x1,
+				const double y0, const double y1,
+				int* const ix0, int* const ix1,
+				int* const iy0, int* const iy1){
+  double margin=1.e-6*index->cellsize;
+  *ix0=getAdvPixIndexCell(x0-margin-index->xmin, index->cellsize, index->nx);
+  *ix1=getAdvPixIndexCell(x1+margin-index->xmin, index->cellsize, index->nx);
+  *iy0=getAdvPixIndexCell(y0-margin-index->ymin, index->cellsize, index->ny);
+  *iy1=getAdvPixIndexCell(y1+margin-index->ymin, index->cellsize, index->ny);
+}
+
+AdvPixIndex* newAdvPixIndex(const AdvPix* const pix, const int npix,
+			    int* const status){
+
+  AdvPixIndex* index=(AdvPixIndex*)malloc(sizeof(AdvPixIndex));
+  CHECK_NULL_RET(index, *status,
+		 "memory allocation for AdvPixIndex failed", index);
+
+  index->first=NULL;
+  index->pixels=NULL;
+  index->npix=npix;
+  index->nx=0;
+  index->ny=0;
+  index->xmin=0.;
+  index->ymin=0.;
+  index->xmax=0.;
+  index->ymax=0.;
+  index->cellsize=1.;
+
+  if (npix<=0) {
+    return(index);
+  }
+
+  // Determine the area covered by the pixels and their average size,
+  // which is used as the edge length of the grid cells.
+  index->xmin=pix[0].sx-.5*pix[0].width;
+  index->xmax=pix[0].sx+.5*pix[0].width;
+  index->ymin=pix[0].sy-.5*pix[0].height;
+  index->ymax=pix[0].sy+.5*pix[0].height;
+  double size=0.;
+  int ii;
+  for (ii=0; ii<npix; ii++) {
+    index->xmin=MIN(index->xmin, pix[ii].sx-.5*pix[ii].width);
+    index->xmax=MAX(index->xmax, pix[ii].sx+.5*pix[ii].width);
+    index->ymin=MIN(index->ymin, pix[ii].sy-.5*pix[ii].height);
+    index->ymax=MAX(index->ymax, pix[ii].sy+.5*pix[ii].height);
+    size+=MAX(pix[ii].width, pix[ii].height);
+  }
+  index->cellsize=size/npix;
+  if (index->cellsize<=0.) {
+    index->cellsize=MAX(index->xmax-index->xmin, index->ymax-index->ymin);
+  }
+  if (index->cellsize<=0.) {
+    index->cellsize=1.;
+  }
+
+  // Widely spread pixels would result in a large number of empty
+  // cells. Limit the number of cells by enlarging them.
+  double maxcells=(double)ADVPIXINDEXCELLSPERPIXEL*npix;
+  while ((floor((index->xmax-index->xmin)/index->cellsize)+1.)*
+	 (floor((index->ymax-index->ymin)/index->cellsize)+1.)>maxcells) {
+    index->cellsize*=2.;
+  }
+  index->nx=(int)floor((index->xmax-index->xmin)/index->cellsize)+1;
+  index->ny=(int)floor((index->ymax-index->ymin)/index->cellsize)+1;
+
+  // Count the pixels overlapping with each cell.
+  long ncells=(long)index->nx*index->ny;
+  index->first=(long*)calloc(ncells+1, sizeof(long));
+  CHECK_NULL_RET(index->first, *status,
+		 "memory allocation for AdvPixIndex failed", index);
+
+  int ix, iy, ix0, ix1, iy0, iy1;
+  for (ii=0; ii<npix; ii++) {
+    getAdvPixIndexRange(index,
+			pix[ii].sx-.5*pix[ii].width, pix[ii].sx+.5*pix[ii].width,
+			pix[ii].sy-.5*pix[ii].height, pix[ii].sy+.5*pix[ii].height,
+			&ix0, &ix1, &iy0, &iy1);
+    for (iy=iy0; iy<=iy1; iy++) {
+      for (ix=ix0; ix<=ix1; ix++) {
+	index->first[ix+(long)iy*index->nx+1]++;
+      }
+    }
+  }
+  long cell;
+  for (cell=0; cell<ncells; cell++) {
+    index->first[cell+1]+=index->first[cell];
+  }
+
+  // Fill in the pixel indices. As the pixels are processed in
+  // ascending order, the indices within each cell are sorted.
+  index->pixels=(int*)malloc(MAX(index->first[ncells], 1)*sizeof(int));
+  CHECK_NULL_RET(index->pixels, *status,
+		 "memory allocation for AdvPixIndex failed", index);
+  long* pos=(long*)malloc(ncells*sizeof(long));
+  CHECK_NULL_RET(pos, *status,
+		 "memory allocation for AdvPixIndex failed", index);
+  memcpy(pos, index->first, ncells*sizeof(long));
+  for (ii=0; ii<npix; ii++) {
+    getAdvPixIndexRange(index,
+			pix[ii].sx-.5*pix[ii].width, pix[ii].sx+.5*pix[ii].width,
+			pix[ii].sy-.5*pix[ii].height, pix[ii].sy+.5*pix[ii].height,
+			&ix0, &ix1, &iy0, &iy1);
+    for (iy=iy0; iy<=iy1; iy++) {
+      for (ix=ix0; ix<=ix1; ix++) {
+	index->pixels[pos[ix+(long)iy*index->nx]++]=ii;
+      }
+    }
+  }
+  free(pos);
+
+  return(index);
+}
+
+void freeAdvPixIndex(AdvPixIndex** const index){
+  if (NULL!=*index) {
+    if (NULL!=(*index)->first) {
+      free((*index)->first);
+    }
+    if (NULL!=(*index)->pixels) {
+      free((*index)->pixels);
+    }
+    free(*index);
+    *index=NULL;
+  }
+}
+
+int getAdvPixIndexCandidates(const AdvPixIndex* const index,
+			     const double x, const double y,
+			     const int** const cand){
+
+  *cand=index->pixels;
+
+  // The margin corresponds to the one used for the pixel boundaries.
+  double margin=1.e-6*index->cellsize;
+  if ((0==index->npix) ||
+      (x<index->xmin-margin) || (x>index->xmax+margin) ||
+      (y<index->ymin-margin) || (y>index->ymax+margin)) {
+    return(0);
+  }
+
+  int ix=getAdvPixIndexCell(x-index->xmin, index->cellsize, index->nx);
+  int iy=getAdvPixIndexCell(y-index->ymin, index->cellsize, index->ny);
+  long cell=ix+(long)iy*index->nx;
+  *cand=&(index->pixels[index->first[cell]]);
+  return((int)(index->first[cell+1]-index->first[cell]));
+}
+
+/** Determine the pixels which might be hit by an impact at the given
+    position. If the detector does not have a spatial index, all
+    pixels are candidates and cand is set to NULL. */
+static int getAdvPixCandidates(const AdvDet* const det,
+			       const double x, const double y,
+			       const int** const cand){
+  if (NULL==det->pixindex) {
+    *cand=NULL;
+    return(det->npix);
+  }
+  return(getAdvPixIndexCandidates(det->pixindex, x, y, cand));
+}
+
+/** Check the candidate pixels for a hit of the impact (given in
+    detector coordinates) and store the resulting pixel impacts. The
+    output array must provide space for ncand entries. Gives the
+    number of pixels that were hit. */
+static int fillAdvPixImpacts(const AdvDet* const det, Impact* const detimp,
+			     const int* const cand, const int ncand,
+			     PixImpact* const piximp){
+  int nimpacts=0;
+  int kk;
+  for (kk=0; kk<ncand; kk++) {
+    int ii=(NULL==cand) ? kk : cand[kk];
+    if (isInAdvPix(&(det->pix[ii]), detimp->position.x, detimp->position.y)) {
+      piximp[nimpacts].pixID=(long)ii;
+      CalcAdvPixImpact(det->pix[ii], detimp, &(piximp[nimpacts]));
+      nimpacts++;
+    }
+  }
+  return nimpacts;
+}
+
 int AdvImpactList(AdvDet *det, Impact *imp, PixImpact **piximp){
 
   // Duplicate the impact but transform the coordinates into
@@ -472,20 +668,56 @@ int AdvImpactList(AdvDet *det, Impact *imp, PixImpact **piximp){
   detimp.position.x = imp->position.x - det->sx;
   detimp.position.y = imp->position.y - det->sy;
 
-  int nimpacts=0;
+  // Only the candidate pixels from the spatial index have to be
+  // checked for a hit
+  const int* cand;
+  int ncand=getAdvPixCandidates(det, detimp.position.x, detimp.position.y,
+				&cand);
+  if (0==ncand) {
+    return 0;
+  }
 
-  // loop over all pixels and check for hit
-  int ii;
+  // The number of hits is limited by the number of candidates
+  PixImpact* buffer=realloc(*piximp, ncand*sizeof(**piximp));
+  if (NULL==buffer) {
+    SIXT_ERROR("memory allocation for pixel impacts failed");
+    return 0;
+  }
+  *piximp=buffer;
 
-  for(ii=0; ii<det->npix; ii++){
-    if(CheckAdvPixImpact(det->pix[ii], &detimp)!=0){
-      nimpacts++;
-      *piximp=realloc(*piximp, nimpacts*sizeof(**piximp));
-      (*piximp)[nimpacts-1].pixID=(long)ii;
-      CalcAdvPixImpact(det->pix[ii], &detimp, &((*piximp)[nimpacts-1]));
+  return fillAdvPixImpacts(det, &detimp, cand, ncand, *piximp);
+}
+
+long AdvImpactListBatch(AdvDet* det, Impact* imp, long nimpacts,
+			PixImpact** piximp, long* maxpiximp,
+			int* const status){
+
+  long npiximp=0;
+  long ii;
+  for (ii=0; ii<nimpacts; ii++) {
+    Impact detimp=imp[ii];
+    detimp.position.x-=det->sx;
+    detimp.position.y-=det->sy;
+
+    const int* cand;
+    int ncand=getAdvPixCandidates(det, detimp.position.x, detimp.position.y,
+				  &cand);
+    if (0==ncand) continue;
+
+    // Make sure that the output buffer can hold all candidates.
+    if (npiximp+ncand>*maxpiximp) {
+      long newsize=MAX(2*(*maxpiximp), npiximp+ncand);
+      newsize=MAX(newsize, 1024);
+      PixImpact* buffer=realloc(*piximp, newsize*sizeof(**piximp));
+      CHECK_NULL_RET(buffer, *status,
+		     "memory allocation for pixel impacts failed", npiximp);
+      *piximp=buffer;
+      *maxpiximp=newsize;
     }
+
+    npiximp+=fillAdvPixImpacts(det, &detimp, cand, ncand, &((*piximp)[npiximp]));
   }
-  return nimpacts;
+  return npiximp;
 }
 
 
@@ -854,6 +1086,7 @@ static void AdvDetXMLElementStart(void* parsedata,
 			xmlparsedata->det->pix[xmlparsedata->det->cpix].grades[xmlparsedata->det->pix[xmlparsedata->det->cpix].ngrades].gradelim_pre=getXMLAttributeLong(attr, "PRE");
 			xmlparsedata->det->pix[xmlparsedata->det->cpix].grades[xmlparsedata->det->pix[xmlparsedata->det->cpix].ngrades].gradelim_post=getXMLAttributeLong(attr, "POST");
 			xmlparsedata->det->pix[xmlparsedata->det->cpix].grades[xmlparsedata->det->pix[xmlparsedata->det->cpix].ngrades].rmf=NULL;
+			xmlparsedata->det->pix[xmlparsedata->det->cpix].grades[xmlparsedata->det->pix[xmlparsedata->det->cpix].ngrades].rmfsampler=NULL;
 			char rmffile[MAXFILENAME];
 			getXMLAttributeString(attr, "RMF", rmffile);
 			xmlparsedata->det->pix[xmlparsedata->det->cpix].grades[xmlparsedata->det->pix[xmlparsedata->det->cpix].ngrades].rmffile=strndup(rmffile,MAXFILENAME);
@@ -871,6 +1104,7 @@ static void AdvDetXMLElementStart(void* parsedata,
 				xmlparsedata->det->pix[i].grades[xmlparsedata->det->pix[i].ngrades].gradelim_pre=getXMLAttributeLong(attr, "PRE");
 				xmlparsedata->det->pix[i].grades[xmlparsedata->det->pix[i].ngrades].gradelim_post=getXMLAttributeLong(attr, "POST");
 				xmlparsedata->det->pix[i].grades[xmlparsedata->det->pix[i].ngrades].rmf=NULL;
+				xmlparsedata->det->pix[i].grades[xmlparsedata->det->pix[i].ngrades].rmfsampler=NULL;
 				char rmffile[MAXFILENAME];
 				getXMLAttributeString(attr, "RMF", rmffile);
 				xmlparsedata->det->pix[i].grades[xmlparsedata->det->pix[i].ngrades].rmffile=strndup(rmffile,MAXFILENAME);
@@ -1174,6 +1408,12 @@ void loadRMFLibrary(AdvDet* det, int* const status){
 		SIXT_ERROR("Memory allocation for rmf library failed");
 		return;
 	}
+	det->rmf_library->samplers = malloc(RMFLIBRARYSIZE*sizeof(*(det->rmf_library->samplers)));
+	if (NULL == det->rmf_library->samplers){
+		*status = EXIT_FAILURE;
+		SIXT_ERROR("Memory allocation for rmf library failed");
+		return;
+	}
 
 	det->rmf_library->size = RMFLIBRARYSIZE;
 	det->rmf_library->n_rmf = 0;
@@ -1181,6 +1421,7 @@ void loadRMFLibrary(AdvDet* det, int* const status){
 	for (int i=0;i<RMFLIBRARYSIZE;i++){
 		det->rmf_library->rmf_array[i]=NULL;
 		det->rmf_library->filenames[i]=NULL;
+		det->rmf_library->samplers[i]=NULL;
 	}
 
 	for (int i=0;i<det->npix;i++){
@@ -1201,6 +1442,7 @@ void addRMF(AdvDet* det,AdvPix* pixel,int rmf_index,int* const status){
 	for (int i=0;i<det->rmf_library->n_rmf;i++){
 		if(!strcmp(det->rmf_library->filenames[i],pixel->grades[rmf_index].rmffile)){
 			pixel->grades[rmf_index].rmf=det->rmf_library->rmf_array[i];
+			pixel->grades[rmf_index].rmfsampler=det->rmf_library->samplers[i];
 			return; //If the rmf is already in there, just update the rmfID and return
 		}
 	}
@@ -1223,6 +1465,21 @@ void addRMF(AdvDet* det,AdvPix* pixel,int rmf_index,int* const status){
 
 	  det->rmf_library->rmf_array=new_rmf_array;
 	  det->rmf_library->filenames=new_filenames;
+
+	  const RMFSampler** new_samplers = realloc(det->rmf_library->samplers,det->rmf_library->size*sizeof(*(det->rmf_library->samplers)));
+	  if (NULL==new_samplers){
+	    *status = EXIT_FAILURE;
+	    SIXT_ERROR("Size update of RMF library failed");
+	    return;
+	  }
+	  det->rmf_library->samplers=new_samplers;
+
+	  // Initialize the new entries, as they are released by freeRMFLibrary
+	  for (int i=det->rmf_library->n_rmf;i<det->rmf_library->size;i++){
+	    det->rmf_library->rmf_array[i]=NULL;
+	    det->rmf_library->filenames[i]=NULL;
+	    det->rmf_library->samplers[i]=NULL;
+	  }
 	}
 
 	//Add RMF to the library
@@ -1237,9 +1494,14 @@ void addRMF(AdvDet* det,AdvPix* pixel,int rmf_index,int* const status){
 	  SIXT_ERROR("RMF path and filename are too long");
 	  return;
 	}
-	det->rmf_library->rmf_array[det->rmf_library->n_rmf] = loadRMF(filepathname,status);
+	// RMFs are shared with other detectors loading the same file
+	det->rmf_library->rmf_array[det->rmf_library->n_rmf] = loadSharedRMF(filepathname,status);
+	CHECK_STATUS_VOID(*status);
 	det->rmf_library->filenames[det->rmf_library->n_rmf] = strndup(pixel->grades[rmf_index].rmffile,MAXFILENAME);
+	det->rmf_library->samplers[det->rmf_library->n_rmf] = getSharedRMFSampler(det->rmf_library->rmf_array[det->rmf_library->n_rmf],status);
+	CHECK_STATUS_VOID(*status);
 	pixel->grades[rmf_index].rmf=det->rmf_library->rmf_array[det->rmf_library->n_rmf];
+	pixel->grades[rmf_index].rmfsampler=det->rmf_library->samplers[det->rmf_library->n_rmf];
 	det->rmf_library->n_rmf++;
 }
 
@@ -1247,11 +1509,12 @@ void addRMF(AdvDet* det,AdvPix* pixel,int rmf_index,int* const status){
 void freeRMFLibrary(RMFLibrary* library){
 	if (NULL!=library){
 		for(int i=0;i<library->size;i++){
-			freeRMF(library->rmf_array[i]);
+			releaseSharedRMF(library->rmf_array[i]);
 			free(library->filenames[i]);
 		}
 		free(library->rmf_array);
 		free(library->filenames);
+		free(library->samplers);
 		free(library);
 	}
 	library=NULL;
@@ -1358,23 +1621,62 @@ void removeOverlapping(AdvDet* det,int* const status){
 		SIXT_ERROR("Memory allocation failed for active_pixels in removeOverlapping");
 		return;
 	}
+	// Last pixel each pixel has been compared with (a pixel can be
+	// contained in several cells of the index)
+	int * compared = malloc(det->npix*sizeof(*compared));
+	if (NULL==compared){
+		*status = EXIT_FAILURE;
+		SIXT_ERROR("Memory allocation failed for compared in removeOverlapping");
+		free(active_pixels);
+		return;
+	}
+
+	// Only pixels sharing a cell of the spatial index can overlap
+	freeAdvPixIndex(&(det->pixindex));
+	AdvPixIndex* index=newAdvPixIndex(det->pix, det->npix, status);
+	if (EXIT_SUCCESS!=*status){
+		freeAdvPixIndex(&index);
+		free(compared);
+		free(active_pixels);
+		return;
+	}
 
 	AdvPix* current_pixel=NULL;
 	AdvPix* pixel_to_compare=NULL;
 	int number_active_pixels=0;
+	for (int i=0;i<det->npix;i++){
+		compared[i]=-1;
+	}
 	for (int i=0;i<det->npix;i++){
 		active_pixels[i]=1;
 		current_pixel = &(det->pix[i]);
 		number_active_pixels++;
-		for (int j=0;j<i;j++){
-			pixel_to_compare = &(det->pix[j]);
-			if(!(current_pixel->sx-.5*current_pixel->width > pixel_to_compare->sx + .5*pixel_to_compare->width || current_pixel->sx+.5*current_pixel->width < pixel_to_compare->sx-.5*pixel_to_compare->width ||
-					current_pixel->sy -.5*current_pixel->height > pixel_to_compare->sy+.5*pixel_to_compare->height || current_pixel->sy+.5*current_pixel->height<pixel_to_compare->sy-.5*pixel_to_compare->height)){
-				if (active_pixels[j]) number_active_pixels--;
-				active_pixels[j]=0;
+		int ix0, ix1, iy0, iy1;
+		getAdvPixIndexRange(index,
+				current_pixel->sx-.5*current_pixel->width, current_pixel->sx+.5*current_pixel->width,
+				current_pixel->sy-.5*current_pixel->height, current_pixel->sy+.5*current_pixel->height,
+				&ix0, &ix1, &iy0, &iy1);
+		for (int iy=iy0;iy<=iy1;iy++){
+			for (int ix=ix0;ix<=ix1;ix++){
+				long cell=ix+(long)iy*index->nx;
+				for (long k=index->first[cell];k<index->first[cell+1];k++){
+					// Only earlier pixels are removed (sorted within the cell)
+					int j=index->pixels[k];
+					if (j>=i) break;
+					if (compared[j]==i) continue;
+					compared[j]=i;
+					pixel_to_compare = &(det->pix[j]);
+					if(!(current_pixel->sx-.5*current_pixel->width > pixel_to_compare->sx + .5*pixel_to_compare->width || current_pixel->sx+.5*current_pixel->width < pixel_to_compare->sx-.5*pixel_to_compare->width ||
+							current_pixel->sy -.5*current_pixel->height > pixel_to_compare->sy+.5*pixel_to_compare->height || current_pixel->sy+.5*current_pixel->height<pixel_to_compare->sy-.5*pixel_to_compare->height)){
+						if (active_pixels[j]) number_active_pixels--;
+						active_pixels[j]=0;
+					}
+				}
 			}
 		}
 	}
+	freeAdvPixIndex(&index);
+	free(compared);
 
 	AdvPix* new_pix_array=malloc(number_active_pixels*sizeof(*(new_pix_array)));
 	if(NULL==new_pix_array){
@@ -1398,6 +1700,9 @@ void removeOverlapping(AdvDet* det,int* const status){
 	det->npix=number_active_pixels;
 	free(active_pixels);
 	headas_chat(0,"Number of pixels after removing overlaps: %d\n \n",number_active_pixels);
+
+	// Index of the remaining pixels for the impact assignment
+	det->pixindex=newAdvPixIndex(det->pix, det->npix, status);
 }
 
 /** Constructor for MatrixCrossTalk structure */
@@ -1540,6 +1845,8 @@ CrosstalkTimedep* newCrossTalkTimedep(int* const status){
 	crosstalk_timedep->time=NULL;
 	crosstalk_timedep->weight=NULL;
 	crosstalk_timedep->weight_t0 = 1.0;
+	crosstalk_timedep->weight_norm=NULL;
+	crosstalk_timedep->slope=NULL;
 	return crosstalk_timedep;
 }
 
@@ -1551,6 +1858,8 @@ void freeCrosstalkTimedep(CrosstalkTimedep* timedep, int gr){
 			free(timedep[k].name_type);
 			free(timedep[k].time);
 			free(timedep[k].weight);
+			free(timedep[k].weight_norm);
+			free(timedep[k].slope);
 			timedep[k].weight_t0=0;
 		}
 	}
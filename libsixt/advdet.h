@@ -31,6 +31,7 @@
 #include "teseventlist.h"
 #include "pixelimpactfile.h"
 #include "tespixel.h"
+#include "rmfsampler.h"
 
 // For FDM calculations in tessim
 #include <math.h>
@@ -44,6 +45,10 @@
 /** Initial size of RMFLibrary. */
 #define RMFLIBRARYSIZE (10)
 
+/** Maximum average number of cells per pixel of the spatial pixel
+    index. */
+#define ADVPIXINDEXCELLSPERPIXEL (4)
+
 #define DEFAULTGOODSAMPLE 32768 // TODO : check whether we do want to leave that as a macro
 
 ////////////////////////////////////////////////////////////////////////
@@ -102,6 +107,9 @@ typedef struct{
   /** ID of the rmf */
   struct RMF* rmf;
 
+  /** Channel sampler of the rmf */
+  const RMFSampler* rmfsampler;
+
   /** The grade values */
   int value;
 
@@ -193,6 +201,38 @@ struct AdvPix{
 }; typedef struct AdvPix AdvPix;
 
 
+/** Spatial index of the pixels of an AdvDet. The area covered by the
+    pixels is divided into a uniform grid of square cells, and for each
+    cell the indices of the pixels overlapping with it are stored (in
+    ascending order). Point queries therefore only have to check the
+    few pixels of one cell instead of all pixels of the detector. The
+    index is read-only after its construction. */
+typedef struct{
+
+  /** Lower left and upper right corner of the grid [m]. */
+  double xmin, ymin, xmax, ymax;
+
+  /** Edge length of the grid cells [m]. */
+  double cellsize;
+
+  /** Number of cells in x- and y-direction. */
+  int nx, ny;
+
+  /** Number of indexed pixels. */
+  int npix;
+
+  /** Offset of the first entry of each cell in the pixels array. The
+      array contains nx*ny+1 entries, i.e., the pixels overlapping with
+      the cell ix+iy*nx are stored in the range
+      [first[cell],first[cell+1]). */
+  long* first;
+
+  /** Pixel indices for all cells. */
+  int* pixels;
+
+}AdvPixIndex;
+
+
 /** Data structure containing a library of different RMFs */
 typedef struct{
 
@@ -208,6 +248,9 @@ typedef struct{
 	/** Array containing the rmf structures */
 	struct RMF** rmf_array;
 
+	/** Array containing the channel samplers of the rmfs */
+	const RMFSampler** samplers;
+
 }RMFLibrary;
 
 /** Data structure containing a library of different ARFs */
@@ -234,6 +277,8 @@ typedef struct{
 	double* time;
 	double* weight;
 	double weight_t0;  // weight at time t=0 (simultaneous)
+	double* weight_norm; // weight/weight_t0 (precomputed at load time)
+	double* slope;       // (weight_norm[i+1]-weight_norm[i])/(time[i+1]-time[i])
 } CrosstalkTimedep;
 
 /** structure containing one of the intermodulation crosstalk table*/
@@ -241,6 +286,10 @@ typedef struct{
 
 	double**** matrix; // 4d table containing the frequency weights
 
+	// contiguous storage of the matrix [n_freq][n_dt][n_ampl][n_ampl]
+	// (matrix only contains pointers into this array)
+	double* data;
+
 	double* ampl;
 	double* dt; // in seconds
 	double* freq;
@@ -275,6 +324,10 @@ typedef struct{
 
 	double*** matrix; // 3d table containing the weights
 
+	// contiguous storage of the matrix [n_samples][n_ener_p][n_ener_v]
+	// (matrix only contains pointers into this array)
+	double* data;
+
 	double* ener_p;
 	double* ener_v;
 	double* samples;
@@ -283,6 +336,13 @@ typedef struct{
 	int n_ener_p;
 	int n_ener_v;
 
+	// table at dt=0 for a victim energy of 0 (used for the energy deposited
+	// by a crosstalk event), already interpolated along the victim energy:
+	// t0_slice[ii*n_ener_p+jj] for the two time samples ii=0,1 enclosing
+	// dt=0. NULL if dt=0 or the victim energy is not tabulated.
+	double* t0_slice;
+	double t0_fac_dt;
+
 }TDMTab;
 
 /** Data structure describing the geometry of a pixel detector with
@@ -304,6 +364,10 @@ typedef struct{
   /** array of pixels. */
   AdvPix *pix;
 
+  /** Spatial index of the pixels. NULL if the pixel array has not
+      been indexed. In that case all pixels are checked. */
+  AdvPixIndex* pixindex;
+
   /** File name (without path contributions) of the FITS file
       containing the XML detector definition. */
   char* filename;
@@ -575,6 +639,30 @@ void CalcAdvPixImpact(AdvPix pix, Impact *imp, PixImpact *piximp);
     event. Gives the number of pixels that were hit.*/
 int AdvImpactList(AdvDet *det, Impact *imp, PixImpact **piximp);
 
+/** Function determining the pixel impacts of an array of nimpacts
+    impacts. The pixel impacts are stored in the order of the input
+    impacts in the array *piximp, which is enlarged if necessary. Its
+    current size is given by *maxpiximp, such that the same buffer can
+    be used for subsequent calls. Gives the number of pixel impacts. */
+long AdvImpactListBatch(AdvDet* det, Impact* imp, long nimpacts,
+			PixImpact** piximp, long* maxpiximp,
+			int* const status);
+
+/** Constructor. Builds the spatial index for the given array of
+    pixels. */
+AdvPixIndex* newAdvPixIndex(const AdvPix* const pix, const int npix,
+			    int* const status);
+
+/** Destructor of the spatial pixel index. */
+void freeAdvPixIndex(AdvPixIndex** const index);
+
+/** Determine the pixels which might contain the given position (in
+    detector coordinates). Returns the number of candidate pixels,
+    whose indices are provided via the pointer cand. */
+int getAdvPixIndexCandidates(const AdvPixIndex* const index,
+			     const double x, const double y,
+			     const int** const cand);
+
 /** Iterates the different pixels and loads the necessary RMFLibrary */
 void loadRMFLibrary(AdvDet* det, int* const status);
 
@@ -593,7 +681,8 @@ void addARF(AdvDet* det,AdvPix* pixel,int* const status);
 /** Destructor of the ARF library structure */
 void freeARFLibrary(ARFLibrary* library);
 
-/** Function to remove overlapping pixels from the detector */
+/** Function to remove overlapping pixels from the detector. The
+    spatial index of the remaining pixels is (re-)built afterwards. */
 void removeOverlapping(AdvDet* det,int* const status);
 
 /** Constructor for MatrixCrossTalk structure */
@@ -158,6 +158,16 @@ Attitude* loadAttitude(const char* const filename, int* const status)
       afe=read_AttitudeFileEntry(af, status);
       CHECK_STATUS_BREAK(*status);
 
+      // The entries have to be in chronological order.
+      if ((af->row>0) && (afe.time<ac->entry[af->row-1].time)) {
+	*status=EXIT_FAILURE;
+	char msg[MAXMSG];
+	sprintf(msg, "entries in attitude file '%s' are not in "
+		"chronological order", filename);
+	SIXT_ERROR(msg);
+	break;
+      }
+
       // Calculate and store attitude data:
       ac->entry[af->row].time=afe.time;
 
@@ -201,65 +211,154 @@ void freeAttitude(Attitude** const ac)
 }
 
 
-static void setAttitudeCurrEntry(Attitude* const ac,
-				 const double time,
-				 int* const status)
+Attitude* copyAttitude(const Attitude* const ac, int* const status)
 {
-  // Check if this is a pointing attitude with only one data point.
-  if (1==ac->nentries) {
-    ac->currentry=0;
-    return;
+  Attitude* copy=getAttitude(status);
+  CHECK_STATUS_RET(*status, copy);
+
+  copy->nentries =ac->nentries;
+  copy->currentry=ac->currentry;
+  copy->align    =ac->align;
+  copy->mjdref   =ac->mjdref;
+  copy->tstart   =ac->tstart;
+  copy->tstop    =ac->tstop;
+
+  if (ac->nentries>0) {
+    copy->entry=(AttitudeEntry*)malloc(ac->nentries*sizeof(AttitudeEntry));
+    CHECK_NULL_RET(copy->entry, *status,
+		   "memory allocation for AttitudeEntry array failed", copy);
+    memcpy(copy->entry, ac->entry, ac->nentries*sizeof(AttitudeEntry));
+  }
+
+  return(copy);
+}
+
+
+/** Determine the index k of the attitude segment
+    [entry[k],entry[k+1]] containing the requested time. The search
+    starts at the segment *cursor (or at the first segment, if no
+    cursor is given) and yields the same segment as walking the
+    entries one by one from there. The remaining range is searched
+    with exponentially growing steps and bisection, i.e., subsequent
+    times cost O(1) and random access costs O(log n). The cursor is
+    updated to the resulting segment. */
+static long getAttitudeSegment(const Attitude* const ac,
+			       const double time,
+			       long* const cursor,
+			       int* const status)
+{
+  const AttitudeEntry* const entry=ac->entry;
+  long curr=0;
+  if (NULL!=cursor) {
+    curr=MIN(MAX(*cursor, 0), ac->nentries-2);
   }
 
-  // Check if the requested time lies within the current time bin.
-  while (time < ac->entry[ac->currentry].time) {
+  if (time < entry[curr].time) {
     // Check if the beginning of the Attitude is reached.
-    if (ac->currentry <= 0) {
+    if (time < entry[0].time) {
+      curr=0;
       *status=EXIT_FAILURE;
       char msg[MAXMSG];
       sprintf(msg, "no attitude entry available for time %lf", time);
       SIXT_ERROR(msg);
-      return;
+    } else {
+      // Determine the last entry before the requested time.
+      long hi=curr-1, lo=hi, step=1;
+      while (entry[lo].time > time) {
+	hi=lo-1;
+	lo=MAX(lo-step, 0);
+	step*=2;
+      }
+      while (lo<hi) {
+	long mid=(lo+hi+1)/2;
+	if (entry[mid].time <= time) {
+	  lo=mid;
+	} else {
+	  hi=mid-1;
+	}
+      }
+      curr=lo;
     }
-    // If not, go one step back.
-    ac->currentry--;
-  }
 
-  while (time > ac->entry[ac->currentry+1].time) {
+  } else if (time > entry[curr+1].time) {
     // Check if the end of the Attitude is reached.
-    if (ac->currentry >= ac->nentries-2) {
+    if (time > entry[ac->nentries-1].time) {
+      curr=ac->nentries-2;
       *status=EXIT_FAILURE;
       char msg[MAXMSG];
       sprintf(msg, "no attitude entry available for time %lf", time);
       SIXT_ERROR(msg);
-      return;
+    } else {
+      // Determine the first segment ending at or after the
+      // requested time.
+      long lo=curr+1, hi=lo, step=1;
+      while (entry[hi+1].time < time) {
+	lo=hi+1;
+	hi=MIN(hi+step, ac->nentries-2);
+	step*=2;
+      }
+      while (lo<hi) {
+	long mid=(lo+hi)/2;
+	if (entry[mid+1].time >= time) {
+	  hi=mid;
+	} else {
+	  lo=mid+1;
+	}
+      }
+      curr=lo;
     }
-    // If not, go one step further.
-    ac->currentry++;
   }
+
+  if (NULL!=cursor) {
+    *cursor=curr;
+  }
+  return(curr);
 }
 
 
-Vector getTelescopeNz(Attitude* const ac,
-		      const double time,
-		      int* const status)
+/** Interpolate the pointing direction within the attitude segment
+    seg. */
+static Vector getSegmentNz(const Attitude* const ac,
+			   const long seg,
+			   const double time)
+{
+  return(interpolateCircleVector(ac->entry[seg].nz,
+				 ac->entry[seg+1].nz,
+				 (time-ac->entry[seg].time)/
+				 (ac->entry[seg+1].time-ac->entry[seg].time)));
+}
+
+
+/** Interpolate the roll angle within the attitude segment seg. */
+static float getSegmentRollAngle(const Attitude* const ac,
+				 const long seg,
+				 const double time)
+{
+  double fraction=
+    (time-ac->entry[seg].time)/
+    (ac->entry[seg+1].time-ac->entry[seg].time);
+  return(ac->entry[seg  ].roll_angle*(1.-fraction) +
+	 ac->entry[seg+1].roll_angle*    fraction );
+}
+
+
+Vector getAttitudeNz(const Attitude* const ac,
+		     const double time,
+		     long* const cursor,
+		     int* const status)
 {
   Vector nz={.x=0., .y=0., .z=0.};
 
   // Check if survey attitude.
   if (ac->nentries>1) {
-    // Find the appropriate entry in the Attitude for the
+    // Find the appropriate segment of the Attitude for the
     // requested time.
-    setAttitudeCurrEntry(ac, time, status);
+    long seg=getAttitudeSegment(ac, time, cursor, status);
     CHECK_STATUS_RET(*status,nz);
 
-    // The requested time lies within the current time bin.
+    // The requested time lies within the segment.
     // Interpolation:
-    nz=interpolateCircleVector(ac->entry[ac->currentry].nz,
-			       ac->entry[ac->currentry+1].nz,
-			       (time-ac->entry[ac->currentry].time)/
-			       (ac->entry[ac->currentry+1].time-
-				ac->entry[ac->currentry].time));
+    nz=getSegmentNz(ac, seg, time);
 
   } else { // Pointing attitude.
     nz=ac->entry[0].nz;
@@ -269,30 +368,32 @@ Vector getTelescopeNz(Attitude* const ac,
 }
 
 
-void getTelescopeAxes(Attitude* const ac,
-		      Vector* const nx,
-		      Vector* const ny,
-		      Vector* const nz,
-		      const double time,
-		      int* const status)
+void getAttitudeAxes(const Attitude* const ac,
+		     Vector* const nx,
+		     Vector* const ny,
+		     Vector* const nz,
+		     const double time,
+		     long* const cursor,
+		     int* const status)
 {
-  // Determine the z vector (telescope pointing direction):
-  *nz=getTelescopeNz(ac, time, status);
-  CHECK_STATUS_VOID(*status);
-  // After calling getTelescopeNz() the internal current entry pointer
-  // within the attitude catalog is set to the appropriate time bin.
-
   // Check if this is a pointed observation.
   int pointed=0;
+  long seg=0;
   Vector dnz;
   if (1==ac->nentries) {
     // There is only one entry in the Attitude.
     pointed=1;
+    *nz=ac->entry[0].nz;
   } else {
-    if (ac->currentry>0) {
-      dnz=vector_difference(*nz, ac->entry[ac->currentry-1].nz);
+    // Determine the z vector (telescope pointing direction):
+    seg=getAttitudeSegment(ac, time, cursor, status);
+    CHECK_STATUS_VOID(*status);
+    *nz=getSegmentNz(ac, seg, time);
+
+    if (seg>0) {
+      dnz=vector_difference(*nz, ac->entry[seg-1].nz);
     } else {
-      dnz=vector_difference(ac->entry[ac->currentry+1].nz, *nz);
+      dnz=vector_difference(ac->entry[seg+1].nz, *nz);
     }
     if (scalar_product(&dnz, &dnz)<1.e-10) {
       pointed=1;
@@ -346,8 +447,12 @@ void getTelescopeAxes(Attitude* const ac,
   Vector y1=normalize_vector(vector_product(*nz, x1));
 
   // Take into account the roll angle.
-  float roll_angle=getRollAngle(ac, time, status);
-  CHECK_STATUS_VOID(*status);
+  float roll_angle;
+  if (1==ac->nentries) {
+    roll_angle=ac->entry[0].roll_angle;
+  } else {
+    roll_angle=getSegmentRollAngle(ac, seg, time);
+  }
   double sinroll=sin(roll_angle);
   double cosroll=cos(roll_angle);
   nx->x= x1.x * cosroll + y1.x * sinroll;
@@ -359,25 +464,48 @@ void getTelescopeAxes(Attitude* const ac,
 }
 
 
-float getRollAngle(Attitude* const ac,
-		   const double time,
-		   int* const status)
+void getAttitudeAxesBatch(const Attitude* const ac,
+			  const double* const time,
+			  const long n,
+			  Vector* const nx,
+			  Vector* const ny,
+			  Vector* const nz,
+			  long* const cursor,
+			  int* const status)
+{
+  // Without a cursor provided by the caller, subsequent times are
+  // still looked up relative to each other.
+  long curr=(NULL!=cursor) ? *cursor : 0;
+
+  long ii;
+  for (ii=0; ii<n; ii++) {
+    getAttitudeAxes(ac, &(nx[ii]), &(ny[ii]), &(nz[ii]), time[ii],
+		    &curr, status);
+    CHECK_STATUS_BREAK(*status);
+  }
+
+  if (NULL!=cursor) {
+    *cursor=curr;
+  }
+}
+
+
+float getAttitudeRollAngle(const Attitude* const ac,
+			   const double time,
+			   long* const cursor,
+			   int* const status)
 {
   // Check if survey attitude.
   if (ac->nentries>1) {
 
-    // Find the appropriate entry in the Attitude for the
+    // Find the appropriate segment of the Attitude for the
     // requested time.
-    setAttitudeCurrEntry(ac, time, status);
+    long seg=getAttitudeSegment(ac, time, cursor, status);
     CHECK_STATUS_RET(*status,0.);
 
-    // The requested time lies within the current time bin.
+    // The requested time lies within the segment.
     // Interpolation:
-    double fraction=
-      (time-ac->entry[ac->currentry].time)/
-      (ac->entry[ac->currentry+1].time-ac->entry[ac->currentry].time);
-    return(ac->entry[ac->currentry  ].roll_angle*(1.-fraction) +
-	   ac->entry[ac->currentry+1].roll_angle*    fraction );
+    return(getSegmentRollAngle(ac, seg, time));
 
   } else { // Pointing attitude.
     return(ac->entry[0].roll_angle);
@@ -385,6 +513,33 @@ float getRollAngle(Attitude* const ac,
 }
 
 
+Vector getTelescopeNz(Attitude* const ac,
+		      const double time,
+		      int* const status)
+{
+  return(getAttitudeNz(ac, time, &ac->currentry, status));
+}
+
+
+void getTelescopeAxes(Attitude* const ac,
+		      Vector* const nx,
+		      Vector* const ny,
+		      Vector* const nz,
+		      const double time,
+		      int* const status)
+{
+  getAttitudeAxes(ac, nx, ny, nz, time, &ac->currentry, status);
+}
+
+
+float getRollAngle(Attitude* const ac,
+		   const double time,
+		   int* const status)
+{
+  return(getAttitudeRollAngle(ac, time, &ac->currentry, status));
+}
+
+
 AttitudeEntry* getAttitudeEntry(int* const status)
 {
   AttitudeEntry* ae=(AttitudeEntry*)malloc(sizeof(AttitudeEntry));
@@ -112,6 +112,60 @@ Attitude* loadAttitude(const char* const filename, int* const status);
 /** Destructor for the Attitude data structure. */
 void freeAttitude(Attitude** const ac);
 
+/** Return an independent copy of the attitude. As the routines
+    getTelescopeNz(), getTelescopeAxes(), and getRollAngle() update
+    the currently selected entry, each thread calling them has to use
+    its own copy. Alternatively, several threads can share the same
+    attitude via getAttitudeNz(), getAttitudeAxes(), and
+    getAttitudeRollAngle() with separate cursors. */
+Attitude* copyAttitude(const Attitude* const ac, int* const status);
+
+/** Determine the telescope pointing direction at a specific time
+    without modifying the attitude, such that it can be shared by
+    several threads. The segment of the attitude containing the
+    requested time is searched starting at the optional cursor, which
+    is owned by the caller (initialized with 0) and updated to the
+    segment. Subsequent times are therefore found in constant time,
+    arbitrary times in O(log n). If the cursor is NULL, the search
+    starts at the beginning of the attitude. The result is identical
+    to getTelescopeNz() with the cursor taking the role of the
+    currently selected entry. */
+Vector getAttitudeNz(const Attitude* const ac,
+		     const double time,
+		     long* const cursor,
+		     int* const status);
+
+/** Determine the 3 axes vectors for the telescope coordinate system
+    without modifying the attitude. The optional cursor is used in
+    the same way as by getAttitudeNz(). */
+void getAttitudeAxes(const Attitude* const ac,
+		     Vector* const nx,
+		     Vector* const ny,
+		     Vector* const nz,
+		     const double time,
+		     long* const cursor,
+		     int* const status);
+
+/** Determine the telescope axes for an array of n points of time.
+    The results are the same as for n subsequent calls of
+    getAttitudeAxes() with the same cursor. */
+void getAttitudeAxesBatch(const Attitude* const ac,
+			  const double* const time,
+			  const long n,
+			  Vector* const nx,
+			  Vector* const ny,
+			  Vector* const nz,
+			  long* const cursor,
+			  int* const status);
+
+/** Determine the roll-angle ([rad]) at a specific time without
+    modifying the attitude. The optional cursor is used in the same
+    way as by getAttitudeNz(). */
+float getAttitudeRollAngle(const Attitude* const ac,
+			   const double time,
+			   long* const cursor,
+			   int* const status);
+
 /** Determine the telescope pointing direction at a specific time. */
 Vector getTelescopeNz(Attitude* const ac,
 		      const double time,
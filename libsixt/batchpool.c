@@ -0,0 +1,314 @@
+/*
+   This file is part of SIXTE.
+
+   SIXTE is free software: you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   any later version.
+
+   SIXTE is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   For a copy of the GNU General Public License see
+   <http://www.gnu.org/licenses/>.
+
+
+   Copyright 2019 Remeis-Sternwarte, Friedrich-Alexander-Universitaet
+                  Erlangen-Nuernberg
+*/
+
+#include "batchpool.h"
+#include "rndgen.h"
+
+
+/** Reserve the next free batch of the worker. Blocks until the
+    worker thread has released a batch, if all of them are in use. */
+static BatchPoolBatch* reserveBatchPoolBatch(BatchPool* const pool,
+					     BatchPoolWorker* const worker,
+					     const double t1)
+{
+  pthread_mutex_lock(&worker->mutex);
+  while (worker->count >= pool->nbatches) {
+    pthread_cond_wait(&worker->cond, &worker->mutex);
+  }
+  BatchPoolBatch* batch=
+    &(worker->batch[(worker->head+worker->count)%pool->nbatches]);
+  pthread_mutex_unlock(&worker->mutex);
+
+  batch->nitems =0;
+  batch->t1     =t1;
+  batch->endgti =0;
+  batch->nextgti=0;
+  batch->t0next =0.;
+  batch->last   =0;
+  return(batch);
+}
+
+
+/** Pass the current batch to the worker thread. Returns 1 if the
+    worker thread has failed. */
+static int pushBatchPoolBatch(BatchPool* const pool,
+			      BatchPoolWorker* const worker)
+{
+  pthread_mutex_lock(&worker->mutex);
+  worker->count++;
+  int failed=worker->failed;
+  pthread_cond_broadcast(&worker->cond);
+  pthread_mutex_unlock(&worker->mutex);
+  worker->current=NULL;
+
+  pool->failed|=failed;
+  return(failed);
+}
+
+
+static void* batchPoolThread(void* arg)
+{
+  BatchPoolWorker* worker=(BatchPoolWorker*)arg;
+  BatchPool* pool=worker->pool;
+  int status=EXIT_SUCCESS;
+
+  int last=0;
+  while (0==last) {
+    pthread_mutex_lock(&worker->mutex);
+    while (0==worker->count) {
+      pthread_cond_wait(&worker->cond, &worker->mutex);
+    }
+    BatchPoolBatch* batch=&(worker->batch[worker->head]);
+    pthread_mutex_unlock(&worker->mutex);
+
+    // After an error the remaining batches are discarded, such that
+    // the producer is not blocked.
+    if (EXIT_SUCCESS==status) {
+      pool->process(pool->data, worker->id, batch, &status);
+    }
+    last=batch->last;
+
+    pthread_mutex_lock(&worker->mutex);
+    worker->head=(worker->head+1)%pool->nbatches;
+    worker->count--;
+    if (EXIT_SUCCESS!=status) {
+      worker->failed=1;
+    }
+    pthread_cond_broadcast(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+  }
+
+  if ((EXIT_SUCCESS==status) && (NULL!=pool->finish)) {
+    pool->finish(pool->data, worker->id, &status);
+  }
+
+  // The callbacks may have selected a thread-specific random number
+  // stream.
+  sixt_set_thread_rndstream(NULL);
+  worker->status=status;
+  return(NULL);
+}
+
+
+BatchPool* newBatchPool(const int nworkers,
+			const size_t itemsize,
+			const long batchsize,
+			const int nbatches,
+			BatchPoolProcess process,
+			BatchPoolFinish finish,
+			void* const data,
+			int* const status)
+{
+  BatchPool* pool=(BatchPool*)malloc(sizeof(BatchPool));
+  CHECK_NULL_RET(pool, *status, "memory allocation for BatchPool failed",
+		 NULL);
+
+  pool->nworkers =nworkers;
+  pool->nstarted =0;
+  pool->itemsize =itemsize;
+  pool->batchsize=batchsize;
+  pool->nbatches =nbatches;
+  pool->process  =process;
+  pool->finish   =finish;
+  pool->data     =data;
+  pool->failed   =0;
+  pool->stopped  =0;
+  pool->joined   =0;
+
+  pool->worker=(BatchPoolWorker*)calloc(nworkers, sizeof(BatchPoolWorker));
+  if (NULL==pool->worker) {
+    free(pool);
+    *status=EXIT_FAILURE;
+    SIXT_ERROR("memory allocation for BatchPool failed");
+    return(NULL);
+  }
+
+  int ii;
+  for (ii=0; ii<nworkers; ii++) {
+    BatchPoolWorker* worker=&(pool->worker[ii]);
+    worker->pool   =pool;
+    worker->id     =ii;
+    worker->batch  =NULL;
+    worker->head   =0;
+    worker->count  =0;
+    worker->current=NULL;
+    worker->failed =0;
+    worker->status =EXIT_SUCCESS;
+    pthread_mutex_init(&worker->mutex, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+  }
+
+  for (ii=0; ii<nworkers; ii++) {
+    BatchPoolWorker* worker=&(pool->worker[ii]);
+    worker->batch=(BatchPoolBatch*)calloc(nbatches, sizeof(BatchPoolBatch));
+    CHECK_NULL_BREAK(worker->batch, *status,
+		     "memory allocation for batches failed");
+    int jj;
+    for (jj=0; jj<nbatches; jj++) {
+      worker->batch[jj].items=malloc(batchsize*itemsize);
+      CHECK_NULL_BREAK(worker->batch[jj].items, *status,
+		       "memory allocation for batches failed");
+      worker->batch[jj].unit=(int*)malloc(batchsize*sizeof(int));
+      CHECK_NULL_BREAK(worker->batch[jj].unit, *status,
+		       "memory allocation for batches failed");
+    }
+    CHECK_STATUS_BREAK(*status);
+  }
+
+  // Start the worker threads.
+  for (ii=0; (EXIT_SUCCESS==*status) && (ii<nworkers); ii++) {
+    if (0!=pthread_create(&(pool->worker[ii].thread), NULL,
+			  &batchPoolThread, &(pool->worker[ii]))) {
+      SIXT_ERROR("could not create thread");
+      *status=EXIT_FAILURE;
+      break;
+    }
+    pool->nstarted++;
+  }
+
+  if (EXIT_SUCCESS!=*status) {
+    freeBatchPool(&pool);
+  }
+  return(pool);
+}
+
+
+void freeBatchPool(BatchPool** const pool)
+{
+  if (NULL!=*pool) {
+    if (0==(*pool)->joined) {
+      int status=EXIT_SUCCESS;
+      stopBatchPool(*pool);
+      joinBatchPool(*pool, &status);
+    }
+    if (NULL!=(*pool)->worker) {
+      int ii;
+      for (ii=0; ii<(*pool)->nworkers; ii++) {
+	BatchPoolWorker* worker=&((*pool)->worker[ii]);
+	if (NULL!=worker->batch) {
+	  int jj;
+	  for (jj=0; jj<(*pool)->nbatches; jj++) {
+	    if (NULL!=worker->batch[jj].items) {
+	      free(worker->batch[jj].items);
+	    }
+	    if (NULL!=worker->batch[jj].unit) {
+	      free(worker->batch[jj].unit);
+	    }
+	  }
+	  free(worker->batch);
+	}
+	pthread_mutex_destroy(&worker->mutex);
+	pthread_cond_destroy(&worker->cond);
+      }
+      free((*pool)->worker);
+    }
+    free(*pool);
+    *pool=NULL;
+  }
+}
+
+
+int addBatchPoolItem(BatchPool* const pool,
+		     const int worker,
+		     const void* const item,
+		     const int unit,
+		     const double t1)
+{
+  BatchPoolWorker* w=&(pool->worker[worker]);
+  if (NULL==w->current) {
+    w->current=reserveBatchPoolBatch(pool, w, t1);
+  }
+  BatchPoolBatch* batch=w->current;
+  memcpy((char*)batch->items+batch->nitems*pool->itemsize, item,
+	 pool->itemsize);
+  batch->unit[batch->nitems]=unit;
+  batch->nitems++;
+  if (pool->batchsize==batch->nitems) {
+    return(pushBatchPoolBatch(pool, w));
+  }
+  return(0);
+}
+
+
+int endBatchPoolInterval(BatchPool* const pool,
+			 const double t1,
+			 const int nextgti,
+			 const double t0next)
+{
+  int failed=0;
+  int ii;
+  for (ii=0; ii<pool->nstarted; ii++) {
+    BatchPoolWorker* w=&(pool->worker[ii]);
+    if (NULL==w->current) {
+      w->current=reserveBatchPoolBatch(pool, w, t1);
+    }
+    w->current->endgti=1;
+    if (0!=nextgti) {
+      w->current->nextgti=1;
+      w->current->t0next=t0next;
+    } else {
+      w->current->last=1;
+    }
+    failed|=pushBatchPoolBatch(pool, w);
+  }
+  if (0==nextgti) {
+    pool->stopped=1;
+  }
+  return(failed);
+}
+
+
+void stopBatchPool(BatchPool* const pool)
+{
+  if (0!=pool->stopped) return;
+
+  int ii;
+  for (ii=0; ii<pool->nstarted; ii++) {
+    BatchPoolWorker* w=&(pool->worker[ii]);
+    if (NULL==w->current) {
+      w->current=reserveBatchPoolBatch(pool, w, 0.);
+    }
+    w->current->nitems=0;
+    w->current->endgti=0;
+    w->current->last=1;
+    pushBatchPoolBatch(pool, w);
+  }
+  pool->stopped=1;
+}
+
+
+void joinBatchPool(BatchPool* const pool, int* const status)
+{
+  if (0!=pool->joined) return;
+
+  int ii;
+  for (ii=0; ii<pool->nstarted; ii++) {
+    pthread_join(pool->worker[ii].thread, NULL);
+    if (EXIT_SUCCESS!=pool->worker[ii].status) {
+      *status=pool->worker[ii].status;
+    }
+  }
+  pool->joined=1;
+
+  if ((0!=pool->failed) && (EXIT_SUCCESS==*status)) {
+    *status=EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,191 @@
+/*
+   This file is part of SIXTE.
+
+   SIXTE is free software: you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   any later version.
+
+   SIXTE is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   For a copy of the GNU General Public License see
+   <http://www.gnu.org/licenses/>.
+
+
+   Copyright 2019 Remeis-Sternwarte, Friedrich-Alexander-Universitaet
+                  Erlangen-Nuernberg
+*/
+
+#ifndef BATCHPOOL_H
+#define BATCHPOOL_H 1
+
+#include "sixt.h"
+
+#include <pthread.h>
+
+
+/////////////////////////////////////////////////////////////////
+// Type Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Batch of items (e.g., photons or impacts) passed from the
+    producing thread to a worker thread. Each item is assigned to a
+    unit (e.g., a telescope module or a detector chip) handled by the
+    worker. */
+typedef struct {
+  /** Array of nitems items with a size of itemsize bytes each. */
+  void* items;
+
+  /** Unit of each item. */
+  int* unit;
+
+  long nitems;
+
+  /** End of the current GTI interval. */
+  double t1;
+
+  /** Flag whether the GTI interval ends with this batch. In that case
+      the worker finalizes its units after the items have been
+      processed. */
+  int endgti;
+
+  /** Flag whether a further GTI interval follows and its start
+      time. */
+  int nextgti;
+  double t0next;
+
+  /** Flag whether this is the last batch of the simulation. */
+  int last;
+
+} BatchPoolBatch;
+
+
+/** Process the items of a batch in the worker thread with the index
+    worker. data is the pointer given to newBatchPool(). */
+typedef void (*BatchPoolProcess)(void* const data,
+				 const int worker,
+				 BatchPoolBatch* const batch,
+				 int* const status);
+
+/** Post-processing of a worker after its last batch. It is only
+    called if no error has occurred. */
+typedef void (*BatchPoolFinish)(void* const data,
+				const int worker,
+				int* const status);
+
+
+/** Worker thread with a bounded queue of batches. The producer fills
+    the first free batch behind the waiting ones and blocks if all of
+    them are in use. */
+typedef struct {
+  struct BatchPool* pool;
+  int id;
+
+  BatchPoolBatch* batch;
+
+  /** Index of the first waiting batch and number of waiting
+      batches. */
+  int head, count;
+
+  /** Batch currently filled by the producer or NULL. */
+  BatchPoolBatch* current;
+
+  /** Set by the worker thread if an error has occurred. The worker
+      then discards the remaining batches. */
+  int failed;
+
+  int status;
+
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+
+} BatchPoolWorker;
+
+
+/** Pool of worker threads, each of which processes the batches
+    passed to its own queue. The assignment of the items to the
+    workers is up to the producer, such that each unit can be handled
+    by a fixed worker and the result does not depend on the number of
+    workers. */
+typedef struct BatchPool {
+  int nworkers;
+  BatchPoolWorker* worker;
+
+  /** Number of started worker threads. */
+  int nstarted;
+
+  size_t itemsize;
+  long batchsize;
+  int nbatches;
+
+  BatchPoolProcess process;
+  BatchPoolFinish finish;
+  void* data;
+
+  /** Flag whether a worker has reported an error to the producer. */
+  int failed;
+
+  /** Flags whether the last batches have been passed to the workers
+      and whether the workers have been joined. */
+  int stopped, joined;
+
+} BatchPool;
+
+
+/////////////////////////////////////////////////////////////////
+// Function Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Constructor. Allocates nbatches batches of batchsize items with
+    itemsize bytes for each of the nworkers workers and starts the
+    worker threads. If a thread cannot be started, the other ones are
+    terminated and NULL is returned. */
+BatchPool* newBatchPool(const int nworkers,
+			const size_t itemsize,
+			const long batchsize,
+			const int nbatches,
+			BatchPoolProcess process,
+			BatchPoolFinish finish,
+			void* const data,
+			int* const status);
+
+/** Destructor. Terminates and joins the worker threads, if that has
+    not been done before. */
+void freeBatchPool(BatchPool** const pool);
+
+/** Append a copy of the item assigned to the given unit to the batch
+    of the worker. Blocks if all batches of the worker are in use. Full
+    batches are passed to the worker. Returns 1 if a worker has
+    failed. */
+int addBatchPoolItem(BatchPool* const pool,
+		     const int worker,
+		     const void* const item,
+		     const int unit,
+		     const double t1);
+
+/** Pass the current batches to all workers and let them finalize
+    their units at the end of the GTI interval ending at t1. If
+    nextgti is 0, the simulation is finished and the workers start
+    their post-processing. Returns 1 if a worker has failed. */
+int endBatchPoolInterval(BatchPool* const pool,
+			 const double t1,
+			 const int nextgti,
+			 const double t0next);
+
+/** Terminate the workers before the end of the simulation, e.g.,
+    after an error. The items that have not been passed yet are
+    discarded. */
+void stopBatchPool(BatchPool* const pool);
+
+/** Wait for the worker threads to finish. The status is set if one of
+    them has failed. */
+void joinBatchPool(BatchPool* const pool, int* const status);
+
+
+#endif /* BATCHPOOL_H */
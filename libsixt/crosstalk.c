@@ -88,6 +88,138 @@ static void add_xt_enerdep_pixel(MatrixEnerdepCrossTalk* matrix,AdvPix* pixel,do
 	matrix->num_cross_talk_pixels++;
 }
 
+/** Reduce the 8 corner values of an interpolation cell to the interpolated
+    value (same order of operations as interp_lin_ndim) */
+static inline double interp_lin_cell(const double* tmp_3d, const double* fac){
+	double tmp_2d[4];
+	for (int ii=0;ii<2;ii++){
+		for (int jj=0;jj<2;jj++){
+			tmp_2d[ ii*2+jj ] =
+					tmp_3d[ (ii*2+jj)*2     ]*(1-fac[2]) +
+					tmp_3d[ (ii*2+jj)*2 + 1 ]*(  fac[2]) ;
+		}
+	}
+	double tmp_1d[2];
+	for (int ii=0;ii<2;ii++){
+		tmp_1d[ ii ] =
+				tmp_2d[ ii*2     ]*(1-fac[1]) +
+				tmp_2d[ ii*2 + 1 ]*(  fac[1]) ;
+	}
+	return tmp_1d[ 0 ]*(1-fac[0]) + tmp_1d[ 1 ]*(  fac[0]) ;
+}
+
+/** 4d interpolation in the contiguous intermodulation table */
+static double interp_imod_table(const ImodTab* tab, const int* iarr, const double* fac){
+	const int s2 = tab->n_ampl;
+	const int s1 = tab->n_ampl*s2;
+	const int s0 = tab->n_dt*s1;
+	const double* d = &(tab->data[iarr[0]*s0 + iarr[1]*s1 + iarr[2]*s2 + iarr[3]]);
+
+	double tmp_3d[8];
+	for (int ii=0;ii<2;ii++){
+		for (int jj=0;jj<2;jj++){
+			for (int kk=0;kk<2;kk++){
+				const double* c = &(d[ii*s0 + jj*s1 + kk*s2]);
+				tmp_3d[ (ii*2+jj)*2 + kk ] = c[0]*(1-fac[3]) + c[1]*(fac[3]);
+			}
+		}
+	}
+	return interp_lin_cell(tmp_3d, fac);
+}
+
+/** 3d interpolation in the contiguous TDM table */
+static double interp_TDM_table(const TDMTab* tab, const int* iarr, const double* fac){
+	const int s1 = tab->n_ener_v;
+	const int s0 = tab->n_ener_p*s1;
+	const double* d = &(tab->data[iarr[0]*s0 + iarr[1]*s1 + iarr[2]]);
+
+	double tmp_3d[8];
+	for (int ii=0;ii<2;ii++){
+		for (int jj=0;jj<2;jj++){
+			tmp_3d[ (ii*2+jj)*2     ] = d[ii*s0 + jj*s1];
+			tmp_3d[ (ii*2+jj)*2 + 1 ] = d[ii*s0 + jj*s1 + 1];
+		}
+	}
+	return interp_lin_cell(tmp_3d, fac);
+}
+
+/** Precompute the part of the TDM table which is needed to calculate the
+    energy deposited by a crosstalk event (dt=0, victim energy 0, see
+    computeWeights). The table is already interpolated along the victim
+    energy, in the same way as calc_prop_xt_influence would do it. */
+static void init_TDM_t0_slice(TDMTab* tab, int* const status){
+	free(tab->t0_slice);
+	tab->t0_slice=NULL;
+
+	double signal_energy=0.;
+	double dt_in_frames=0.;
+	if ((signal_energy < tab->ener_v[0]) ||
+			(signal_energy >= tab->ener_p[tab->n_ener_v-1]) ||
+			(dt_in_frames <= tab->samples[0]) ||
+			(dt_in_frames >= tab->samples[tab->n_samples-1])){
+		return;
+	}
+
+	int ind_dt = binary_search(dt_in_frames,tab->samples,tab->n_samples);
+	float d_dt = (dt_in_frames-tab->samples[ind_dt])/(tab->samples[ind_dt+1]-tab->samples[ind_dt]);
+	int ind_dev = binary_search(signal_energy,tab->ener_v,tab->n_ener_v);
+	float d_dev=(signal_energy-tab->ener_v[ind_dev])/(tab->ener_v[ind_dev+1]-tab->ener_v[ind_dev]);
+	double fac_dev = d_dev;
+
+	tab->t0_slice = (double*) malloc(2*tab->n_ener_p*sizeof(double));
+	CHECK_MALLOC_VOID_STATUS(tab->t0_slice,*status);
+	for (int ii=0; ii<2; ii++){
+		for (int jj=0; jj<tab->n_ener_p; jj++){
+			const double* d = tab->matrix[ind_dt+ii][jj];
+			tab->t0_slice[ii*tab->n_ener_p+jj] =
+					d[ind_dev]*(1-fac_dev) + d[ind_dev+1]*(fac_dev);
+		}
+	}
+	tab->t0_fac_dt = d_dt;
+}
+
+/** Interpolate the precomputed TDM table at dt=0 for a victim energy of 0
+    (identical to calc_prop_xt_influence / calc_der_xt_influence) */
+static void calc_TDM_t0_influence(const TDMTab* tab, double perturber_energy, double* enweight){
+	if ((perturber_energy < tab->ener_p[0]) ||
+			(perturber_energy >= tab->ener_p[tab->n_ener_p-1])) {
+		headas_chat(7, " *** warning : perturber energy %g is outside the tabulated values for TDM cross-talk [%g,%g]}n",
+				perturber_energy, tab->ener_p[0],tab->ener_p[tab->n_ener_p-1]);
+		headas_chat(7, "     ---> skipping this event!\n");
+		return;
+	}
+	int ind_dep = binary_search(perturber_energy,tab->ener_p,tab->n_ener_p);
+	float d_dep=(perturber_energy-tab->ener_p[ind_dep])/(tab->ener_p[ind_dep+1]-tab->ener_p[ind_dep]);
+	double fac_dep = d_dep;
+
+	const double* s0 = &(tab->t0_slice[ind_dep]);
+	const double* s1 = &(tab->t0_slice[tab->n_ener_p+ind_dep]);
+	double tmp_1d[2];
+	tmp_1d[0] = s0[0]*(1-fac_dep) + s0[1]*(fac_dep);
+	tmp_1d[1] = s1[0]*(1-fac_dep) + s1[1]*(fac_dep);
+	*enweight = tmp_1d[0]*(1-tab->t0_fac_dt) + tmp_1d[1]*(tab->t0_fac_dt);
+}
+
+/** Precompute the normalized weights and the slopes of the time dependence */
+static void init_timedep_slopes(CrosstalkTimedep* timedep, int* const status){
+	timedep->weight_norm = (double*) malloc(timedep->length*sizeof(double));
+	CHECK_MALLOC_VOID_STATUS(timedep->weight_norm,*status);
+	timedep->slope = (double*) malloc(timedep->length*sizeof(double));
+	CHECK_MALLOC_VOID_STATUS(timedep->slope,*status);
+
+	// we need to weight to be one at t=0 (not the case for tessim LUT)
+	for (int ii=0; ii<timedep->length; ii++){
+		timedep->weight_norm[ii] = timedep->weight[ii] / timedep->weight_t0;
+	}
+	for (int ii=0; ii<timedep->length-1; ii++){
+		timedep->slope[ii] = (timedep->weight_norm[ii+1]-timedep->weight_norm[ii]) /
+				(timedep->time[ii+1]-timedep->time[ii]);
+	}
+	if (timedep->length>0){
+		timedep->slope[timedep->length-1] = 0.0;
+	}
+}
+
 // taken from Roland's Memo (V2, 10.06.2016)
 double get_imod_df(double f_sig, double f_per, int* status){
 
@@ -168,7 +300,7 @@ double get_intermod_weight(AdvDet* det, int grading, double df, double dt,
 	double fac[] = {d_df, d_dt, d_ampl[0], d_ampl[1]};
 
 	// get the crosstalk energy (in eV) and convert to keV
-	double cross_energy = interp_lin_ndim(det->crosstalk_imod_table[grading].matrix,iarr,fac,4)*1e-3;
+	double cross_energy = interp_imod_table(&(det->crosstalk_imod_table[grading]),iarr,fac)*1e-3;
 
 	// printf("  |-> weights: %.3e %.3e %.3e %.3e | %.3e %.3e | %.3e \n",c00,c01,c10,c11,c0,c1,cross_talk_weight);
 
@@ -243,7 +375,7 @@ void calc_prop_xt_influence(AdvDet* det,double signal_energy, double perturber_e
 		double fac[] = {d_dt, d_dep, d_dev};
 
 		// get the perturber energy (in keV) and rescale it
-		*enweight = interp_lin_ndim(det->crosstalk_TDM_prop[grading].matrix,iarr,fac,3);
+		*enweight = interp_TDM_table(&(det->crosstalk_TDM_prop[grading]),iarr,fac);
 		//printf("In routine %f\n", *enweight);
 	}
 }
@@ -288,7 +420,7 @@ void calc_der_xt_influence(AdvDet* det,double signal_energy, double perturber_en
 		double fac[] = {d_dt, d_dep, d_dev};
 
 		// get the crosstalk energy (in keV) and rescale it
-		*enweight = interp_lin_ndim(det->crosstalk_TDM_der[grading].matrix,iarr,fac,3);
+		*enweight = interp_TDM_table(&(det->crosstalk_TDM_der[grading]),iarr,fac);
 		//printf("In routine %f\n", *enweight);
 	}
 }
@@ -498,6 +630,8 @@ void load_thermal_timedep(AdvDet* det, int i, int k, int* const status){
 		det->crosstalk_ther_timedep[i][2*k].weight_t0 =
 				(1-fac_low)*det->crosstalk_ther_timedep[i][2*k].weight[ind_t0_low] +
 				(fac_low)  *det->crosstalk_ther_timedep[i][2*k].weight[ind_t0_low+1];
+		init_timedep_slopes(&(det->crosstalk_ther_timedep[i][2*k]),status);
+		CHECK_STATUS_BREAK(*status);
 
 		// Read time dependence info for second the second case (same grading, different frequency difference)
 		int n_time_hi, n_weight_hi;
@@ -521,6 +655,8 @@ void load_thermal_timedep(AdvDet* det, int i, int k, int* const status){
 		det->crosstalk_ther_timedep[i][2*k+1].weight_t0 =
 				(1-fac_hi)*det->crosstalk_ther_timedep[i][2*k+1].weight[ind_t0_hi] +
 				(fac_hi)  *det->crosstalk_ther_timedep[i][2*k+1].weight[ind_t0_hi+1];
+		init_timedep_slopes(&(det->crosstalk_ther_timedep[i][2*k+1]),status);
+		CHECK_STATUS_BREAK(*status);
 
 	}while(0);
 
@@ -786,6 +922,8 @@ void load_elec_timedep(AdvDet* det, int k, int* const status){
 		det->crosstalk_elec_timedep[2*k].weight_t0 =
 				(1-fac_low)*det->crosstalk_elec_timedep[2*k].weight[ind_t0_low] +
 				(fac_low)  *det->crosstalk_elec_timedep[2*k].weight[ind_t0_low+1];
+		init_timedep_slopes(&(det->crosstalk_elec_timedep[2*k]),status);
+		CHECK_STATUS_BREAK(*status);
 
 
 		// Read time dependence info for second the second case (same grading, different frequency difference)
@@ -810,6 +948,8 @@ void load_elec_timedep(AdvDet* det, int k, int* const status){
 		det->crosstalk_elec_timedep[2*k+1].weight_t0 =
 				(1-fac_hi)*det->crosstalk_elec_timedep[2*k+1].weight[ind_t0_hi] +
 				(fac_hi)  *det->crosstalk_elec_timedep[2*k+1].weight[ind_t0_hi+1];
+		init_timedep_slopes(&(det->crosstalk_elec_timedep[2*k+1]),status);
+		CHECK_STATUS_BREAK(*status);
 
 	}while(0);
 
@@ -955,7 +1095,8 @@ void load_electrical_cross_talk(AdvDet* det,int pixid,int* const status){
 static void initImodTab(ImodTab* tab, int n_ampl, int n_dt, int n_freq,
 		double* ampl, double* dt, double* freq, int* status){
 
-	// make a short pointer
+	tab->matrix = NULL;
+	tab->data = NULL;
 
 	tab->n_ampl = n_ampl;
 	tab->n_dt   = n_dt;
@@ -984,25 +1125,23 @@ static void initImodTab(ImodTab* tab, int n_ampl, int n_dt, int n_freq,
 		tab->freq[ii] = freq[ii];
 	}
 
-	// allocate the 4d matrix (n_freq x n_dt x n_ampl x nampl)
+	// allocate the 4d matrix (n_freq x n_dt x n_ampl x nampl) as one contiguous
+	// block; the pointer levels are only kept to address it as matrix[][][][]
+	tab->data = (double*) calloc (n_freq*n_dt*n_ampl*n_ampl, sizeof(double));
+	CHECK_MALLOC_VOID_STATUS(tab->data,*status);
+	double*** rows = (double***) malloc (n_freq*n_dt*sizeof(double**));
+	CHECK_MALLOC_VOID_STATUS(rows,*status);
+	double** cols = (double**) malloc (n_freq*n_dt*n_ampl*sizeof(double*));
+	CHECK_MALLOC_VOID_STATUS(cols,*status);
 	tab->matrix = (double****) malloc (n_freq*sizeof(double***));
 	CHECK_MALLOC_VOID_STATUS(tab->matrix,*status);
 
 	for (int ll=0; ll<n_freq; ll++){               // FREQ-LOOP
-		tab->matrix[ll] = (double***) malloc (n_dt*sizeof(double**));
-		CHECK_MALLOC_VOID_STATUS(tab->matrix[ll],*status);
-
+		tab->matrix[ll] = &(rows[ll*n_dt]);
 		for (int ii=0; ii<n_dt; ii++){             // DT-LOOP
-			tab->matrix[ll][ii] = (double**) malloc (n_ampl*sizeof(double*));
-			CHECK_MALLOC_VOID_STATUS(tab->matrix[ll][ii],*status);
-
+			tab->matrix[ll][ii] = &(cols[(ll*n_dt+ii)*n_ampl]);
 			for (int jj=0; jj<n_ampl; jj++){      // AMPL1-LOOP
-				tab->matrix[ll][ii][jj] = (double*) malloc (n_ampl*sizeof(double));
-				CHECK_MALLOC_VOID_STATUS(tab->matrix[ll][ii][jj],*status);
-
-				for (int kk=0; kk<n_ampl; kk++){  // AMPL2-LOOP
-					tab->matrix[ll][ii][jj][kk] = 0.0;
-				}
+				tab->matrix[ll][ii][jj] = &(tab->data[((ll*n_dt+ii)*n_ampl+jj)*n_ampl]);
 			}
 		}
 	}
@@ -1233,6 +1372,10 @@ static void initTDMTab(TDMTab** tab, int n_samples, int n_ener_p, int n_ener_v,
 		double* samples, double* ener_p, double* ener_v, int* status){
 	// make a short pointer
 	TDMTab* t = (*tab);
+	t->matrix = NULL;
+	t->data = NULL;
+	t->t0_slice = NULL;
+	t->t0_fac_dt = 0.0;
 
 	t->n_samples = n_samples;
 	t->n_ener_p  = n_ener_p;
@@ -1256,21 +1399,19 @@ static void initTDMTab(TDMTab** tab, int n_samples, int n_ener_p, int n_ener_v,
 		t->ener_v[ii] = ener_v[ii];
 	}
 
-	// allocate the 3d matrix (n_samples x n_ener_p x n_ener_v)
+	// allocate the 3d matrix (n_samples x n_ener_p x n_ener_v) as one contiguous
+	// block; the pointer levels are only kept to address it as matrix[][][]
+	t->data = (double*) calloc (n_samples*n_ener_p*n_ener_v, sizeof(double));
+	CHECK_MALLOC_VOID_STATUS(t->data,*status);
+	double** rows = (double**) malloc (n_samples*n_ener_p*sizeof(double*));
+	CHECK_MALLOC_VOID_STATUS(rows,*status);
 	t->matrix = (double***) malloc (n_samples*sizeof(double**));
 	CHECK_MALLOC_VOID_STATUS(t->matrix,*status);
 
 	for (int ll=0; ll<n_samples; ll++){               // SAMPLE-LOOP
-		t->matrix[ll] = (double**) malloc (n_ener_p*sizeof(double*));
-		CHECK_MALLOC_VOID_STATUS(t->matrix[ll],*status);
-
+		t->matrix[ll] = &(rows[ll*n_ener_p]);
 		for (int ii=0; ii<n_ener_p; ii++){             // ENER_P-LOOP
-			t->matrix[ll][ii] = (double*) malloc (n_ener_v*sizeof(double));
-			CHECK_MALLOC_VOID_STATUS(t->matrix[ll][ii],*status);
-
-			for (int jj=0; jj<n_ener_v; jj++){      // ENER_V-LOOP
-				t->matrix[ll][ii][jj] = 0.0;
-			}
+			t->matrix[ll][ii] = &(t->data[(ll*n_ener_p+ii)*n_ener_v]);
 		}
 	}
 	return;
@@ -1477,6 +1618,8 @@ void load_prop_table(AdvDet* det, int k ,int* status){
 			printf(" *** error: reading proportional crosstalk table %s  failed\n", fullfilename);
 			break;
 		}
+		init_TDM_t0_slice(&(det->crosstalk_TDM_prop[k]),status);
+		CHECK_STATUS_BREAK(*status);
 		free(samples);
 		free(ener_v);
 		free(ener_p);
@@ -1610,6 +1753,8 @@ void load_der_table(AdvDet* det, int k ,int* status){
 			printf(" *** error: reading derivative crosstalk table %s  failed\n", fullfilename);
 			break;
 		}
+		init_TDM_t0_slice(&(det->crosstalk_TDM_der[k]),status);
+		CHECK_STATUS_BREAK(*status);
 		free(samples);
 		free(ener_v);
 		free(ener_p);
@@ -2089,14 +2234,9 @@ int computeCrosstalkInfluence(CrosstalkTimedep* buffer,PixImpact* impact,PixImpa
 		int timedep_index=binary_search(time_difference,buffer->time,buffer->length);
 		assert(timedep_index<buffer->length-1);
 
-		// we need to weight to be one at t=0 (not the case for tessim LUT)
-		double weight0 = buffer->weight[timedep_index]   / buffer->weight_t0;
-		double weight1 = buffer->weight[timedep_index+1] / buffer->weight_t0;
-
-		// influence previous impact
-		energy_influence= energy*(weight0+
-				(weight1-weight0) /(buffer->time[timedep_index+1]-buffer->time[timedep_index])
-				*(time_difference-buffer->time[timedep_index]));
+		// influence previous impact (weights normalized to one at t=0)
+		energy_influence= energy*(buffer->weight_norm[timedep_index]+
+				buffer->slope[timedep_index]*(time_difference-buffer->time[timedep_index]));
 		impact->energy+=energy_influence;
 		*influence+=energy_influence;
 		headas_chat(7,", Influence:%.2e (fraction:%.2e)\n",*influence,*influence/energy);
@@ -2295,7 +2435,11 @@ void computeWeights(AdvDet* det, CrosstalkProxy* xtalk_proxy, PixImpact * impact
 			double dt_in_frames=0.;
 			double energy_fictional_victim=0.;
 			double crosstalk_effect=0.;
-			calc_prop_xt_influence(det,energy_fictional_victim,crosstalk->energy,&crosstalk_effect, dt_in_frames, grade);
+			if (det->crosstalk_TDM_prop[grade].t0_slice!=NULL){
+				calc_TDM_t0_influence(&(det->crosstalk_TDM_prop[grade]),crosstalk->energy,&crosstalk_effect);
+			} else {
+				calc_prop_xt_influence(det,energy_fictional_victim,crosstalk->energy,&crosstalk_effect, dt_in_frames, grade);
+			}
 			if (abs(xtalk_proxy->type[ii])==-PROPCTK1){
 				energies[ii]=crosstalk_effect*det->prop_TDM_scaling_1/1.e-2; //Scaled at 1% of amplitude;
 			} else if (abs(xtalk_proxy->type[ii])==-PROPCTK2){
@@ -2308,7 +2452,11 @@ void computeWeights(AdvDet* det, CrosstalkProxy* xtalk_proxy, PixImpact * impact
 			double dt_in_frames=0.;
 			double energy_fictional_victim=0.;
 			double crosstalk_effect=0.;
-			calc_der_xt_influence(det,energy_fictional_victim,crosstalk->energy,&crosstalk_effect, dt_in_frames, grade);
+			if (det->crosstalk_TDM_der[grade].t0_slice!=NULL){
+				calc_TDM_t0_influence(&(det->crosstalk_TDM_der[grade]),crosstalk->energy,&crosstalk_effect);
+			} else {
+				calc_der_xt_influence(det,energy_fictional_victim,crosstalk->energy,&crosstalk_effect, dt_in_frames, grade);
+			}
 			energies[ii]=crosstalk_effect*det->der_TDM_scaling/1.e-2; //Scaled at 1% of amplitude;
 		}
 	}
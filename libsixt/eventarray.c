@@ -138,13 +138,18 @@ double* SaveEventArray1d(ReadEvent* ea, int* status)
  }
 
     //Create the 1D-image from EventArray
+  CopyEventArray1d(ea, EventArray1d);
+  return(EventArray1d);
+}
+
+void CopyEventArray1d(const ReadEvent* ea, double* EventArray1d)
+{
   int x, y;
   for (x=0; x<ea->naxis1; x++) {
     for (y=0; y<ea->naxis2; y++) {
       EventArray1d[(x+ ea->naxis1*y)] = ea->EventArray[x][y];
    }
   }
-  return(EventArray1d);
 }
 
 void FreeEventArray1d(double* EventArray1d)
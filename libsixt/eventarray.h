@@ -54,6 +54,9 @@ int readEventList_nextRow(CoMaEventFile* ef, ReadEvent* ea);
 
 double* SaveEventArray1d(ReadEvent* ea, int* status);
 
+//copies the EventArray to an existing 1d-image of size naxis1*naxis2
+void CopyEventArray1d(const ReadEvent* ea, double* EventArray1d);
+
 void FreeEventArray1d(double* EventArray1d);
 
 void FreeEventArray(ReadEvent* ea);
@@ -31,6 +31,7 @@ EventFile* newEventFile(int* const status)
 
   // Initialize pointers with NULL.
   file->fptr=NULL;
+  file->buffer=NULL;
 
   // Initialize.
   file->nrows=0;
@@ -50,6 +51,22 @@ EventFile* newEventFile(int* const status)
   file->csignals=0;
   file->cphas    =0;
   file->cpileup =0;
+  file->btime   =-1;
+  file->bframe  =-1;
+  file->bpha    =-1;
+  file->bpi     =-1;
+  file->bsignal =-1;
+  file->brawx   =-1;
+  file->brawy   =-1;
+  file->bra     =-1;
+  file->bdec    =-1;
+  file->bph_id  =-1;
+  file->bsrc_id =-1;
+  file->bnpixels=-1;
+  file->btype   =-1;
+  file->bpileup =-1;
+  file->bsignals=-1;
+  file->bphas   =-1;
 
   return(file);
 }
@@ -59,6 +76,9 @@ void freeEventFile(EventFile** const file,
 		   int* const status)
 {
   if (NULL!=*file) {
+    // Write buffered rows to the file.
+    freeFitsBlockBuffer(&(*file)->buffer, status);
+
     if (NULL!=(*file)->fptr) {
       // If the file was opened in READWRITE mode, calculate
       // the check sum an append it to the FITS header.
@@ -98,6 +118,35 @@ void getColNumsFromEventFile(EventFile* const file,	int* const status)
 	fits_get_colnum(file->fptr, CASEINSEN, "SIGNALS", &file->csignals, status);
 	fits_get_colnum(file->fptr, CASEINSEN, "PHAS", &file->cphas, status);
 	CHECK_STATUS_VOID(*status);
+
+	// (Re-)Assign the columns of the buffer for block-wise I/O.
+	if (NULL==file->buffer) {
+		file->buffer=newFitsBlockBuffer(file->fptr, status);
+	} else {
+		clearFitsBlockColumns(file->buffer, status);
+	}
+	CHECK_STATUS_VOID(*status);
+	FitsBlockBuffer* buf=file->buffer;
+	file->btime   =addFitsBlockColumn(buf, file->ctime, TDOUBLE, 1, status);
+	file->bframe  =addFitsBlockColumn(buf, file->cframe, TLONG, 1, status);
+	file->bpha    =addFitsBlockColumn(buf, file->cpha, TLONG, 1, status);
+	file->bsignal =addFitsBlockColumn(buf, file->csignal, TFLOAT, 1, status);
+	file->brawx   =addFitsBlockColumn(buf, file->crawx, TINT, 1, status);
+	file->brawy   =addFitsBlockColumn(buf, file->crawy, TINT, 1, status);
+	file->bra     =addFitsBlockColumn(buf, file->cra, TDOUBLE, 1, status);
+	file->bdec    =addFitsBlockColumn(buf, file->cdec, TDOUBLE, 1, status);
+	file->bph_id  =addFitsBlockColumn(buf, file->cph_id, TLONG, NEVENTPHOTONS, status);
+	file->bsrc_id =addFitsBlockColumn(buf, file->csrc_id, TLONG, NEVENTPHOTONS, status);
+	file->bnpixels=addFitsBlockColumn(buf, file->cnpixels, TLONG, 1, status);
+	file->btype   =addFitsBlockColumn(buf, file->ctype, TINT, 1, status);
+	file->bpileup =addFitsBlockColumn(buf, file->cpileup, TINT, 1, status);
+	file->bsignals=addFitsBlockColumn(buf, file->csignals, TFLOAT, 9, status);
+	file->bphas   =addFitsBlockColumn(buf, file->cphas, TLONG, 9, status);
+	file->bpi=-1;
+	if (file->cpi > 0) {
+		file->bpi =addFitsBlockColumn(buf, file->cpi, TLONG, 1, status);
+	}
+	CHECK_STATUS_VOID(*status);
 }
 
 
@@ -257,6 +306,10 @@ void addCol2EventFile(EventFile* const file,
 		*colnum = cnum+1;
 	}
 
+	// Write buffered rows before the column layout changes.
+	resetFitsBlockBuffer(file->buffer, status);
+	CHECK_STATUS_VOID(*status);
+
 	// Insert column in File
 	fits_insert_col(file->fptr,*colnum,ttype,tform,status);
 	CHECK_STATUS_VOID(*status);
@@ -314,59 +367,36 @@ void getEventFromFile(const EventFile* const file,
     return;
   }
 
-  // Read in the data.
-  int anynul=0;
-  double dnull=0.;
-  float fnull=0.;
-  long lnull=0;
-  int inull=0;
-
-  fits_read_col(file->fptr, TDOUBLE, file->ctime, row, 1, 1,
-		&dnull, &event->time, &anynul, status);
-  fits_read_col(file->fptr, TLONG, file->cframe, row, 1, 1,
-		&lnull, &event->frame, &anynul, status);
-  fits_read_col(file->fptr, TLONG, file->cpha, row, 1, 1,
-		&lnull, &event->pha, &anynul, status);
-  fits_read_col(file->fptr, TFLOAT, file->csignal, row, 1, 1,
-		&fnull, &event->signal, &anynul, status);
-  fits_read_col(file->fptr, TINT, file->crawx, row, 1, 1,
-		&inull, &event->rawx, &anynul, status);
-  fits_read_col(file->fptr, TINT, file->crawy, row, 1, 1,
-		&inull, &event->rawy, &anynul, status);
-  fits_read_col(file->fptr, TDOUBLE, file->cra, row, 1, 1,
-		&dnull, &event->ra, &anynul, status);
-  event->ra*=M_PI/180.;
-  fits_read_col(file->fptr, TDOUBLE, file->cdec, row, 1, 1,
-		&lnull, &event->dec, &anynul, status);
-  event->dec*=M_PI/180.;
-  fits_read_col(file->fptr, TLONG, file->cph_id, row, 1, NEVENTPHOTONS,
-		&lnull, &event->ph_id, &anynul, status);
-  fits_read_col(file->fptr, TLONG, file->csrc_id, row, 1, NEVENTPHOTONS,
-		&lnull, &event->src_id, &anynul, status);
-  fits_read_col(file->fptr, TLONG, file->cnpixels, row, 1, 1,
-		&lnull, &event->npixels, &anynul, status);
-  fits_read_col(file->fptr, TINT, file->ctype, row, 1, 1,
-		&inull, &event->type, &anynul, status);
-  fits_read_col(file->fptr, TINT, file->cpileup, row, 1, 1,
-		&inull, &event->pileup, &anynul, status);
-  fits_read_col(file->fptr, TFLOAT, file->csignals, row, 1, 9,
-		&fnull, &event->signals, &anynul, status);
-  fits_read_col(file->fptr, TLONG, file->cphas, row, 1, 9,
-		&lnull, &event->phas, &anynul, status);
+  // Make sure the row is available in the buffer.
+  FitsBlockBuffer* buf=file->buffer;
+  long idx=readFitsBlockRow(buf, row, file->nrows, status);
   CHECK_STATUS_VOID(*status);
 
-  // only read PI column if file->cpi is valid
-  if( file->cpi > 0 ){
-  	fits_read_col(file->fptr, TLONG, file->cpi, row, 1, 1,
-  			&dnull, &event->pi,&anynul, status);
-  	CHECK_STATUS_VOID(*status);
+  // Copy the data from the buffer.
+  event->time   =FITSBLOCK_COL(buf, file->btime, double)[idx];
+  event->frame  =FITSBLOCK_COL(buf, file->bframe, long)[idx];
+  event->pha    =FITSBLOCK_COL(buf, file->bpha, long)[idx];
+  event->signal =FITSBLOCK_COL(buf, file->bsignal, float)[idx];
+  event->rawx   =FITSBLOCK_COL(buf, file->brawx, int)[idx];
+  event->rawy   =FITSBLOCK_COL(buf, file->brawy, int)[idx];
+  event->ra     =FITSBLOCK_COL(buf, file->bra, double)[idx]*M_PI/180.;
+  event->dec    =FITSBLOCK_COL(buf, file->bdec, double)[idx]*M_PI/180.;
+  event->npixels=FITSBLOCK_COL(buf, file->bnpixels, long)[idx];
+  event->type   =FITSBLOCK_COL(buf, file->btype, int)[idx];
+  event->pileup =FITSBLOCK_COL(buf, file->bpileup, int)[idx];
+  int ii;
+  for (ii=0; ii<NEVENTPHOTONS; ii++) {
+    event->ph_id[ii] =FITSBLOCK_COL(buf, file->bph_id, long)[idx*NEVENTPHOTONS+ii];
+    event->src_id[ii]=FITSBLOCK_COL(buf, file->bsrc_id, long)[idx*NEVENTPHOTONS+ii];
+  }
+  for (ii=0; ii<9; ii++) {
+    event->signals[ii]=FITSBLOCK_COL(buf, file->bsignals, float)[idx*9+ii];
+    event->phas[ii]   =FITSBLOCK_COL(buf, file->bphas, long)[idx*9+ii];
   }
 
-  // Check if an error occurred during the reading process.
-  if (0!=anynul) {
-    *status=EXIT_FAILURE;
-    SIXT_ERROR("reading from EventFile failed");
-    return;
+  // only read PI column if file->cpi is valid
+  if( file->bpi >= 0 ){
+    event->pi=FITSBLOCK_COL(buf, file->bpi, long)[idx];
   }
 }
 
@@ -375,46 +405,36 @@ void updateEventInFile(const EventFile* const file,
 		       const int row, Event* const event,
 		       int* const status)
 {
-//puts("write event.");
-  fits_write_col(file->fptr, TDOUBLE, file->ctime, row,
-		 1, 1, &event->time, status);
-  fits_write_col(file->fptr, TLONG, file->cframe, row,
-		 1, 1, &event->frame, status);
-  fits_write_col(file->fptr, TLONG, file->cpha, row,
-		 1, 1, &event->pha, status);
-  fits_write_col(file->fptr, TFLOAT, file->csignal, row,
-		 1, 1, &event->signal, status);
-  fits_write_col(file->fptr, TINT, file->crawx, row,
-		 1, 1, &event->rawx, status);
-  fits_write_col(file->fptr, TINT, file->crawy, row,
-		 1, 1, &event->rawy, status);
-  double dbuffer=event->ra*180./M_PI;
-  fits_write_col(file->fptr, TDOUBLE, file->cra, row,
-		 1, 1, &dbuffer, status);
-  dbuffer=event->dec*180./M_PI;
-  fits_write_col(file->fptr, TDOUBLE, file->cdec, row,
-		 1, 1, &dbuffer, status);
-  fits_write_col(file->fptr, TLONG, file->cph_id, row,
-		 1, NEVENTPHOTONS, &event->ph_id, status);
-  fits_write_col(file->fptr, TLONG, file->csrc_id, row,
-		 1, NEVENTPHOTONS, &event->src_id, status);
-  fits_write_col(file->fptr, TLONG, file->cnpixels, row,
-		 1, 1, &event->npixels, status);
-  fits_write_col(file->fptr, TINT, file->cpileup, row,
-		 1, 1, &event->pileup, status);
-  fits_write_col(file->fptr, TINT, file->ctype, row,
-		 1, 1, &event->type, status);
-  fits_write_col(file->fptr, TFLOAT, file->csignals, row,
-		 1, 9, &event->signals, status);
-  fits_write_col(file->fptr, TLONG, file->cphas, row,
-		 1, 9, &event->phas, status);
+  // Store the data in the buffer. The buffer is written to the FITS
+  // file as soon as a row outside the current block is accessed.
+  FitsBlockBuffer* buf=file->buffer;
+  long idx=writeFitsBlockRow(buf, row, status);
   CHECK_STATUS_VOID(*status);
 
+  FITSBLOCK_COL(buf, file->btime, double)[idx]=event->time;
+  FITSBLOCK_COL(buf, file->bframe, long)[idx]=event->frame;
+  FITSBLOCK_COL(buf, file->bpha, long)[idx]=event->pha;
+  FITSBLOCK_COL(buf, file->bsignal, float)[idx]=event->signal;
+  FITSBLOCK_COL(buf, file->brawx, int)[idx]=event->rawx;
+  FITSBLOCK_COL(buf, file->brawy, int)[idx]=event->rawy;
+  FITSBLOCK_COL(buf, file->bra, double)[idx]=event->ra*180./M_PI;
+  FITSBLOCK_COL(buf, file->bdec, double)[idx]=event->dec*180./M_PI;
+  FITSBLOCK_COL(buf, file->bnpixels, long)[idx]=event->npixels;
+  FITSBLOCK_COL(buf, file->bpileup, int)[idx]=event->pileup;
+  FITSBLOCK_COL(buf, file->btype, int)[idx]=event->type;
+  int ii;
+  for (ii=0; ii<NEVENTPHOTONS; ii++) {
+    FITSBLOCK_COL(buf, file->bph_id, long)[idx*NEVENTPHOTONS+ii]=event->ph_id[ii];
+    FITSBLOCK_COL(buf, file->bsrc_id, long)[idx*NEVENTPHOTONS+ii]=event->src_id[ii];
+  }
+  for (ii=0; ii<9; ii++) {
+    FITSBLOCK_COL(buf, file->bsignals, float)[idx*9+ii]=event->signals[ii];
+    FITSBLOCK_COL(buf, file->bphas, long)[idx*9+ii]=event->phas[ii];
+  }
+
   // only write PI value if event->pi value is valid, i.e., != -1.
-  if( file->cpi > 0 ){
-  	fits_write_col(file->fptr, TLONG, file->cpi, row,
-  			1, 1, &event->pi, status);
-    CHECK_STATUS_VOID(*status);
+  if( file->bpi >= 0 ){
+    FITSBLOCK_COL(buf, file->bpi, long)[idx]=event->pi;
   }
 }
 
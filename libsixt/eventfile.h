@@ -25,6 +25,7 @@
 
 #include "sixt.h"
 #include "event.h"
+#include "fitsblockbuffer.h"
 
 
 /////////////////////////////////////////////////////////////////
@@ -44,6 +45,15 @@ typedef struct {
   int ctime, cframe, cpha, cpi, csignal, crawx, crawy, cra, cdec,
     cph_id, csrc_id, cnpixels, ctype, cpileup, csignals, cphas;
 
+  /** Buffer for block-wise access to the FITS table. The buffer is
+      written to the file when the EventFile is closed. */
+  FitsBlockBuffer* buffer;
+
+  /** Column indices within the buffer. The value -1 denotes that the
+      optional column is not available. */
+  int btime, bframe, bpha, bpi, bsignal, brawx, brawy, bra, bdec,
+    bph_id, bsrc_id, bnpixels, btype, bpileup, bsignals, bphas;
+
 } EventFile;
 
 
@@ -21,6 +21,22 @@
 
 #include "fft_array.h"
 
+#include <pthread.h>
+
+
+/** The FFTW planner is not thread-safe. */
+static pthread_mutex_t fftw_planner_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef HAVE_FFTW3_THREADS
+static pthread_once_t fftw_threads_once=PTHREAD_ONCE_INIT;
+static int fftw_threads_ok=0;
+
+static void initFFTWThreads(void)
+{
+  fftw_threads_ok=fftw_init_threads();
+}
+#endif
+
 fftw_complex* FFTOfArray_1d(double* Image1d, int ImageSize1, int ImageSize2, int type)
 {
   fftw_complex* Input;
@@ -69,3 +85,126 @@ fftw_complex* FFTOfArray(fftw_complex* Input, int ImageSize1, int ImageSize2, in
 
   return(Output);
 }
+
+
+FFTCorrelator* newFFTCorrelator(const double* const Kernel1d,
+				const int ImageSize1, const int ImageSize2,
+				const int nthreads, int* const status)
+{
+  FFTCorrelator* corr=(FFTCorrelator*)malloc(sizeof(FFTCorrelator));
+  CHECK_NULL_RET(corr, *status,
+		 "memory allocation for FFTCorrelator failed", corr);
+
+  // Initialize pointers with NULL.
+  corr->image   =NULL;
+  corr->spec    =NULL;
+  corr->kernel  =NULL;
+  corr->forward =NULL;
+  corr->backward=NULL;
+
+  corr->ImageSize1=ImageSize1;
+  corr->ImageSize2=ImageSize2;
+  corr->nspec=(long)ImageSize1*(ImageSize2/2+1);
+
+  corr->image=(double*)fftw_malloc(sizeof(double)*ImageSize1*ImageSize2);
+  CHECK_NULL_RET(corr->image, *status,
+		 "memory allocation for FFTCorrelator failed", corr);
+  corr->spec=(fftw_complex*)fftw_malloc(sizeof(fftw_complex)*corr->nspec);
+  CHECK_NULL_RET(corr->spec, *status,
+		 "memory allocation for FFTCorrelator failed", corr);
+  corr->kernel=(fftw_complex*)fftw_malloc(sizeof(fftw_complex)*corr->nspec);
+  CHECK_NULL_RET(corr->kernel, *status,
+		 "memory allocation for FFTCorrelator failed", corr);
+
+  // Create the plans. FFTW_MEASURE overwrites the buffers, so this
+  // has to be done before they are filled.
+  const char* wisdom=getenv("SIXTE_FFTW_WISDOM");
+  if ((NULL!=wisdom)&&('\0'==wisdom[0])) {
+    wisdom=NULL;
+  }
+
+  pthread_mutex_lock(&fftw_planner_mutex);
+#ifdef HAVE_FFTW3_THREADS
+  pthread_once(&fftw_threads_once, initFFTWThreads);
+  if (0!=fftw_threads_ok) {
+    fftw_plan_with_nthreads(MAX(nthreads, 1));
+  }
+#endif
+  if (NULL!=wisdom) {
+    fftw_import_wisdom_from_filename(wisdom);
+  }
+  corr->forward=fftw_plan_dft_r2c_2d(ImageSize1, ImageSize2,
+				     corr->image, corr->spec, FFTW_MEASURE);
+  corr->backward=fftw_plan_dft_c2r_2d(ImageSize1, ImageSize2,
+				      corr->spec, corr->image, FFTW_MEASURE);
+  if ((NULL!=wisdom)&&(NULL!=corr->forward)&&(NULL!=corr->backward)) {
+    if (0==fftw_export_wisdom_to_filename(wisdom)) {
+      SIXT_WARNING("could not store FFTW wisdom");
+    }
+  }
+  pthread_mutex_unlock(&fftw_planner_mutex);
+  CHECK_NULL_RET(corr->forward, *status,
+		 "creation of FFT plan failed", corr);
+  CHECK_NULL_RET(corr->backward, *status,
+		 "creation of FFT plan failed", corr);
+
+  // Spectrum of the kernel. The complex conjugate and the
+  // normalization of the backward transform are applied once here.
+  long ii;
+  for (ii=0; ii<(long)ImageSize1*ImageSize2; ii++) {
+    corr->image[ii]=Kernel1d[ii];
+  }
+  fftw_execute(corr->forward);
+  const double norm=1./((double)ImageSize1*ImageSize2);
+  for (ii=0; ii<corr->nspec; ii++) {
+    corr->kernel[ii][0]= corr->spec[ii][0]*norm;
+    corr->kernel[ii][1]=-corr->spec[ii][1]*norm;
+  }
+
+  return(corr);
+}
+
+
+void freeFFTCorrelator(FFTCorrelator** const corr)
+{
+  if (NULL!=*corr) {
+    pthread_mutex_lock(&fftw_planner_mutex);
+    if (NULL!=(*corr)->forward) {
+      fftw_destroy_plan((*corr)->forward);
+    }
+    if (NULL!=(*corr)->backward) {
+      fftw_destroy_plan((*corr)->backward);
+    }
+    pthread_mutex_unlock(&fftw_planner_mutex);
+    if (NULL!=(*corr)->image) {
+      fftw_free((*corr)->image);
+    }
+    if (NULL!=(*corr)->spec) {
+      fftw_free((*corr)->spec);
+    }
+    if (NULL!=(*corr)->kernel) {
+      fftw_free((*corr)->kernel);
+    }
+    free(*corr);
+    *corr=NULL;
+  }
+}
+
+
+void correlateFFTArray(FFTCorrelator* const corr)
+{
+  fftw_execute(corr->forward);
+
+  // Multiply with the conjugate spectrum of the kernel.
+  long ii;
+  for (ii=0; ii<corr->nspec; ii++) {
+    double re=corr->spec[ii][0]*corr->kernel[ii][0]
+      -corr->spec[ii][1]*corr->kernel[ii][1];
+    double im=corr->spec[ii][0]*corr->kernel[ii][1]
+      +corr->spec[ii][1]*corr->kernel[ii][0];
+    corr->spec[ii][0]=re;
+    corr->spec[ii][1]=im;
+  }
+
+  fftw_execute(corr->backward);
+}
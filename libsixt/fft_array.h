@@ -20,7 +20,7 @@
 */
 
 #ifndef FFT_ARRAY_H
-#define FFT_ARRAY_H1
+#define FFT_ARRAY_H 1
 
 #include "sixt.h"
 #include "fftw3.h"
@@ -30,6 +30,37 @@
 ////////////////////////////////////////////////////////////////////////
 
 
+/** Engine for the repeated cyclic cross-correlation of real-valued
+    images with a fixed kernel, e.g., of the event array with the
+    reconstruction array of a coded mask. The spectrum of the kernel
+    is calculated only once. The real-to-complex and complex-to-real
+    plans and the buffers are kept for all correlations. */
+typedef struct {
+  /** Image dimensions. The images are stored in the same 1d format
+      as used by FFTOfArray_1d(). */
+  int ImageSize1, ImageSize2;
+
+  /** Number of entries of the half spectrum. */
+  long nspec;
+
+  /** Real-valued image to be correlated with the kernel. The content
+      is replaced by the result of correlateFFTArray(). */
+  double* image;
+
+  /** Half spectrum of the image. */
+  fftw_complex* spec;
+
+  /** Complex conjugate of the half spectrum of the kernel, divided by
+      the number of pixels. */
+  fftw_complex* kernel;
+
+  /** Plans for the forward (image->spec) and backward (spec->image)
+      transform. */
+  fftw_plan forward, backward;
+
+} FFTCorrelator;
+
+
 /////////////////////////////////////////////////////////////////////
 // Function Declarations.
 /////////////////////////////////////////////////////////////////////
@@ -42,4 +73,24 @@ fftw_complex* FFTOfArray_1d(double* Image1d, int ImageSize1, int ImageSize2, int
 //type +1 equals FFTW_BAKWARD;type -1 equals FFTW_FORWARD
 fftw_complex* FFTOfArray(fftw_complex* Input, int ImageSize1, int ImageSize2, int type);
 
+/** Constructor. Creates the FFT plans with FFTW_MEASURE and computes
+    the spectrum of the kernel, which has to be given in the same 1d
+    format as for FFTOfArray_1d(). If the environment variable
+    SIXTE_FFTW_WISDOM contains a file name, the FFTW wisdom is read
+    from this file before planning and stored there afterwards, such
+    that the planning only has to be performed once. The transforms
+    use nthreads threads if the multi-threaded FFTW library is
+    available. */
+FFTCorrelator* newFFTCorrelator(const double* const Kernel1d,
+				const int ImageSize1, const int ImageSize2,
+				const int nthreads, int* const status);
+
+/** Destructor. */
+void freeFFTCorrelator(FFTCorrelator** const corr);
+
+/** Correlate the image stored in corr->image with the kernel. The
+    image is replaced by the normalized result, i.e., the real part of
+    FFTInv(FFT(image)*conj(FFT(kernel)))/(ImageSize1*ImageSize2). */
+void correlateFFTArray(FFTCorrelator* const corr);
+
 #endif
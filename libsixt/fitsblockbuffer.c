@@ -0,0 +1,288 @@
+/*
+   This file is part of SIXTE.
+
+   SIXTE is free software: you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   any later version.
+
+   SIXTE is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   For a copy of the GNU General Public License see
+   <http://www.gnu.org/licenses/>.
+
+
+   Copyright 2019 Remeis-Sternwarte, Friedrich-Alexander-Universitaet
+                  Erlangen-Nuernberg
+*/
+
+#include "fitsblockbuffer.h"
+
+
+/** Size of a single element of the given CFITSIO data type [byte]. A
+    return value of 0 indicates an unsupported data type. */
+static size_t getFitsBlockElementSize(const int datatype)
+{
+  switch (datatype) {
+  case TBYTE:   return(sizeof(unsigned char));
+  case TSHORT:  return(sizeof(short));
+  case TINT:    return(sizeof(int));
+  case TLONG:   return(sizeof(long));
+  case TFLOAT:  return(sizeof(float));
+  case TDOUBLE: return(sizeof(double));
+  default:      return(0);
+  }
+}
+
+
+/** Move the file pointer to the HDU of the buffer. The number of the
+    previously active HDU is stored in prevhdu, such that it can be
+    restored afterwards. */
+static void moveToFitsBlockHDU(const FitsBlockBuffer* const buf,
+			       int* const prevhdu,
+			       int* const status)
+{
+  fits_get_hdu_num(buf->fptr, prevhdu);
+  if (*prevhdu!=buf->hdunum) {
+    fits_movabs_hdu(buf->fptr, buf->hdunum, NULL, status);
+  }
+}
+
+
+/** Counterpart to moveToFitsBlockHDU(). */
+static void restoreFitsBlockHDU(const FitsBlockBuffer* const buf,
+				const int prevhdu,
+				int* const status)
+{
+  if (prevhdu!=buf->hdunum) {
+    fits_movabs_hdu(buf->fptr, prevhdu, NULL, status);
+  }
+}
+
+
+FitsBlockBuffer* newFitsBlockBuffer(fitsfile* const fptr, int* const status)
+{
+  FitsBlockBuffer* buf=(FitsBlockBuffer*)malloc(sizeof(FitsBlockBuffer));
+  CHECK_NULL_RET(buf, *status, "memory allocation for FitsBlockBuffer failed",
+		 buf);
+
+  // Initialize pointers with NULL.
+  buf->fptr=fptr;
+  int ii;
+  for (ii=0; ii<FITSBLOCKBUFFER_MAXCOLS; ii++) {
+    buf->cols[ii].data=NULL;
+  }
+
+  // Initialize values.
+  buf->hdunum=0;
+  buf->size=FITSBLOCKBUFFER_MINROWS;
+  buf->firstrow=0;
+  buf->nrows=0;
+  buf->modified=0;
+  buf->ncols=0;
+
+  CHECK_NULL_RET(fptr, *status, "no FITS file specified for FitsBlockBuffer",
+		 buf);
+
+  // Remember the HDU the buffer belongs to.
+  fits_get_hdu_num(fptr, &buf->hdunum);
+
+  // Determine the optimum number of rows that are processed with
+  // one CFITSIO call.
+  long rowsize=0;
+  fits_get_rowsize(fptr, &rowsize, status);
+  CHECK_STATUS_RET(*status, buf);
+  if (rowsize>buf->size) {
+    buf->size=rowsize;
+  }
+
+  return(buf);
+}
+
+
+void freeFitsBlockBuffer(FitsBlockBuffer** const buf, int* const status)
+{
+  if (NULL!=*buf) {
+    flushFitsBlockBuffer(*buf, status);
+
+    int ii;
+    for (ii=0; ii<FITSBLOCKBUFFER_MAXCOLS; ii++) {
+      if (NULL!=(*buf)->cols[ii].data) {
+	free((*buf)->cols[ii].data);
+      }
+    }
+    free(*buf);
+    *buf=NULL;
+  }
+}
+
+
+int addFitsBlockColumn(FitsBlockBuffer* const buf,
+		       const int colnum,
+		       const int datatype,
+		       const long repeat,
+		       int* const status)
+{
+  if (buf->nrows>0) {
+    *status=EXIT_FAILURE;
+    SIXT_ERROR("cannot add column to FitsBlockBuffer containing data");
+    return(-1);
+  }
+  if (buf->ncols>=FITSBLOCKBUFFER_MAXCOLS) {
+    *status=EXIT_FAILURE;
+    SIXT_ERROR("too many columns in FitsBlockBuffer");
+    return(-1);
+  }
+
+  size_t elsize=getFitsBlockElementSize(datatype);
+  if (0==elsize) {
+    *status=EXIT_FAILURE;
+    char msg[MAXMSG];
+    sprintf(msg, "unsupported data type %d for FitsBlockBuffer", datatype);
+    SIXT_ERROR(msg);
+    return(-1);
+  }
+
+  FitsBlockColumn* col=&(buf->cols[buf->ncols]);
+  col->colnum  =colnum;
+  col->datatype=datatype;
+  col->repeat  =MAX(repeat, 1);
+  col->elsize  =elsize;
+  col->data    =calloc(buf->size*col->repeat, elsize);
+  CHECK_NULL_RET(col->data, *status,
+		 "memory allocation for FitsBlockBuffer column failed", -1);
+
+  return(buf->ncols++);
+}
+
+
+void clearFitsBlockColumns(FitsBlockBuffer* const buf, int* const status)
+{
+  resetFitsBlockBuffer(buf, status);
+
+  int ii;
+  for (ii=0; ii<buf->ncols; ii++) {
+    if (NULL!=buf->cols[ii].data) {
+      free(buf->cols[ii].data);
+      buf->cols[ii].data=NULL;
+    }
+  }
+  buf->ncols=0;
+}
+
+
+long readFitsBlockRow(FitsBlockBuffer* const buf,
+		      const long row,
+		      const long nrows,
+		      int* const status)
+{
+  // Check if the row is already available in the buffer.
+  if ((buf->nrows>0)&&(row>=buf->firstrow)&&(row<buf->firstrow+buf->nrows)) {
+    return(row-buf->firstrow);
+  }
+
+  if ((row<1)||(row>nrows)) {
+    *status=EXIT_FAILURE;
+    SIXT_ERROR("requested row is not available in FITS table");
+    return(-1);
+  }
+
+  // Write the current block to the file before it is replaced.
+  resetFitsBlockBuffer(buf, status);
+  CHECK_STATUS_RET(*status, -1);
+
+  // Load a new block starting at the requested row.
+  long nread=MIN(buf->size, nrows-row+1);
+  int prevhdu;
+  moveToFitsBlockHDU(buf, &prevhdu, status);
+  CHECK_STATUS_RET(*status, -1);
+
+  int anynul=0;
+  int ii;
+  for (ii=0; ii<buf->ncols; ii++) {
+    FitsBlockColumn* col=&(buf->cols[ii]);
+    fits_read_col(buf->fptr, col->datatype, col->colnum, row, 1,
+		  nread*col->repeat, NULL, col->data, &anynul, status);
+    CHECK_STATUS_BREAK(*status);
+  }
+  restoreFitsBlockHDU(buf, prevhdu, status);
+  CHECK_STATUS_RET(*status, -1);
+
+  if (0!=anynul) {
+    *status=EXIT_FAILURE;
+    SIXT_ERROR("reading block of rows from FITS table failed");
+    return(-1);
+  }
+
+  buf->firstrow=row;
+  buf->nrows=nread;
+
+  return(0);
+}
+
+
+long writeFitsBlockRow(FitsBlockBuffer* const buf,
+		       const long row,
+		       int* const status)
+{
+  if (row<1) {
+    *status=EXIT_FAILURE;
+    SIXT_ERROR("invalid row number for FITS table");
+    return(-1);
+  }
+
+  if ((buf->nrows>0)&&(row>=buf->firstrow)&&(row<buf->firstrow+buf->nrows)) {
+    // Overwrite a row that is already buffered.
+  } else if ((buf->nrows>0)&&(row==buf->firstrow+buf->nrows)&&
+	     (buf->nrows<buf->size)) {
+    // Append the row to the current block.
+    buf->nrows++;
+  } else {
+    // Start a new block.
+    resetFitsBlockBuffer(buf, status);
+    CHECK_STATUS_RET(*status, -1);
+    buf->firstrow=row;
+    buf->nrows=1;
+  }
+  buf->modified=1;
+
+  return(row-buf->firstrow);
+}
+
+
+void flushFitsBlockBuffer(FitsBlockBuffer* const buf, int* const status)
+{
+  if ((NULL==buf)||(0==buf->modified)||(0==buf->nrows)) return;
+  CHECK_STATUS_VOID(*status);
+
+  int prevhdu;
+  moveToFitsBlockHDU(buf, &prevhdu, status);
+  CHECK_STATUS_VOID(*status);
+
+  int ii;
+  for (ii=0; ii<buf->ncols; ii++) {
+    FitsBlockColumn* col=&(buf->cols[ii]);
+    fits_write_col(buf->fptr, col->datatype, col->colnum, buf->firstrow, 1,
+		   buf->nrows*col->repeat, col->data, status);
+    CHECK_STATUS_BREAK(*status);
+  }
+  restoreFitsBlockHDU(buf, prevhdu, status);
+  CHECK_STATUS_VOID(*status);
+
+  buf->modified=0;
+}
+
+
+void resetFitsBlockBuffer(FitsBlockBuffer* const buf, int* const status)
+{
+  if (NULL==buf) return;
+
+  flushFitsBlockBuffer(buf, status);
+  CHECK_STATUS_VOID(*status);
+
+  buf->firstrow=0;
+  buf->nrows=0;
+}
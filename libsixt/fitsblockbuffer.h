@@ -0,0 +1,172 @@
+/*
+   This file is part of SIXTE.
+
+   SIXTE is free software: you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   any later version.
+
+   SIXTE is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   For a copy of the GNU General Public License see
+   <http://www.gnu.org/licenses/>.
+
+
+   Copyright 2019 Remeis-Sternwarte, Friedrich-Alexander-Universitaet
+                  Erlangen-Nuernberg
+*/
+
+#ifndef FITSBLOCKBUFFER_H
+#define FITSBLOCKBUFFER_H 1
+
+#include "sixt.h"
+
+
+/////////////////////////////////////////////////////////////////
+// Constants.
+/////////////////////////////////////////////////////////////////
+
+
+/** Maximum number of columns that can be attached to a single
+    FitsBlockBuffer. */
+#define FITSBLOCKBUFFER_MAXCOLS (24)
+
+/** Minimum number of rows held in the buffer. The actual block size
+    is derived from fits_get_rowsize(), but is never smaller than
+    this value. */
+#define FITSBLOCKBUFFER_MINROWS (1024)
+
+
+/////////////////////////////////////////////////////////////////
+// Type Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Single buffered column of a FITS binary table. */
+typedef struct {
+  /** Column number in the FITS table. */
+  int colnum;
+
+  /** CFITSIO data type of the buffered values (e.g. TDOUBLE). */
+  int datatype;
+
+  /** Number of elements per row (vector columns). */
+  long repeat;
+
+  /** Size of a single element [byte]. */
+  size_t elsize;
+
+  /** Buffered values. The array contains size*repeat elements of the
+      data type specified by datatype. */
+  void* data;
+
+} FitsBlockColumn;
+
+
+/** Write-back cache for a block of consecutive rows of a FITS binary
+    table. The columns of the block are read and written with a single
+    CFITSIO call per column, while the individual rows are accessed
+    via the returned buffer index. The buffer keeps track of the HDU
+    it belongs to, such that it is not affected by other routines
+    moving the file pointer to a different extension. */
+typedef struct {
+  /** Pointer to the FITS file. The file is not closed by the
+      destructor. */
+  fitsfile* fptr;
+
+  /** Number of the HDU containing the buffered table. */
+  int hdunum;
+
+  /** Maximum number of rows in the buffer. */
+  long size;
+
+  /** Number of the first buffered row in the FITS table. Numbering
+      starts at 1. If the value is 0, the buffer is empty. */
+  long firstrow;
+
+  /** Number of valid rows in the buffer. */
+  long nrows;
+
+  /** Flag whether the buffer contains data that have not been
+      written to the FITS file yet. */
+  int modified;
+
+  /** Buffered columns. */
+  int ncols;
+  FitsBlockColumn cols[FITSBLOCKBUFFER_MAXCOLS];
+
+} FitsBlockBuffer;
+
+
+/////////////////////////////////////////////////////////////////
+// Macros.
+/////////////////////////////////////////////////////////////////
+
+
+/** Access the data array of the column with the index icol (as
+    returned by addFitsBlockColumn()) as an array of the given C
+    type. */
+#define FITSBLOCK_COL(buf, icol, type) ((type*)((buf)->cols[(icol)].data))
+
+
+/////////////////////////////////////////////////////////////////
+// Function Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Constructor. Returns a pointer to an empty FitsBlockBuffer
+    attached to the current HDU of the specified FITS file. The number
+    of rows per block is determined with fits_get_rowsize(). */
+FitsBlockBuffer* newFitsBlockBuffer(fitsfile* const fptr, int* const status);
+
+/** Destructor. Writes modified data to the FITS file before
+    releasing the memory. */
+void freeFitsBlockBuffer(FitsBlockBuffer** const buf, int* const status);
+
+/** Add a column to the buffer. The return value is the index of the
+    column within the buffer, which has to be used to access the
+    data. Columns can only be added as long as the buffer is
+    empty. */
+int addFitsBlockColumn(FitsBlockBuffer* const buf,
+		       const int colnum,
+		       const int datatype,
+		       const long repeat,
+		       int* const status);
+
+/** Remove all columns from the buffer. Modified data are written to
+    the FITS file before. This routine has to be called whenever the
+    column layout of the table changes. */
+void clearFitsBlockColumns(FitsBlockBuffer* const buf, int* const status);
+
+/** Make sure that the specified row is available in the buffer and
+    return its index within the buffer. If the row is not buffered
+    yet, a new block starting at this row is loaded from the FITS
+    file. The parameter nrows denotes the total number of rows in the
+    FITS table. */
+long readFitsBlockRow(FitsBlockBuffer* const buf,
+		      const long row,
+		      const long nrows,
+		      int* const status);
+
+/** Return the buffer index for writing the specified row. The row
+    is appended to the current block if possible. Otherwise the
+    block is written to the FITS file and a new block is started. All
+    columns of the row have to be filled by the calling routine. */
+long writeFitsBlockRow(FitsBlockBuffer* const buf,
+		       const long row,
+		       int* const status);
+
+/** Write modified data to the FITS file. The buffered rows remain
+    valid. */
+void flushFitsBlockBuffer(FitsBlockBuffer* const buf, int* const status);
+
+/** Write modified data to the FITS file and discard the buffered
+    rows. This routine has to be called if the table is modified
+    without using the buffer (e.g. if rows are deleted). */
+void resetFitsBlockBuffer(FitsBlockBuffer* const buf, int* const status);
+
+
+#endif /* FITSBLOCKBUFFER_H */
@@ -21,6 +21,14 @@
  */
 
 #include "gendet.h"
+#include "phpat.h"
+
+#include <pthread.h>
+
+/** The aux background model is shared by all detectors. Protect it
+    against simultaneous access from detectors simulated in different
+    threads. */
+static pthread_mutex_t aux_bkg_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 ////////////////////////////////////////////////////////////////////
 // Program Code
@@ -44,7 +52,9 @@ GenDet* newGenDet(int* const status) {
 	det->specarf_filename = NULL;
 	det->rmf_filename = NULL;
 	det->rmf = NULL;
+	det->rmfsampler = NULL;
 	det->elf = NULL;
+	det->patengine = NULL;
 	for (int ii = 0; ii < MAX_PHABKG; ii++) {
 		det->phabkg[ii] = NULL;
 	}
@@ -55,6 +65,8 @@ GenDet* newGenDet(int* const status) {
 	det->ignore_bkg = 0;
 	det->auxbackground = 0;
 	det->anyphoton = 0;
+	det->last_clock_time = 0.;
+	det->n_detected_photons = 0;
 	det->frametime = 0.;
 	det->deadtime = 0.;
 	det->cte = 1.;
@@ -108,7 +120,7 @@ void destroyGenDet(GenDet** const det) {
 		if (NULL != (*det)->rmf_filename) {
 			free((*det)->rmf_filename);
 		}
-		freeRMF((*det)->rmf);
+		releaseSharedRMF((*det)->rmf);
 		destroyClockList(&(*det)->clocklist);
 		destroyGenPixGrid(&(*det)->pixgrid);
 		destroyGenSplit(&(*det)->split);
@@ -144,12 +156,18 @@ int addGenDetPhotonImpact(GenDet* const det, const Impact* const impact,
 	float energy;
 
 	if (NULL != det->rmf) {
+		if (NULL == det->rmfsampler) {
+			det->rmfsampler = getSharedRMFSampler(det->rmf, status);
+			CHECK_STATUS_RET(*status, 0);
+		}
+
 		// Determine the measured detector channel (PI channel) according
 		// to the RMF.
-		// The channel is obtained from the RMF using the corresponding
-		// HEAdas routine which is based on drawing a random number.
-		long channel;
-		returnRMFChannel(det->rmf, impact->energy, &channel);
+		// The channel is obtained from the cumulative distribution of the
+		// RMF, which is based on drawing a random number.
+		long channel = getRMFSamplerChannel(det->rmfsampler, impact->energy,
+				status);
+		CHECK_STATUS_RET(*status, 0);
 
 		// Check if the photon is really measured. If the PI channel
 		// returned by the HEAdas RMF function is '-1', the photon is not
@@ -196,14 +214,7 @@ void GenDetLineShift(GenDet* const det) {
 	int ii;
 	if (det->cte != 1.) {
 		for (ii = 1; ii < det->pixgrid->ywidth; ii++) {
-			if (0 != det->line[ii]->anycharge) {
-				int jj;
-				for (jj = 0; jj < det->line[ii]->xwidth; jj++) {
-					if (det->line[ii]->charge[jj] > 0.) {
-						det->line[ii]->charge[jj] *= det->cte;
-					}
-				}
-			}
+			scaleGenDetLine(det->line[ii], det->cte);
 		}
 	}
 
@@ -226,6 +237,11 @@ void setGenDetEventFile(GenDet* const det, EventFile* const elf) {
 	det->elf = elf;
 }
 
+void setGenDetPatternEngine(GenDet* const det,
+		struct PatternEngine* const engine) {
+	det->patengine = engine;
+}
+
 void setGenDetIgnoreBkg(GenDet* const det, const int ignore) {
 	if (0 == ignore) {
 		det->ignore_bkg = 0;
@@ -242,7 +258,7 @@ static inline void GenDetReadoutPixel(GenDet* const det, const int lineindex,
 	GenDetLine* line = det->line[lineindex];
 
 	// Check if an output event file is defined.
-	if (NULL == det->elf) {
+	if (NULL == det->elf && NULL == det->patengine) {
 		*status = EXIT_FAILURE;
 		SIXT_ERROR("no event file specified (needed for event detection)");
 		return;
@@ -304,8 +320,18 @@ static inline void GenDetReadoutPixel(GenDet* const det, const int lineindex,
 			event->npixels = 1;
 
 			// Store the event in the output event file.
-			addEvent2File(det->elf, event, status);
-			CHECK_STATUS_BREAK(*status);
+			if (NULL != det->elf) {
+				addEvent2File(det->elf, event, status);
+				CHECK_STATUS_BREAK(*status);
+			}
+
+			// Pass the event on to the pattern recombination, which
+			// takes over the event.
+			if (NULL != det->patengine) {
+				addPatternEngineEvent(det->patengine, event, status);
+				event = NULL;
+				CHECK_STATUS_BREAK(*status);
+			}
 
 		} while (0); // END of error handling loop.
 
@@ -322,8 +348,16 @@ void GenDetReadoutLine(GenDet* const det, const int lineindex,
 	line->last_readouttime = det->clocklist->time;
 
 	if (0 != line->anycharge) {
-		int ii;
-		for (ii = 0; ii < line->xwidth; ii++) {
+		// Only the charged pixels have to be read out, unless the line
+		// is in dense mode. They are read out in increasing order.
+		int npixels = line->xwidth;
+		if (0 == line->dense) {
+			sortGenDetLinePixels(line);
+			npixels = line->nchargedpix;
+		}
+		int kk;
+		for (kk = 0; kk < npixels; kk++) {
+			int ii = (0 == line->dense) ? line->chargedpix[kk] : kk;
 			GenDetReadoutPixel(det, lineindex, readoutindex, ii,
 					det->clocklist->readout_time, status);
 			CHECK_STATUS_BREAK(*status);
@@ -334,6 +368,10 @@ void GenDetReadoutLine(GenDet* const det, const int lineindex,
 		// Reset the anycharge flag of this line.
 		line->anycharge = line->anycarry;
 		line->anycarry = 0;
+
+		// Remove the pixels, which have been read out, from the list of
+		// charged pixels.
+		updateGenDetLinePixels(line);
 	}
 }
 
@@ -371,7 +409,9 @@ static void insertBadPix(GenDet* const det, const double timespan) {
 static void insert_aux_bkg(GenDet* const det, double time, double dt) {
 	// Get background events for the required time interval (has
 	// to be given in [s]).
+	pthread_mutex_lock(&aux_bkg_mutex);
 	backgroundOutput* list = bkgGetBackgroundList(dt);
+	pthread_mutex_unlock(&aux_bkg_mutex);
 	double cosrota = cos(det->pixgrid->rota);
 	double sinrota = sin(det->pixgrid->rota);
 	int ii;
@@ -533,14 +573,13 @@ void operateGenDetClock(GenDet* const det, const double time, int* const status)
 	if ( (GENDET_EVENT_TRIGGERED == det->readout_trigger )
 			 && (0 == det->ignore_bkg)  ){
 
-		static double last_time = 0.0; // Time of the last function call.
-
 		// Insert background events (PHA and AUX)
-		insert_background_events(det, last_time,time - last_time, status);
+		insert_background_events(det, det->last_clock_time,
+				time - det->last_clock_time, status);
 		CHECK_STATUS_VOID(*status);
 
 		// Remember the time of the function call.
-		last_time = time;
+		det->last_clock_time = time;
 
 	} else if (GENDET_TIME_TRIGGERED == det->readout_trigger) {
 		// Time-triggered mode.
@@ -900,6 +939,7 @@ void addGenDetCharge2Pixel(GenDet* const det, const int column, const int row,
 					src_id);
 		}
 		line->anycharge = 1;
+		markGenDetLinePixel(line, column);
 
 		// Set PH_ID and SRC_ID.
 		if (oldcharge < 0.001) {
@@ -36,6 +36,7 @@
 #include "phabkg.h"
 #include "point.h"
 #include "rmf.h"
+#include "rmfsampler.h"
 #include "xmlbuffer.h"
 
 
@@ -57,6 +58,10 @@ typedef enum {
 } GenSplitType;
 
 
+/** Online pattern recombination (defined in phpat.h). */
+struct PatternEngine;
+
+
 /////////////////////////////////////////////////////////////////
 // Type Declarations.
 /////////////////////////////////////////////////////////////////
@@ -141,6 +146,11 @@ typedef struct {
   char* rmf_filename;
   struct RMF* rmf;
 
+  /** Sampler for the detector channels according to the RMF. It is
+      set up with the first photon and shared with all detectors using
+      the same RMF. */
+  const RMFSampler* rmfsampler;
+
   /** Lower readout threshold in units of [keV]. This threshold is
       applied in the read-out routine before converting the pixel
       charge to a PHA value. Pixel charges below this threshold will
@@ -199,6 +209,16 @@ typedef struct {
       last new frame. */
   int anyphoton;
 
+  /** Time of the last call of the detector clock in event-triggered
+      mode. The background events are inserted for the interval since
+      then. */
+  double last_clock_time;
+
+  /** Total number of detected photons. Only the number of photons
+      absorbed by valid pixels inside the detector is counted. Split
+      events created by one photon are counted only once. */
+  unsigned long n_detected_photons;
+
   /** Charge transfer efficiency (CTE). In a line shift of the pixel
       array the charges in the shifted pixels are multiplied by this
       value in order to account for losses due to the shift. */
@@ -212,6 +232,12 @@ typedef struct {
       manually. */
   EventFile* elf;
 
+  /** Optional online pattern recombination. If it is defined, the
+      read-out events are passed to it in addition to the output
+      EventFile, which may then be omitted. The engine is not
+      destroyed together with the GenDet data struct. */
+  struct PatternEngine* patengine;
+
   /** Properties of the DEPFET sensor. */
   DepfetProp depfet;
 
@@ -319,6 +345,10 @@ void parseGenDetXML(GenDet* const det,
 /** Assign an output EventFile. */
 void setGenDetEventFile(GenDet* const det, EventFile* const elf);
 
+/** Assign an online pattern recombination engine (see phpat.h). */
+void setGenDetPatternEngine(GenDet* const det,
+			    struct PatternEngine* const engine);
+
 /** Set the ignore_bkg flag. */
 void setGenDetIgnoreBkg(GenDet* const det, const int ignore);
 
@@ -49,10 +49,14 @@ GenDetLine* newGenDetLine(const int xwidth, int* const status)
   line->src_id  =NULL;
   line->carry_ph_id   =NULL;
   line->carry_src_id  =NULL;
+  line->chargedpix    =NULL;
+  line->ischarged     =NULL;
 
   line->xwidth=0;
   line->anycharge=0;
   line->anycarry=0;
+  line->nchargedpix=0;
+  line->dense=0;
   line->last_readouttime=0.;
 
   // Allocate memory.
@@ -77,6 +81,12 @@ GenDetLine* newGenDetLine(const int xwidth, int* const status)
   line->carry_src_id=(long**)malloc(xwidth*sizeof(long*));
   CHECK_NULL_RET(line->carry_src_id, *status,
 		 "memory allocation for GenDetLine failed", line);
+  line->chargedpix=(int*)malloc(MAX(xwidth/GENDETLINE_DENSE_FRACTION, 1)*sizeof(int));
+  CHECK_NULL_RET(line->chargedpix, *status,
+		 "memory allocation for GenDetLine failed", line);
+  line->ischarged=(unsigned char*)calloc(xwidth, sizeof(unsigned char));
+  CHECK_NULL_RET(line->ischarged, *status,
+		 "memory allocation for GenDetLine failed", line);
   int ii;
   for(ii=0; ii<xwidth; ii++) {
     line->ph_id[ii]=(long*)malloc(NEVENTPHOTONS*sizeof(long));
@@ -133,6 +143,12 @@ void destroyGenDetLine(GenDetLine** const line)
     if (NULL!=(*line)->deadtime) {
       free((*line)->deadtime);
     }
+    if (NULL!=(*line)->chargedpix) {
+      free((*line)->chargedpix);
+    }
+    if (NULL!=(*line)->ischarged) {
+      free((*line)->ischarged);
+    }
     if (NULL!=(*line)->ph_id) {
       int ii;
       for (ii=0; ii<(*line)->xwidth; ii++) {
@@ -175,13 +191,43 @@ void destroyGenDetLine(GenDetLine** const line)
 }
 
 
+/** Return the index of the kk-th pixel to be regarded, i.e., of the
+    kk-th charged pixel in sparse mode or simply kk in dense mode. */
+static inline int getGenDetLinePixel(const GenDetLine* const line,
+				     const int kk)
+{
+  return((0==line->dense) ? line->chargedpix[kk] : kk);
+}
+
+
+/** Return the number of pixels to be regarded. */
+static inline int getGenDetLineNPixels(const GenDetLine* const line)
+{
+  return((0==line->dense) ? line->nchargedpix : line->xwidth);
+}
+
+
+static int compareGenDetLinePixels(const void* a, const void* b)
+{
+  return(*(const int*)a - *(const int*)b);
+}
+
+
 void clearGenDetLine(GenDetLine* const line)
 {
-  // Check if the line contains any charge. If not the clearing
-  // is not necessary.
+  // Check if the line contains any charges or carry charges. If not
+  // the clearing is not necessary.
+  if ((0==line->anycharge)&&(0==line->anycarry)) return;
+
+  // Only the pixels in the list of charged pixels have to be
+  // regarded (all pixels in dense mode).
+  const int npix=getGenDetLineNPixels(line);
+
+  // Check if the line contains any charge.
   if (1==line->anycharge) {
-    int ii;
-    for(ii=0; ii<line->xwidth; ii++) {
+    int kk;
+    for(kk=0; kk<npix; kk++) {
+      int ii=getGenDetLinePixel(line, kk);
       if (line->charge[ii]>0.) {
 	line->charge[ii]=0.;
 	int jj;
@@ -196,8 +242,9 @@ void clearGenDetLine(GenDetLine* const line)
   // Check if the line contains carry charges for the next
   // read-out cycle.
   if (1==line->anycarry) {
-    int ii;
-    for(ii=0; ii<line->xwidth; ii++) {
+    int kk;
+    for(kk=0; kk<npix; kk++) {
+      int ii=getGenDetLinePixel(line, kk);
       if (line->ccarry[ii]>0.) {
 	line->charge[ii]=line->ccarry[ii];
 	line->ccarry[ii]=0.;
@@ -212,6 +259,8 @@ void clearGenDetLine(GenDetLine* const line)
     }
     line->anycarry=0;
   }
+
+  updateGenDetLinePixels(line);
 }
 
 
@@ -224,10 +273,13 @@ void addGenDetLine(GenDetLine* const line0, const GenDetLine* const line1)
   line0->anycharge=1;
 
   // Add the charges.
-  int ii;
-  for(ii=0; ii<line1->xwidth; ii++) {
+  const int npix=getGenDetLineNPixels(line1);
+  int ll;
+  for(ll=0; ll<npix; ll++) {
+    int ii=getGenDetLinePixel(line1, ll);
     if (line1->charge[ii]>0.) {
       line0->charge[ii]+=line1->charge[ii];
+      markGenDetLinePixel(line0, ii);
 
       // Copy the photon and source IDs.
       int jj, kk;
@@ -242,3 +294,81 @@ void addGenDetLine(GenDetLine* const line0, const GenDetLine* const line1)
     }
   }
 }
+
+
+void markGenDetLinePixel(GenDetLine* const line, const int xindex)
+{
+  if ((0!=line->dense)||(0!=line->ischarged[xindex])) return;
+
+  // If too many pixels are charged, switch to dense mode.
+  if (line->nchargedpix>=line->xwidth/GENDETLINE_DENSE_FRACTION) {
+    line->dense=1;
+    return;
+  }
+
+  line->ischarged[xindex]=1;
+  line->chargedpix[line->nchargedpix++]=xindex;
+}
+
+
+void updateGenDetLinePixels(GenDetLine* const line)
+{
+  if (0==line->dense) {
+    // Remove the pixels without charges from the list.
+    int kk, nn=0;
+    for (kk=0; kk<line->nchargedpix; kk++) {
+      int ii=line->chargedpix[kk];
+      if ((line->charge[ii]!=0.)||(line->ccarry[ii]!=0.)) {
+	line->chargedpix[nn++]=ii;
+      } else {
+	line->ischarged[ii]=0;
+      }
+    }
+    line->nchargedpix=nn;
+
+  } else {
+    // Check if the line can be switched back to sparse mode.
+    int ii, nn=0;
+    for (ii=0; ii<line->xwidth; ii++) {
+      if ((line->charge[ii]!=0.)||(line->ccarry[ii]!=0.)) {
+	nn++;
+      }
+    }
+    if (nn>line->xwidth/GENDETLINE_DENSE_FRACTION) return;
+
+    line->nchargedpix=0;
+    for (ii=0; ii<line->xwidth; ii++) {
+      if ((line->charge[ii]!=0.)||(line->ccarry[ii]!=0.)) {
+	line->ischarged[ii]=1;
+	line->chargedpix[line->nchargedpix++]=ii;
+      } else {
+	line->ischarged[ii]=0;
+      }
+    }
+    line->dense=0;
+  }
+}
+
+
+void sortGenDetLinePixels(GenDetLine* const line)
+{
+  if ((0==line->dense)&&(line->nchargedpix>1)) {
+    qsort(line->chargedpix, line->nchargedpix, sizeof(int),
+	  compareGenDetLinePixels);
+  }
+}
+
+
+void scaleGenDetLine(GenDetLine* const line, const double factor)
+{
+  if (0==line->anycharge) return;
+
+  const int npix=getGenDetLineNPixels(line);
+  int kk;
+  for (kk=0; kk<npix; kk++) {
+    int ii=getGenDetLinePixel(line, kk);
+    if (line->charge[ii]>0.) {
+      line->charge[ii]*=factor;
+    }
+  }
+}
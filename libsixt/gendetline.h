@@ -27,6 +27,18 @@
 #include "event.h"
 
 
+/////////////////////////////////////////////////////////////////
+// Constants.
+/////////////////////////////////////////////////////////////////
+
+
+/** Maximum fraction (1/GENDETLINE_DENSE_FRACTION) of pixels in a line
+    for which the indices of the charged pixels are tracked. If more
+    pixels are charged, the line switches to the dense mode, where all
+    pixels are scanned. */
+#define GENDETLINE_DENSE_FRACTION (8)
+
+
 /////////////////////////////////////////////////////////////////
 // Type Declarations.
 /////////////////////////////////////////////////////////////////
@@ -78,6 +90,25 @@ typedef struct {
       for the next read-out cycle (f.e. for DEPFETs). */
   int anycarry;
 
+  /** Indices of the pixels, which might contain charges or carry
+      charges, in arbitrary order. All pixels with a non-zero charge
+      or carry charge are contained in this list, as long as the line
+      is not in dense mode. In that case the read-out, clearing, and
+      shifting of the line only have to regard these pixels. */
+  int* chargedpix;
+
+  /** Number of entries in chargedpix. */
+  int nchargedpix;
+
+  /** Flag for each pixel whether it is contained in chargedpix. */
+  unsigned char* ischarged;
+
+  /** If this flag is set, the list of charged pixels is not
+      maintained and all pixels of the line have to be scanned. The
+      line switches automatically between the two modes depending on
+      the fraction of charged pixels. */
+  int dense;
+
 } GenDetLine;
 
 
@@ -104,5 +135,24 @@ void clearGenDetLine(GenDetLine* const line);
     remain in there and have to be cleared separately. */
 void addGenDetLine(GenDetLine* const line0, const GenDetLine* const line1);
 
+/** Register the pixel with the given index as charged. This routine
+    has to be called whenever a charge or carry charge is added to a
+    pixel. */
+void markGenDetLinePixel(GenDetLine* const line, const int xindex);
+
+/** Remove the pixels without charge and carry charge from the list
+    of charged pixels. If the line is in dense mode and the fraction
+    of charged pixels is sufficiently small, the list is rebuilt and
+    the line switches back to the sparse mode. */
+void updateGenDetLinePixels(GenDetLine* const line);
+
+/** Sort the list of charged pixels in increasing order, such that
+    the pixels are read out in the same order as in dense mode. */
+void sortGenDetLinePixels(GenDetLine* const line);
+
+/** Multiply the charges in all pixels of the line with the given
+    factor, e.g., in order to apply the charge transfer efficiency. */
+void scaleGenDetLine(GenDetLine* const line, const double factor);
+
 
 #endif /* GENDETLINE_H */
@@ -42,6 +42,7 @@ MAP OF SECTIONS IN THIS FILE::
 
  - 1. polyFit
  - 2. polyFitLinear
+ - FFT plan cache (getFFTPlan)
  - 3. FFT
  - 4. FFTinverse
  - 5. gsl_vector_sqrtIFCA
@@ -142,6 +143,92 @@ int polyFitLinear (gsl_vector *x_fit, gsl_vector *y_fit, double *a, double *b)
 /*xxxx end of SECTION 2 xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx*/
 
 
+/***** FFT plan cache ********************************************************
+* FFTPlanCache: Wavetables and workspaces of the GSL FFT routines, kept per transform length. SIRENA calls FFT and
+* FFTinverse for every pulse (and for every filter length), so allocating them for each call is a considerable
+* overhead. The cache is thread-local, i.e., it can be used by concurrently running reconstruction threads without
+* locking, and it is released when the thread terminates.
+*****************************************************************************/
+FFTPlan::FFTPlan(size_t size): n(size), rwavetable(NULL), rwork(NULL), cwavetable(NULL), cwork(NULL), data(3*size) {}
+
+FFTPlan::~FFTPlan()
+{
+	if (rwavetable != NULL) gsl_fft_real_wavetable_free(rwavetable);
+	if (rwork != NULL) gsl_fft_real_workspace_free(rwork);
+	if (cwavetable != NULL) gsl_fft_complex_wavetable_free(cwavetable);
+	if (cwork != NULL) gsl_fft_complex_workspace_free(cwork);
+}
+
+namespace
+{
+	struct FFTPlanCache
+	{
+		std::map<size_t,FFTPlan*> plans;
+
+		~FFTPlanCache()
+		{
+			for (std::map<size_t,FFTPlan*>::iterator it=plans.begin(); it!=plans.end(); ++it) delete it->second;
+		}
+	};
+
+	thread_local FFTPlanCache fftPlanCache;
+}
+
+/***** getFFTPlan *************************************************************
+* getFFTPlan: Returns the cached wavetable and workspace for transforms of the given length, allocating them on the
+*             first request. The real (real=true) or complex (real=false) parts are set up on demand.
+*             Returns NULL if the allocation fails.
+*
+* Parameters:
+* - n: Length of the transform
+* - real: Real-to-complex (true) or complex (false) transform
+*****************************************************************************/
+FFTPlan *getFFTPlan(size_t n, bool real)
+{
+	if (n == 0) return(NULL);
+
+	FFTPlan *plan;
+	std::map<size_t,FFTPlan*>::iterator it = fftPlanCache.plans.find(n);
+	if (it != fftPlanCache.plans.end()) plan = it->second;
+	else
+	{
+		plan = new FFTPlan(n);
+		fftPlanCache.plans[n] = plan;
+	}
+
+	if (real && (plan->rwavetable == NULL))
+	{
+		plan->rwavetable = gsl_fft_real_wavetable_alloc(n);
+		plan->rwork = gsl_fft_real_workspace_alloc(n);
+		if ((plan->rwavetable == NULL) || (plan->rwork == NULL))
+		{
+			// Do not keep a half-initialized plan in the cache
+			if (plan->rwavetable != NULL) gsl_fft_real_wavetable_free(plan->rwavetable);
+			if (plan->rwork != NULL) gsl_fft_real_workspace_free(plan->rwork);
+			plan->rwavetable = NULL;
+			plan->rwork = NULL;
+			return(NULL);
+		}
+	}
+	else if (!real && (plan->cwavetable == NULL))
+	{
+		plan->cwavetable = gsl_fft_complex_wavetable_alloc(n);
+		plan->cwork = gsl_fft_complex_workspace_alloc(n);
+		if ((plan->cwavetable == NULL) || (plan->cwork == NULL))
+		{
+			if (plan->cwavetable != NULL) gsl_fft_complex_wavetable_free(plan->cwavetable);
+			if (plan->cwork != NULL) gsl_fft_complex_workspace_free(plan->cwork);
+			plan->cwavetable = NULL;
+			plan->cwork = NULL;
+			return(NULL);
+		}
+	}
+
+	return(plan);
+}
+/*xxxx end of FFT plan cache xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx*/
+
+
 /***** SECTION 3 ************************************************************
 * FFT: This function calculates the FFT of the elements of a vector
 *
@@ -169,6 +256,10 @@ int polyFitLinear (gsl_vector *x_fit, gsl_vector *y_fit, double *a, double *b)
 *     n-1      z(t = n-1)      x(f = -1/(n Delta))
 *
 * The frequency axis will be as built f = i/STD = i/(size/samprate) with i varying from 0 to size/2-1 (n=size and Delta=1/samprate sec/sample).
+*
+* As the input is real, a real-to-complex (mixed-radix) transform is used and the negative frequencies are obtained
+* from the Hermitian symmetry of the result. The wavetables and workspaces are taken from a thread-local cache
+* (see getFFTPlan), so they are only allocated once per transform length and thread.
 * 
 * Parameters:
 * - invector: Input GSL vector
@@ -177,34 +268,31 @@ int polyFitLinear (gsl_vector *x_fit, gsl_vector *y_fit, double *a, double *b)
 *****************************************************************************/
 int FFT(gsl_vector *invector,gsl_vector_complex *outvector,double STD)
 {
-	int status=EPOK;
+	const size_t n = invector->size;
+	FFTPlan *plan = getFFTPlan(n,true);
+	if (plan == NULL)
+	{
+		EP_PRINT_ERROR("Cannot allocate the FFT wavetable/workspace",EPFAIL);
+		return(EPFAIL);
+	}
+	double *data = &(plan->data[0]);
 
-	//Declare variables
- 	gsl_fft_complex_workspace * work;
- 	gsl_fft_complex_wavetable * wavetable;
- 	#define REAL(z,i) ((z)[2*(i)])
- 	#define IMAG(z,i) ((z)[2*(i)+1])
- 	double data[2*invector->size];
-
- 	//FFT calculus
- 	work = gsl_fft_complex_workspace_alloc(invector->size);
- 	wavetable = gsl_fft_complex_wavetable_alloc(invector->size);
- 		//In order to work with complex numbers
- 	for (int i=0; i< invector->size; i++) {
- 		REAL(data,i) = gsl_vector_get(invector,i);
- 		IMAG(data,i) = 0.0;
- 	}
- 	gsl_fft_complex_forward(data,1,invector->size,wavetable,work);
- 	for (int i=0; i< invector->size; i++) {
- 		gsl_vector_complex_set(outvector,i,gsl_complex_rect(REAL(data,i),IMAG(data,i)));
- 	}
- 	gsl_vector_complex_scaleIFCA(outvector,gsl_complex_rect(1.0/sqrt(invector->size),0.0)); //Factor 1/sqrt(N), in the FFT expression
- 	gsl_vector_complex_scaleIFCA(outvector,gsl_complex_rect(sqrt(2*STD),0.0));
-
- 	gsl_fft_complex_wavetable_free(wavetable); wavetable = 0;
- 	gsl_fft_complex_workspace_free(work); work = 0;
+	//FFT calculus
+	for (size_t i=0; i<n; i++) data[i] = gsl_vector_get(invector,i);
+	gsl_fft_real_transform(data,1,n,plan->rwavetable,plan->rwork);
 
- 	return EPOK;
+	// Unpack the half-complex result to the complex spectrum
+	double *cdata = &(plan->data[n]);
+	gsl_fft_halfcomplex_unpack(data,cdata,1,n);
+
+	// Factor 1/sqrt(N), in the FFT expression, and sqrt(2*STD)
+	const double scale = sqrt(2*STD)/sqrt(n);
+	for (size_t i=0; i<n; i++)
+	{
+		gsl_vector_complex_set(outvector,i,gsl_complex_rect(cdata[2*i]*scale,cdata[2*i+1]*scale));
+	}
+
+	return EPOK;
 }
 /*xxxx end of SECTION 3 xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx*/
 
@@ -212,6 +300,9 @@ int FFT(gsl_vector *invector,gsl_vector_complex *outvector,double STD)
 /***** SECTION 4 ************************************************************
 * FFTinverse: This function calculates the inverse FFT of the elements of a vector
 * 
+* The input is not required to be Hermitian, so a complex transform is used (the wavetable and workspace are taken
+* from the thread-local cache, see getFFTPlan).
+*
 * Parameters:
 * - invector: Input GSL complex vector
 * - outvector: Output GSL vector with the inverse FFT of invector
@@ -219,27 +310,31 @@ int FFT(gsl_vector *invector,gsl_vector_complex *outvector,double STD)
 *****************************************************************************/
 int FFTinverse(gsl_vector_complex *invector,gsl_vector *outvector,double STD)
 {
-	//Declare variables
-	int status=EPOK;
-	gsl_fft_complex_workspace * work (gsl_fft_complex_workspace_alloc(invector->size));
-	gsl_fft_complex_wavetable * wavetable (gsl_fft_complex_wavetable_alloc(invector->size));
-	std::vector<std::complex<double> >cd (invector->size,std::complex<double> (0, 0));
-	gsl_complex_packed_array cpa (reinterpret_cast<double *>(&cd[0]));
+	const size_t n = invector->size;
+	FFTPlan *plan = getFFTPlan(n,false);
+	if (plan == NULL)
+	{
+		EP_PRINT_ERROR("Cannot allocate the FFT wavetable/workspace",EPFAIL);
+		return(EPFAIL);
+	}
+	double *cdata = &(plan->data[n]);
 
-	for (int i=0;i<invector->size;i++) cd[i]=std::complex<double> (GSL_REAL(gsl_vector_complex_get(invector,i)),GSL_IMAG(gsl_vector_complex_get(invector,i)));
+	for (size_t i=0;i<n;i++)
+	{
+		gsl_complex z = gsl_vector_complex_get(invector,i);
+		cdata[2*i] = GSL_REAL(z);
+		cdata[2*i+1] = GSL_IMAG(z);
+	}
 
 	//Inverse FFT calculus
-	gsl_fft_complex_inverse(cpa,1,invector->size,wavetable,work);
+	gsl_fft_complex_inverse(cdata,1,n,plan->cwavetable,plan->cwork);
 
-	for (int i=0;i<invector->size;i++)
+	// Factor 1/sqrt(N), in the FFT expression, and 1/sqrt(2*STD)
+	const double scale = sqrt(n)/sqrt(2*STD);
+	for (size_t i=0;i<n;i++)
 	{
-		gsl_vector_set(outvector,i,cd[i].real());
+		gsl_vector_set(outvector,i,cdata[2*i]*scale);
 	}
-	gsl_vector_scale(outvector,sqrt(invector->size)); //Factor 1/sqrt(N), in the FFT expression
-	gsl_vector_scale(outvector,1/sqrt(2*STD));
-
-	gsl_fft_complex_wavetable_free(wavetable); wavetable = 0;
-	gsl_fft_complex_workspace_free(work); work = 0;
 
  	return EPOK;
 }
@@ -44,6 +44,8 @@
 	#include <gsl/gsl_blas.h>
 	#include <gsl/gsl_multifit.h>
 	#include <gsl/gsl_fft_complex.h>
+	#include <gsl/gsl_fft_real.h>
+	#include <gsl/gsl_fft_halfcomplex.h>
 	#include <gsl/gsl_complex_math.h>
 	#include <gsl/gsl_sort.h>
 	#include <gsl/gsl_sort_vector.h>
@@ -62,6 +64,7 @@
 	#include <iostream>
 	#include <boost/lexical_cast.hpp>
 	#include <vector>
+	#include <map>
         #include <complex>
 	#include <getopt.h> // For getopt module
 	#include <stdarg.h>
@@ -93,6 +96,27 @@
 	
 	//const int safetyMargin = 50; // In samples
 
+	// Cached wavetables and workspaces of the GSL FFT routines for one transform length
+	struct FFTPlan
+	{
+		size_t n;
+		gsl_fft_real_wavetable *rwavetable;
+		gsl_fft_real_workspace *rwork;
+		gsl_fft_complex_wavetable *cwavetable;
+		gsl_fft_complex_workspace *cwork;
+		// Scratch buffer: n doubles (real data) followed by n complex values
+		std::vector<double> data;
+
+		FFTPlan(size_t size);
+		~FFTPlan();
+
+	private:
+		FFTPlan(const FFTPlan&);
+		FFTPlan& operator=(const FFTPlan&);
+	};
+
+	FFTPlan *getFFTPlan(size_t n, bool real);
+
 	int polyFit (gsl_vector *x_fit, gsl_vector *y_fit, double *a, double *b, double *c);
 	int polyFitLinear (gsl_vector *x_fit, gsl_vector *y_fit, double *a, double *b);
 	int FFT(gsl_vector *invector,gsl_vector_complex *outvector,double STD);
@@ -161,9 +161,11 @@ void processImpactsWithRMF(AdvDet* det,PixImpFile* piximpacfile,TesEventFile* ev
 
 				// Determine the measured detector channel (PI channel) according
 				// to the RMF.
-				// The channel is obtained from the RMF using the corresponding
-				// HEAdas routine which is based on drawing a random number.
-				returnRMFChannel(rmf, impact.totalenergy, &channel); //use total energy here to take pileup into account
+				// The channel is obtained from the cumulative distribution of the
+				// RMF, which is based on drawing a random number.
+				channel=getRMFSamplerChannel(det->pix[impact.pixID].grades[grading_index].rmfsampler,
+						impact.totalenergy, status); //use total energy here to take pileup into account
+				CHECK_STATUS_VOID(*status);
 
 				// Check if the photon is really measured. If the PI channel
 				// returned by the HEAdas RMF function is '-1', the photon is not
@@ -618,8 +620,10 @@ void processGradedEvent(GradeProxy* grade_proxy, const double sample_length,PixI
 				//with the new grade-proxy updated with the xt pileup (part 1)
 				if (is_trigger==0){
 					// Determine the measured detector channel (PI channel) according to the RMF.
-					// The channel is obtained from the RMF using the corresponding HEAdas routine which is based on drawing a random number.
-					returnRMFChannel(rmf, grade_proxy->impact->energy, &channel); //use total energy here to take pileup into account
+					// The channel is obtained from the cumulative distribution of the RMF, which is based on drawing a random number.
+					channel=getRMFSamplerChannel(det->pix[impact_to_save->pixID].grades[grading_index].rmfsampler,
+							grade_proxy->impact->energy, status); //use total energy here to take pileup into account
+					CHECK_STATUS_VOID(*status);
 
 					// Check if the photon is really measured. If the PI channel returned by the HEAdas RMF function is '-1', the photon is not
 					// detected. This should not happen as the rmf is supposedly normalized
@@ -34,6 +34,7 @@ ImpactFile* newImpactFile(int* const status)
 
   // Initialize pointers with NULL.
   file->fptr=NULL;
+  file->buffer=NULL;
 
   // Initialize values.
   file->nrows=0;
@@ -44,6 +45,12 @@ ImpactFile* newImpactFile(int* const status)
   file->cy   =0;
   file->cph_id =0;
   file->csrc_id=0;
+  file->btime  =-1;
+  file->benergy=-1;
+  file->bx     =-1;
+  file->by     =-1;
+  file->bph_id =-1;
+  file->bsrc_id=-1;
 
   return(file);
 }
@@ -52,6 +59,9 @@ ImpactFile* newImpactFile(int* const status)
 void freeImpactFile(ImpactFile** const file, int* const status)
 {
   if (NULL!=*file) {
+    // Write buffered rows to the file.
+    freeFitsBlockBuffer(&(*file)->buffer, status);
+
     if (NULL!=(*file)->fptr) {
       fits_close_file((*file)->fptr, status);
       headas_chat(5, "closed impact list file (containing %ld rows).\n",
@@ -101,6 +111,17 @@ ImpactFile* openImpactFile(const char* const filename,
   fits_get_colnum(file->fptr, CASEINSEN, "SRC_ID", &file->csrc_id, status);
   CHECK_STATUS_RET(*status, file);
 
+  // Set up the buffer for block-wise I/O.
+  file->buffer=newFitsBlockBuffer(file->fptr, status);
+  CHECK_STATUS_RET(*status, file);
+  file->btime  =addFitsBlockColumn(file->buffer, file->ctime, TDOUBLE, 1, status);
+  file->benergy=addFitsBlockColumn(file->buffer, file->cenergy, TFLOAT, 1, status);
+  file->bx     =addFitsBlockColumn(file->buffer, file->cx, TDOUBLE, 1, status);
+  file->by     =addFitsBlockColumn(file->buffer, file->cy, TDOUBLE, 1, status);
+  file->bph_id =addFitsBlockColumn(file->buffer, file->cph_id, TLONG, 1, status);
+  file->bsrc_id=addFitsBlockColumn(file->buffer, file->csrc_id, TLONG, 1, status);
+  CHECK_STATUS_RET(*status, file);
+
   return(file);
 }
 
@@ -197,44 +218,18 @@ void getNextImpactFromFile(ImpactFile* const file, Impact* const impact,
     return;
   }
 
-  // Read in the data.
-  int anynul=0;
-  impact->time=0.;
-  fits_read_col(file->fptr, TDOUBLE, file->ctime, file->row, 1, 1,
-		&impact->time, &impact->time, &anynul, status);
-  CHECK_STATUS_VOID(*status);
-
-  impact->energy = 0.;
-  fits_read_col(file->fptr, TFLOAT, file->cenergy, file->row, 1, 1,
-		&impact->energy, &impact->energy, &anynul, status);
+  // Make sure the row is available in the buffer.
+  FitsBlockBuffer* buf=file->buffer;
+  long idx=readFitsBlockRow(buf, file->row, file->nrows, status);
   CHECK_STATUS_VOID(*status);
 
-  impact->position.x = 0.;
-  fits_read_col(file->fptr, TDOUBLE, file->cx, file->row, 1, 1,
-		&impact->position.x, &impact->position.x, &anynul, status);
-  CHECK_STATUS_VOID(*status);
-
-  impact->position.y = 0.;
-  fits_read_col(file->fptr, TDOUBLE, file->cy, file->row, 1, 1,
-		&impact->position.y, &impact->position.y, &anynul, status);
-  CHECK_STATUS_VOID(*status);
-
-  impact->ph_id = 0;
-  fits_read_col(file->fptr, TLONG, file->cph_id, file->row, 1, 1,
-		&impact->ph_id, &impact->ph_id, &anynul, status);
-  CHECK_STATUS_VOID(*status);
-
-  impact->src_id = 0;
-  fits_read_col(file->fptr, TLONG, file->csrc_id, file->row, 1, 1,
-		&impact->src_id, &impact->src_id, &anynul, status);
-  CHECK_STATUS_VOID(*status);
-
-  // Check if an error occurred during the reading process.
-  if (0!=anynul) {
-    *status=EXIT_FAILURE;
-    SIXT_ERROR("failed reading from impact list file");
-    return;
-  }
+  // Copy the data from the buffer.
+  impact->time      =FITSBLOCK_COL(buf, file->btime, double)[idx];
+  impact->energy    =FITSBLOCK_COL(buf, file->benergy, float)[idx];
+  impact->position.x=FITSBLOCK_COL(buf, file->bx, double)[idx];
+  impact->position.y=FITSBLOCK_COL(buf, file->by, double)[idx];
+  impact->ph_id     =FITSBLOCK_COL(buf, file->bph_id, long)[idx];
+  impact->src_id    =FITSBLOCK_COL(buf, file->bsrc_id, long)[idx];
 
   return;
 }
@@ -247,16 +242,16 @@ void addImpact2File(ImpactFile* const ilf,
   ilf->row++;
   ilf->nrows++;
 
-  fits_write_col(ilf->fptr, TDOUBLE, ilf->ctime,
-		 ilf->row, 1, 1, &impact->time, status);
-  fits_write_col(ilf->fptr, TFLOAT, ilf->cenergy,
-		 ilf->row, 1, 1, &impact->energy, status);
-  fits_write_col(ilf->fptr, TDOUBLE, ilf->cx,
-		 ilf->row, 1, 1, &(impact->position.x), status);
-  fits_write_col(ilf->fptr, TDOUBLE, ilf->cy,
-		 ilf->row, 1, 1, &(impact->position.y), status);
-  fits_write_col(ilf->fptr, TLONG, ilf->cph_id,
-		 ilf->row, 1, 1, &impact->ph_id, status);
-  fits_write_col(ilf->fptr, TLONG, ilf->csrc_id,
-		 ilf->row, 1, 1, &impact->src_id, status);
+  // Store the data in the buffer. The buffer is written to the FITS
+  // file as soon as it is full.
+  FitsBlockBuffer* buf=ilf->buffer;
+  long idx=writeFitsBlockRow(buf, ilf->row, status);
+  CHECK_STATUS_VOID(*status);
+
+  FITSBLOCK_COL(buf, ilf->btime, double)[idx]=impact->time;
+  FITSBLOCK_COL(buf, ilf->benergy, float)[idx]=impact->energy;
+  FITSBLOCK_COL(buf, ilf->bx, double)[idx]=impact->position.x;
+  FITSBLOCK_COL(buf, ilf->by, double)[idx]=impact->position.y;
+  FITSBLOCK_COL(buf, ilf->bph_id, long)[idx]=impact->ph_id;
+  FITSBLOCK_COL(buf, ilf->bsrc_id, long)[idx]=impact->src_id;
 }
@@ -26,6 +26,7 @@
 #include "sixt.h"
 #include "impact.h"
 #include "point.h"
+#include "fitsblockbuffer.h"
 
 
 /////////////////////////////////////////////////////////////////
@@ -48,6 +49,12 @@ typedef struct {
   /** Column numbers in the FITS binary table. */
   int ctime, cenergy, cx, cy, cph_id, csrc_id;
 
+  /** Buffer for block-wise access to the FITS table. */
+  FitsBlockBuffer* buffer;
+
+  /** Column indices within the buffer. */
+  int btime, benergy, bx, by, bph_id, bsrc_id;
+
 } ImpactFile;
 
 
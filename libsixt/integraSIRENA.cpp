@@ -2761,6 +2761,13 @@ int th_get_event_list(TesEventList** test_event, TesRecord** record)
   return 1;
 }
 
+// It sets the file the event lists are written to in THREADING mode
+// (in record order, as soon as the records are reconstructed)
+void th_set_output(TesEventFile* outfile, double delta_t)
+{
+  scheduler::get()->set_output(outfile, delta_t);
+}
+
 // It returns 'true' if THREADING mode
 int is_threading(){
   return scheduler::get()->is_threading();
@@ -567,6 +567,11 @@ extern "C"
 #endif
 int th_get_event_list(TesEventList** test_event, TesRecord** record);
 
+#ifdef __cplusplus
+extern "C"
+#endif
+void th_set_output(TesEventFile* outfile, double delta_t);
+
 #ifdef __cplusplus
 extern "C"
 #endif
@@ -22,153 +22,319 @@
 
 #include "kdtreeelement.h"
 
+#include <sys/mman.h>
 
-KDTreeElement* newKDTreeElement(int* const status)
+
+/** Return the component of the vector along the given axis. */
+static inline double getKDTreeAxisValue(const Vector* const v,
+					const int axis)
 {
-  KDTreeElement* el = (KDTreeElement*)malloc(sizeof(KDTreeElement));
-  CHECK_NULL(el, *status,
-	     "memory allocation for KDTreeElement failed");
+  switch (axis) {
+  case 0:  return(v->x);
+  case 1:  return(v->y);
+  default: return(v->z);
+  }
+}
 
-  // Initalize pointers with NULL.
-  el->src   = NULL;
-  el->left  = NULL;
-  el->right = NULL;
 
-  // Get memory for the content.
-  el->src = newSource(status);
-  CHECK_STATUS_RET(*status, el);
+/** Ordering of the nodes along the given axis. Nodes with the same
+    coordinate are ordered by their row number in the catalog, such
+    that the tree does not depend on the order of the input list. */
+static inline int precedesKDTreeNode(const KDTreeNode* const a,
+				     const KDTreeNode* const b,
+				     const int axis)
+{
+  double va=getKDTreeAxisValue(&a->location, axis);
+  double vb=getKDTreeAxisValue(&b->location, axis);
+  return((va<vb)||((va==vb)&&(a->row<b->row)));
+}
+
 
-  return(el);
+static inline void swapKDTreeNodes(KDTreeNode* const a, KDTreeNode* const b)
+{
+  KDTreeNode buffer=*a;
+  *a=*b;
+  *b=buffer;
 }
 
 
-void freeKDTreeElement(KDTreeElement** el)
+/** Rearrange the nodes in the index range [left,right] such that the
+    node with rank k (with respect to the given axis) is located at
+    the index k, all preceding nodes at lower and all other nodes at
+    higher indices (quickselect). */
+static void selectKDTreeNodes(KDTreeNode* const nodes,
+			      long left, long right,
+			      const long k, const int axis)
 {
-  if (NULL!=*el) {
-    if (NULL!=(*el)->left) {
-      freeKDTreeElement(&((*el)->left));
+  while (right>left) {
+    // Use the median of the first, the middle, and the last node as
+    // pivot and move it to the end.
+    long mid=left+(right-left)/2;
+    if (precedesKDTreeNode(&nodes[mid], &nodes[left], axis)) {
+      swapKDTreeNodes(&nodes[mid], &nodes[left]);
+    }
+    if (precedesKDTreeNode(&nodes[right], &nodes[left], axis)) {
+      swapKDTreeNodes(&nodes[right], &nodes[left]);
+    }
+    if (precedesKDTreeNode(&nodes[mid], &nodes[right], axis)) {
+      swapKDTreeNodes(&nodes[mid], &nodes[right]);
     }
-    if (NULL!=(*el)->right) {
-      freeKDTreeElement(&((*el)->right));
+    KDTreeNode pivot=nodes[right];
+
+    // Partition the nodes.
+    long store=left;
+    long ii;
+    for (ii=left; ii<right; ii++) {
+      if (precedesKDTreeNode(&nodes[ii], &pivot, axis)) {
+	swapKDTreeNodes(&nodes[ii], &nodes[store]);
+	store++;
+      }
     }
-    freeSource(&(*el)->src);
+    swapKDTreeNodes(&nodes[store], &nodes[right]);
+
+    // Continue with the part containing the rank k.
+    if (k==store) {
+      return;
+    } else if (k<store) {
+      right=store-1;
+    } else {
+      left=store+1;
+    }
+  }
+}
+
 
-    free(*el);
-    *el=NULL;
+/** Return the Source object belonging to the specified node. The
+    object is initialized on first use. */
+static Source* getKDTreeSource(KDTree* const tree, const long index)
+{
+  Source* src=&(tree->src[index]);
+  if (0==src->row) {
+    src->ra =tree->nodes[index].ra;
+    src->dec=tree->nodes[index].dec;
+    src->row=tree->nodes[index].row;
   }
+  return(src);
 }
 
 
-KDTreeElement* buildKDTree2(Source* const list,
-			    const long nelements,
-			    const int depth,
-			    int* const status)
+/** Allocate the array of Source objects for a tree with the given
+    nodes. */
+static KDTree* newKDTree(KDTreeNode* const nodes,
+			 const long nnodes,
+			 int* const status)
 {
-  if (0==nelements) return(NULL);
+  KDTree* tree=(KDTree*)malloc(sizeof(KDTree));
+  CHECK_NULL(tree, *status, "memory allocation for KDTree failed");
 
-  // Get a new empty node.
-  KDTreeElement* node=newKDTreeElement(status);
-  CHECK_STATUS_RET(*status, node);
+  tree->nodes  =nodes;
+  tree->nnodes =nnodes;
+  tree->map    =NULL;
+  tree->mapsize=0;
 
-  // Check if there is only one element in the source list.
-  if (1==nelements) {
-    *(node->src)=list[0];
-    return(node);
-  }
+  // The Source objects are initialized with zeros, i.e., the memory
+  // pages are only touched for sources that are actually used.
+  tree->src=(Source*)calloc(MAX(nnodes, 1), sizeof(Source));
+  CHECK_NULL(tree->src, *status, "memory allocation for KDTree failed");
 
-  long median=nelements/2;
-  int axis=depth % 3;
-  quicksortSources(list, 0, nelements-1, axis);
+  return(tree);
+}
 
-  // Fill the newly created node with data.
-  *(node->src)=list[median];
 
-  // Set right and left pointers of node.
-  if (median>0) {
-    node->left=buildKDTree2(list, median, depth+1, status);
+KDTree* buildKDTree(const Source* const list,
+		    const long nelements,
+		    int* const status)
+{
+  KDTreeNode* nodes=(KDTreeNode*)malloc(MAX(nelements, 1)*sizeof(KDTreeNode));
+  CHECK_NULL(nodes, *status, "memory allocation for KDTree failed");
+
+  // Determine the unit vectors of all source positions once.
+  long ii;
+  for (ii=0; ii<nelements; ii++) {
+    nodes[ii].location=unit_vector(list[ii].ra, list[ii].dec);
+    nodes[ii].ra =list[ii].ra;
+    nodes[ii].dec=list[ii].dec;
+    nodes[ii].row=list[ii].row;
   }
 
-  if (median<nelements-1) {
-    node->right=buildKDTree2(&list[median+1],
-			     nelements-median-1,
-			     depth+1, status);
+  KDTree* tree=newKDTree(nodes, nelements, status);
+  if (EXIT_SUCCESS!=*status) {
+    free(nodes);
+    return(tree);
+  }
+
+  // Select the median of each sub-tree. The pending sub-trees are
+  // stored on a stack.
+  struct {
+    long lo, hi;
+    int depth;
+  } stack[2*KDTREE_MAXDEPTH];
+  int nstack=0;
+  if (nelements>1) {
+    stack[nstack].lo=0;
+    stack[nstack].hi=nelements;
+    stack[nstack].depth=0;
+    nstack++;
+  }
+  while (nstack>0) {
+    nstack--;
+    long lo=stack[nstack].lo;
+    long hi=stack[nstack].hi;
+    int depth=stack[nstack].depth;
+
+    long median=lo+(hi-lo)/2;
+    selectKDTreeNodes(nodes, lo, hi-1, median, depth % 3);
+
+    // Continue with the sub-trees containing more than one node.
+    if (median-lo>1) {
+      stack[nstack].lo=lo;
+      stack[nstack].hi=median;
+      stack[nstack].depth=depth+1;
+      nstack++;
+    }
+    if (hi-median-1>1) {
+      stack[nstack].lo=median+1;
+      stack[nstack].hi=hi;
+      stack[nstack].depth=depth+1;
+      nstack++;
+    }
   }
 
-  return(node);
+  return(tree);
 }
 
 
-LinkedPhoListElement* KDTreeRangeSearch(KDTreeElement* const node,
-					const int depth,
-					const Vector* const ref,
-					const double min_align,
-					const double t0, const double t1,
-					const double mjdref,
-					SimputCtlg* const simputcat,
-					int* const status)
+KDTree* mapKDTree(void* const map,
+		  const size_t mapsize,
+		  KDTreeNode* const nodes,
+		  const long nnodes,
+		  int* const status)
 {
-  // Check if the kd-Tree exists.
-  if (NULL==node) return(NULL);
+  KDTree* tree=newKDTree(nodes, nnodes, status);
+  CHECK_STATUS_RET(*status, tree);
 
-  LinkedPhoListElement* list=NULL;
+  tree->map    =map;
+  tree->mapsize=mapsize;
 
-  // Check if the current node lies within the search radius.
-  Vector location=unit_vector(node->src->ra, node->src->dec);
-  if (0==check_fov(&location, ref, min_align)) {
-    // Generate photons for this particular source.
-    list=getXRayPhotons(node->src, simputcat, t0, t1, mjdref, status);
-    CHECK_STATUS_RET(*status, list);
-  }
+  return(tree);
+}
 
-  // Check if we are at a leaf.
-  if ((NULL==node->left) && (NULL==node->right)) {
-    return(list);
-  }
 
-  int axis=depth % 3;
-
-  // Check which branch to search first.
-  KDTreeElement* near;
-  KDTreeElement* far;
-  double distance2edge=
-    getVectorDimensionValue(ref, axis)-getVectorDimensionValue(&location, axis);
-  if (distance2edge < 0.) {
-    near = node->left;
-    far  = node->right;
-  } else {
-    far  = node->left;
-    near = node->right;
+void freeKDTree(KDTree** const tree)
+{
+  if (NULL!=*tree) {
+    if (NULL!=(*tree)->src) {
+      long ii;
+      for (ii=0; ii<(*tree)->nnodes; ii++) {
+	if (NULL!=(*tree)->src[ii].t_next_photon) {
+	  free((*tree)->src[ii].t_next_photon);
+	}
+      }
+      free((*tree)->src);
+    }
+    if (NULL!=(*tree)->map) {
+      munmap((*tree)->map, (*tree)->mapsize);
+    } else if (NULL!=(*tree)->nodes) {
+      free((*tree)->nodes);
+    }
+    free(*tree);
+    *tree=NULL;
   }
+}
 
-  // Descend into near tree if it exists, and then check
-  // against current node.
-  if (NULL!=near) {
-    LinkedPhoListElement* near_list=
-      KDTreeRangeSearch(near, depth+1, ref, min_align,
-			t0, t1, mjdref, simputcat, status);
 
-    // Merge the new photons into the existing list.
-    list=mergeLinkedPhoLists(list, near_list);
-  }
-  // END of (NULL!=near)
-
-  // Check whether we have to look into the far tree.
-  // A search is only necessary if the minimum distance
-  // of the reference point is such that we can have an
-  // overlap there.
-  if (NULL!=far) {
-    if (cos(distance2edge) > min_align) {
-      // Move to the end of the linked list.
-      // Append newly found entries.
-      LinkedPhoListElement* far_list =
-	KDTreeRangeSearch(far, depth+1, ref, min_align,
-			  t0, t1, mjdref, simputcat, status);
-
-      // Merge the new photons into the existing list.
-      list = mergeLinkedPhoLists(list, far_list);
+void saveKDTree(const KDTree* const tree, FILE* const file,
+		int* const status)
+{
+  if (tree->nnodes>0) {
+    if (fwrite(tree->nodes, sizeof(KDTreeNode), tree->nnodes, file)!=
+	(size_t)tree->nnodes) {
+      *status=EXIT_FAILURE;
+      SIXT_ERROR("writing KDTree failed");
     }
   }
-  // END of (NULL!=far)
+}
 
-  return(list);
+
+void KDTreeRangeSearch(KDTree* const tree,
+		       const Vector* const ref,
+		       const double min_align,
+		       const double t0, const double t1,
+		       const double mjdref,
+		       SimputCtlg* const simputcat,
+		       PhotonBuffer* const buf,
+		       int* const status)
+{
+  // Check if the kd-Tree exists.
+  if ((NULL==tree)||(0==tree->nnodes)) return;
+
+  // Sub-trees that still have to be searched. The near branch is
+  // always put on top of the far branch, such that the sources are
+  // visited in the same order as with a recursive search.
+  struct {
+    long lo, hi;
+    int depth;
+  } stack[2*KDTREE_MAXDEPTH];
+  int nstack=0;
+  stack[nstack].lo=0;
+  stack[nstack].hi=tree->nnodes;
+  stack[nstack].depth=0;
+  nstack++;
+
+  while (nstack>0) {
+    nstack--;
+    long lo=stack[nstack].lo;
+    long hi=stack[nstack].hi;
+    int depth=stack[nstack].depth;
+    long median=lo+(hi-lo)/2;
+    const KDTreeNode* node=&(tree->nodes[median]);
+
+    // Check if the current node lies within the search radius.
+    if (0==check_fov(&node->location, ref, min_align)) {
+      // Generate photons for this particular source.
+      getXRayPhotons(getKDTreeSource(tree, median), simputcat,
+		     t0, t1, mjdref, buf, status);
+      CHECK_STATUS_VOID(*status);
+    }
+
+    // Check if we are at a leaf.
+    if (hi-lo==1) continue;
+
+    int axis=depth % 3;
+
+    // Check which branch to search first.
+    long near_lo, near_hi, far_lo, far_hi;
+    double distance2edge=
+      getKDTreeAxisValue(ref, axis)-getKDTreeAxisValue(&node->location, axis);
+    if (distance2edge < 0.) {
+      near_lo=lo;
+      near_hi=median;
+      far_lo =median+1;
+      far_hi =hi;
+    } else {
+      far_lo =lo;
+      far_hi =median;
+      near_lo=median+1;
+      near_hi=hi;
+    }
+
+    // Check whether we have to look into the far tree.
+    // A search is only necessary if the minimum distance
+    // of the reference point is such that we can have an
+    // overlap there.
+    if ((far_hi>far_lo)&&(cos(distance2edge) > min_align)) {
+      stack[nstack].lo=far_lo;
+      stack[nstack].hi=far_hi;
+      stack[nstack].depth=depth+1;
+      nstack++;
+    }
+
+    // Descend into near tree if it exists.
+    if (near_hi>near_lo) {
+      stack[nstack].lo=near_lo;
+      stack[nstack].hi=near_hi;
+      stack[nstack].depth=depth+1;
+      nstack++;
+    }
+  }
 }
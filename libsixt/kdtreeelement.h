@@ -26,21 +26,62 @@
 #include "sixt.h"
 #include "check_fov.h"
 #include "simput.h"
+#include "photonbuffer.h"
 #include "source.h"
 
 
+/////////////////////////////////////////////////////////////////
+// Constants.
+/////////////////////////////////////////////////////////////////
+
+
+/** Maximum depth of the KDTree. As the tree is balanced, this
+    value is sufficient for any number of sources. */
+#define KDTREE_MAXDEPTH (64)
+
+
 /////////////////////////////////////////////////////////////////
 // Type Declarations.
 /////////////////////////////////////////////////////////////////
 
 
-/** Element of a KDTree (multidimensional binary tree). */
-struct structKDTreeElement {
+/** Node of a KDTree (multidimensional binary tree). The node only
+    contains the position of the source, such that the array of
+    nodes can be stored in a file and memory-mapped later on. */
+typedef struct {
+  /** Unit vector pointing to the source position. */
+  Vector location;
+
+  /** Coordinates of source position [rad]. */
+  double ra, dec;
+
+  /** Row number of the source in the SimputCtlg. */
+  long row;
+
+} KDTreeNode;
+
+
+/** Balanced KDTree stored in a contiguous array. The root of the
+    sub-tree covering the index range [lo,hi) is located at the index
+    lo+(hi-lo)/2. The nodes with lower indices form the left, the
+    nodes with higher indices the right sub-tree. The splitting axis
+    is given by the depth of the node modulo 3. */
+typedef struct {
+  /** Array of nodes. */
+  KDTreeNode* nodes;
+  long nnodes;
+
+  /** Source objects corresponding to the nodes, containing the
+      state of the photon generation. The entries are initialized
+      when the source is used for the first time (row>0). */
   Source* src;
-  struct structKDTreeElement* left;
-  struct structKDTreeElement* right;
-};
-typedef struct structKDTreeElement KDTreeElement;
+
+  /** Memory mapping containing the array of nodes. If the value is
+      NULL, the nodes have been allocated on the heap. */
+  void* map;
+  size_t mapsize;
+
+} KDTree;
 
 
 /////////////////////////////////////////////////////////////////
@@ -48,32 +89,44 @@ typedef struct structKDTreeElement KDTreeElement;
 /////////////////////////////////////////////////////////////////
 
 
-/** Constructor. */
-KDTreeElement* newKDTreeElement(int* const status);
+/** Build up the KDTree from the given list of Sources. The median
+    of each sub-tree is determined by a selection algorithm on the
+    precomputed unit vectors, i.e., the tree is built in O(n log
+    n). */
+KDTree* buildKDTree(const Source* const list,
+		    const long nelements,
+		    int* const status);
+
+/** Create a KDTree from an array of nodes contained in a memory
+    mapping (e.g., as stored with saveKDTree()). The mapping is
+    released by the destructor. */
+KDTree* mapKDTree(void* const map,
+		  const size_t mapsize,
+		  KDTreeNode* const nodes,
+		  const long nnodes,
+		  int* const status);
 
 /** Destructor. */
-void freeKDTreeElement(KDTreeElement** el);
+void freeKDTree(KDTree** const tree);
 
-/** Build up the KDTree from the given list of Sources. */
-KDTreeElement* buildKDTree2(Source* const list,
-			    const long nelements,
-			    const int depth,
-			    int* const status);
+/** Write the array of nodes to the given file. */
+void saveKDTree(const KDTree* const tree, FILE* const file,
+		int* const status);
 
 /** Perform a range search on the given kdTree, i.e., return all X-ray
     sources lying within a certain radius around the reference
     point. This region is defined by the minimum cosine value for the
     scalar product of the source direction and the reference
-    vector. The function returns a time-ordered list of newly
-    generated photons. */
-LinkedPhoListElement* KDTreeRangeSearch(KDTreeElement* const node,
-					const int depth,
-					const Vector* const ref,
-					const double min_align,
-					const double t0, const double t1,
-					const double mjdref,
-					SimputCtlg* const simputcat,
-					int* const status);
+    vector. The newly generated photons are appended to the
+    PhotonBuffer (one chunk per source). */
+void KDTreeRangeSearch(KDTree* const tree,
+		       const Vector* const ref,
+		       const double min_align,
+		       const double t0, const double t1,
+		       const double mjdref,
+		       SimputCtlg* const simputcat,
+		       PhotonBuffer* const buf,
+		       int* const status);
 
 
 #endif /* KDTREEELEMENT_H */
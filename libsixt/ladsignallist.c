@@ -47,3 +47,447 @@ void freeLADSignalList(LADSignalListItem** const list)
     *list=NULL;
   }
 }
+
+
+/** Check whether the signal in slot a of the LADSignalBuffer precedes
+    the signal in slot b. */
+static inline int precedesLADSignalBuffer(const LADSignalBuffer* const buf,
+					  const long a, const long b)
+{
+  double ta=buf->signals[a].time;
+  double tb=buf->signals[b].time;
+  if (ta<tb) return(1);
+  if (ta>tb) return(0);
+  return(buf->seq[a]<buf->seq[b]);
+}
+
+
+/** Hash value of the anode for the LADSignalCache. The return value
+    is in the range [0,nslots), where nslots has to be a power of
+    2. */
+static inline long hashLADSignalCache(const long panel,
+				      const long module,
+				      const long element,
+				      const long anode,
+				      const long nslots)
+{
+  unsigned long h=(unsigned long)panel;
+  h=h*1000003UL+(unsigned long)module;
+  h=h*1000003UL+(unsigned long)element;
+  h=h*1000003UL+(unsigned long)anode;
+  h^=h>>29;
+  h*=0x9E3779B97F4A7C15UL;
+  h^=h>>32;
+  return((long)(h&(unsigned long)(nslots-1)));
+}
+
+
+/** Append the entry to the end of its chain of the hash table. */
+static inline void linkLADSignalCacheSlot(LADSignalCache* const cache,
+					  const long ii)
+{
+  LADSignalCacheItem* item=&(cache->items[ii]);
+  item->hslot=hashLADSignalCache(item->signal.panel, item->signal.module,
+				 item->signal.element, item->signal.anode,
+				 cache->nslots);
+  item->hnext=-1;
+  if (cache->hlast[item->hslot]<0) {
+    cache->hfirst[item->hslot]=ii;
+  } else {
+    cache->items[cache->hlast[item->hslot]].hnext=ii;
+  }
+  cache->hlast[item->hslot]=ii;
+}
+
+
+/** Re-build the hash table with the specified number of chains. The
+    entries are inserted in insertion order, such that the order
+    within each chain is preserved. */
+static void rehashLADSignalCache(LADSignalCache* const cache,
+				 const long nslots,
+				 int* const status)
+{
+  long* hfirst=(long*)realloc(cache->hfirst, nslots*sizeof(long));
+  CHECK_NULL_VOID(hfirst, *status,
+		  "memory allocation for LADSignalCache failed");
+  cache->hfirst=hfirst;
+  long* hlast=(long*)realloc(cache->hlast, nslots*sizeof(long));
+  CHECK_NULL_VOID(hlast, *status,
+		  "memory allocation for LADSignalCache failed");
+  cache->hlast=hlast;
+  cache->nslots=nslots;
+
+  long ii;
+  for (ii=0; ii<nslots; ii++) {
+    cache->hfirst[ii]=-1;
+    cache->hlast[ii] =-1;
+  }
+  for (ii=cache->first; ii>=0; ii=cache->items[ii].next) {
+    linkLADSignalCacheSlot(cache, ii);
+  }
+}
+
+
+/** Return the first entry in the cache on the specified anode, or
+    -1 if there is none. */
+static inline long findLADSignalCacheAnode(const LADSignalCache* const cache,
+					   const long panel,
+					   const long module,
+					   const long element,
+					   const long anode)
+{
+  long ii=cache->hfirst[hashLADSignalCache(panel, module, element, anode,
+					   cache->nslots)];
+  for (; ii>=0; ii=cache->items[ii].hnext) {
+    const LADSignal* signal=&(cache->items[ii].signal);
+    if ((signal->anode==anode)&&(signal->element==element)&&
+	(signal->module==module)&&(signal->panel==panel)) {
+      return(ii);
+    }
+  }
+  return(-1);
+}
+
+
+LADSignalBuffer* newLADSignalBuffer(int* const status)
+{
+  LADSignalBuffer* buf=(LADSignalBuffer*)malloc(sizeof(LADSignalBuffer));
+  CHECK_NULL_RET(buf, *status, "memory allocation for LADSignalBuffer failed",
+		 buf);
+
+  // Initialize pointers with NULL.
+  buf->signals  =NULL;
+  buf->seq      =NULL;
+  buf->freeslots=NULL;
+  buf->heap     =NULL;
+
+  // Initialize values.
+  buf->maxsignals=0;
+  buf->nfree     =0;
+  buf->nheap     =0;
+  buf->nextseq   =0;
+
+  // Allocate the pool.
+  buf->signals=(LADSignal*)malloc(LADSIGNALLIST_INITSIZE*sizeof(LADSignal));
+  CHECK_NULL_RET(buf->signals, *status,
+		 "memory allocation for LADSignalBuffer failed", buf);
+  buf->seq=(long*)malloc(LADSIGNALLIST_INITSIZE*sizeof(long));
+  CHECK_NULL_RET(buf->seq, *status,
+		 "memory allocation for LADSignalBuffer failed", buf);
+  buf->freeslots=(long*)malloc(LADSIGNALLIST_INITSIZE*sizeof(long));
+  CHECK_NULL_RET(buf->freeslots, *status,
+		 "memory allocation for LADSignalBuffer failed", buf);
+  buf->heap=(long*)malloc(LADSIGNALLIST_INITSIZE*sizeof(long));
+  CHECK_NULL_RET(buf->heap, *status,
+		 "memory allocation for LADSignalBuffer failed", buf);
+  buf->maxsignals=LADSIGNALLIST_INITSIZE;
+
+  // All slots are unused. They are taken in ascending order.
+  long ii;
+  for (ii=0; ii<buf->maxsignals; ii++) {
+    buf->freeslots[ii]=buf->maxsignals-1-ii;
+  }
+  buf->nfree=buf->maxsignals;
+
+  return(buf);
+}
+
+
+void freeLADSignalBuffer(LADSignalBuffer** const buf)
+{
+  if (NULL!=*buf) {
+    if (NULL!=(*buf)->signals) {
+      free((*buf)->signals);
+    }
+    if (NULL!=(*buf)->seq) {
+      free((*buf)->seq);
+    }
+    if (NULL!=(*buf)->freeslots) {
+      free((*buf)->freeslots);
+    }
+    if (NULL!=(*buf)->heap) {
+      free((*buf)->heap);
+    }
+    free(*buf);
+    *buf=NULL;
+  }
+}
+
+
+void insertLADSignalBuffer(LADSignalBuffer* const buf,
+			   const LADSignal* const signal,
+			   int* const status)
+{
+  // Enlarge the pool if necessary.
+  if (0==buf->nfree) {
+    long maxsignals=2*buf->maxsignals;
+    LADSignal* signals=
+      (LADSignal*)realloc(buf->signals, maxsignals*sizeof(LADSignal));
+    CHECK_NULL_VOID(signals, *status,
+		    "memory allocation for LADSignalBuffer failed");
+    buf->signals=signals;
+    long* seq=(long*)realloc(buf->seq, maxsignals*sizeof(long));
+    CHECK_NULL_VOID(seq, *status,
+		    "memory allocation for LADSignalBuffer failed");
+    buf->seq=seq;
+    long* freeslots=(long*)realloc(buf->freeslots, maxsignals*sizeof(long));
+    CHECK_NULL_VOID(freeslots, *status,
+		    "memory allocation for LADSignalBuffer failed");
+    buf->freeslots=freeslots;
+    long* heap=(long*)realloc(buf->heap, maxsignals*sizeof(long));
+    CHECK_NULL_VOID(heap, *status,
+		    "memory allocation for LADSignalBuffer failed");
+    buf->heap=heap;
+
+    long ii;
+    for (ii=0; ii<maxsignals-buf->maxsignals; ii++) {
+      buf->freeslots[ii]=maxsignals-1-ii;
+    }
+    buf->nfree=maxsignals-buf->maxsignals;
+    buf->maxsignals=maxsignals;
+  }
+
+  // Store the signal in an unused slot.
+  long slot=buf->freeslots[--buf->nfree];
+  copyLADSignal(&(buf->signals[slot]), signal);
+  buf->seq[slot]=buf->nextseq++;
+
+  // Move the slot up in the heap.
+  long pos=buf->nheap++;
+  while (pos>0) {
+    long parent=(pos-1)/2;
+    if (!precedesLADSignalBuffer(buf, slot, buf->heap[parent])) break;
+    buf->heap[pos]=buf->heap[parent];
+    pos=parent;
+  }
+  buf->heap[pos]=slot;
+}
+
+
+LADSignal* getLADSignalBufferFirst(const LADSignalBuffer* const buf)
+{
+  if (0==buf->nheap) {
+    return(NULL);
+  }
+  return(&(buf->signals[buf->heap[0]]));
+}
+
+
+void removeLADSignalBufferFirst(LADSignalBuffer* const buf)
+{
+  if (0==buf->nheap) return;
+
+  // Release the slot.
+  buf->freeslots[buf->nfree++]=buf->heap[0];
+
+  // Move the last slot in the heap down from the top.
+  long slot=buf->heap[--buf->nheap];
+  long pos=0;
+  while (1) {
+    long child=2*pos+1;
+    if (child>=buf->nheap) break;
+    if ((child+1<buf->nheap)&&
+	(precedesLADSignalBuffer(buf, buf->heap[child+1], buf->heap[child]))) {
+      child++;
+    }
+    if (!precedesLADSignalBuffer(buf, buf->heap[child], slot)) break;
+    buf->heap[pos]=buf->heap[child];
+    pos=child;
+  }
+  if (buf->nheap>0) {
+    buf->heap[pos]=slot;
+  }
+}
+
+
+LADSignalCache* newLADSignalCache(int* const status)
+{
+  LADSignalCache* cache=(LADSignalCache*)malloc(sizeof(LADSignalCache));
+  CHECK_NULL_RET(cache, *status, "memory allocation for LADSignalCache failed",
+		 cache);
+
+  // Initialize pointers with NULL.
+  cache->items    =NULL;
+  cache->freeitems=NULL;
+  cache->hfirst   =NULL;
+  cache->hlast    =NULL;
+
+  // Initialize values.
+  cache->maxitems=0;
+  cache->nfree   =0;
+  cache->first   =-1;
+  cache->last    =-1;
+  cache->nsignals=0;
+  cache->nslots  =0;
+  cache->nextseq =0;
+
+  // Allocate the pool.
+  cache->items=(LADSignalCacheItem*)
+    malloc(LADSIGNALLIST_INITSIZE*sizeof(LADSignalCacheItem));
+  CHECK_NULL_RET(cache->items, *status,
+		 "memory allocation for LADSignalCache failed", cache);
+  cache->freeitems=(long*)malloc(LADSIGNALLIST_INITSIZE*sizeof(long));
+  CHECK_NULL_RET(cache->freeitems, *status,
+		 "memory allocation for LADSignalCache failed", cache);
+  cache->maxitems=LADSIGNALLIST_INITSIZE;
+
+  long ii;
+  for (ii=0; ii<cache->maxitems; ii++) {
+    cache->freeitems[ii]=cache->maxitems-1-ii;
+  }
+  cache->nfree=cache->maxitems;
+
+  // The hash table has as many chains as the pool has entries.
+  rehashLADSignalCache(cache, cache->maxitems, status);
+
+  return(cache);
+}
+
+
+void freeLADSignalCache(LADSignalCache** const cache)
+{
+  if (NULL!=*cache) {
+    if (NULL!=(*cache)->items) {
+      free((*cache)->items);
+    }
+    if (NULL!=(*cache)->freeitems) {
+      free((*cache)->freeitems);
+    }
+    if (NULL!=(*cache)->hfirst) {
+      free((*cache)->hfirst);
+    }
+    if (NULL!=(*cache)->hlast) {
+      free((*cache)->hlast);
+    }
+    free(*cache);
+    *cache=NULL;
+  }
+}
+
+
+void appendLADSignalCache(LADSignalCache* const cache,
+			  const LADSignal* const signal,
+			  int* const status)
+{
+  // Enlarge the pool and the hash table if necessary.
+  if (0==cache->nfree) {
+    long maxitems=2*cache->maxitems;
+    LADSignalCacheItem* items=(LADSignalCacheItem*)
+      realloc(cache->items, maxitems*sizeof(LADSignalCacheItem));
+    CHECK_NULL_VOID(items, *status,
+		    "memory allocation for LADSignalCache failed");
+    cache->items=items;
+    long* freeitems=(long*)realloc(cache->freeitems, maxitems*sizeof(long));
+    CHECK_NULL_VOID(freeitems, *status,
+		    "memory allocation for LADSignalCache failed");
+    cache->freeitems=freeitems;
+
+    long ii;
+    for (ii=0; ii<maxitems-cache->maxitems; ii++) {
+      cache->freeitems[ii]=maxitems-1-ii;
+    }
+    cache->nfree=maxitems-cache->maxitems;
+    cache->maxitems=maxitems;
+
+    rehashLADSignalCache(cache, maxitems, status);
+    CHECK_STATUS_VOID(*status);
+  }
+
+  // Append the signal to the end of the list.
+  long ii=cache->freeitems[--cache->nfree];
+  LADSignalCacheItem* item=&(cache->items[ii]);
+  copyLADSignal(&(item->signal), signal);
+  item->seq =cache->nextseq++;
+  item->prev=cache->last;
+  item->next=-1;
+  if (cache->last<0) {
+    cache->first=ii;
+  } else {
+    cache->items[cache->last].next=ii;
+  }
+  cache->last=ii;
+  cache->nsignals++;
+
+  linkLADSignalCacheSlot(cache, ii);
+}
+
+
+LADSignal* getLADSignalCacheFirst(const LADSignalCache* const cache)
+{
+  if (cache->first<0) {
+    return(NULL);
+  }
+  return(&(cache->items[cache->first].signal));
+}
+
+
+void removeLADSignalCache(LADSignalCache* const cache,
+			  LADSignal* const signal)
+{
+  long ii=(long)((LADSignalCacheItem*)signal-cache->items);
+  LADSignalCacheItem* item=&(cache->items[ii]);
+
+  // Remove the entry from the list.
+  if (item->prev<0) {
+    cache->first=item->next;
+  } else {
+    cache->items[item->prev].next=item->next;
+  }
+  if (item->next<0) {
+    cache->last=item->prev;
+  } else {
+    cache->items[item->next].prev=item->prev;
+  }
+
+  // Remove the entry from its chain of the hash table.
+  long prev=-1;
+  long jj=cache->hfirst[item->hslot];
+  while (jj!=ii) {
+    prev=jj;
+    jj=cache->items[jj].hnext;
+  }
+  if (prev<0) {
+    cache->hfirst[item->hslot]=item->hnext;
+  } else {
+    cache->items[prev].hnext=item->hnext;
+  }
+  if (cache->hlast[item->hslot]==ii) {
+    cache->hlast[item->hslot]=prev;
+  }
+
+  // Release the entry.
+  cache->freeitems[cache->nfree++]=ii;
+  cache->nsignals--;
+}
+
+
+LADSignal* findLADSignalCacheNeighbour(const LADSignalCache* const cache,
+				       const long panel,
+				       const long module,
+				       const long element,
+				       const long* const anodes,
+				       const long nanodes,
+				       const long anode_min,
+				       const long anode_max)
+{
+  // Among the first signals on the anodes adjacent to the given ones,
+  // select the one that has been appended first.
+  long found=-1;
+  long ii;
+  for (ii=0; ii<nanodes; ii++) {
+    long neighbour;
+    for (neighbour=anodes[ii]-1; neighbour<=anodes[ii]+1; neighbour+=2) {
+      if ((neighbour<anode_min)||(neighbour>=anode_max)) continue;
+      long jj=findLADSignalCacheAnode(cache, panel, module, element,
+				      neighbour);
+      if ((jj>=0)&&((found<0)||(cache->items[jj].seq<cache->items[found].seq))) {
+	found=jj;
+      }
+    }
+  }
+
+  if (found<0) {
+    return(NULL);
+  }
+  return(&(cache->items[found].signal));
+}
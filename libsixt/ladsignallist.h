@@ -27,6 +27,17 @@
 #include "ladsignal.h"
 
 
+/////////////////////////////////////////////////////////////////
+// Constants.
+/////////////////////////////////////////////////////////////////
+
+
+/** Initial number of signals the LADSignalBuffer and the
+    LADSignalCache can hold. The arrays are enlarged by a factor of 2
+    whenever they are full. */
+#define LADSIGNALLIST_INITSIZE (1024)
+
+
 /////////////////////////////////////////////////////////////////
 // Type Declarations.
 /////////////////////////////////////////////////////////////////
@@ -42,6 +53,90 @@ struct structLADSignalListItem {
 typedef struct structLADSignalListItem LADSignalListItem;
 
 
+/** Time-ordered buffer of LADSignals. The signals are stored in a
+    pool of slots, which are re-used after the signals have been
+    removed, and are sorted with a binary min-heap. Signals with the
+    same time are returned in the order in which they have been
+    inserted, i.e., the order is the same as for the insertion into a
+    time-ordered linked list behind all signals with the same time. */
+typedef struct {
+  /** Pool of signal slots. */
+  LADSignal* signals;
+
+  /** Insertion number of the signal in the respective slot. */
+  long* seq;
+  long maxsignals;
+
+  /** Stack of unused slots. */
+  long* freeslots;
+  long nfree;
+
+  /** Binary min-heap of the occupied slots, ordered by the time and
+      the insertion number of the signals. */
+  long* heap;
+  long nheap;
+
+  /** Insertion number of the next signal. */
+  long nextseq;
+
+} LADSignalBuffer;
+
+
+/** Entry of the LADSignalCache. */
+typedef struct {
+  LADSignal signal;
+
+  /** Insertion number of the signal. */
+  long seq;
+
+  /** Previous and next entry in insertion order. -1 if there is
+      none. */
+  long prev, next;
+
+  /** Next entry in the same chain of the hash table. -1 if there is
+      none. */
+  long hnext;
+
+  /** Index of the chain of the hash table. */
+  long hslot;
+
+} LADSignalCacheItem;
+
+
+/** Cache of LADSignals that are waiting to be recombined to
+    events. The signals are kept in insertion order. Additionally they
+    are indexed with a hash table over the panel, module, element, and
+    anode, such that the signals on a particular anode can be found
+    without scanning the whole cache. Within each chain of the hash
+    table the signals are in insertion order, too. */
+typedef struct {
+  /** Pool of entries. */
+  LADSignalCacheItem* items;
+  long maxitems;
+
+  /** Stack of unused entries. */
+  long* freeitems;
+  long nfree;
+
+  /** First and last entry in insertion order. -1 if the cache is
+      empty. */
+  long first, last;
+
+  /** Number of signals in the cache. */
+  long nsignals;
+
+  /** First and last entry of each chain of the hash table. The
+      number of chains is a power of 2. */
+  long* hfirst;
+  long* hlast;
+  long nslots;
+
+  /** Insertion number of the next signal. */
+  long nextseq;
+
+} LADSignalCache;
+
+
 /////////////////////////////////////////////////////////////////
 // Function Declarations.
 /////////////////////////////////////////////////////////////////
@@ -53,5 +148,59 @@ LADSignalListItem* newLADSignalListItem(int* const status);
 /** Destructor. */
 void freeLADSignalList(LADSignalListItem** const list);
 
+/** Constructor. Returns a pointer to an empty LADSignalBuffer. */
+LADSignalBuffer* newLADSignalBuffer(int* const status);
+
+/** Destructor. */
+void freeLADSignalBuffer(LADSignalBuffer** const buf);
+
+/** Insert a copy of the signal into the buffer. */
+void insertLADSignalBuffer(LADSignalBuffer* const buf,
+			   const LADSignal* const signal,
+			   int* const status);
+
+/** Return the signal with the earliest time in the buffer. The
+    return value is NULL if the buffer is empty. The pointer is only
+    valid until the buffer is modified. */
+LADSignal* getLADSignalBufferFirst(const LADSignalBuffer* const buf);
+
+/** Remove the signal with the earliest time from the buffer. */
+void removeLADSignalBufferFirst(LADSignalBuffer* const buf);
+
+/** Constructor. Returns a pointer to an empty LADSignalCache. */
+LADSignalCache* newLADSignalCache(int* const status);
+
+/** Destructor. */
+void freeLADSignalCache(LADSignalCache** const cache);
+
+/** Append a copy of the signal to the end of the cache. */
+void appendLADSignalCache(LADSignalCache* const cache,
+			  const LADSignal* const signal,
+			  int* const status);
+
+/** Return the signal that has been appended to the cache first. The
+    return value is NULL if the cache is empty. The pointer is only
+    valid until the next call of appendLADSignalCache(). */
+LADSignal* getLADSignalCacheFirst(const LADSignalCache* const cache);
+
+/** Remove the signal from the cache. The signal must have been
+    obtained from the cache. */
+void removeLADSignalCache(LADSignalCache* const cache,
+			  LADSignal* const signal);
+
+/** Return the signal in the panel, module, and element that has been
+    appended to the cache first among all signals on an anode
+    adjacent to one of the nanodes given anodes. Only anodes in the
+    range [anode_min,anode_max) are taken into account. The return
+    value is NULL if there is no such signal. */
+LADSignal* findLADSignalCacheNeighbour(const LADSignalCache* const cache,
+				       const long panel,
+				       const long module,
+				       const long element,
+				       const long* const anodes,
+				       const long nanodes,
+				       const long anode_min,
+				       const long anode_max);
+
 
 #endif /* LADSIGNALLIST_H */
@@ -43,12 +43,6 @@ void phdetGenDet(GenDet* const det,
   CHECK_STATUS_VOID(*status);
 
 
-  // Total number of detected photons. Only the number of
-  // photons absorbed by valid pixels inside the detector is
-  // counted. Split events created by one photon are counted only
-  // once.
-  static unsigned long n_detected_photons=0;
-
   // Check if an impact has been given as a parameter.
   if (NULL!=impact) {
     // Add the impact to the detector array. If it is absorbed
@@ -56,7 +50,7 @@ void phdetGenDet(GenDet* const det,
     // the number of detected photons.
 	headas_chat(7,"new impact:\n time=%lf, det->frametime=%lf\n", impact->time, det->frametime);
     if (addGenDetPhotonImpact(det, impact, status) > 0) {
-        n_detected_photons++;
+        det->n_detected_photons++;
     }
     CHECK_STATUS_VOID(*status);
   }
@@ -23,72 +23,110 @@
 #include "phgen.h"
 
 
-int phgen(Attitude* const ac,
-	  SourceCatalog** const srccat,
-	  const unsigned int ncat,
-	  const double t0,
-	  const double tend,
-	  const double mjdref,
-	  const double dt,
-	  const float fov,
-	  Photon* const ph,
-	  int* const status)
+PhotonGenerator* newPhotonGenerator(int* const status)
 {
-  // Photon list buffer.
-  static LinkedPhoListElement* pholist=NULL;
-  // Counter for the photon IDs.
-  static long long ph_id=0;
+  PhotonGenerator* gen=(PhotonGenerator*)malloc(sizeof(PhotonGenerator));
+  CHECK_NULL(gen, *status, "memory allocation for PhotonGenerator failed");
+
+  // Initialize values.
+  gen->time =0.;
+  gen->ph_id=0;
+  gen->attcursor=0;
+
+  gen->buffer=newPhotonBuffer(status);
+  CHECK_STATUS_RET(*status, gen);
+
+  return(gen);
+}
+
+
+void freePhotonGenerator(PhotonGenerator** const gen)
+{
+  if (NULL!=*gen) {
+    freePhotonBuffer(&(*gen)->buffer);
+    free(*gen);
+    *gen=NULL;
+  }
+}
+
 
+long phgenBatch(PhotonGenerator* const gen,
+		const Attitude* const ac,
+		SourceCatalog** const srccat,
+		const unsigned int ncat,
+		const double t0,
+		const double tend,
+		const double mjdref,
+		const double dt,
+		const float fov,
+		Photon* const ph,
+		const long nmax,
+		int* const status)
+{
   // Current time.
-  static double time=0.;
-  if (time<t0) {
-    time=t0;
+  if (gen->time<t0) {
+    gen->time=t0;
   }
 
-  // If the photon list is empty generate new photons from the
-  // given source catalog.
-  while((NULL==pholist)&&(time<tend)) {
+  // If the photon buffer is empty generate new photons from the
+  // given source catalogs.
+  while ((0==getPhotonBufferNPhotons(gen->buffer))&&(gen->time<tend)) {
     // Determine the telescope pointing at the current point of time.
-    Vector pointing=getTelescopeNz(ac, time, status);
-    CHECK_STATUS_BREAK(*status);
-
-    // Display the program progress status.
-    double ra, dec;
-    calculate_ra_dec(pointing, &ra, &dec);
+    Vector pointing=getAttitudeNz(ac, gen->time, &gen->attcursor, status);
+    CHECK_STATUS_RET(*status, 0);
 
     // Generate new photons for all specified catalogs.
-    double t1=MIN(time+dt, tend);
+    double t1=MIN(gen->time+dt, tend);
     unsigned int ii;
     for (ii=0; ii<ncat; ii++) {
       if (NULL==srccat[ii]) continue;
 
       // Get photons for all sources in the catalog.
-      LinkedPhoListElement* newlist=
-	genFoVXRayPhotons(srccat[ii], &pointing, fov,
-			  time, t1, mjdref, status);
-      CHECK_STATUS_BREAK(*status);
-
-      // Merge the photon lists.
-      pholist=mergeLinkedPhoLists(pholist, newlist);
+      genFoVXRayPhotons(srccat[ii], &pointing, fov,
+			gen->time, t1, mjdref, gen->buffer, status);
+      CHECK_STATUS_RET(*status, 0);
     }
 
+    // Merge the photons of all sources.
+    mergePhotonBuffer(gen->buffer, status);
+    CHECK_STATUS_RET(*status, 0);
+
     // Increase the time.
-    time+=dt;
+    gen->time+=dt;
   }
 
-  // If there is no photon in the buffer.
-  if (NULL==pholist) return(0);
+  // Take the photons from the buffer.
+  long nph=getPhotonBufferPhotons(gen->buffer, ph, nmax, status);
+  CHECK_STATUS_RET(*status, 0);
 
-  // Take the first photon from the list and return it.
-  copyPhoton(ph, &pholist->photon);
+  // Set the photon IDs.
+  long ii;
+  for (ii=0; ii<nph; ii++) {
+    ph[ii].ph_id=++gen->ph_id;
+  }
+
+  return(nph);
+}
 
-  // Delete the processed element.
-  LinkedPhoListElement* next=pholist->next;
-  free(pholist);
-  pholist=next;
 
-  // Set the photon ID.
-  ph->ph_id=++ph_id;
+int phgen(const Attitude* const ac,
+	  SourceCatalog** const srccat,
+	  const unsigned int ncat,
+	  const double t0,
+	  const double tend,
+	  const double mjdref,
+	  const double dt,
+	  const float fov,
+	  Photon* const ph,
+	  int* const status)
+{
+  // Photon generator shared by all calls.
+  static PhotonGenerator* gen=NULL;
+  if (NULL==gen) {
+    gen=newPhotonGenerator(status);
+    CHECK_STATUS_RET(*status, 0);
+  }
 
-  return(1);
+  return((int)phgenBatch(gen, ac, srccat, ncat, t0, tend, mjdref, dt, fov,
+			 ph, 1, status));
 }
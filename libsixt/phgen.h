@@ -27,15 +27,72 @@
 #include "attitude.h"
 #include "gendet.h"
 #include "photon.h"
+#include "photonbuffer.h"
 #include "sourcecatalog.h"
 
 
+/////////////////////////////////////////////////////////////////
+// Type Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** State of the photon generation. Photons are generated for
+    consecutive time intervals of the length dt. The photons of one
+    interval are kept in a time-ordered buffer until they have been
+    taken by the calling routine. */
+typedef struct {
+  /** Buffer for the photons of the current time interval. */
+  PhotonBuffer* buffer;
+
+  /** Start time of the next time interval. */
+  double time;
+
+  /** Counter for the photon IDs. */
+  long long ph_id;
+
+  /** Cursor for the search of the telescope pointing in the
+      attitude, which is therefore not modified. */
+  long attcursor;
+
+} PhotonGenerator;
+
+
 /////////////////////////////////////////////////////////////////
 // Function Declarations.
 /////////////////////////////////////////////////////////////////
 
 
-int phgen(Attitude* const ac,
+/** Constructor. */
+PhotonGenerator* newPhotonGenerator(int* const status);
+
+/** Destructor. */
+void freePhotonGenerator(PhotonGenerator** const gen);
+
+/** Generate photons for the specified source catalogs and copy up to
+    nmax of them in time order to the array ph. The return value is
+    the number of photons. If it is 0, no more photons are available
+    before tend. New photons are only generated when the buffer has
+    run empty, such that a batch never spans more than one time
+    interval and the random numbers are drawn in the same order as
+    with repeated calls of phgen(). */
+long phgenBatch(PhotonGenerator* const gen,
+		const Attitude* const ac,
+		SourceCatalog** const srccat,
+		const unsigned int ncat,
+		const double t0,
+		const double tend,
+		const double mjdref,
+		const double dt,
+		const float fov,
+		Photon* const ph,
+		const long nmax,
+		int* const status);
+
+/** Return the next photon from the specified source catalogs. The
+    function uses an internal PhotonGenerator, which is shared by all
+    calls. The return value is 1 if a photon has been generated and 0
+    otherwise. */
+int phgen(const Attitude* const ac,
 	  SourceCatalog** const srccat,
 	  const unsigned int ncat,
 	  const double t0,
@@ -28,6 +28,17 @@ int phimg(const GenTel* const tel,
 	  Photon* const ph,
 	  Impact* const imp,
 	  int* const status)
+{
+  return(phimgCursor(tel, ac, &ac->currentry, ph, imp, status));
+}
+
+
+int phimgCursor(const GenTel* const tel,
+		const Attitude* const ac,
+		long* const attcursor,
+		Photon* const ph,
+		Impact* const imp,
+		int* const status)
 {
   // Calculate the minimum cos-value for sources inside the FOV:
   // (angle(x0,source) <= 1/2 * diameter)
@@ -35,7 +46,7 @@ int phimg(const GenTel* const tel,
 
   // Determine the telescope pointing direction at the current time.
   struct Telescope telescope;
-  telescope.nz=getTelescopeNz(ac, ph->time, status);
+  telescope.nz=getAttitudeNz(ac, ph->time, attcursor, status);
   CHECK_STATUS_RET(*status, 0);
 
   // Check whether the photon is inside the FOV.
@@ -46,8 +57,8 @@ int phimg(const GenTel* const tel,
 
     // Determine telescope data like pointing direction (attitude) etc.
     // The telescope coordinate system consists of an x-, y-, and z-axis.
-    getTelescopeAxes(ac, &telescope.nx, &telescope.ny, &telescope.nz,
-		     ph->time, status);
+    getAttitudeAxes(ac, &telescope.nx, &telescope.ny, &telescope.nz,
+		    ph->time, attcursor, status);
     CHECK_STATUS_RET(*status, 0);
 
     // Determine the photon impact position on the detector (in [m]).
@@ -87,3 +98,24 @@ int phimg(const GenTel* const tel,
   }
   // End of FOV check.
 }
+
+
+long phimgBatch(const GenTel* const tel,
+		const Attitude* const ac,
+		long* const attcursor,
+		Photon* const ph,
+		const long nph,
+		Impact* const imp,
+		int* const status)
+{
+  long nimp=0;
+  long ii;
+  for (ii=0; ii<nph; ii++) {
+    int isimg=phimgCursor(tel, ac, attcursor, &(ph[ii]), &(imp[nimp]),
+			    status);
+    CHECK_STATUS_RET(*status, nimp);
+    if (0!=isimg) nimp++;
+  }
+
+  return(nimp);
+}
@@ -36,11 +36,40 @@
 /////////////////////////////////////////////////////////////////
 
 
+/** Determine the impact position of the photon on the detector. The
+    return value is 1 if the photon hits the detector and 0
+    otherwise. The telescope pointing is searched starting at the
+    currently selected entry of the attitude. */
 int phimg(const GenTel* const tel,
 	  Attitude* const ac,
 	  Photon* const ph,
 	  Impact* const imp,
 	  int* const status);
 
+/** Same as phimg(), but the attitude is not modified. Instead, the
+    telescope pointing is searched starting at the attitude cursor,
+    which is owned by the caller (see getAttitudeNz()). Several
+    threads can therefore share the same attitude with separate
+    cursors. */
+int phimgCursor(const GenTel* const tel,
+		const Attitude* const ac,
+		long* const attcursor,
+		Photon* const ph,
+		Impact* const imp,
+		int* const status);
+
+/** Image an array of nph photons. The resulting impacts are stored
+    consecutively in the array imp, which must have space for nph
+    entries. The return value is the number of impacts. The photons
+    are processed in the given order, i.e., the result is the same as
+    for individual calls of phimgCursor() with the same cursor. */
+long phimgBatch(const GenTel* const tel,
+		const Attitude* const ac,
+		long* const attcursor,
+		Photon* const ph,
+		const long nph,
+		Impact* const imp,
+		int* const status);
+
 
 #endif /* PHIMG_H */
@@ -0,0 +1,267 @@
+/*
+   This file is part of SIXTE.
+
+   SIXTE is free software: you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   any later version.
+
+   SIXTE is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   For a copy of the GNU General Public License see
+   <http://www.gnu.org/licenses/>.
+
+
+   Copyright 2019 Remeis-Sternwarte, Friedrich-Alexander-Universitaet
+                  Erlangen-Nuernberg
+*/
+
+
+#include "photonbuffer.h"
+
+
+/** Check whether the next photon of chunk a precedes the next photon
+    of chunk b. */
+static inline int precedesPhotonChunk(const PhotonBuffer* const buf,
+				      const long a, const long b)
+{
+  double ta=buf->photons[buf->chunks[a].first].time;
+  double tb=buf->photons[buf->chunks[b].first].time;
+  if (ta<tb) return(1);
+  if (ta>tb) return(0);
+  return(a<b);
+}
+
+
+/** Restore the heap property below the specified heap position. */
+static void siftDownPhotonBuffer(PhotonBuffer* const buf, long pos)
+{
+  long chunk=buf->heap[pos];
+  while (1) {
+    long child=2*pos+1;
+    if (child>=buf->nheap) break;
+    if ((child+1<buf->nheap)&&
+	(precedesPhotonChunk(buf, buf->heap[child+1], buf->heap[child]))) {
+      child++;
+    }
+    if (!precedesPhotonChunk(buf, buf->heap[child], chunk)) break;
+    buf->heap[pos]=buf->heap[child];
+    pos=child;
+  }
+  buf->heap[pos]=chunk;
+}
+
+
+PhotonBuffer* newPhotonBuffer(int* const status)
+{
+  PhotonBuffer* buf=(PhotonBuffer*)malloc(sizeof(PhotonBuffer));
+  CHECK_NULL_RET(buf, *status, "memory allocation for PhotonBuffer failed",
+		 buf);
+
+  // Initialize pointers with NULL.
+  buf->photons=NULL;
+  buf->chunks =NULL;
+  buf->heap   =NULL;
+
+  // Initialize values.
+  buf->nphotons  =0;
+  buf->maxphotons=0;
+  buf->nremaining=0;
+  buf->nchunks   =0;
+  buf->maxchunks =0;
+  buf->nheap     =0;
+  buf->merged    =0;
+
+  // Allocate the arena.
+  buf->photons=(Photon*)malloc(PHOTONBUFFER_INITSIZE*sizeof(Photon));
+  CHECK_NULL_RET(buf->photons, *status,
+		 "memory allocation for PhotonBuffer failed", buf);
+  buf->maxphotons=PHOTONBUFFER_INITSIZE;
+
+  buf->chunks=(PhotonChunk*)malloc(PHOTONBUFFER_INITCHUNKS*sizeof(PhotonChunk));
+  CHECK_NULL_RET(buf->chunks, *status,
+		 "memory allocation for PhotonBuffer failed", buf);
+  buf->heap=(long*)malloc(PHOTONBUFFER_INITCHUNKS*sizeof(long));
+  CHECK_NULL_RET(buf->heap, *status,
+		 "memory allocation for PhotonBuffer failed", buf);
+  buf->maxchunks=PHOTONBUFFER_INITCHUNKS;
+
+  return(buf);
+}
+
+
+void freePhotonBuffer(PhotonBuffer** const buf)
+{
+  if (NULL!=*buf) {
+    if (NULL!=(*buf)->photons) {
+      free((*buf)->photons);
+    }
+    if (NULL!=(*buf)->chunks) {
+      free((*buf)->chunks);
+    }
+    if (NULL!=(*buf)->heap) {
+      free((*buf)->heap);
+    }
+    free(*buf);
+    *buf=NULL;
+  }
+}
+
+
+void clearPhotonBuffer(PhotonBuffer* const buf)
+{
+  buf->nphotons  =0;
+  buf->nremaining=0;
+  buf->nchunks   =0;
+  buf->nheap     =0;
+  buf->merged    =0;
+}
+
+
+void startPhotonBufferChunk(PhotonBuffer* const buf, int* const status)
+{
+  if (0!=buf->merged) {
+    *status=EXIT_FAILURE;
+    SIXT_ERROR("cannot add photons to PhotonBuffer before it is empty");
+    return;
+  }
+
+  // Re-use the last chunk if it does not contain any photons.
+  if ((buf->nchunks>0)&&(0==buf->chunks[buf->nchunks-1].nphotons)) {
+    buf->chunks[buf->nchunks-1].first=buf->nphotons;
+    return;
+  }
+
+  // Enlarge the arrays of chunks if necessary.
+  if (buf->nchunks>=buf->maxchunks) {
+    long maxchunks=2*buf->maxchunks;
+    PhotonChunk* chunks=
+      (PhotonChunk*)realloc(buf->chunks, maxchunks*sizeof(PhotonChunk));
+    CHECK_NULL_VOID(chunks, *status,
+		    "memory allocation for PhotonBuffer failed");
+    buf->chunks=chunks;
+
+    long* heap=(long*)realloc(buf->heap, maxchunks*sizeof(long));
+    CHECK_NULL_VOID(heap, *status,
+		    "memory allocation for PhotonBuffer failed");
+    buf->heap=heap;
+
+    buf->maxchunks=maxchunks;
+  }
+
+  buf->chunks[buf->nchunks].first   =buf->nphotons;
+  buf->chunks[buf->nchunks].nphotons=0;
+  buf->nchunks++;
+}
+
+
+Photon* appendPhotonBuffer(PhotonBuffer* const buf, int* const status)
+{
+  if (0==buf->nchunks) {
+    startPhotonBufferChunk(buf, status);
+    CHECK_STATUS_RET(*status, NULL);
+  }
+
+  // Enlarge the arena if necessary.
+  if (buf->nphotons>=buf->maxphotons) {
+    long maxphotons=2*buf->maxphotons;
+    Photon* photons=(Photon*)realloc(buf->photons, maxphotons*sizeof(Photon));
+    CHECK_NULL_RET(photons, *status,
+		   "memory allocation for PhotonBuffer failed", NULL);
+    buf->photons=photons;
+    buf->maxphotons=maxphotons;
+  }
+
+  buf->chunks[buf->nchunks-1].nphotons++;
+  buf->nremaining++;
+  return(&(buf->photons[buf->nphotons++]));
+}
+
+
+void mergePhotonBuffer(PhotonBuffer* const buf, int* const status)
+{
+  if (0!=buf->merged) {
+    *status=EXIT_FAILURE;
+    SIXT_ERROR("PhotonBuffer has already been merged");
+    return;
+  }
+
+  // Insert all non-empty chunks into the heap. As the chunk indices
+  // are in ascending order, the array only has to be heapified.
+  buf->nheap=0;
+  long ii;
+  for (ii=0; ii<buf->nchunks; ii++) {
+    if (buf->chunks[ii].nphotons>0) {
+      buf->heap[buf->nheap++]=ii;
+    }
+  }
+  for (ii=buf->nheap/2-1; ii>=0; ii--) {
+    siftDownPhotonBuffer(buf, ii);
+  }
+
+  if (buf->nheap>0) {
+    buf->merged=1;
+  } else {
+    clearPhotonBuffer(buf);
+  }
+}
+
+
+long getPhotonBufferNPhotons(const PhotonBuffer* const buf)
+{
+  return(buf->nremaining);
+}
+
+
+long getPhotonBufferPhotons(PhotonBuffer* const buf,
+			    Photon* const ph,
+			    const long nmax,
+			    int* const status)
+{
+  if (0==buf->merged) {
+    if (buf->nphotons>0) {
+      *status=EXIT_FAILURE;
+      SIXT_ERROR("PhotonBuffer has to be merged before photons can be taken");
+    }
+    return(0);
+  }
+
+  long nph=0;
+  while ((nph<nmax)&&(buf->nheap>0)) {
+    PhotonChunk* chunk=&(buf->chunks[buf->heap[0]]);
+
+    if (1==buf->nheap) {
+      // Only a single chunk is left, such that the photons can be
+      // copied as a block.
+      long ncopy=MIN(nmax-nph, chunk->nphotons);
+      memcpy(&(ph[nph]), &(buf->photons[chunk->first]), ncopy*sizeof(Photon));
+      nph+=ncopy;
+      chunk->first   +=ncopy;
+      chunk->nphotons-=ncopy;
+    } else {
+      copyPhoton(&(ph[nph++]), &(buf->photons[chunk->first]));
+      chunk->first++;
+      chunk->nphotons--;
+    }
+
+    // Remove an exhausted chunk from the heap.
+    if (0==chunk->nphotons) {
+      buf->heap[0]=buf->heap[--buf->nheap];
+    }
+    if (buf->nheap>0) {
+      siftDownPhotonBuffer(buf, 0);
+    }
+  }
+
+  buf->nremaining-=nph;
+
+  // Re-use the arena for the next time interval.
+  if (0==buf->nheap) {
+    clearPhotonBuffer(buf);
+  }
+
+  return(nph);
+}
@@ -0,0 +1,135 @@
+/*
+   This file is part of SIXTE.
+
+   SIXTE is free software: you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   any later version.
+
+   SIXTE is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   For a copy of the GNU General Public License see
+   <http://www.gnu.org/licenses/>.
+
+
+   Copyright 2019 Remeis-Sternwarte, Friedrich-Alexander-Universitaet
+                  Erlangen-Nuernberg
+*/
+
+#ifndef PHOTONBUFFER_H
+#define PHOTONBUFFER_H 1
+
+#include "sixt.h"
+#include "photon.h"
+
+
+/////////////////////////////////////////////////////////////////
+// Constants.
+/////////////////////////////////////////////////////////////////
+
+
+/** Initial number of photons the buffer can hold. The arena is
+    enlarged by a factor of 2 whenever it is full. */
+#define PHOTONBUFFER_INITSIZE (4096)
+
+/** Initial number of chunks the buffer can hold. */
+#define PHOTONBUFFER_INITCHUNKS (64)
+
+
+/////////////////////////////////////////////////////////////////
+// Type Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Time-ordered sequence of photons of a single source within the
+    PhotonBuffer arena. */
+typedef struct {
+  /** Index of the next photon in the arena. */
+  long first;
+
+  /** Number of remaining photons. */
+  long nphotons;
+
+} PhotonChunk;
+
+
+/** Buffer for the photons generated from several sources within a
+    particular time interval. The photons of each source are stored as
+    a time-ordered chunk in a contiguous arena, which is re-used for
+    the subsequent time intervals. The chunks are merged with a binary
+    heap. For photons with the same arrival time, the chunk that has
+    been filled first has precedence, i.e., the resulting order is the
+    same as for pairwise merging of the individual lists. */
+typedef struct {
+  /** Arena containing the photons of all chunks. */
+  Photon* photons;
+  long nphotons;
+  long maxphotons;
+
+  /** Number of photons that have not been taken from the buffer
+      yet. */
+  long nremaining;
+
+  /** Chunks within the arena. */
+  PhotonChunk* chunks;
+  long nchunks;
+  long maxchunks;
+
+  /** Binary min-heap of the indices of the non-empty chunks, ordered
+      by the time of their next photon. */
+  long* heap;
+  long nheap;
+
+  /** Flag whether the chunks have been merged. No further photons
+      can be added until the buffer is empty again. */
+  int merged;
+
+} PhotonBuffer;
+
+
+/////////////////////////////////////////////////////////////////
+// Function Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Constructor. Returns a pointer to an empty PhotonBuffer. */
+PhotonBuffer* newPhotonBuffer(int* const status);
+
+/** Destructor. */
+void freePhotonBuffer(PhotonBuffer** const buf);
+
+/** Discard all photons in the buffer. The allocated memory is
+    kept. */
+void clearPhotonBuffer(PhotonBuffer* const buf);
+
+/** Start a new chunk. All photons that are subsequently added
+    with appendPhotonBuffer() belong to this chunk and have to be in
+    time order. */
+void startPhotonBufferChunk(PhotonBuffer* const buf, int* const status);
+
+/** Append a new photon to the current chunk. The returned pointer
+    has to be filled by the calling routine. It is only valid until
+    the next call of this routine. */
+Photon* appendPhotonBuffer(PhotonBuffer* const buf, int* const status);
+
+/** Merge the chunks after all photons of the current time interval
+    have been added. */
+void mergePhotonBuffer(PhotonBuffer* const buf, int* const status);
+
+/** Return the number of photons in the buffer. */
+long getPhotonBufferNPhotons(const PhotonBuffer* const buf);
+
+/** Copy up to nmax photons in time order from the buffer to the
+    array ph and remove them from the buffer. The return value is
+    the number of photons. When the buffer runs empty, it is cleared
+    and can be filled again. */
+long getPhotonBufferPhotons(PhotonBuffer* const buf,
+			    Photon* const ph,
+			    const long nmax,
+			    int* const status);
+
+
+#endif /* PHOTONBUFFER_H */
@@ -31,6 +31,7 @@ PhotonFile* newPhotonFile(int* const status)
 
   // Initialize pointers with NULL.
   plf->fptr=NULL;
+  plf->buffer=NULL;
 
   // Initialize values.
   plf->nrows=0;
@@ -41,6 +42,12 @@ PhotonFile* newPhotonFile(int* const status)
   plf->cdec=0;
   plf->cph_id=0;
   plf->csrc_id=0;
+  plf->btime=-1;
+  plf->benergy=-1;
+  plf->bra=-1;
+  plf->bdec=-1;
+  plf->bph_id=-1;
+  plf->bsrc_id=-1;
 
   return(plf);
 }
@@ -49,6 +56,9 @@ PhotonFile* newPhotonFile(int* const status)
 void freePhotonFile(PhotonFile** const plf, int* const status)
 {
   if (NULL!=*plf) {
+    // Write buffered rows to the file.
+    freeFitsBlockBuffer(&(*plf)->buffer, status);
+
     if (NULL!=(*plf)->fptr) {
       // If the file was opened in READWRITE mode, calculate
       // the check sum an append it to the FITS header.
@@ -115,6 +125,21 @@ PhotonFile* openPhotonFile(const char* const filename,
   fits_get_colnum(plf->fptr, CASEINSEN, "SRC_ID", &plf->csrc_id, &opt_status);
   fits_clear_errmark();
 
+  // Set up the buffer for block-wise I/O.
+  plf->buffer=newFitsBlockBuffer(plf->fptr, status);
+  CHECK_STATUS_RET(*status, plf);
+  plf->btime  =addFitsBlockColumn(plf->buffer, plf->ctime, TDOUBLE, 1, status);
+  plf->benergy=addFitsBlockColumn(plf->buffer, plf->cenergy, TFLOAT, 1, status);
+  plf->bra    =addFitsBlockColumn(plf->buffer, plf->cra, TDOUBLE, 1, status);
+  plf->bdec   =addFitsBlockColumn(plf->buffer, plf->cdec, TDOUBLE, 1, status);
+  if (0!=plf->cph_id) {
+    plf->bph_id=addFitsBlockColumn(plf->buffer, plf->cph_id, TLONG, 1, status);
+  }
+  if (0!=plf->csrc_id) {
+    plf->bsrc_id=addFitsBlockColumn(plf->buffer, plf->csrc_id, TLONG, 1, status);
+  }
+  CHECK_STATUS_RET(*status, plf);
+
   return(plf);
 }
 
@@ -211,7 +236,6 @@ int PhotonFile_getRow(PhotonFile* const plf,
 		      Photon* const ph, const long row)
 {
   int status=EXIT_SUCCESS;
-  int anynul=0;
 
   // Check if there is still a row available.
   if (row > plf->nrows) {
@@ -219,44 +243,26 @@ int PhotonFile_getRow(PhotonFile* const plf,
     return(EXIT_FAILURE);
   }
 
-  // Read in the data.
-  ph->time=0.;
-  fits_read_col(plf->fptr, TDOUBLE, plf->ctime, row, 1, 1,
-		&ph->time, &ph->time, &anynul, &status);
-
-  ph->energy=0.;
-  fits_read_col(plf->fptr, TFLOAT, plf->cenergy, row, 1, 1,
-		&ph->energy, &ph->energy, &anynul, &status);
-
-  ph->ra=0.;
-  fits_read_col(plf->fptr, TDOUBLE, plf->cra, row, 1, 1,
-		&ph->ra, &ph->ra, &anynul, &status);
-  ph->ra *=M_PI/180.; // Convert from [deg] to [rad].
+  // Make sure the row is available in the buffer.
+  FitsBlockBuffer* buf=plf->buffer;
+  long idx=readFitsBlockRow(buf, row, plf->nrows, &status);
+  CHECK_STATUS_RET(status, status);
 
-  ph->dec=0.;
-  fits_read_col(plf->fptr, TDOUBLE, plf->cdec, row, 1, 1,
-		&ph->dec, &ph->dec, &anynul, &status);
-  ph->dec*=M_PI/180.; // Convert from [deg] to [rad].
+  // Copy the data from the buffer.
+  ph->time  =FITSBLOCK_COL(buf, plf->btime, double)[idx];
+  ph->energy=FITSBLOCK_COL(buf, plf->benergy, float)[idx];
+  ph->ra    =FITSBLOCK_COL(buf, plf->bra, double)[idx]*M_PI/180.;
+  ph->dec   =FITSBLOCK_COL(buf, plf->bdec, double)[idx]*M_PI/180.;
 
   // Optional columns: read values only if column exists.
   ph->ph_id=0;
-  if (0!=plf->cph_id) {
-    fits_read_col(plf->fptr, TLONG, plf->cph_id, row, 1, 1,
-		  &ph->ph_id, &ph->ph_id, &anynul, &status);
+  if (plf->bph_id>=0) {
+    ph->ph_id=FITSBLOCK_COL(buf, plf->bph_id, long)[idx];
   }
 
   ph->src_id=0;
-  if (0!=plf->csrc_id) {
-    fits_read_col(plf->fptr, TLONG, plf->csrc_id, row, 1, 1,
-		  &ph->src_id, &ph->src_id, &anynul, &status);
-  }
-
-  CHECK_STATUS_RET(status, status);
-
-  // Check if an error occurred during the reading process.
-  if (0!=anynul) {
-    SIXT_ERROR("reading from event list failed");
-    return(EXIT_FAILURE);
+  if (plf->bsrc_id>=0) {
+    ph->src_id=FITSBLOCK_COL(buf, plf->bsrc_id, long)[idx];
   }
 
   return(status);
@@ -280,26 +286,24 @@ int addPhoton2File(PhotonFile* const plf, Photon* const ph)
     ph->ph_id=plf->row;
   }
 
-  // Store the data in the FITS file.
-  fits_write_col(plf->fptr, TDOUBLE, plf->ctime,
-		 plf->row, 1, 1, &ph->time, &status);
-  fits_write_col(plf->fptr, TFLOAT, plf->cenergy,
-		 plf->row, 1, 1, &ph->energy, &status);
-  fits_write_col(plf->fptr, TDOUBLE, plf->cra,
-		 plf->row, 1, 1, &ra, &status);
-  fits_write_col(plf->fptr, TDOUBLE, plf->cdec,
-		 plf->row, 1, 1, &dec, &status);
+  // Store the data in the buffer. The buffer is written to the FITS
+  // file as soon as it is full.
+  FitsBlockBuffer* buf=plf->buffer;
+  long idx=writeFitsBlockRow(buf, plf->row, &status);
+  CHECK_STATUS_RET(status, status);
+
+  FITSBLOCK_COL(buf, plf->btime, double)[idx]=ph->time;
+  FITSBLOCK_COL(buf, plf->benergy, float)[idx]=ph->energy;
+  FITSBLOCK_COL(buf, plf->bra, double)[idx]=ra;
+  FITSBLOCK_COL(buf, plf->bdec, double)[idx]=dec;
 
   // Optional columns: write values only if column exists.
-  if (0!=plf->cph_id) {
-    fits_write_col(plf->fptr, TLONG, plf->cph_id,
-		   plf->row, 1, 1, &ph->ph_id, &status);
+  if (plf->bph_id>=0) {
+    FITSBLOCK_COL(buf, plf->bph_id, long)[idx]=ph->ph_id;
   }
-  if (0!=plf->csrc_id) {
-    fits_write_col(plf->fptr, TLONG, plf->csrc_id,
-		   plf->row, 1, 1, &ph->src_id, &status);
+  if (plf->bsrc_id>=0) {
+    FITSBLOCK_COL(buf, plf->bsrc_id, long)[idx]=ph->src_id;
   }
-  CHECK_STATUS_RET(status, status);
 
   return(status);
 }
@@ -25,6 +25,7 @@
 
 #include "sixt.h"
 #include "photon.h"
+#include "fitsblockbuffer.h"
 
 
 ////////////////////////////////////////////////////////////////////////
@@ -47,6 +48,13 @@ typedef struct {
   /** Column numbers in the FITS binary table. */
   int ctime, cenergy, cra, cdec, cph_id, csrc_id;
 
+  /** Buffer for block-wise access to the FITS table. */
+  FitsBlockBuffer* buffer;
+
+  /** Column indices within the buffer. The value -1 denotes that the
+      optional column is not available. */
+  int btime, benergy, bra, bdec, bph_id, bsrc_id;
+
 } PhotonFile;
 
 
@@ -29,11 +29,110 @@
 #include "gendet.h"
 
 
+/////////////////////////////////////////////////////////////////
+// Type Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+struct PatternStatistics {
+  /** Number of valid patterns. */
+  long nvalids;
+  /** Number of valid patterns flagged as pile-up. */
+  long npvalids;
+
+  /** Number of invalid patterns. */
+  long ninvalids;
+  /** Number of invalid patterns flagged as pile-up. */
+  long npinvalids;
+
+  /** Number of patterns with a particular grade. */
+  long ngrade[13];
+  /** NUmber of patterns with a particular grade flagged as
+      pile-up. */
+  long npgrade[13];
+};
+
+
+/** Online pattern recombination. The single-pixel events are passed
+    to the engine in the order of their detection, e.g., directly from
+    GenDetReadoutLine(). As soon as an event of a new frame arrives,
+    the events of the previous frame are recombined to patterns and
+    written to the output file. The neighbors of a pixel are found via
+    a hash table of the pixel coordinates of the current frame. The
+    patterns are identical to the ones obtained from a PIXEL event
+    file with phpat(). */
+typedef struct PatternEngine {
+  /** Detector providing the thresholds and the response. */
+  GenDet* det;
+
+  /** Output pattern file. */
+  EventFile* dest;
+
+  /** Flag whether invalid patterns are omitted in the output. */
+  char skip_invalids;
+
+  /** Flag whether the eROSITA split threshold has to be applied. */
+  int iseROSITA;
+
+  /** Events belonging to the current frame. */
+  Event** framelist;
+  long nframelist;
+  long maxnframelist;
+
+  /** Events belonging to the current pattern. */
+  Event** neighborlist;
+  long nneighborlist;
+  long maxnneighborlist;
+
+  /** Hash table of the pixel coordinates of the events in the
+      current frame with npixhash buckets. Each bucket contains the
+      index of the first event in the frame list, pixnext the index
+      of the next event in the same bucket (-1 at the end of the
+      chain). */
+  long* pixhash;
+  long npixhash;
+  long maxnpixhash;
+  long* pixnext;
+
+  /** Buffer for the indices of neighboring events. */
+  long* neighboridx;
+
+  /** Pattern / grade statistics. */
+  struct PatternStatistics statistics;
+
+} PatternEngine;
+
+
 /////////////////////////////////////////////////////////////////
 // Function Declarations.
 /////////////////////////////////////////////////////////////////
 
 
+/** Constructor. The event type of the output file is set to
+    'PATTERN'. */
+PatternEngine* newPatternEngine(GenDet* const det,
+				EventFile* const dest,
+				const char skip_invalids,
+				const int iseROSITA,
+				int* const status);
+
+/** Destructor. Events of an incomplete frame are discarded. */
+void destroyPatternEngine(PatternEngine** const engine);
+
+/** Add a single-pixel event. The events have to be passed in the
+    order of their frames. The engine takes over the event and
+    releases it. */
+void addPatternEngineEvent(PatternEngine* const engine,
+			   Event* const event,
+			   int* const status);
+
+/** Recombine the events of the last frame and store the pattern
+    statistics in the header of the output file. */
+void finalizePatternEngine(PatternEngine* const engine,
+			   int* const status);
+
+/** Pattern recombination of the single-pixel events in the PIXEL
+    event file src. The patterns are stored in dest. */
 void phpat(GenDet* const det,
 	   const EventFile* const src,
 	   EventFile* const dest,
@@ -22,85 +22,316 @@
 
 #include "phproj.h"
 
+#include <pthread.h>
+#include <unistd.h>
 
-void phproj(GenInst* const inst,
-	    Attitude* const ac,
-	    EventFile* const elf,
-	    const double t0,
-	    const double exposure,
-	    int* const status)
-{
-  const double cosrota=cos(inst->det->pixgrid->rota);
-  const double sinrota=sin(inst->det->pixgrid->rota);
 
-  // LOOP over all events in the input file.
-  long row;
-  for (row=0; row<elf->nrows; row++) {
+/////////////////////////////////////////////////////////////////
+// Constants.
+/////////////////////////////////////////////////////////////////
 
-    // Read the next event from the file.
-    Event event;
-    getEventFromFile(elf, row+1, &event, status);
-    CHECK_STATUS_BREAK(*status);
 
-    // Check whether we are still within the requested time interval.
-    if (event.time < t0) continue;
-    if (event.time > t0+exposure) break;
+/** Minimum number of events per thread. Smaller blocks are projected
+    in the calling thread, since the thread start-up would exceed the
+    computation time. */
+#define PHPROJ_MINROWS (256)
+
+
+/////////////////////////////////////////////////////////////////
+// Type Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Input and output arrays for the projection of a block of events
+    from the event file buffer. */
+typedef struct {
+  /** Index of the event within the current block of the event
+      file buffer. */
+  long* index;
+
+  /** Raw pixel coordinates of the events. */
+  int* rawx;
+  int* rawy;
+
+  /** Random offsets within the pixel in x- and y-direction. */
+  double* rndx;
+  double* rndy;
+
+  /** Index of the telescope axes valid for the event. */
+  long* iaxes;
+
+  /** Distinct event times in the block and the telescope axes
+      valid for them. */
+  double* atime;
+  Vector* nx;
+  Vector* ny;
+  Vector* nz;
+
+  /** Resulting equatorial coordinates [rad]. */
+  double* ra;
+  double* dec;
+
+  /** Detector and telescope geometry. */
+  const GenPixGrid* pixgrid;
+  double cosrota, sinrota;
+  double focal_length;
+
+} PhProjBlock;
 
-    // Determine the Position of the source on the sky:
-    // First determine telescope pointing direction at the current time.
-    Vector nx, ny, nz;
-    getTelescopeAxes(ac, &nx, &ny, &nz, event.time, status);
-    CHECK_STATUS_BREAK(*status);
 
-    // Determine RA and DEC of the photon origin.
+/** Range of events within a PhProjBlock processed by a single
+    thread. */
+typedef struct {
+  const PhProjBlock* block;
+  long first, last;
+} PhProjRange;
+
+
+/////////////////////////////////////////////////////////////////
+// Static Functions.
+/////////////////////////////////////////////////////////////////
+
+
+/** Determine RA and DEC of the photon origin for the events in the
+    range [first,last) of the block. */
+static void phprojRange(const PhProjBlock* const block,
+			const long first,
+			const long last)
+{
+  const GenPixGrid* pixgrid=block->pixgrid;
+  long ii;
+  for (ii=first; ii<last; ii++) {
     // Exact position on the detector.
     double xb=
-      (event.rawx*1.-inst->det->pixgrid->xrpix
-       +0.5+sixt_get_random_number(status))*inst->det->pixgrid->xdelt;
-    CHECK_STATUS_BREAK(*status);
+      (block->rawx[ii]*1.-pixgrid->xrpix+0.5+block->rndx[ii])*pixgrid->xdelt;
     double yb=
-      (event.rawy*1.-inst->det->pixgrid->yrpix
-       +0.5+sixt_get_random_number(status))*inst->det->pixgrid->ydelt;
-    CHECK_STATUS_BREAK(*status);
+      (block->rawy[ii]*1.-pixgrid->yrpix+0.5+block->rndy[ii])*pixgrid->ydelt;
 
-    double xr=cosrota*xb -sinrota*yb;
-    double yr=sinrota*xb +cosrota*yb;
+    double xr=block->cosrota*xb -block->sinrota*yb;
+    double yr=block->sinrota*xb +block->cosrota*yb;
 
     struct Point2d detpos;
-    detpos.x=xr + inst->det->pixgrid->xrval; // in [m]
-    detpos.y=yr + inst->det->pixgrid->yrval; // in [m]
+    detpos.x=xr + pixgrid->xrval; // in [m]
+    detpos.y=yr + pixgrid->yrval; // in [m]
 
     // Determine the source position on the sky using the telescope
     // axis pointing vector and a vector from the point of the intersection
     // of the optical axis with the sky plane to the source position.
+    const Vector* nx=&(block->nx[block->iaxes[ii]]);
+    const Vector* ny=&(block->ny[block->iaxes[ii]]);
+    const Vector* nz=&(block->nz[block->iaxes[ii]]);
     Vector srcpos;
-    srcpos.x = nz.x
-      +detpos.x/inst->tel->focal_length*nx.x
-      +detpos.y/inst->tel->focal_length*ny.x;
-    srcpos.y = nz.y
-      +detpos.x/inst->tel->focal_length*nx.y
-      +detpos.y/inst->tel->focal_length*ny.y;
-    srcpos.z = nz.z
-      +detpos.x/inst->tel->focal_length*nx.z
-      +detpos.y/inst->tel->focal_length*ny.z;
+    srcpos.x = nz->x
+      +detpos.x/block->focal_length*nx->x
+      +detpos.y/block->focal_length*ny->x;
+    srcpos.y = nz->y
+      +detpos.x/block->focal_length*nx->y
+      +detpos.y/block->focal_length*ny->y;
+    srcpos.z = nz->z
+      +detpos.x/block->focal_length*nx->z
+      +detpos.y/block->focal_length*ny->z;
     srcpos = normalize_vector(srcpos);
 
     // Determine the equatorial coordinates RA and DEC
     // (RA and DEC are in the range [-pi:pi] and [-pi/2:pi/2] respectively).
-    calculate_ra_dec(srcpos, &event.ra, &event.dec);
+    calculate_ra_dec(srcpos, &(block->ra[ii]), &(block->dec[ii]));
+  }
+}
 
-    // Update the data in the event list FITS file.
-    updateEventInFile(elf, row+1, &event, status);
-    CHECK_STATUS_BREAK(*status);
+
+static void* phprojThread(void* arg)
+{
+  PhProjRange* range=(PhProjRange*)arg;
+  phprojRange(range->block, range->first, range->last);
+  return(NULL);
+}
+
+
+/** Project the first n events of the block, distributing them to
+    the requested number of threads. */
+static void phprojBlock(const PhProjBlock* const block,
+			const long n,
+			const int nthreads)
+{
+  int nt=(int)MIN((long)nthreads, n/PHPROJ_MINROWS);
+  if (nt<=1) {
+    phprojRange(block, 0, n);
+    return;
+  }
+
+  pthread_t thread[nt];
+  PhProjRange range[nt];
+  int started[nt];
+  int ii;
+  for (ii=0; ii<nt; ii++) {
+    range[ii].block=block;
+    range[ii].first=n*ii/nt;
+    range[ii].last =n*(ii+1)/nt;
+    started[ii]=(0==pthread_create(&thread[ii], NULL, phprojThread, &range[ii]));
+    if (!started[ii]) {
+      // Process the events in the current thread.
+      phprojThread(&range[ii]);
+    }
+  }
+  for (ii=0; ii<nt; ii++) {
+    if (started[ii]) {
+      pthread_join(thread[ii], NULL);
+    }
   }
-  CHECK_STATUS_VOID(*status);
-  // END of LOOP over all events.
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Program Code.
+/////////////////////////////////////////////////////////////////
+
+
+void phproj(GenInst* const inst,
+	    const Attitude* const ac,
+	    EventFile* const elf,
+	    const double t0,
+	    const double exposure,
+	    int* const status)
+{
+  phproj_threads(inst, ac, elf, t0, exposure, 1, status);
+}
+
+
+void phproj_threads(GenInst* const inst,
+		    const Attitude* const ac,
+		    EventFile* const elf,
+		    const double t0,
+		    const double exposure,
+		    const int nthreads,
+		    int* const status)
+{
+  int nt=nthreads;
+  if (nt<=0) {
+    nt=(int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  nt=MAX(nt, 1);
+
+  PhProjBlock block;
+  block.pixgrid=inst->det->pixgrid;
+  block.cosrota=cos(inst->det->pixgrid->rota);
+  block.sinrota=sin(inst->det->pixgrid->rota);
+  block.focal_length=inst->tel->focal_length;
+
+  // The events are processed block by block as they are held in the
+  // buffer of the event file.
+  FitsBlockBuffer* buf=elf->buffer;
+  long size=buf->size;
+  block.rndx =(double*)malloc(size*sizeof(double));
+  block.rndy =(double*)malloc(size*sizeof(double));
+  block.ra   =(double*)malloc(size*sizeof(double));
+  block.dec  =(double*)malloc(size*sizeof(double));
+  block.iaxes=(long*)malloc(size*sizeof(long));
+  block.atime=(double*)malloc(size*sizeof(double));
+  block.index=(long*)malloc(size*sizeof(long));
+  block.rawx =(int*)malloc(size*sizeof(int));
+  block.rawy =(int*)malloc(size*sizeof(int));
+  block.nx   =(Vector*)malloc(size*sizeof(Vector));
+  block.ny   =(Vector*)malloc(size*sizeof(Vector));
+  block.nz   =(Vector*)malloc(size*sizeof(Vector));
+
+  do { // Error handling loop.
+    if ((NULL==block.rndx)||(NULL==block.rndy)||(NULL==block.ra)||
+	(NULL==block.dec)||(NULL==block.iaxes)||(NULL==block.atime)||
+	(NULL==block.index)||
+	(NULL==block.rawx)||(NULL==block.rawy)||(NULL==block.nx)||
+	(NULL==block.ny)||(NULL==block.nz)) {
+      *status=EXIT_FAILURE;
+      SIXT_ERROR("memory allocation for sky projection failed");
+      break;
+    }
+
+    // Cursor for the search of the event times in the attitude.
+    long attcursor=0;
+
+    // LOOP over all events in the input file.
+    int finished=0;
+    long row=0;
+    while ((row<elf->nrows)&&(0==finished)) {
+
+      // Make sure the next block of events is available in the buffer.
+      long idx0=readFitsBlockRow(buf, row+1, elf->nrows, status);
+      CHECK_STATUS_BREAK(*status);
+      long available=buf->nrows-idx0;
+
+      const double* time=FITSBLOCK_COL(buf, elf->btime, double)+idx0;
+      const int* rawx=FITSBLOCK_COL(buf, elf->brawx, int)+idx0;
+      const int* rawy=FITSBLOCK_COL(buf, elf->brawy, int)+idx0;
+
+      // Select the events within the requested time interval and
+      // determine the random numbers in the same order as for a
+      // row-by-row processing. The attitude is only evaluated once
+      // per distinct event time.
+      long n=0, naxes=0;
+      long ii;
+      for (ii=0; ii<available; ii++) {
+	if (time[ii] < t0) continue;
+	if (time[ii] > t0+exposure) {
+	  finished=1;
+	  break;
+	}
+
+	if ((0==n)||(time[ii]!=time[block.index[n-1]])) {
+	  block.atime[naxes++]=time[ii];
+	}
+	block.iaxes[n]=naxes-1;
+	block.index[n]=ii;
+	block.rawx[n]=rawx[ii];
+	block.rawy[n]=rawy[ii];
+
+	block.rndx[n]=sixt_get_random_number(status);
+	CHECK_STATUS_BREAK(*status);
+	block.rndy[n]=sixt_get_random_number(status);
+	CHECK_STATUS_BREAK(*status);
+	n++;
+      }
+      CHECK_STATUS_BREAK(*status);
+
+      getAttitudeAxesBatch(ac, block.atime, naxes, block.nx, block.ny,
+			   block.nz, &attcursor, status);
+      CHECK_STATUS_BREAK(*status);
+
+      phprojBlock(&block, n, nt);
+
+      // Update the data in the event list FITS file.
+      for (ii=0; ii<n; ii++) {
+	long idx=writeFitsBlockRow(buf, row+block.index[ii]+1, status);
+	CHECK_STATUS_BREAK(*status);
+	FITSBLOCK_COL(buf, elf->bra, double)[idx] =block.ra[ii]*180./M_PI;
+	FITSBLOCK_COL(buf, elf->bdec, double)[idx]=block.dec[ii]*180./M_PI;
+      }
+      CHECK_STATUS_BREAK(*status);
+
+      row+=available;
+    }
+    CHECK_STATUS_BREAK(*status);
+    // END of LOOP over all events.
+
+  } while(0); // END of error handling loop.
+
+  // Release memory.
+  free(block.rndx);
+  free(block.rndy);
+  free(block.ra);
+  free(block.dec);
+  free(block.iaxes);
+  free(block.atime);
+  free(block.index);
+  free(block.rawx);
+  free(block.rawy);
+  free(block.nx);
+  free(block.ny);
+  free(block.nz);
 }
 
 
 void phproj_advdet(GenInst* const inst,
 		AdvDet* const adv_det,
-	    Attitude* const ac,
+	    const Attitude* const ac,
 	    TesEventFile* const event_file,
 	    const double t0,
 	    const double exposure,
@@ -115,6 +346,9 @@ void phproj_advdet(GenInst* const inst,
 	Obj2D_instance * general_geometry= getObj2DFromAdvdet(adv_det,status);
 	CHECK_STATUS_VOID(*status);
 
+	// Cursor for the search of the event times in the attitude.
+	long attcursor=0;
+
 	// LOOP over all events in the input file.
 	long pixid;
 	double time,ra,dec;
@@ -135,7 +369,7 @@ void phproj_advdet(GenInst* const inst,
 		// Determine the Position of the source on the sky:
 		// First determine telescope pointing direction at the current time.
 		Vector nx, ny, nz;
-		getTelescopeAxes(ac, &nx, &ny, &nz, time, status);
+		getAttitudeAxes(ac, &nx, &ny, &nz, time, &attcursor, status);
 		CHECK_STATUS_BREAK(*status);
 
 		// Determine RA and DEC of the photon origin.
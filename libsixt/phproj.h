@@ -40,17 +40,36 @@
 /////////////////////////////////////////////////////////////////
 
 
+/** Determine RA and DEC of the events in the given file within the
+    time interval [t0,t0+exposure]. The results are identical to the
+    ones of phproj_threads() with a single thread. The attitude is not
+    modified, such that it can be shared by several threads. */
 void phproj(GenInst* const inst,
-	    Attitude* const ac,
+	    const Attitude* const ac,
 	    EventFile* const plf,
 	    const double t0,
 	    const double exposure,
 	    int* const status);
 
+/** Same as phproj(), but the events are processed in blocks of the
+    event file buffer. The telescope axes are only determined once
+    for events with the same time, and the projection of each block
+    is distributed to the specified number of threads (0: number of
+    available processors). The random numbers are drawn in the order
+    of the events, such that the results do not depend on the number
+    of threads. */
+void phproj_threads(GenInst* const inst,
+		    const Attitude* const ac,
+		    EventFile* const plf,
+		    const double t0,
+		    const double exposure,
+		    const int nthreads,
+		    int* const status);
+
 /** Update RA DEC column of the given file using the PIXID column */
 void phproj_advdet(GenInst* const inst,
 		AdvDet* const adv_det,
-	    Attitude* const ac,
+	    const Attitude* const ac,
 	    TesEventFile* const event_file,
 	    const double t0,
 	    const double exposure,
@@ -22,6 +22,95 @@
 
 #include "psf.h"
 
+#include <limits.h>
+
+
+/** Determine the pixel of the PSF image corresponding to the given
+    value of the cumulative distribution, i.e., the first pixel whose
+    cumulative value is greater than or equal to rnd. The value must
+    not exceed the total sum of the image. */
+static void getPSFItemPixel(const PSF_Item* const psf_item,
+			    const double rnd,
+			    int* const x1, int* const y1)
+{
+  if (NULL!=psf_item->guide) {
+    // Indexed search: start at the guide table entry and correct the
+    // position by a few steps. The result is the same as for the
+    // binary search below.
+    int jj=(int)(rnd*psf_item->nguide);
+    if (jj>=psf_item->nguide) jj=psf_item->nguide-1;
+    long kk=psf_item->guide[jj];
+    while ((kk>0)&&(psf_item->cdf[kk-1]>=rnd)) kk--;
+    while (psf_item->cdf[kk]<rnd) kk++;
+
+    *x1=(int)(kk/psf_item->naxis2);
+    *y1=(int)(kk%psf_item->naxis2);
+    return;
+  }
+
+  // Perform a binary search to obtain the x-coordinate.
+  int high=psf_item->naxis1-1;
+  int low=0;
+  int mid;
+  int ymax=psf_item->naxis2-1;
+  while (high > low) {
+    mid=(low+high)/2;
+    if (psf_item->data[mid][ymax] < rnd) {
+      low=mid+1;
+    } else {
+      high=mid;
+    }
+  }
+  *x1=low;
+
+  // Search for the y coordinate:
+  high=psf_item->naxis2-1;
+  low=0;
+  while (high > low) {
+    mid=(low+high)/2;
+    if (psf_item->data[*x1][mid] < rnd) {
+      low=mid+1;
+    } else {
+      high=mid;
+    }
+  }
+  *y1=low;
+}
+
+
+/** Set up the guide table for the indexed search in the cumulative
+    distribution of the PSF image. The table is only created if the
+    cumulative distribution is stored contiguously and is monotonically
+    increasing. */
+static void initPSFItemGuide(PSF_Item* const psf_item, int* const status)
+{
+  if (NULL==psf_item->cdf) return;
+
+  long npixels=(long)psf_item->naxis1*psf_item->naxis2;
+  if ((npixels<1)||(npixels>INT_MAX)) return;
+
+  long kk;
+  for (kk=1; kk<npixels; kk++) {
+    if (psf_item->cdf[kk]<psf_item->cdf[kk-1]) {
+      headas_chat(5, "PSF image contains negative values, use binary search\n");
+      return;
+    }
+  }
+
+  psf_item->guide=(int*)malloc(npixels*sizeof(int));
+  CHECK_NULL_VOID(psf_item->guide, *status,
+		  "memory allocation for PSF guide table failed");
+  psf_item->nguide=(int)npixels;
+
+  kk=0;
+  int jj;
+  for (jj=0; jj<psf_item->nguide; jj++) {
+    double threshold=jj*1./psf_item->nguide;
+    while ((kk<npixels-1)&&(psf_item->cdf[kk]<threshold)) kk++;
+    psf_item->guide[jj]=(int)kk;
+  }
+}
+
 
 int get_psf_pos(struct Point2d* const position,
 		const Photon photon,
@@ -122,34 +211,7 @@ int get_psf_pos(struct Point2d* const position,
 
   // PSF coordinates [pixel] of the position obtained from the best fitting PSF image.
   int x1, y1;
-
-  // Perform a binary search to obtain the x-coordinate.
-  int high=psf_item->naxis1-1;
-  int low=0;
-  int mid;
-  int ymax=psf_item->naxis2-1;
-  while (high > low) {
-    mid=(low+high)/2;
-    if (psf_item->data[mid][ymax] < rnd) {
-      low=mid+1;
-    } else {
-      high=mid;
-    }
-  }
-  x1=low;
-
-  // Search for the y coordinate:
-  high=psf_item->naxis2-1;
-  low=0;
-  while (high > low) {
-    mid=(low+high)/2;
-    if (psf_item->data[x1][mid] < rnd) {
-      low=mid+1;
-    } else {
-      high=mid;
-    }
-  }
-  y1=low;
+  getPSFItemPixel(psf_item, rnd, &x1, &y1);
   // Now x1 and y1 have pixel positions [integer pixel].
 
   // Determine the distance ([m]) of the central reference position
@@ -158,11 +220,16 @@ int get_psf_pos(struct Point2d* const position,
 
   // rotate to the phi used for evaluating the psf
   double sinp, cosp;
+  if (NULL!=psf->sinphis) {
+    sinp=psf->sinphis[index3];
+    cosp=psf->cosphis[index3];
+  } else {
 #if defined( __APPLE__) && defined(__MACH__)
-  __sincos(psf->phis[index3], &sinp, &cosp);
+    __sincos(psf->phis[index3], &sinp, &cosp);
 #else
-  sincos(psf->phis[index3], &sinp, &cosp);
+    sincos(psf->phis[index3], &sinp, &cosp);
 #endif
+  }
   position->x=cosp*distance;
   position->y=sinp*distance;
 
@@ -202,13 +269,22 @@ void destroyPSF(PSF** const psf)
 	  for (count2=0; count2<(*psf)->nthetas; count2++) {
 	    if (NULL!=(*psf)->data[count1][count2]) {
 	      for (count3=0; count3<(*psf)->nphis; count3++) {
-		if (NULL!=(*psf)->data[count1][count2][count3].data) {
-		  for (xcount=0; xcount<(*psf)->data[count1][count2][count3].naxis1; xcount++) {
-		    if (NULL!=(*psf)->data[count1][count2][count3].data[xcount]) {
-		      free((*psf)->data[count1][count2][count3].data[xcount]);
+		PSF_Item* item=&((*psf)->data[count1][count2][count3]);
+		if (NULL!=item->data) {
+		  if (NULL!=item->cdf) {
+		    // The rows point into the contiguous array.
+		    free(item->cdf);
+		  } else {
+		    for (xcount=0; xcount<item->naxis1; xcount++) {
+		      if (NULL!=item->data[xcount]) {
+			free(item->data[xcount]);
+		      }
 		    }
 		  }
-		  free((*psf)->data[count1][count2][count3].data);
+		  free(item->data);
+		}
+		if (NULL!=item->guide) {
+		  free(item->guide);
 		}
 	      }
 	      free((*psf)->data[count1][count2]);
@@ -223,6 +299,8 @@ void destroyPSF(PSF** const psf)
     if (NULL!=(*psf)->energies) free((*psf)->energies);
     if (NULL!=(*psf)->thetas  ) free((*psf)->thetas  );
     if (NULL!=(*psf)->phis    ) free((*psf)->phis    );
+    if (NULL!=(*psf)->sinphis ) free((*psf)->sinphis );
+    if (NULL!=(*psf)->cosphis ) free((*psf)->cosphis );
 
     free(*psf);
     *psf=NULL;
@@ -310,6 +388,8 @@ PSF* newPSF(const char* const filename,
     psf->energies = NULL;
     psf->thetas   = NULL;
     psf->phis     = NULL;
+    psf->sinphis  = NULL;
+    psf->cosphis  = NULL;
     psf->nenergies= 0;
     psf->nthetas  = 0;
     psf->nphis    = 0;
@@ -376,6 +456,22 @@ PSF* newPSF(const char* const filename,
       headas_chat(5, " %.3lf deg\n", psf->phis[count]/M_PI*180.);
     }
 
+    // Pre-compute the sine and cosine of the azimuthal angles.
+    psf->sinphis=(double*)malloc(MAX(psf->nphis, 1)*sizeof(double));
+    psf->cosphis=(double*)malloc(MAX(psf->nphis, 1)*sizeof(double));
+    if ((NULL==psf->sinphis)||(NULL==psf->cosphis)) {
+      *status=EXIT_FAILURE;
+      SIXT_ERROR("memory allocation for PSF data failed");
+      break;
+    }
+    for (count=0; count<psf->nphis; count++) {
+#if defined( __APPLE__) && defined(__MACH__)
+      __sincos(psf->phis[count], &(psf->sinphis[count]), &(psf->cosphis[count]));
+#else
+      sincos(psf->phis[count], &(psf->sinphis[count]), &(psf->cosphis[count]));
+#endif
+    }
+
     // Allocate memory for the 3-dimensional PSF data array.
     psf->data=(PSF_Item***)malloc(psf->nenergies*sizeof(PSF_Item**));
     if (NULL==psf->data) {
@@ -400,6 +496,9 @@ PSF* newPSF(const char* const filename,
 	// Initialize the PSF_Item objects in the 3-dimensional array.
 	for (count3=0; count3<psf->nphis; count3++) {
 	  psf->data[count][count2][count3].data = NULL;
+	  psf->data[count][count2][count3].cdf = NULL;
+	  psf->data[count][count2][count3].guide = NULL;
+	  psf->data[count][count2][count3].nguide = 0;
 	  psf->data[count][count2][count3].naxis1 = 0;
 	  psf->data[count][count2][count3].naxis2 = 0;
 	}
@@ -523,26 +622,23 @@ PSF* newPSF(const char* const filename,
 	}
 
 
-	// Get memory for the PSF_Item data.
+	// Get memory for the PSF_Item data. The rows are stored in one
+	// contiguous array.
+	psf->data[index1][index2][index3].cdf=(double *)
+	  malloc(psf->data[index1][index2][index3].naxis1*
+		 psf->data[index1][index2][index3].naxis2*sizeof(double));
 	psf->data[index1][index2][index3].data=(double **)
 	  malloc(psf->data[index1][index2][index3].naxis1*sizeof(double *));
-	if (NULL!=psf->data[index1][index2][index3].data) {
-	  for (count=0; count<psf->data[index1][index2][index3].naxis1; count++) {
-	    psf->data[index1][index2][index3].data[count]=(double *)
-	      malloc(psf->data[index1][index2][index3].naxis2*sizeof(double));
-	    if (NULL==psf->data[index1][index2][index3].data[count]) {
-	      *status=EXIT_FAILURE;
-	      SIXT_ERROR("not enough memory to store PSF data");
-	      break;
-	    }
-	  }
-	} else {
+	if ((NULL==psf->data[index1][index2][index3].cdf)||
+	    (NULL==psf->data[index1][index2][index3].data)) {
 	  *status=EXIT_FAILURE;
 	  SIXT_ERROR("not enough memory to store PSF data");
 	  break;
 	}
-	// Check if all memory was allocated successfully
-	CHECK_STATUS_BREAK(*status);
+	for (count=0; count<psf->data[index1][index2][index3].naxis1; count++) {
+	  psf->data[index1][index2][index3].data[count]=
+	    &(psf->data[index1][index2][index3].cdf[count*psf->data[index1][index2][index3].naxis2]);
+	}
 
 
 	// Allocate memory for input buffer (1D array)
@@ -590,6 +686,10 @@ PSF* newPSF(const char* const filename,
 	  }
 	}
 
+	// Set up the sampling of the impact positions.
+	initPSFItemGuide(&(psf->data[index1][index2][index3]), status);
+	CHECK_STATUS_BREAK(*status);
+
 	// Plot normalization of PSF for current off-axis angle and energy
 	headas_chat(5, "PSF: images %.2lf%% of incident photons for "
 		    "%.1lf keV, %.4lf arc min, %.4lf deg, \n",
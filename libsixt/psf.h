@@ -40,9 +40,24 @@
 /** Stores the PSF data for one particular off-axis angle and one
     particular energy. */
 typedef struct {
-  /** Pointer to the PSF data array [x][y]. */
+  /** Pointer to the PSF data array [x][y]. The array contains the
+      cumulative distribution of the pixel values (running over y
+      first), normalized to 1. */
   double** data;
 
+  /** Contiguous storage of the cumulative distribution. If this
+      pointer is not NULL, the rows of the data array point into this
+      array. Otherwise they have been allocated individually. */
+  double* cdf;
+
+  /** Guide table for the indexed search in the cumulative
+      distribution: guide[j] is the first pixel with a cumulative
+      value of at least j/nguide. If the pointer is NULL (e.g., for
+      images with negative pixel values), the impact position is
+      determined with a binary search. */
+  int* guide;
+  int nguide;
+
   /** Width of the image [pixel]. */
   int naxis1, naxis2;
   /** Width of one pixel [m]. */
@@ -72,6 +87,9 @@ typedef struct {
   int nphis;
   /** Different azimuthal angles PSF images are available for ([rad]). */
   double* phis;
+  /** Sine and cosine of the azimuthal angles (optional). */
+  double* sinphis;
+  double* cosphis;
 
 } PSF;
 
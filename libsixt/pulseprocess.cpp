@@ -41,7 +41,7 @@ The purpose of this package is to support utilities related to find pulses.
 
 MAP OF SECTIONS IN THIS FILE:
 
- - 1. lpf_boxcar
+ - 1. lpf_boxcar, lpf_boxcar_derivative
  - 2. differentiate
  - 3. findMeanSigma
  - 4. medianKappaClipping
@@ -63,6 +63,107 @@ MAP OF SECTIONS IN THIS FILE:
 
 #include "pulseprocess.h"
 
+#include <algorithm>
+
+/***** Scratch buffers *******************************************************
+* Work arrays of the preprocessing of the records (low-pass filtering, derivative and kappa-clipping). They are
+* thread-local, i.e., they can be used by concurrently running reconstruction threads without locking, and they
+* only grow, so they are allocated once per thread instead of once per record.
+*****************************************************************************/
+namespace
+{
+	thread_local std::vector<double> lpfScratch;
+	thread_local std::vector<double> mkcScratch;
+
+	/* Box-car low-pass filtering of the first 'szVct' elements of 'invector' (in place). If 'derivative' is true,
+	   the filtered vector is differentiated in the same pass (see 'lpf_boxcar' and 'differentiate'). */
+	int boxcarKernel (gsl_vector *invector, int szVct, double scaleFactor, int sampleRate, bool derivative)
+	{
+		// Define the LPF (frequency domain) and the box-car function (time domain)
+		double cutFreq = 2 * (1/(2*pi*scaleFactor));
+		int boxLength =(int) ((1/cutFreq) * sampleRate);
+
+		if (boxLength < 1)		boxLength = 1;
+		if (boxLength >= szVct)	        return(4);
+
+		// Lengthened copy of the input vector (to not have fake results for the last boxLength windows)
+		if (lpfScratch.size() < (size_t)(szVct+boxLength))	lpfScratch.resize(szVct+boxLength);
+		double *aux = &lpfScratch[0];
+		double *vct = invector->data;
+		size_t stride = invector->stride;
+		for (int i=0;i<szVct;i++)
+		{
+			aux[i] = vct[i*stride];
+		}
+		double value = aux[szVct-1];
+		for (int i=szVct;i<szVct+boxLength;i++)
+		{
+			if (value > 0) 		value = value-0.01*value;
+			else if (value< 0)	value = value+0.01*value;
+			aux[i] = value;
+		}
+
+		// Apply the box-car window by shifting it along the (lengthened) input vector
+		double boxSum = 0.0;
+		for (int i=0;i<boxLength;i++)
+		{
+			boxSum = boxSum + aux[i];
+		}
+		double filtered = boxSum/boxLength;
+		if (!derivative)	vct[0] = filtered;
+		for (int i=0;i<szVct-1;i++)
+		{
+			boxSum = boxSum - aux[i] + aux[i+boxLength];
+			double next = boxSum/boxLength;
+			if (derivative)		vct[i*stride] = next-filtered;
+			else			vct[(i+1)*stride] = next;
+			filtered = next;
+		}
+		if (derivative)		vct[(szVct-1)*stride] = vct[(szVct-2)*stride];
+
+		if (boxLength == 1)	return(3);
+
+		return (EPOK);
+	}
+
+	/* Mean and standard deviation of the first 'size' elements of 'vct' (see 'findMeanSigma') */
+	void meanSigma (const double *vct, size_t stride, int size, double *mean, double *sigma)
+	{
+		bool veryBig = false;
+		for (int i=0;i<size;i++)
+		{
+			if (vct[i*stride]>1e10)
+			{
+				veryBig = true;
+				break;
+			}
+		}
+
+		if (veryBig == false)
+		{
+			double sum = 0.0;
+			for (int i=0;i<size;i++)
+			{
+				sum = sum + vct[i*stride];
+			}
+			*mean = sum/size;
+			// Standard deviation
+			double suma = 0.0;
+			for (int i=0;i<size;i++)
+			{
+				suma = suma + pow(vct[i*stride]-*mean,2.0);
+			}
+			*sigma = sqrt(suma/(size-1));
+		}
+		else	// To avoid an inf in IO or a NAN in JUPITER
+		{
+			*mean = 1e10;
+			*sigma = 1e10;
+		}
+	}
+}
+
+
 /***** SECTION 1 ************************************************************
 * lpf_boxcar function: This function implements a low pass filtering as a box-car function in time
 *
@@ -78,11 +179,10 @@ MAP OF SECTIONS IN THIS FILE:
 *   	sinc(fc)=0, sinc(1)=0 => fc=1
 *   	fc=kf1 => fc~2f1
 *
-* - Declare variables
 * - Define the LPF (frequency domain) and the box-car function (time domain)
-* - It is going to work with a longer vector to not have fake results for the last boxLength windows
+* - It is going to work with a longer copy of the vector (thread-local scratch buffer) to not have fake results for
+*   the last boxLength windows
 * - Apply the box-car window by shifting it along the (lengthened) input vector
-* - Free allocated GSL vectors
 *
 *  The function returns:
 *    1: Function cannot run
@@ -97,88 +197,27 @@ MAP OF SECTIONS IN THIS FILE:
 ******************************************************************************/
 int lpf_boxcar (gsl_vector **invector, int szVct, double scaleFactor, int sampleRate)
 {
-	string message = "";
-	char valERROR[256];
-	
-	// Declare variables
-	gsl_vector *invectorAux;
-	gsl_vector *invectorAux1;
-	double cutFreq;	//Frequency domain
-	int boxLength;	//Time domain
-	double boxSum = 0.0;
-
-	// Define the LPF (frequency domain) and the box-car function (time domain)
-	cutFreq = 2 * (1/(2*pi*scaleFactor));	//According to Jan, sinc(f1)=0.6 where f1=1/(2pi*scaleFactor)
-						//sinc(0.5)~0.6 => f1~0.5
-						//sinc(fc)=0, sinc(1)=0 => fc=1
-						//fc=kf1 => fc~2f1
-	boxLength =(int) ((1/cutFreq) * sampleRate);
-
-	if (boxLength < 1)		boxLength = 1;
-	if (boxLength >= szVct)	        return(4);
-
-	// It is going to work with a longer vector to not have fake results for the last boxLength windows
-	// (due to not having n samples to take into account)
-	// It is not necessary to check the allocation because 'boxLength' is 1 at least
-	invectorAux = gsl_vector_alloc(szVct+boxLength);
-	invectorAux1 = gsl_vector_alloc(szVct+boxLength);
-	for (int i=0;i<szVct;i++)
-	{
-		gsl_vector_set(invectorAux,i,gsl_vector_get(*invector,i));	// 'i' already correct in the for
-	}
-	double value = gsl_vector_get(*invector,szVct-1);
-	for (int i=szVct;i<szVct+boxLength;i++)
-	{
-		if (value > 0) 		value = value-0.01*value;
-		else if (value< 0)	value = value+0.01*value;
-		gsl_vector_set(invectorAux,i,value);				// 'i' already correct in the for
-	}
-
-	// Apply the box-car window by shifting it along the (lengthened) input vector 
-	for (int i=0;i<boxLength;i++)
-	{
-		boxSum = boxSum + gsl_vector_get(invectorAux,i);
-	}
-	gsl_vector_set(invectorAux1,0,boxSum/boxLength);			// 'i' already correct in the for
-
-	if (invectorAux->size-boxLength-1+1 > invectorAux1->size-1)
-	{
-		sprintf(valERROR,"%d",__LINE__+8);
-		string str(valERROR);
-		message = "Setting i-th element of vector out of range in line " + str + " (" + __FILE__ + ")";
-		EP_PRINT_ERROR(message,EPFAIL);
-	}
-	for (int i=0;i<invectorAux->size-boxLength;i++)
-	{
-		boxSum = boxSum - gsl_vector_get(invectorAux,i) + gsl_vector_get(invectorAux,i+boxLength);
-		gsl_vector_set(invectorAux1,i+1,boxSum/boxLength);		
-	}
-
-	if (invectorAux->size-boxLength+boxLength-2+1 > invectorAux1->size-1)
-	{
-		sprintf(valERROR,"%d",__LINE__+8);
-		string str(valERROR);
-		message = "Setting i-th element of vector out of range in line " + str + " (" + __FILE__ + ")";
-		EP_PRINT_ERROR(message,EPFAIL);
-	}
-	for (int i=0;i<boxLength-1;i++)
-	{
-		boxSum = boxSum - gsl_vector_get(invectorAux,invectorAux->size-boxLength+i);
-		gsl_vector_set(invectorAux1,invectorAux->size-boxLength+i+1,boxSum/(boxLength-i-1));
-	}
+	return(boxcarKernel(*invector,szVct,scaleFactor,sampleRate,false));
+}
 
-	for (int i=0;i<szVct;i++)
-	{
-		gsl_vector_set(*invector,i,gsl_vector_get(invectorAux1,i));	// 'i' already correct in the for
-	}
 
-	// Free allocated GSL vectors
-	gsl_vector_free(invectorAux); invectorAux = 0;
-	gsl_vector_free(invectorAux1); invectorAux1 = 0;
-	
-	if (boxLength == 1)	return(3);
-
-	return (EPOK);
+/***** SECTION 1 ************************************************************
+* lpf_boxcar_derivative function: This function applies the low pass filtering ('lpf_boxcar') and the derivative
+*                                 ('differentiate') to the input vector in a single pass
+*
+* The result is identical to calling 'lpf_boxcar' and 'differentiate' one after the other. The return values are the
+* ones of 'lpf_boxcar' (if the vector is not filtered because of a too low cut-off frequency, it is not differentiated
+* either).
+*
+* Parameters:
+* - invector: Input/Output vector (non-filtered input vector/differentiated filtered input vector)
+* - szVct: Size of the invector
+* - scaleFactor: Scale factor
+* - sampleRate: Sampling frequency (samples per second)
+******************************************************************************/
+int lpf_boxcar_derivative (gsl_vector **invector, int szVct, double scaleFactor, int sampleRate)
+{
+	return(boxcarKernel(*invector,szVct,scaleFactor,sampleRate,true));
 }
 /*xxxx end of SECTION 1 xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx*/
 
@@ -195,12 +234,13 @@ int lpf_boxcar (gsl_vector **invector, int szVct, double scaleFactor, int sample
 ******************************************************************************/
 int differentiate (gsl_vector **invector,int szVct)
 {
+	double *vct = (*invector)->data;
+	size_t stride = (*invector)->stride;
 	for (int i=0; i<szVct-1; i++)
 	{
-		gsl_vector_set(*invector,i,gsl_vector_get(*invector,i+1)-gsl_vector_get(*invector,i));	
+		vct[i*stride] = vct[(i+1)*stride]-vct[i*stride];
 	}
-	gsl_vector_set(*invector,szVct-1,gsl_vector_get(*invector,szVct-2));
-	//gsl_vector_set(*invector,szVct-1,-999);
+	vct[(szVct-1)*stride] = vct[(szVct-2)*stride];
 
 	return (EPOK);
 }
@@ -217,112 +257,9 @@ int differentiate (gsl_vector **invector,int szVct)
 ******************************************************************************/
 int findMeanSigma (gsl_vector *invector, double *mean, double *sigma)
 {
-	// Declare variables
-	int size = invector->size; // Size of the input vector
-	// To calculate the mean
-	bool veryBig = false;
-        double suma = 0.0;
-
-	// Mean
-	for (int i=0;i<size;i++)
-	{
-                if (gsl_vector_get(invector,i)>1e10)
-		{
-			veryBig =true;
-			break;
-		}
-	}
-	
-	if (veryBig == false)
-	{
-                *mean = 0.0;
-                for (int i=0;i<size;i++)
-                {
-                    *mean = *mean + gsl_vector_get(invector,i);
-                }
-                *mean = *mean/size;
-		// Standard deviation
-                for (int i=0;i<size;i++)
-                {
-                    suma = suma + pow(gsl_vector_get(invector,i)-*mean,2.0);
-                }
-                *sigma = sqrt(suma/(size-1));
-	}
-	else	// To avoid an inf in IO or a NAN in JUPITER
-	{
-		*mean = 1e10;
-		*sigma = 1e10;
-	}
+	meanSigma(invector->data,invector->stride,invector->size,mean,sigma);
 
 	return EPOK;
-        
-        
-        /*// Declare variables
-	int size = invector->size; // Size of the input vector
-	// To calculate the mean
-	//double data[size];	// Intermediate value to use 'gsl_stats_median_from_sorted_data'
-	bool veryBig = false;
-
-	// Mean
-	for (int i=0;i<size;i++)
-	{
-		//data[i] = gsl_vector_get(invector,i);
-		//if (data[i]>1e10)
-                if (gsl_vector_get(invector,i)>1e10)
-		{
-			veryBig =true;
-			break;
-		}
-	}
-	
-	gsl_vector *vector_prueba = gsl_vector_alloc(5);
-        gsl_vector_set(vector_prueba,0,2);
-        gsl_vector_set(vector_prueba,1,20);
-        gsl_vector_set(vector_prueba,2,-2);
-        gsl_vector_set(vector_prueba,3,17);
-        gsl_vector_set(vector_prueba,4,-0.5);
-        double media = 0.0;
-        double suma =0.0;
-        double std;
-        double data_prueba[5];
-        for (int i=0;i<5;i++)
-	{
-		data_prueba[i] = gsl_vector_get(vector_prueba,i);
-        }
-	
-	if (veryBig == false)
-	{
-                
-                media = 0.0;
-                for (int i=0;i<5;i++)
-                {
-                    media = media + gsl_vector_get(vector_prueba,i);
-                }
-                media = media/5;
-		//*mean = gsl_stats_mean(data, 1, size);
-                *mean = gsl_stats_mean(data_prueba, 1, 5);
-		// Standard deviation
-                
-                for (int i=0;i<5;i++)
-                {
-                    suma = suma + pow(gsl_vector_get(vector_prueba,i)-media,2.0);
-                    cout<<"suma: "<<suma<<endl;
-                }
-                std = sqrt(suma/4);
-		//*sigma= gsl_stats_sd_m(data, 1, size, *mean);
-		*sigma= gsl_stats_sd_m(data_prueba, 1, 5, *mean);
-                cout<<"media0: "<<media<<endl;
-                cout<<"*mean: "<<*mean<<endl;
-                cout<<"std0: "<<std<<endl;
-                cout<<"*sigma: "<<*sigma<<endl;
-	}
-	else	// To avoid an inf in IO or a NAN in JUPITER
-	{
-		*mean = 1e10;
-		*sigma = 1e10;
-	}
-
-	return EPOK;*/
 }
 /*xxxx end of SECTION 3 xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx*/
 
@@ -337,8 +274,9 @@ int findMeanSigma (gsl_vector *invector, double *mean, double *sigma)
 * if there are pulses in the input invector they are always positive).
 *
 * - Declare variables
-* - Calculate the median
-* - Iterate until there are no points out of the maximum excursion (kappa*sigma)
+* - Calculate the median (by a linear-time selection in a thread-local copy of the input vector)
+* - Iterate until there are no points out of the maximum excursion (kappa*sigma). The mean and sigma after the
+*   replacement are the starting values of the next iteration
 * - Establish the threshold as mean+nSigmas*sigma
 *
 * Parameters:
@@ -356,199 +294,80 @@ int medianKappaClipping (gsl_vector *invector, double kappa, double stopCriteria
 
 	// Declare variables
 	int size = invector->size; // Size of the input vector
+	int sizeStats = size-boxLPF-1;	// Number of elements used to calculate mean and sigma
 	double mean1, sg1;
 	double mean2, sg2;
-	gsl_vector_view temp;
-	// Variables to remove input vector elements higher than the maximum excursion (kappa*sg)
-	int i;							// To go through the elements of a vector
-	int cnt;						// Number of points inside the excursion (mean+-excursion)
-	// It is not necessary to check the allocation because 'invector' size must already be > 0
-	gsl_vector *invectorNew = gsl_vector_alloc(size);	// Auxiliary vector
-        
-        /*gsl_vector *vector_prueba = gsl_vector_alloc(6);
-        gsl_vector_set(vector_prueba,0,2);
-        gsl_vector_set(vector_prueba,1,20);
-        gsl_vector_set(vector_prueba,2,-2);
-        gsl_vector_set(vector_prueba,3,17);
-        gsl_vector_set(vector_prueba,4,-0.5);
-        gsl_vector_set(vector_prueba,5,23);
-        gsl_sort_vector(vector_prueba);
-        cout<<"median0="<<(gsl_vector_get(vector_prueba,(int) (6/2)-1)+gsl_vector_get(vector_prueba,(int) (6/2)))/2<<endl;
-        double data_prueba[6];				
-        for (int i=0;i<6;i++)
+	int cnt;			// Number of points out of the excursion (mean+-excursion)
+
+	if ((sizeStats < 1) || (sizeStats > size))
 	{
-		data_prueba[i] = gsl_vector_get(vector_prueba,i);
+		sprintf(valERROR,"%d",__LINE__-2);
+		string str(valERROR);
+		message = "View goes out of scope the original vector in line " + str + " (" + __FILE__ + ")";
+		EP_PRINT_ERROR(message,EPFAIL); return(EPFAIL);
 	}
-	gsl_sort(data_prueba,1,6);
-	cout<<"median1: "<<gsl_stats_median_from_sorted_data(data_prueba,1,6)<<endl;*/
-        
-	// To calculate the median
-	//double data[size];					// Intermediate value to use 'gsl_stats_median_from_sorted_data'
-	double median;
 
-	// Median
-	/*for (int i=0;i<size;i++)
+	// Auxiliary vector
+	if (mkcScratch.size() < (size_t)size)	mkcScratch.resize(size);
+	double *invectorNew = &mkcScratch[0];
+	for (int i=0;i<size;i++)
 	{
-		data[i] = gsl_vector_get(invector,i);
+		invectorNew[i] = gsl_vector_get(invector,i);
 	}
-	gsl_sort(data,1,size);
-	median = gsl_stats_median_from_sorted_data(data,1,size);*/
-        gsl_vector_memcpy(invectorNew,invector);
-        gsl_sort_vector(invectorNew);
-        if (size%2 == 0)	//Even
-        {
-            median = (gsl_vector_get(invectorNew,(int) (size/2)-1)+gsl_vector_get(invectorNew,(int) (size/2)))/2;
-        }
-        else                    //Odd
-        {
-            median = gsl_vector_get(invectorNew,(int) (size/2));
-        }
-
-	gsl_vector_memcpy(invectorNew,invector);
 
-	// Iterate until no points out of the maximum excursion (kappa*sigma)
-	do
+	// Median
+	double median;
+	std::nth_element(invectorNew,invectorNew+size/2,invectorNew+size);
+	if (size%2 == 0)	//Even
 	{
-		if ((size-boxLPF-1 < 1) || (size-boxLPF-1 >invectorNew->size))
-		{
-			sprintf(valERROR,"%d",__LINE__+5);
-			string str(valERROR);
-			message = "View goes out of scope the original vector in line " + str + " (" + __FILE__ + ")";
-			EP_PRINT_ERROR(message,EPFAIL);
-		}
-		temp = gsl_vector_subvector(invectorNew,0,size-boxLPF-1);
-		if (findMeanSigma (&temp.vector, &mean1, &sg1))
-		{
-			message = "Cannot run findMeanSigma routine for kappa-sigma iteration";
-			EP_PRINT_ERROR(message,EPFAIL);return(EPFAIL);
-		}
-		i = 0;
-		cnt = 0;
-
-		while (i<invectorNew->size)
-		{
-			if ((gsl_vector_get(invectorNew,i) >= mean1 + kappa*sg1) || (gsl_vector_get(invectorNew,i) <= mean1 - kappa*sg1))
-			// HARDPOINT!!!!!!!!!!!!!!!!!!! (kappa)
-			{
-				if ((i < 0) || (i >(invectorNew)->size-1))
-				{
-					sprintf(valERROR,"%d",__LINE__+5);
-					string str(valERROR);
-					message = "Setting with <= 0 size in line " + str + " (" + __FILE__ + ")";
-					EP_PRINT_ERROR(message,EPFAIL);
-				}
-				gsl_vector_set(invectorNew,i,median);
-				cnt++;
-			}
-			i++;
-		}
-
-		if (cnt != 0)
-		// Some points of the invector have been replaced with the median
-		{
-			temp = gsl_vector_subvector(invectorNew,0,size-boxLPF-1);
-			if (findMeanSigma (&temp.vector, &mean2, &sg2))
-			{
-				message = "Cannot run findMeanSigma routine for kappa-sigma iteration after replacement with the median";
-				EP_PRINT_ERROR(message,EPFAIL);return(EPFAIL);
-			}
-		}
-		else
-		// No points of the invector have been replaced with the median
-		{
-			mean2 =mean1;
-			sg2 = sg1;
-		}
-
-	} while (fabs((mean2-mean1)/mean1)>(stopCriteria/100.0));	// HARDPOINT!!!!!!!!!!!!!!!!!!! (stopCriteria)
-	
+		median = (*std::max_element(invectorNew,invectorNew+size/2)+invectorNew[size/2])/2;
+	}
+	else                    //Odd
+	{
+		median = invectorNew[size/2];
+	}
 
-	// Establish the threshold as mean+nSigmas*sigma
-	*threshold = mean2+nSigmas*sg2;	// HARDPOINT!!!!!!!!!!!!!!!!!!! (nSigmas)
-	//cout<<"threshold="<<*threshold<<endl;
-        //cout<<"mean2="<<mean2<<" sigma="<<sg2<<endl;
-        	
-	////////////////////////////////////////////////////////////////
-	/*size = 2000;
-        double dataNew[size];
-        double sg2New;
-	// Median
 	for (int i=0;i<size;i++)
 	{
-		dataNew[i] = gsl_vector_get(invector,i);
+		invectorNew[i] = gsl_vector_get(invector,i);
 	}
-	gsl_sort(dataNew,1,size);
-	median = gsl_stats_median_from_sorted_data (dataNew,1,size);
-
-	gsl_vector_memcpy(invectorNew,invector);
 
 	// Iterate until no points out of the maximum excursion (kappa*sigma)
-	do
+	meanSigma(invectorNew,1,sizeStats,&mean1,&sg1);
+	while (1)
 	{
-		if ((size-boxLPF-1 < 1) || (size-boxLPF-1 >invectorNew->size))
-		{
-			sprintf(valERROR,"%d",__LINE__+5);
-			string str(valERROR);
-			message = "View goes out of scope the original vector in line " + str + " (" + __FILE__ + ")";
-			EP_PRINT_ERROR(message,EPFAIL);
-		}
-		temp = gsl_vector_subvector(invectorNew,0,size);
-		if (findMeanSigma (&temp.vector, &mean1, &sg1))
-		{
-			message = "Cannot run findMeanSigma routine for kappa-sigma iteration";
-			EP_PRINT_ERROR(message,EPFAIL);return(EPFAIL);
-		}
-		i = 0;
+		double upper = mean1 + kappa*sg1;	// HARDPOINT!!!!!!!!!!!!!!!!!!! (kappa)
+		double lower = mean1 - kappa*sg1;
 		cnt = 0;
-
-		while (i<invectorNew->size)
+		for (int i=0;i<size;i++)
 		{
-			if ((gsl_vector_get(invectorNew,i) >= mean1 + kappa*sg1) || (gsl_vector_get(invectorNew,i) <= mean1 - kappa*sg1))
-			// HARDPOINT!!!!!!!!!!!!!!!!!!! (kappa)
+			if ((invectorNew[i] >= upper) || (invectorNew[i] <= lower))
 			{
-				if ((i < 0) || (i >(invectorNew)->size-1))
-				{
-					sprintf(valERROR,"%d",__LINE__+5);
-					string str(valERROR);
-					message = "Setting with <= 0 size in line " + str + " (" + __FILE__ + ")";
-					EP_PRINT_ERROR(message,EPFAIL);
-				}
-				gsl_vector_set(invectorNew,i,median);
+				invectorNew[i] = median;
 				cnt++;
 			}
-			i++;
 		}
 
 		if (cnt != 0)
 		// Some points of the invector have been replaced with the median
 		{
-			temp = gsl_vector_subvector(invectorNew,0,size);
-			if (findMeanSigma (&temp.vector, &mean2, &sg2New))
-			{
-				message = "Cannot run findMeanSigma routine for kappa-sigma iteration after replacement with the median";
-				EP_PRINT_ERROR(message,EPFAIL);return(EPFAIL);
-			}
+			meanSigma(invectorNew,1,sizeStats,&mean2,&sg2);
 		}
 		else
 		// No points of the invector have been replaced with the median
 		{
 			mean2 =mean1;
-			sg2New = sg1;
+			sg2 = sg1;
 		}
 
-	} while (fabs((mean2-mean1)/mean1)>(stopCriteria/100.0));	// HARDPOINT!!!!!!!!!!!!!!!!!!! (stopCriteria)
+		if (!(fabs((mean2-mean1)/mean1)>(stopCriteria/100.0)))	break;	// HARDPOINT!!!!!!!!!!!!!!!!!!! (stopCriteria)
 
-	// Establish the threshold as mean+nSigmas*sigma
-	double thresholdNew = mean2+nSigmas*sg2New;	// HARDPOINT!!!!!!!!!!!!!!!!!!! (nSigmas)
-	cout<<thresholdNew<<endl;
-	//cout<<"thresholdNew="<<thresholdNew<<endl;
-        //cout<<"sigmaNew="<<sg2New<<endl;
-        
-        //cout<<"theshold-thesholdNew="<<(*threshold-thresholdNew)/sg2<<"sgs"<<endl;
-        //cout<<"theshold-thesholdNew="<<(*threshold-thresholdNew)/sg2New<<"sgsNew"<<endl;*/
-	////////////////////////////////////////////////////////////////
+		mean1 = mean2;
+		sg1 = sg2;
+	}
 
-	gsl_vector_free(invectorNew); invectorNew= 0;
+	// Establish the threshold as mean+nSigmas*sigma
+	*threshold = mean2+nSigmas*sg2;	// HARDPOINT!!!!!!!!!!!!!!!!!!! (nSigmas)
 
 	return EPOK;
 }
@@ -44,6 +44,7 @@
 	#include <integraSIRENA.h>
 
 	int lpf_boxcar (gsl_vector **invector, int szVct, double scaleFactor, int sampleRate);
+	int lpf_boxcar_derivative (gsl_vector **invector, int szVct, double scaleFactor, int sampleRate);
 	int differentiate (gsl_vector **invector,int szVct);
 
 	int findMeanSigma (gsl_vector *invector, double *mean, double *sigma);
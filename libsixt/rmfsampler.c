@@ -0,0 +1,370 @@
+/*
+   This file is part of SIXTE.
+
+   SIXTE is free software: you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   any later version.
+
+   SIXTE is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   For a copy of the GNU General Public License see
+   <http://www.gnu.org/licenses/>.
+
+
+   Copyright 2019 Remeis-Sternwarte, Friedrich-Alexander-Universitaet
+                  Erlangen-Nuernberg
+*/
+
+#include "rmfsampler.h"
+
+#include <pthread.h>
+
+
+/////////////////////////////////////////////////////////////////
+// Type Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Entry of the registry of shared RMFs. */
+typedef struct {
+  /** Name of the file the RMF has been loaded from. NULL for RMFs
+      that have been registered by getSharedRMFSampler(). */
+  char* filename;
+
+  struct RMF* rmf;
+
+  /** Sampler for the RMF. Built on demand. */
+  RMFSampler* sampler;
+
+  /** Number of users of the RMF. */
+  long refcount;
+
+} SharedRMF;
+
+
+/////////////////////////////////////////////////////////////////
+// Static Variables.
+/////////////////////////////////////////////////////////////////
+
+
+/** Registry of the RMFs shared by different detectors. The access is
+    protected by the mutex, such that detectors can be initialized by
+    different threads. */
+static SharedRMF* shared_rmfs=NULL;
+static long nshared_rmfs=0;
+static long maxshared_rmfs=0;
+static pthread_mutex_t shared_rmfs_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+
+/////////////////////////////////////////////////////////////////
+// Static Functions.
+/////////////////////////////////////////////////////////////////
+
+
+/** Return the index of the energy bin containing the given energy,
+    i.e., the first bin with an upper boundary not below the
+    energy. */
+static long getRMFEnergyBin(const struct RMF* const rmf, const double energy)
+{
+  long lower=0, upper=rmf->NumberEnergyBins-1;
+  while (upper>lower) {
+    long mid=(lower+upper)/2;
+    if (rmf->HighEnergy[mid]<energy) {
+      lower=mid+1;
+    } else {
+      upper=mid;
+    }
+  }
+  return(upper);
+}
+
+
+/** Return the index of the registry entry for the given RMF, or -1
+    if the RMF is not registered. The mutex has to be locked by the
+    calling routine. */
+static long findSharedRMF(const struct RMF* const rmf)
+{
+  long ii;
+  for (ii=0; ii<nshared_rmfs; ii++) {
+    if (shared_rmfs[ii].rmf==rmf) {
+      return(ii);
+    }
+  }
+  return(-1);
+}
+
+
+/** Append a new entry with a reference counter of 1 to the
+    registry. The mutex has to be locked by the calling routine. */
+static long addSharedRMF(struct RMF* const rmf,
+			 const char* const filename,
+			 int* const status)
+{
+  if (nshared_rmfs>=maxshared_rmfs) {
+    long newsize=MAX(2*maxshared_rmfs, 8);
+    SharedRMF* entries=
+      (SharedRMF*)realloc(shared_rmfs, newsize*sizeof(SharedRMF));
+    CHECK_NULL_RET(entries, *status,
+		   "memory allocation for RMF registry failed", -1);
+    shared_rmfs=entries;
+    maxshared_rmfs=newsize;
+  }
+
+  SharedRMF* entry=&(shared_rmfs[nshared_rmfs]);
+  entry->filename=NULL;
+  entry->rmf=rmf;
+  entry->sampler=NULL;
+  entry->refcount=1;
+
+  if (NULL!=filename) {
+    entry->filename=strdup(filename);
+    CHECK_NULL_RET(entry->filename, *status,
+		   "memory allocation for RMF file name failed", -1);
+  }
+
+  return(nshared_rmfs++);
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Program Code.
+/////////////////////////////////////////////////////////////////
+
+
+RMFSampler* newRMFSampler(const struct RMF* const rmf, int* const status)
+{
+  RMFSampler* sampler=(RMFSampler*)malloc(sizeof(RMFSampler));
+  CHECK_NULL_RET(sampler, *status,
+		 "memory allocation for RMFSampler failed", sampler);
+
+  // Initialize pointers with NULL.
+  sampler->first  =NULL;
+  sampler->cum    =NULL;
+  sampler->channel=NULL;
+
+  // Initialize values.
+  sampler->rmf      =rmf;
+  sampler->nbins    =0;
+  sampler->monotonic=1;
+
+  CHECK_NULL_RET(rmf, *status, "no RMF specified for RMFSampler", sampler);
+  sampler->nbins=rmf->NumberEnergyBins;
+
+  // Determine the number of matrix elements.
+  sampler->first=(long*)malloc((sampler->nbins+1)*sizeof(long));
+  CHECK_NULL_RET(sampler->first, *status,
+		 "memory allocation for RMFSampler failed", sampler);
+
+  long nelements=0;
+  long ii;
+  for (ii=0; ii<sampler->nbins; ii++) {
+    sampler->first[ii]=nelements;
+    long jj;
+    for (jj=0; jj<rmf->NumberGroups[ii]; jj++) {
+      nelements+=rmf->NumberChannelGroups[rmf->FirstGroup[ii]+jj];
+    }
+  }
+  sampler->first[sampler->nbins]=nelements;
+
+  sampler->cum=(double*)malloc(MAX(nelements, 1)*sizeof(double));
+  CHECK_NULL_RET(sampler->cum, *status,
+		 "memory allocation for RMFSampler failed", sampler);
+  sampler->channel=(long*)malloc(MAX(nelements, 1)*sizeof(long));
+  CHECK_NULL_RET(sampler->channel, *status,
+		 "memory allocation for RMFSampler failed", sampler);
+
+  // Accumulate the matrix elements of each energy bin in the same
+  // order as returnRMFChannel() does.
+  for (ii=0; ii<sampler->nbins; ii++) {
+    double sum=0.;
+    long kk=sampler->first[ii];
+    long jj;
+    for (jj=0; jj<rmf->NumberGroups[ii]; jj++) {
+      long igrp=rmf->FirstGroup[ii]+jj;
+      long ll;
+      for (ll=0; ll<rmf->NumberChannelGroups[igrp]; ll++) {
+	float element=rmf->Matrix[rmf->FirstElement[igrp]+ll];
+	if (element<0.) {
+	  sampler->monotonic=0;
+	}
+	sum+=element;
+	sampler->cum[kk]=sum;
+	sampler->channel[kk]=rmf->FirstChannelGroup[igrp]+ll+rmf->FirstChannel;
+	kk++;
+      }
+    }
+  }
+
+  return(sampler);
+}
+
+
+void freeRMFSampler(RMFSampler** const sampler)
+{
+  if (NULL!=*sampler) {
+    if (NULL!=(*sampler)->first) {
+      free((*sampler)->first);
+    }
+    if (NULL!=(*sampler)->cum) {
+      free((*sampler)->cum);
+    }
+    if (NULL!=(*sampler)->channel) {
+      free((*sampler)->channel);
+    }
+    free(*sampler);
+    *sampler=NULL;
+  }
+}
+
+
+long getRMFSamplerChannel(const RMFSampler* const sampler,
+			  const double energy,
+			  int* const status)
+{
+  const struct RMF* rmf=sampler->rmf;
+
+  // Check if the energy is outside the range covered by the RMF.
+  if ((energy<rmf->LowEnergy[0])||
+      (energy>rmf->HighEnergy[rmf->NumberEnergyBins-1])) {
+    return(-1);
+  }
+
+  long bin=getRMFEnergyBin(rmf, energy);
+
+  double p=sixt_get_random_number(status);
+  CHECK_STATUS_RET(*status, -1);
+
+  // Find the first element where the cumulative sum reaches the
+  // random number.
+  long lower=sampler->first[bin], upper=sampler->first[bin+1];
+  if (0!=sampler->monotonic) {
+    while (upper>lower) {
+      long mid=(lower+upper)/2;
+      if (sampler->cum[mid]<p) {
+	lower=mid+1;
+      } else {
+	upper=mid;
+      }
+    }
+    if (lower<sampler->first[bin+1]) {
+      return(sampler->channel[lower]);
+    }
+  } else {
+    for (; lower<upper; lower++) {
+      if (sampler->cum[lower]>=p) {
+	return(sampler->channel[lower]);
+      }
+    }
+  }
+
+  // The photon is not detected.
+  return(-1);
+}
+
+
+void getRMFSamplerChannels(const RMFSampler* const sampler,
+			   const float* const energy,
+			   const long n,
+			   long* const channel,
+			   int* const status)
+{
+  long ii;
+  for (ii=0; ii<n; ii++) {
+    channel[ii]=getRMFSamplerChannel(sampler, energy[ii], status);
+    CHECK_STATUS_VOID(*status);
+  }
+}
+
+
+struct RMF* loadSharedRMF(const char* const filename, int* const status)
+{
+  // Identify the file by its canonical path, such that different
+  // relative paths to the same file are recognized.
+  char path[MAXFILENAME];
+  if (NULL==realpath(filename, path)) {
+    strncpy(path, filename, MAXFILENAME-1);
+    path[MAXFILENAME-1]='\0';
+  }
+
+  pthread_mutex_lock(&shared_rmfs_mutex);
+
+  long ii;
+  for (ii=0; ii<nshared_rmfs; ii++) {
+    if ((NULL!=shared_rmfs[ii].filename)&&
+	(0==strcmp(shared_rmfs[ii].filename, path))) {
+      shared_rmfs[ii].refcount++;
+      struct RMF* rmf=shared_rmfs[ii].rmf;
+      pthread_mutex_unlock(&shared_rmfs_mutex);
+      return(rmf);
+    }
+  }
+
+  struct RMF* rmf=loadRMF((char*)filename, status);
+  if ((EXIT_SUCCESS==*status)&&(NULL!=rmf)) {
+    addSharedRMF(rmf, path, status);
+  }
+
+  pthread_mutex_unlock(&shared_rmfs_mutex);
+  return(rmf);
+}
+
+
+const RMFSampler* getSharedRMFSampler(struct RMF* const rmf,
+				      int* const status)
+{
+  CHECK_NULL_RET(rmf, *status, "no RMF specified for RMFSampler", NULL);
+
+  pthread_mutex_lock(&shared_rmfs_mutex);
+
+  long ii=findSharedRMF(rmf);
+  if (ii<0) {
+    ii=addSharedRMF(rmf, NULL, status);
+  }
+
+  RMFSampler* sampler=NULL;
+  if (EXIT_SUCCESS==*status) {
+    if (NULL==shared_rmfs[ii].sampler) {
+      shared_rmfs[ii].sampler=newRMFSampler(rmf, status);
+      if (EXIT_SUCCESS!=*status) {
+	freeRMFSampler(&shared_rmfs[ii].sampler);
+      }
+    }
+    sampler=shared_rmfs[ii].sampler;
+  }
+
+  pthread_mutex_unlock(&shared_rmfs_mutex);
+  return(sampler);
+}
+
+
+void releaseSharedRMF(struct RMF* const rmf)
+{
+  if (NULL==rmf) return;
+
+  pthread_mutex_lock(&shared_rmfs_mutex);
+
+  long ii=findSharedRMF(rmf);
+  if (ii<0) {
+    freeRMF(rmf);
+  } else if (0==--shared_rmfs[ii].refcount) {
+    freeRMFSampler(&shared_rmfs[ii].sampler);
+    if (NULL!=shared_rmfs[ii].filename) {
+      free(shared_rmfs[ii].filename);
+    }
+    freeRMF(rmf);
+
+    // Move the last entry to the free position.
+    shared_rmfs[ii]=shared_rmfs[--nshared_rmfs];
+    if (0==nshared_rmfs) {
+      free(shared_rmfs);
+      shared_rmfs=NULL;
+      maxshared_rmfs=0;
+    }
+  }
+
+  pthread_mutex_unlock(&shared_rmfs_mutex);
+}
@@ -0,0 +1,123 @@
+/*
+   This file is part of SIXTE.
+
+   SIXTE is free software: you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   any later version.
+
+   SIXTE is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   For a copy of the GNU General Public License see
+   <http://www.gnu.org/licenses/>.
+
+
+   Copyright 2019 Remeis-Sternwarte, Friedrich-Alexander-Universitaet
+                  Erlangen-Nuernberg
+*/
+
+#ifndef RMFSAMPLER_H
+#define RMFSAMPLER_H 1
+
+#include "sixt.h"
+#include "rmf.h"
+
+
+/////////////////////////////////////////////////////////////////
+// Type Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Pre-computed cumulative distribution of the detector channels for
+    each energy bin of an RMF. The random channel for a given energy
+    is determined with a binary search instead of summing up the
+    matrix elements for each photon. The sampler uses the same random
+    number and the same summation order as the SIMPUT routine
+    returnRMFChannel(), i.e., the resulting channels are identical to
+    the ones obtained with that routine. Once it has been initialized,
+    the sampler is only read and can be used by several threads at
+    the same time. */
+typedef struct {
+  /** Underlying RMF. The matrix is not modified and not released by
+      the destructor of the sampler. */
+  const struct RMF* rmf;
+
+  /** Number of energy bins. */
+  long nbins;
+
+  /** Index of the first entry of each energy bin in the arrays cum
+      and channel. The array contains nbins+1 entries, i.e., the
+      entries of energy bin ii are in the range
+      [first[ii],first[ii+1]). */
+  long* first;
+
+  /** Cumulative sum of the matrix elements within the energy bin. */
+  double* cum;
+
+  /** Channel corresponding to the respective matrix element. */
+  long* channel;
+
+  /** Flag whether all matrix elements are non-negative. Otherwise
+      the cumulative sums are not monotonic and the channel is
+      determined with a linear search. */
+  int monotonic;
+
+} RMFSampler;
+
+
+/////////////////////////////////////////////////////////////////
+// Function Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Constructor. Builds the cumulative channel distributions for all
+    energy bins of the RMF. */
+RMFSampler* newRMFSampler(const struct RMF* const rmf, int* const status);
+
+/** Destructor. */
+void freeRMFSampler(RMFSampler** const sampler);
+
+/** Determine a random detector channel for the given photon energy
+    [keV] according to the RMF. A single random number is taken from
+    the global generator via sixt_get_random_number(), if the energy
+    is within the range covered by the RMF. If the photon is not
+    detected, the return value is -1. */
+long getRMFSamplerChannel(const RMFSampler* const sampler,
+			  const double energy,
+			  int* const status);
+
+/** Determine the random detector channels for an array of n photon
+    energies [keV]. The random numbers are taken in the order of the
+    input array, i.e., the result is the same as for n subsequent
+    calls of getRMFSamplerChannel(). */
+void getRMFSamplerChannels(const RMFSampler* const sampler,
+			   const float* const energy,
+			   const long n,
+			   long* const channel,
+			   int* const status);
+
+/** Load the RMF from the specified file. If the same file has
+    already been loaded by another detector, the existing data
+    structure is returned and its reference counter is
+    incremented. The RMF has to be released with releaseSharedRMF()
+    and must not be modified. */
+struct RMF* loadSharedRMF(const char* const filename, int* const status);
+
+/** Return the sampler for the given RMF. The sampler is built on the
+    first call and shared by all detectors using the same RMF. If the
+    RMF has not been obtained via loadSharedRMF() (e.g., if it has
+    been loaded from an RSP file), the RMF is registered and will be
+    released together with the sampler by releaseSharedRMF(). */
+const RMFSampler* getSharedRMFSampler(struct RMF* const rmf,
+				      int* const status);
+
+/** Decrement the reference counter of the RMF. The RMF and its
+    sampler are released if they are not used any more. RMFs that
+    have never been registered are released immediately. */
+void releaseSharedRMF(struct RMF* const rmf);
+
+
+#endif /* RMFSAMPLER_H */
@@ -20,6 +20,7 @@
 
 #include "simput.h"
 #include "rndgen.h"
+#include "rndstream.h"
 
 // Use a Pseudo RNG for testing
 #include<mt19937ar.h>
@@ -34,6 +35,14 @@ unsigned int SIXT_RNG_INITIALIZED = 0;
 
 int USE_PSEUDO_RNG = 0;
 
+/** Seed given to sixt_init_rng. */
+static unsigned int SIXT_RNG_SEED = 0;
+
+/** Random number stream set for the current thread by
+    sixt_set_thread_rndstream(). It is kept in a thread-local variable,
+    such that the check costs no more than a plain memory access. */
+static __thread RndStream* thread_rndstream = NULL;
+
 unsigned int sixt_rng_is_initialized() {
 	return SIXT_RNG_INITIALIZED;
 }
@@ -42,6 +51,10 @@ unsigned int sixt_use_pseudo_rng() {
 	return USE_PSEUDO_RNG;
 }
 
+unsigned int sixt_get_rng_seed() {
+	return SIXT_RNG_SEED;
+}
+
 
 static double sixt_pseudo_random_number(int* const status){
 
@@ -87,10 +100,19 @@ static double sixt_std_random_number(int* const status){
 
 
 double sixt_get_random_number(int* const status){
+	// Threads with their own stream do not touch the global generator.
+	if (NULL!=thread_rndstream) {
+		return getRndStreamUniform(thread_rndstream);
+	}
 	return random_number_generator(status);
 }
 
 
+void sixt_set_thread_rndstream(RndStream* const rs) {
+	thread_rndstream = rs;
+}
+
+
 static void set_sixt_rng(double(*rndgen)(int* const)) {
 	random_number_generator=rndgen;
 }
@@ -106,6 +128,7 @@ void sixt_init_rng(const unsigned int seed, int* const status) {
 		return;
 	}
 
+	SIXT_RNG_SEED = seed;
 
 	if(getenv("SIXTE_USE_PSEUDO_RNG")!=NULL) {
 		USE_PSEUDO_RNG = 1;
@@ -22,6 +22,7 @@
 #define RNDGEN_H 1
 
 #include "headas_rand.h"
+#include "rndstream.h"
 #include "simput.h"
 #include "sixt.h"
 
@@ -37,6 +38,11 @@ unsigned int sixt_rng_is_initialized();
 /** Return value of USE_PSEUDO_RNG. */
 unsigned int sixt_use_pseudo_rng();
 
+/** Return the seed the random number generator has been initialized
+    with. The value can be used to set up independent RndStream
+    instances (see rndstream.h), e.g., one for each thread or chip. */
+unsigned int sixt_get_rng_seed();
+
 
 /** This routine returns a random number. The values are either
     obtained from the Remeis random number server or are created by
@@ -53,6 +59,13 @@ unsigned int sixt_use_pseudo_rng();
     source files 'headas_rand.h' and 'headas_rand.c'. */
 double sixt_get_random_number(int* const status);
 
+/** Use the given stream for all random numbers requested by the
+    calling thread via sixt_get_random_number() (and therefore also
+    by the SIMPUT routines). With NULL, the thread uses the global
+    generator again. The stream must remain valid as long as it is
+    set. */
+void sixt_set_thread_rndstream(RndStream* const rs);
+
 /** Initialize the random number generator. */
 void sixt_init_rng(const unsigned int seed, int* const status);
 
@@ -0,0 +1,273 @@
+/*
+   This file is part of SIXTE.
+
+   SIXTE is free software: you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   any later version.
+
+   SIXTE is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   For a copy of the GNU General Public License see
+   <http://www.gnu.org/licenses/>.
+
+
+   Copyright 2019 Remeis-Sternwarte, Friedrich-Alexander-Universitaet
+                  Erlangen-Nuernberg
+*/
+
+#include "rndstream.h"
+
+
+/** Multipliers and Weyl constants of Philox4x32. */
+#define PHILOX_M0 (0xD2511F53U)
+#define PHILOX_M1 (0xCD9E8D57U)
+#define PHILOX_W0 (0x9E3779B9U)
+#define PHILOX_W1 (0xBB67AE85U)
+
+/** Number of rounds of the Philox block cipher. */
+#define PHILOX_ROUNDS (10)
+
+/** Threshold for the mean value of the Poisson distribution above
+    which the transformed rejection method is used. */
+#define RNDSTREAM_POISSON_PTRS (10.)
+
+
+/** Philox4x32-10 block cipher. Encrypts the 128-bit counter with the
+    64-bit key. */
+static void philox4x32(const uint32_t* const ctr, const uint32_t* const key,
+		       uint32_t* const out)
+{
+  uint32_t c0=ctr[0], c1=ctr[1], c2=ctr[2], c3=ctr[3];
+  uint32_t k0=key[0], k1=key[1];
+
+  int ii;
+  for (ii=0; ii<PHILOX_ROUNDS; ii++) {
+    uint64_t p0=(uint64_t)PHILOX_M0*c0;
+    uint64_t p1=(uint64_t)PHILOX_M1*c2;
+    uint32_t n0=(uint32_t)(p1>>32)^c1^k0;
+    uint32_t n2=(uint32_t)(p0>>32)^c3^k1;
+    c1=(uint32_t)p1;
+    c3=(uint32_t)p0;
+    c0=n0;
+    c2=n2;
+    k0+=PHILOX_W0;
+    k1+=PHILOX_W1;
+  }
+
+  out[0]=c0;
+  out[1]=c1;
+  out[2]=c2;
+  out[3]=c3;
+}
+
+
+/** Generate the next block of four 32-bit words. */
+static void refillRndStream(RndStream* const rs)
+{
+  uint32_t ctr[4];
+  ctr[0]=(uint32_t)rs->block;
+  ctr[1]=(uint32_t)(rs->block>>32);
+  ctr[2]=(uint32_t)rs->stream;
+  ctr[3]=(uint32_t)(rs->stream>>32);
+  philox4x32(ctr, rs->key, rs->out);
+  rs->block++;
+  rs->nused=0;
+}
+
+
+RndStream* newRndStream(const unsigned int seed,
+			const uint64_t stream,
+			int* const status)
+{
+  RndStream* rs=(RndStream*)malloc(sizeof(RndStream));
+  CHECK_NULL_RET(rs, *status, "memory allocation for RndStream failed", rs);
+
+  initRndStream(rs, seed, stream);
+
+  return(rs);
+}
+
+
+void freeRndStream(RndStream** const rs)
+{
+  if (NULL!=*rs) {
+    free(*rs);
+    *rs=NULL;
+  }
+}
+
+
+void initRndStream(RndStream* const rs,
+		   const unsigned int seed,
+		   const uint64_t stream)
+{
+  rs->key[0]=(uint32_t)seed;
+  rs->key[1]=0;
+  rs->stream=stream;
+  seekRndStream(rs, 0);
+}
+
+
+uint64_t getRndStreamId(const uint32_t major, const uint32_t minor)
+{
+  return((((uint64_t)major)<<32) | (uint64_t)minor);
+}
+
+
+void seekRndStream(RndStream* const rs, const uint64_t position)
+{
+  rs->block=position/4;
+  rs->nused=4;
+  if (0!=position%4) {
+    refillRndStream(rs);
+    rs->nused=(int)(position%4);
+  }
+  rs->has_gauss=0;
+  rs->gauss=0.;
+}
+
+
+uint32_t getRndStreamUInt32(RndStream* const rs)
+{
+  if (rs->nused>=4) {
+    refillRndStream(rs);
+  }
+  return(rs->out[rs->nused++]);
+}
+
+
+double getRndStreamUniform(RndStream* const rs)
+{
+  // Combine 27 and 26 random bits to a double with 53-bit
+  // resolution (same as genrand_res53() in mt19937ar.c).
+  uint32_t a=getRndStreamUInt32(rs)>>5;
+  uint32_t b=getRndStreamUInt32(rs)>>6;
+  return((a*67108864.0+b)*(1.0/9007199254740992.0));
+}
+
+
+double getRndStreamGauss(RndStream* const rs)
+{
+  if (0!=rs->has_gauss) {
+    rs->has_gauss=0;
+    return(rs->gauss);
+  }
+
+  // Box-Muller transform. The argument of the logarithm lies in the
+  // interval (0,1].
+  double sqrt_2rho=sqrt(-2.*log(1.-getRndStreamUniform(rs)));
+  double phi=getRndStreamUniform(rs)*2.*M_PI;
+
+  rs->gauss=sqrt_2rho*sin(phi);
+  rs->has_gauss=1;
+  return(sqrt_2rho*cos(phi));
+}
+
+
+double getRndStreamExp(RndStream* const rs, const double avg)
+{
+  return(-log(1.-getRndStreamUniform(rs))*avg);
+}
+
+
+long getRndStreamPoisson(RndStream* const rs, const double lambda)
+{
+  if (lambda<=0.) {
+    return(0);
+  }
+
+  if (lambda<RNDSTREAM_POISSON_PTRS) {
+    // Multiplication of uniform random numbers (Knuth).
+    double limit=exp(-lambda);
+    double prod=getRndStreamUniform(rs);
+    long k=0;
+    while (prod>limit) {
+      prod*=getRndStreamUniform(rs);
+      k++;
+    }
+    return(k);
+  }
+
+  // Transformed rejection method PTRS (Hoermann 1993, Insurance:
+  // Mathematics and Economics 12, 39).
+  double slam=sqrt(lambda);
+  double loglam=log(lambda);
+  double b=0.931+2.53*slam;
+  double a=-0.059+0.02483*b;
+  double invalpha=1.1239+1.1328/(b-3.4);
+  double vr=0.9277-3.6224/(b-2.);
+
+  while (1) {
+    double u=getRndStreamUniform(rs)-0.5;
+    double v=getRndStreamUniform(rs);
+    double us=0.5-fabs(u);
+    long k=(long)floor((2.*a/us+b)*u+lambda+0.43);
+    if ((us>=0.07)&&(v<=vr)) {
+      return(k);
+    }
+    if ((k<0)||((us<0.013)&&(v>us))) {
+      continue;
+    }
+    if (log(v)+log(invalpha)-log(a/(us*us)+b) <=
+	-lambda+k*loglam-lgamma(k+1.)) {
+      return(k);
+    }
+  }
+}
+
+
+void fillRndStreamUniform(RndStream* const rs, double* const x, const long n)
+{
+  long ii;
+  for (ii=0; ii<n; ii++) {
+    x[ii]=getRndStreamUniform(rs);
+  }
+}
+
+
+void fillRndStreamGauss(RndStream* const rs, double* const x, const long n)
+{
+  long ii=0;
+
+  // Use a remaining value from a previous call first.
+  if ((n>0)&&(0!=rs->has_gauss)) {
+    x[ii++]=getRndStreamGauss(rs);
+  }
+
+  // Generate pairs of values.
+  for (; ii+1<n; ii+=2) {
+    double sqrt_2rho=sqrt(-2.*log(1.-getRndStreamUniform(rs)));
+    double phi=getRndStreamUniform(rs)*2.*M_PI;
+    x[ii]  =sqrt_2rho*cos(phi);
+    x[ii+1]=sqrt_2rho*sin(phi);
+  }
+
+  // Odd number of values.
+  if (ii<n) {
+    x[ii]=getRndStreamGauss(rs);
+  }
+}
+
+
+void fillRndStreamExp(RndStream* const rs, double* const x, const long n,
+		      const double avg)
+{
+  long ii;
+  for (ii=0; ii<n; ii++) {
+    x[ii]=getRndStreamExp(rs, avg);
+  }
+}
+
+
+void fillRndStreamPoisson(RndStream* const rs, long* const k, const long n,
+			  const double lambda)
+{
+  long ii;
+  for (ii=0; ii<n; ii++) {
+    k[ii]=getRndStreamPoisson(rs, lambda);
+  }
+}
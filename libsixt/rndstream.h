@@ -0,0 +1,135 @@
+/*
+   This file is part of SIXTE.
+
+   SIXTE is free software: you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   any later version.
+
+   SIXTE is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   For a copy of the GNU General Public License see
+   <http://www.gnu.org/licenses/>.
+
+
+   Copyright 2019 Remeis-Sternwarte, Friedrich-Alexander-Universitaet
+                  Erlangen-Nuernberg
+*/
+
+#ifndef RNDSTREAM_H
+#define RNDSTREAM_H 1
+
+#include <stdint.h>
+#include "sixt.h"
+
+
+/////////////////////////////////////////////////////////////////
+// Type Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Independent stream of random numbers based on the counter-based
+    Philox4x32-10 generator (Salmon et al. 2011, "Parallel random
+    numbers: as easy as 1, 2, 3"). The n-th random number of a stream
+    is a pure function of the seed, the stream identifier, and n. In
+    contrast to the global generator behind sixt_get_random_number(),
+    the results therefore do not depend on the order in which
+    different streams are used, e.g., by different threads. Each
+    stream must only be used by a single thread at a time. */
+typedef struct {
+  /** Key of the block cipher, derived from the seed. */
+  uint32_t key[2];
+
+  /** Stream identifier, which occupies the upper half of the
+      counter. */
+  uint64_t stream;
+
+  /** Index of the next block within the stream (lower half of the
+      counter). */
+  uint64_t block;
+
+  /** Output of the current block and number of words that have
+      already been consumed. */
+  uint32_t out[4];
+  int nused;
+
+  /** Second Gaussian random number from the Box-Muller
+      transform. */
+  double gauss;
+  int has_gauss;
+
+} RndStream;
+
+
+/////////////////////////////////////////////////////////////////
+// Function Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Constructor. Returns a stream for the given seed and stream
+    identifier. Different stream identifiers yield statistically
+    independent sequences. */
+RndStream* newRndStream(const unsigned int seed,
+			const uint64_t stream,
+			int* const status);
+
+/** Destructor. */
+void freeRndStream(RndStream** const rs);
+
+/** Initialize an existing RndStream data structure (e.g., on the
+    stack or within an array of streams for several threads). */
+void initRndStream(RndStream* const rs,
+		   const unsigned int seed,
+		   const uint64_t stream);
+
+/** Compose a stream identifier from two indices, e.g., the number of
+    a chip and a pixel, or a thread and a work package. */
+uint64_t getRndStreamId(const uint32_t major, const uint32_t minor);
+
+/** Move the stream to the specified position. The position counts
+    the 32-bit words generated since the beginning of the stream. A
+    uniform double consumes two words. */
+void seekRndStream(RndStream* const rs, const uint64_t position);
+
+/** Return the next 32-bit random integer. */
+uint32_t getRndStreamUInt32(RndStream* const rs);
+
+/** Return a uniformly distributed random number in the interval
+    [0,1) with 53-bit resolution. */
+double getRndStreamUniform(RndStream* const rs);
+
+/** Return a Gaussian distributed random number with zero mean and
+    unit standard deviation. */
+double getRndStreamGauss(RndStream* const rs);
+
+/** Return an exponentially distributed random number with the given
+    mean value. */
+double getRndStreamExp(RndStream* const rs, const double avg);
+
+/** Return a Poisson distributed random number with the given mean
+    value. */
+long getRndStreamPoisson(RndStream* const rs, const double lambda);
+
+/** Fill the array with n uniformly distributed random numbers in the
+    interval [0,1). */
+void fillRndStreamUniform(RndStream* const rs, double* const x, const long n);
+
+/** Fill the array with n Gaussian distributed random numbers with
+    zero mean and unit standard deviation. */
+void fillRndStreamGauss(RndStream* const rs, double* const x, const long n);
+
+/** Fill the array with n exponentially distributed random numbers
+    with the given mean value. */
+void fillRndStreamExp(RndStream* const rs, double* const x, const long n,
+		      const double avg);
+
+/** Fill the array with n Poisson distributed random numbers with the
+    given mean value. */
+void fillRndStreamPoisson(RndStream* const rs, long* const k, const long n,
+			  const double lambda);
+
+
+#endif /* RNDSTREAM_H */
@@ -6,103 +6,87 @@
 #include "threadsafe_queue.h"
 #include "tasksSIRENA.h"
 
-std::mutex end_workers_mut;
-std::mutex end_eworkers_mut;
-std::mutex records_detected_mut;
-std::mutex records_energy_mut;
-
 threadsafe_queue<sirena_data*> detection_queue;
 threadsafe_queue<sirena_data*> detected_queue;
-threadsafe_queue<sirena_data*> energy_queue;
 threadsafe_queue<sirena_data*> end_queue;
 
 scheduler* scheduler::instance = 0;
 
-bool end_workers = false;
-bool end_eworkers = false;
-
-unsigned int records_detected = 0;
-unsigned int records_energy = 0;
-
 /* ****************************************************************************/
 /* Workers ********************************************************************/
 /* ****************************************************************************/
 void detection_worker()
 {
   //log_trace("Starting detection worker...");
-  while(1){
-    sirena_data* data;
-    if(detection_queue.wait_and_pop(data)){
-      //log_trace("Extracting detection data from queue...");
-      th_runDetect(data->rec,
-                data->last_record,
-                data->all_pulses,
-                &(data->rec_init),
-                &(data->record_pulses));
-      detected_queue.push(data);
-      std::unique_lock<std::mutex> lk(records_detected_mut);
-      ++records_detected;
-      lk.unlock();
-    }
-    std::unique_lock<std::mutex> lk(end_workers_mut);
-    if(end_workers){
-      lk.unlock();
-      break;
-    }
-    lk.unlock();
+  sirena_data* data;
+  while(detection_queue.blck_wait_and_pop(data)){
+    //log_trace("Extracting detection data from queue...");
+    th_runDetect(data->rec,
+                 data->last_record,
+                 data->all_pulses,
+                 &(data->rec_init),
+                 &(data->record_pulses));
+    detected_queue.push(data);
   }
 }
 
-void energy_worker()
+void energy_worker_v2()
 {
   //log_trace("Starting energy worker...");
-  while(1){
-    sirena_data* data;
-    if(energy_queue.wait_and_pop(data)){
-      //log_trace("Extracting energy data from queue...");
-      //log_debug("Energy data in record %i",data->n_record);
-      th_runEnergy(data->rec, 
-                   &(data->rec_init),
-                   &(data->record_pulses),
-                   &(data->optimal_filter));
-      end_queue.push(data);
-      std::unique_lock<std::mutex> lk(records_energy_mut);
-      ++records_energy;
-      lk.unlock();
-    }
-    std::unique_lock<std::mutex> lk(end_workers_mut);
-    if(end_workers){
-      lk.unlock();
-      break;
-    }
-    lk.unlock();
+  sirena_data* data;
+  while(detected_queue.blck_wait_and_pop(data)){
+    //log_trace("Extracting energy data from queue...");
+    //log_debug("Energy data in record %i",data->n_record);
+    th_runEnergy(data->rec, 
+                 &(data->rec_init),
+                 &(data->record_pulses),
+                 &(data->optimal_filter));
+    end_queue.push(data);
   }
 }
 
-void energy_worker_v2()
+/* ****************************************************************************/
+/* Helpers ********************************************************************/
+/* ****************************************************************************/
+
+// Releases all the data of a record which has been written
+static void delete_data(sirena_data* data)
 {
-  //log_trace("Starting energy worker...");
-  while(1){
-    sirena_data* data;
-    if(detected_queue.wait_and_pop(data)){
-      //log_trace("Extracting energy data from queue...");
-      //log_debug("Energy data in record %i",data->n_record);
-      th_runEnergy(data->rec, 
-                   &(data->rec_init),
-                   &(data->record_pulses),
-                   &(data->optimal_filter));
-      end_queue.push(data);
-      std::unique_lock<std::mutex> lk(records_energy_mut);
-      ++records_energy;
-      lk.unlock();
-    }
-    std::unique_lock<std::mutex> lk(end_eworkers_mut);
-    if(end_eworkers){
-      lk.unlock();
-      break;
-    }
-    lk.unlock();
-  }
+  TesRecord* rec = data->rec;
+  if (rec){
+    if (rec->adc_array) delete [] rec->adc_array;
+    if (rec->adc_double) delete [] rec->adc_double;
+    if (rec->phid_list){
+      if (rec->phid_list->phid_array) delete [] rec->phid_list->phid_array;
+      if (rec->phid_list->times) delete [] rec->phid_list->times;
+      delete rec->phid_list;
+    }
+    delete rec;
+  }
+  if (data->rec_init){
+    // The library is shared by all the records
+    data->rec_init->library_collection = 0;
+    delete data->rec_init;
+  }
+  delete data->all_pulses;
+  delete data->record_pulses;
+  delete data->optimal_filter;
+
+  TesEventList* event_list = data->event_list;
+  delete [] event_list->event_indexes;
+  delete [] event_list->energies;
+  delete [] event_list->avgs_4samplesDerivative;
+  delete [] event_list->Es_lowres;
+  delete [] event_list->grades1;
+  delete [] event_list->grades2;
+  delete [] event_list->pulse_heights;
+  delete [] event_list->ph_ids;
+  delete [] event_list->grading;
+  delete [] event_list->phis;
+  delete [] event_list->lagsShifts;
+  delete event_list;
+
+  delete data;
 }
 
 /* ****************************************************************************/
@@ -117,12 +101,17 @@ void scheduler::push_detection(TesRecord* record,
                                OptimalFilterSIRENA** optimal,
                                TesEventList* event_list)
 {
+  // Backpressure: wait until there is a free slot in the
+  // reconstruction pipeline (writing the finished records meanwhile)
+  emit_records(this->max_pending_records - 1);
+
   //log_trace("pushing detection data into the queue...");
   sirena_data* input = new sirena_data;
-  tesrecord* rec = new tesrecord(record);
-  input->rec = rec->get_TesRecord();
+  tesrecord rec(record);
+  input->rec = rec.get_TesRecord();
   input->n_record = nRecord;
   input->last_record = lastRecord;
+  input->index = num_records;
   input->all_pulses = new PulsesCollection;
   if (pulsesAll and pulsesAll->ndetpulses > 0){
     *input->all_pulses = *pulsesAll;
@@ -151,455 +140,150 @@ void scheduler::push_detection(TesRecord* record,
   ++num_records;
 }
 
-void scheduler::finish_reconstruction(ReconstructInitSIRENA* reconstruct_init,
-                                      PulsesCollection** pulsesAll, 
-                                      OptimalFilterSIRENA** optimalFilter)
+// Collects the finished records and emits them in record order.
+// It blocks until at most 'max_pending' records are still in the
+// reconstruction pipeline.
+void scheduler::emit_records(unsigned int max_pending)
 {
-  // Waits until all the records are detected
-  // this works because this function should only be called
-  // after all the records are queue
-  //log_trace("Waiting until all the detection workers end");
+  sirena_data* data;
   while(1){
-    std::unique_lock<std::mutex> lk(records_detected_mut);
-    if (records_detected == this->num_records){
-      lk.unlock();
+    while(end_queue.try_pop(data)){
+      reorder_buffer[data->index % this->max_pending_records] = data;
+    }
+    while((data = reorder_buffer[records_emitted % this->max_pending_records])){
+      reorder_buffer[records_emitted % this->max_pending_records] = 0;
+      emit_record(data);
+      ++records_emitted;
+    }
+    if (this->num_records - records_emitted <= max_pending){
       break;
     }
-    lk.unlock();
-  }
-  
-  // Sorting the arrays by record number
-  //log_trace("Sorting the arrays by record number");
-  if ((*pulsesAll)->pulses_detected){
-    delete [] (*pulsesAll)->pulses_detected;
-  }
-  
-  (*pulsesAll)->size = this->num_records;
-  (*pulsesAll)->ndetpulses = 0;
-  (*pulsesAll)->pulses_detected = new PulseDetected[this->num_records];
-
-  //log_debug("Number of records %i", this->num_records);
-  this->data_array = new sirena_data*[this->num_records];//+1];
-  while(!detected_queue.empty()){
-    sirena_data* data;
-    if(detected_queue.wait_and_pop(data)){
-      data_array[data->n_record-1] = data;
+    // Waits for the next finished record
+    if (end_queue.blck_wait_and_pop(data)){
+      reorder_buffer[data->index % this->max_pending_records] = data;
     }
   }
+}
 
-  std::unique_lock<std::mutex> lk(end_workers_mut);
-  end_workers = true;
-  lk.unlock();
-  for(unsigned int i = 0; i < this->max_detection_workers; ++i){
-    this->detection_workers[i].join();
-  }
-
-  //
-  // Energy
-  //
-  //log_trace("Starting energy workers...");
-  if(this->is_running_energy){
-    std::unique_lock<std::mutex> lk_end(end_workers_mut);
-    end_workers = false;
-    lk_end.unlock();
-    this->energy_workers = new std::thread[this->max_detection_workers];
-    for (unsigned int i = 0; i < this->max_detection_workers; ++i){//
-      this->energy_workers[i] = std::thread (energy_worker);
-    }
-    
-    //log_trace("Filling energy queue...");
-    for (unsigned int i = 0; i < this->num_records; ++i){
-      energy_queue.push(data_array[i]);
-    }
-  
-    // Waits until all the energies are calculated
-    //log_trace("Waiting until the energy workers end...");
-    while(1){
-      std::unique_lock<std::mutex> lk_energy(records_energy_mut);
-      if (records_energy == this->num_records){
-        lk_energy.unlock();
-        break;
-      }
-      lk_energy.unlock();
+// Appends the pulses of a finished record to 'pulses_all', fills its
+// event list and writes it to the output file (if any)
+void scheduler::emit_record(sirena_data* data)
+{
+  PulsesCollection* in_record = data->record_pulses;
+  if (pulses_all->size < (pulses_all->ndetpulses + in_record->ndetpulses)){
+    int new_size = 2*pulses_all->size;
+    if (new_size < pulses_all->ndetpulses + in_record->ndetpulses){
+      new_size = pulses_all->ndetpulses + in_record->ndetpulses;
     }
-    
-    std::unique_lock<std::mutex> lk_end2(end_workers_mut);
-    end_workers = true;
-    lk_end2.unlock();
-    for(unsigned int i = 0; i < this->max_detection_workers; ++i){
-      this->energy_workers[i].join();
-    }
-  }//end energy
-
-  //
-  // Reconstruction of the pulses array
-  //
-  //log_trace("Reconstruction of the pulses array...");
-  for (unsigned int i = 0; i < this->num_records; ++i){
-    PulsesCollection* all = data_array[i]->all_pulses;
-    PulsesCollection* in_record = data_array[i]->record_pulses;
-    PulsesCollection aux;
-    if ((*pulsesAll)->size < 
-        ((*pulsesAll)->ndetpulses + in_record->ndetpulses)){
-      aux = *(*pulsesAll);
-      delete *pulsesAll;
-      *pulsesAll = new PulsesCollection;
-      //**pulsesAll = aux;
-      (*pulsesAll)->ndetpulses = aux.ndetpulses;
-      (*pulsesAll)->size = (*pulsesAll)->ndetpulses + in_record->ndetpulses;
-      (*pulsesAll)->pulses_detected =  new PulseDetected[(*pulsesAll)->size];
-      for (unsigned int i = 0; i < aux.ndetpulses; ++i){
-        (*pulsesAll)->pulses_detected[i] = aux.pulses_detected[i];
-      }
+    PulseDetected* pulses = new PulseDetected[new_size];
+    for (int i = 0; i < pulses_all->ndetpulses; ++i){
+      pulses[i] = pulses_all->pulses_detected[i];
     }
-    for (unsigned int i = 0; i < in_record->ndetpulses; ++i){
-      (*pulsesAll)->pulses_detected[i+(*pulsesAll)->ndetpulses] = 
-        in_record->pulses_detected[i];
+    if (pulses_all->pulses_detected){
+      delete [] pulses_all->pulses_detected;
     }
-    (*pulsesAll)->ndetpulses += in_record->ndetpulses;
-  }// End reconstruction of the pulses array
+    pulses_all->pulses_detected = pulses;
+    pulses_all->size = new_size;
+  }
+  for (int i = 0; i < in_record->ndetpulses; ++i){
+    pulses_all->pulses_detected[i+pulses_all->ndetpulses] = 
+      in_record->pulses_detected[i];
+  }
+  pulses_all->ndetpulses += in_record->ndetpulses;
 
   //log_trace("Filling eventlist...");
-  for(unsigned int i = 0; i < this->num_records; ++i){
+  TesEventList* event_list = data->event_list;
+  TesRecord* rec = data->rec;
+  event_list->index = in_record->ndetpulses;
+  for (int ip=0; ip < in_record->ndetpulses; ip++) {
+    event_list->event_indexes[ip] = 
+      (in_record->pulses_detected[ip].Tstart - rec->time)/rec->delta_t;
     
-    TesEventList* event_list = data_array[i]->event_list;
-    //PulsesCollection* pulses = data_array[i]->pulses_detected;
-    PulsesCollection* record_pulses = data_array[i]->record_pulses;
-    TesRecord* rec = data_array[i]->rec;
-    /*if (event_list->energies != 0) delete [] event_list->energies;
-    if (event_list->avgs_4samplesDerivative != 0) delete [] event_list->avgs_4samplesDerivative;
-    if (event_list->grades1 != 0) delete [] event_list->grades1;
-    if (event_list->grades2 != 0) delete [] event_list->grades2;
-    if (event_list->pulse_heights != 0) delete [] event_list->pulse_heights;
-    if (event_list->ph_ids != 0) delete [] event_list->ph_ids;*/
-
-    if (strcmp(data_array[i]->rec_init->EnergyMethod,"PCA") != 0){
-      event_list->index = record_pulses->ndetpulses;
-      /*event_list->energies = new double[event_list->index];
-      event_list->avgs_4samplesDerivative = new double[event_list->index];
-      event_list->grades1  = new int[event_list->index];
-      event_list->grades2  = new int[event_list->index];
-      event_list->pulse_heights  = new double[event_list->index];
-      event_list->ph_ids   = new long[event_list->index];*/
-
-      for (int ip=0; ip < record_pulses->ndetpulses; ip++) {
-        //log_debug("eventlist index %i record %i", ip, i);
-        //log_debug("event_list indexes %p", event_list->event_indexes[ip]);
-        //continue;
-        event_list->event_indexes[ip] = 
-          (record_pulses->pulses_detected[ip].Tstart - rec->time)/rec->delta_t;
-        
-        event_list->energies[ip] = data_array[i]->record_pulses->pulses_detected[ip].energy;
-        
-        event_list->avgs_4samplesDerivative[ip] = 
-          record_pulses->pulses_detected[ip].avg_4samplesDerivative;
-        event_list->Es_lowres[ip] = record_pulses->pulses_detected[ip].E_lowres;
-        event_list->grading[ip] = record_pulses->pulses_detected[ip].grading;
-        event_list->grades1[ip]  = record_pulses->pulses_detected[ip].grade1;
-        event_list->grades2[ip]  = record_pulses->pulses_detected[ip].grade2;
-        event_list->pulse_heights[ip]  = record_pulses->pulses_detected[ip].pulse_height;
-        event_list->ph_ids[ip]   = 0;
-        event_list->phis[ip] = record_pulses->pulses_detected[ip].phi;
-        event_list->lagsShifts[ip] = record_pulses->pulses_detected[ip].lagsShift;
-      }
-      if (data_array[i]->last_record == 1) {
-        //log_debug("eventlist last record");
-        double numLagsUsed_mean;
-        double numLagsUsed_sigma;
-        gsl_vector *numLagsUsed_vector = gsl_vector_alloc((*pulsesAll)->ndetpulses);
-        
-        for (int ip = 0; ip < (*pulsesAll)->ndetpulses; ip++) {
-          gsl_vector_set(numLagsUsed_vector,ip,(*pulsesAll)->pulses_detected[ip].numLagsUsed);
-        }
-        if (findMeanSigma (numLagsUsed_vector, &numLagsUsed_mean, &numLagsUsed_sigma)) {
-          EP_EXIT_ERROR("Cannot run findMeanSigma routine for calculating numLagsUsed statistics",EPFAIL);
-        }
-        gsl_vector_free(numLagsUsed_vector);
-      }
-    }else{
-      if (data_array[i]->last_record == 1) {
-        // Free & Fill TesEventList structure
-        /*event_list->index = (*pulsesAll)->ndetpulses;
-        event_list->event_indexes = new double[event_list->index];
-        event_list->energies = new double[event_list->index];
-        event_list->avgs_4samplesDerivative = new double[event_list->index];
-        event_list->grades1  = new int[event_list->index];
-        event_list->grades2  = new int[event_list->index];
-        event_list->pulse_heights  = new double[event_list->index];
-        event_list->ph_ids   = new long[event_list->index];*/
-        
-        for (int ip = 0; ip<(*pulsesAll)->ndetpulses; ip++) {
-          //log_debug("eventlist index %i record %i", ip, i);
-          event_list->event_indexes[ip] = 
-            ((*pulsesAll)->pulses_detected[ip].Tstart - rec->time)/rec->delta_t;
-          
-          event_list->energies[ip] = (*pulsesAll)->pulses_detected[ip].energy;
-          
-          event_list->avgs_4samplesDerivative[ip]  = (*pulsesAll)->pulses_detected[ip].avg_4samplesDerivative;
-          event_list->Es_lowres[ip]  = (*pulsesAll)->pulses_detected[ip].E_lowres;
-          event_list->grading[ip] = (*pulsesAll)->pulses_detected[ip].grading;
-          event_list->grades1[ip]  = (*pulsesAll)->pulses_detected[ip].grade1;
-          event_list->grades2[ip]  = (*pulsesAll)->pulses_detected[ip].grade2;
-          event_list->pulse_heights[ip]  = (*pulsesAll)->pulses_detected[ip].pulse_height;
-          event_list->ph_ids[ip]   = 0;    
-          event_list->phis[ip] = record_pulses->pulses_detected[ip].phi;
-          event_list->lagsShifts[ip] = record_pulses->pulses_detected[ip].lagsShift;
-        }
-      }
+    event_list->energies[ip] = in_record->pulses_detected[ip].energy;
+    
+    event_list->avgs_4samplesDerivative[ip] = 
+      in_record->pulses_detected[ip].avg_4samplesDerivative;
+    event_list->Es_lowres[ip] = in_record->pulses_detected[ip].E_lowres;
+    event_list->grading[ip] = in_record->pulses_detected[ip].grading;
+    event_list->grades1[ip]  = in_record->pulses_detected[ip].grade1;
+    event_list->grades2[ip]  = in_record->pulses_detected[ip].grade2;
+    event_list->pulse_heights[ip]  = in_record->pulses_detected[ip].pulse_height;
+    event_list->ph_ids[ip]   = 0;
+    event_list->phis[ip] = in_record->pulses_detected[ip].phi;
+    event_list->lagsShifts[ip] = in_record->pulses_detected[ip].lagsShift;
+  }
+  if (data->last_record == 1) {
+    //log_debug("eventlist last record");
+    double numLagsUsed_mean;
+    double numLagsUsed_sigma;
+    gsl_vector *numLagsUsed_vector = gsl_vector_alloc(pulses_all->ndetpulses);
+    
+    for (int ip = 0; ip < pulses_all->ndetpulses; ip++) {
+      gsl_vector_set(numLagsUsed_vector,ip,pulses_all->pulses_detected[ip].numLagsUsed);
     }
+    if (findMeanSigma (numLagsUsed_vector, &numLagsUsed_mean, &numLagsUsed_sigma)) {
+      EP_EXIT_ERROR("Cannot run findMeanSigma routine for calculating numLagsUsed statistics",EPFAIL);
+    }
+    gsl_vector_free(numLagsUsed_vector);
+  }
 
-    //log_debug("Eventlist from record %i", (i + 1) );
-    //log_debug("%i, %i, %i",event_list->size, event_list->size_energy, event_list->index);
-    for (int j = 0; j < event_list->index; ++j){
-      /*log_debug("%f, %f, %f, %f, %i %i, %ld", event_list->event_indexes[j],
-                event_list->pulse_heights[j],
-                event_list->avgs_4samplesDerivative[j],
-                event_list->energies[j],
-                event_list->grades1[j],
-                event_list->grades2[j],
-                event_list->ph_ids[j]);*/
+  if (this->output_file){
+    int status = EXIT_SUCCESS;
+    saveEventListToFile(this->output_file, event_list, rec->time,
+                        this->output_delta_t, rec->pixid, &status);
+    if (status != EXIT_SUCCESS){
+      EP_EXIT_ERROR("Cannot save the event list of the record",EPFAIL);
     }
-  }// for event_list
+    delete_data(data);
+  }else{
+    finished_records.push_back(data);
+  }
 }
 
 void scheduler::finish_reconstruction_v2(ReconstructInitSIRENA* reconstruct_init,
                                          PulsesCollection** pulsesAll, 
                                          OptimalFilterSIRENA** optimalFilter)
 {
-  // Waits until all the records are detected
+  // Waits until all the records are reconstructed and emitted
   // this works because this function should only be called
   // after all the records are queue
-  //log_trace("Waiting until all the detection workers end");
-  while(1){
-    std::unique_lock<std::mutex> lk(records_detected_mut);
-    if (records_detected == this->num_records){
-      lk.unlock();
-      break;
-    }
-    lk.unlock();
-  }
+  //log_trace("Waiting until all the records are emitted");
+  emit_records(0);
 
-  std::unique_lock<std::mutex> lk(end_workers_mut);
-  end_workers = true;
-  lk.unlock();
+  detection_queue.close();
   for(unsigned int i = 0; i < this->max_detection_workers; ++i){
     this->detection_workers[i].join();
   }
-
-  // Waits until all the energies are calculated
-  //log_trace("Waiting until the energy workers end...");
-  while(1){
-    std::unique_lock<std::mutex> lk_energy(records_energy_mut);
-    if (records_energy == this->num_records){
-      lk_energy.unlock();
-      break;
-    }
-    lk_energy.unlock();
-  }
-  
-  std::unique_lock<std::mutex> lk_end2(end_eworkers_mut);
-  end_eworkers = true;
-  lk_end2.unlock();
+  detected_queue.close();
   for(unsigned int i = 0; i < this->max_energy_workers; ++i){
     this->energy_workers[i].join();
   }
+  delete [] this->detection_workers; this->detection_workers = 0;
+  delete [] this->energy_workers; this->energy_workers = 0;
+  this->max_detection_workers = 0;
+  this->max_energy_workers = 0;
 
-  // Sorting the arrays by record number
-  //log_trace("Sorting the arrays by record number");
+  // Pulses of all the records in record order
   if ((*pulsesAll)->pulses_detected){
     delete [] (*pulsesAll)->pulses_detected;
   }
-  
-  (*pulsesAll)->size = this->num_records;
-  (*pulsesAll)->ndetpulses = 0;
-  (*pulsesAll)->pulses_detected = new PulseDetected[this->num_records];
-
-  //log_debug("Number of records %i", this->num_records);
-  this->data_array = new sirena_data*[this->num_records];//+1];
-  while(!end_queue.empty()){
-    sirena_data* data;
-    if(end_queue.wait_and_pop(data)){
-      data_array[data->n_record-1] = data;
-    }
-  }
-  //
-  // Reconstruction of the pulses array
-  //
-  //log_trace("Reconstruction of the pulses array...");
-  for (unsigned int i = 0; i < this->num_records; ++i){
-    PulsesCollection* all = data_array[i]->all_pulses;
-    PulsesCollection* in_record = data_array[i]->record_pulses;
-    PulsesCollection aux;
-    if ((*pulsesAll)->size < 
-        ((*pulsesAll)->ndetpulses + in_record->ndetpulses)){
-      aux = *(*pulsesAll);
-      delete *pulsesAll;
-      *pulsesAll = new PulsesCollection;
-      (*pulsesAll)->ndetpulses = aux.ndetpulses;
-      (*pulsesAll)->size = (*pulsesAll)->ndetpulses + in_record->ndetpulses;
-      (*pulsesAll)->pulses_detected =  new PulseDetected[(*pulsesAll)->size];
-      for (unsigned int i = 0; i < aux.ndetpulses; ++i){
-        (*pulsesAll)->pulses_detected[i] = aux.pulses_detected[i];
-      }
-    }
-    for (unsigned int i = 0; i < in_record->ndetpulses; ++i){
-      (*pulsesAll)->pulses_detected[i+(*pulsesAll)->ndetpulses] = 
-        in_record->pulses_detected[i];
-    }
-    (*pulsesAll)->ndetpulses += in_record->ndetpulses;
-  }// End reconstruction of the pulses array
-
-  //log_debug("pulsesAll");
-  for (int i = 0; i < (*pulsesAll)->ndetpulses; ++i){
-    /*log_debug("data - %i, %i, %i, %i, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %i",
-              (*pulsesAll)->pulses_detected[i].pulse_duration,
-              (*pulsesAll)->pulses_detected[i].grade1,
-              (*pulsesAll)->pulses_detected[i].grade2,
-              (*pulsesAll)->pulses_detected[i].pixid,
-              (*pulsesAll)->pulses_detected[i].Tstart,
-              (*pulsesAll)->pulses_detected[i].Tend,
-              (*pulsesAll)->pulses_detected[i].riseTime,
-              (*pulsesAll)->pulses_detected[i].fallTime,
-              (*pulsesAll)->pulses_detected[i].pulse_height,
-              (*pulsesAll)->pulses_detected[i].maxDER,
-              (*pulsesAll)->pulses_detected[i].samp1DER,
-              (*pulsesAll)->pulses_detected[i].avg_4samplesDerivative,
-              (*pulsesAll)->pulses_detected[i].quality,
-              (*pulsesAll)->pulses_detected[i].numLagsUsed);*/
-    for (int j = 0; j < (*pulsesAll)->pulses_detected[i].pulse_adc->size; ++j){
-      //log_debug("%d, ",*((*pulsesAll)->pulses_detected[i].pulse_adc->data));
-    }
-  }
-
-  //log_trace("Filling eventlist...");
-  for(unsigned int i = 0; i < this->num_records; ++i){
-    
-    TesEventList* event_list = data_array[i]->event_list;
-    //PulsesCollection* pulses = data_array[i]->pulses_detected;
-    PulsesCollection* record_pulses = data_array[i]->record_pulses;
-    TesRecord* rec = data_array[i]->rec;
-    /*if (event_list->energies != 0) delete [] event_list->energies;
-    if (event_list->avgs_4samplesDerivative != 0) delete [] event_list->avgs_4samplesDerivative;
-    if (event_list->grades1 != 0) delete [] event_list->grades1;
-    if (event_list->grades2 != 0) delete [] event_list->grades2;
-    if (event_list->pulse_heights != 0) delete [] event_list->pulse_heights;
-    if (event_list->ph_ids != 0) delete [] event_list->ph_ids;*/
-
-    if (strcmp(data_array[i]->rec_init->EnergyMethod,"PCA") != 0){
-      event_list->index = record_pulses->ndetpulses;
-      /*event_list->energies = new double[event_list->index];
-      event_list->avgs_4samplesDerivative = new double[event_list->index];
-      event_list->grades1  = new int[event_list->index];
-      event_list->grades2  = new int[event_list->index];
-      event_list->pulse_heights  = new double[event_list->index];
-      event_list->ph_ids   = new long[event_list->index];*/
-
-      for (int ip=0; ip < record_pulses->ndetpulses; ip++) {
-        //log_debug("eventlist index %i record %i", ip, i);
-        //log_debug("event_list indexes %p", event_list->event_indexes[ip]);
-        //continue;
-        event_list->event_indexes[ip] = 
-          (record_pulses->pulses_detected[ip].Tstart - rec->time)/rec->delta_t;
-        
-        event_list->energies[ip] = data_array[i]->record_pulses->pulses_detected[ip].energy;
-        
-        event_list->avgs_4samplesDerivative[ip] = 
-          record_pulses->pulses_detected[ip].avg_4samplesDerivative;
-        event_list->Es_lowres[ip] = record_pulses->pulses_detected[ip].E_lowres;
-        event_list->grading[ip] = record_pulses->pulses_detected[ip].grading;
-        event_list->grades1[ip]  = record_pulses->pulses_detected[ip].grade1;
-        event_list->grades2[ip]  = record_pulses->pulses_detected[ip].grade2;
-        event_list->pulse_heights[ip]  = record_pulses->pulses_detected[ip].pulse_height;
-        event_list->ph_ids[ip]   = 0;
-        event_list->phis[ip] = record_pulses->pulses_detected[ip].phi;
-        event_list->lagsShifts[ip] = record_pulses->pulses_detected[ip].lagsShift;
-      }
-      if (data_array[i]->last_record == 1) {
-        //log_debug("eventlist last record");
-        double numLagsUsed_mean;
-        double numLagsUsed_sigma;
-        gsl_vector *numLagsUsed_vector = gsl_vector_alloc((*pulsesAll)->ndetpulses);
-        
-        for (int ip = 0; ip < (*pulsesAll)->ndetpulses; ip++) {
-          gsl_vector_set(numLagsUsed_vector,ip,(*pulsesAll)->pulses_detected[ip].numLagsUsed);
-        }
-        if (findMeanSigma (numLagsUsed_vector, &numLagsUsed_mean, &numLagsUsed_sigma)) {
-          EP_EXIT_ERROR("Cannot run findMeanSigma routine for calculating numLagsUsed statistics",EPFAIL);
-        }
-        gsl_vector_free(numLagsUsed_vector);
-      }
-    }else{
-      if (data_array[i]->last_record == 1) {
-        // Free & Fill TesEventList structure
-        /*event_list->index = (*pulsesAll)->ndetpulses;
-        event_list->event_indexes = new double[event_list->index];
-        event_list->energies = new double[event_list->index];
-        event_list->avgs_4samplesDerivative = new double[event_list->index];
-        event_list->grades1  = new int[event_list->index];
-        event_list->grades2  = new int[event_list->index];
-        event_list->pulse_heights  = new double[event_list->index];
-        event_list->ph_ids   = new long[event_list->index];*/
-        
-        for (int ip = 0; ip<(*pulsesAll)->ndetpulses; ip++) {
-          //log_debug("eventlist index %i record %i", ip, i);
-          event_list->event_indexes[ip] = 
-            ((*pulsesAll)->pulses_detected[ip].Tstart - rec->time)/rec->delta_t;
-          
-          event_list->energies[ip] = (*pulsesAll)->pulses_detected[ip].energy;
-          
-          event_list->avgs_4samplesDerivative[ip]  = (*pulsesAll)->pulses_detected[ip].avg_4samplesDerivative;
-          event_list->Es_lowres[ip]  = (*pulsesAll)->pulses_detected[ip].E_lowres;
-          event_list->grading[ip] = (*pulsesAll)->pulses_detected[ip].grading;
-          event_list->grades1[ip]  = (*pulsesAll)->pulses_detected[ip].grade1;
-          event_list->grades2[ip]  = (*pulsesAll)->pulses_detected[ip].grade2;
-          event_list->pulse_heights[ip]  = (*pulsesAll)->pulses_detected[ip].pulse_height;
-          event_list->ph_ids[ip]   = 0;    
-          event_list->phis[ip] = record_pulses->pulses_detected[ip].phi;
-          event_list->lagsShifts[ip] = record_pulses->pulses_detected[ip].lagsShift;
-        }
-      }
-    }
-
-    //log_debug("Eventlist from record %i", (i + 1) );
-    //log_debug("%i, %i, %i",event_list->size, event_list->size_energy, event_list->index);
-    for (int j = 0; j < event_list->index; ++j){
-      /*log_debug("%f, %f, %f, %f, %i %i, %ld", event_list->event_indexes[j],
-                event_list->pulse_heights[j],
-                event_list->avgs_4samplesDerivative[j],
-                event_list->energies[j],
-                event_list->grades1[j],
-                event_list->grades2[j],
-                event_list->ph_ids[j]);*/
-    }
-  }// for event_list
+  (*pulsesAll)->ndetpulses = pulses_all->ndetpulses;
+  (*pulsesAll)->size = pulses_all->size;
+  (*pulsesAll)->pulses_detected = pulses_all->pulses_detected;
+  pulses_all->ndetpulses = 0;
+  pulses_all->size = 0;
+  pulses_all->pulses_detected = 0;
 }
 
 void scheduler::get_test_event(TesEventList** test_event, TesRecord** record)
 {
-  if(this->current_record == this->num_records) return;
+  if(this->current_record == this->finished_records.size()) return;
   //log_trace("Getting eventlist from record %i", (this->current_record + 1));
-  *test_event = this->data_array[this->current_record]->event_list;
-  *record = this->data_array[this->current_record]->rec;
+  *test_event = this->finished_records[this->current_record]->event_list;
+  *record = this->finished_records[this->current_record]->rec;
   this->current_record++;
 }
 
-void scheduler::init()
-{
-  if(threading){
-    this->num_cores = std::thread::hardware_concurrency();
-    //this->num_cores = 1;
-    if(this->num_cores < 2){
-      this->max_detection_workers = 1;
-    }else{
-      this->max_detection_workers = this->num_cores - 1;
-    }
-    this->detection_workers = new std::thread[this->max_detection_workers];
-    for (unsigned int i = 0; i < this->max_detection_workers; ++i){
-      this->detection_workers[i] = std::thread (detection_worker);
-    }
-  }
-}
-
 void scheduler::init_v2()
 {
   if(threading){
@@ -614,6 +298,16 @@ void scheduler::init_v2()
       /*log_debug("detection %u energy %u", this->max_detection_workers,
                 this->max_energy_workers);*/
     }
+    this->max_pending_records = SCHEDULER_RECORDS_PER_WORKER *
+      (this->max_detection_workers + this->max_energy_workers);
+    this->reorder_buffer = new sirena_data*[this->max_pending_records];
+    for (unsigned int i = 0; i < this->max_pending_records; ++i){
+      this->reorder_buffer[i] = 0;
+    }
+    this->pulses_all = new PulsesCollection;
+
+    detection_queue.reopen();
+    detected_queue.reopen();
     this->detection_workers = new std::thread[this->max_detection_workers];
     for (unsigned int i = 0; i < this->max_detection_workers; ++i){
       this->detection_workers[i] = std::thread (detection_worker);
@@ -633,7 +327,14 @@ scheduler::scheduler():
   num_records(0),
   is_running_energy(false),
   current_record(0),
-  data_array(0)
+  reorder_buffer(0),
+  max_pending_records(0),
+  records_emitted(0),
+  pulses_all(0),
+  output_file(0),
+  output_delta_t(0.),
+  detection_workers(0),
+  energy_workers(0)
 {
   this->init_v2();
 }
@@ -643,6 +344,12 @@ scheduler::~scheduler()
   if(threading){
     instance = 0;
   }
+  if(reorder_buffer){
+    delete [] reorder_buffer; reorder_buffer = 0;
+  }
+  if(pulses_all){
+    delete pulses_all; pulses_all = 0;
+  }
 }
 
 /* ****************************************************************************/
@@ -746,7 +453,7 @@ phidlist::~phidlist()
 
 PhIDList* phidlist::get_PhIDList() const
 {
-  PhIDList* ret = new PhIDList;
+  PhIDList* ret = new PhIDList();
   ret->wait_list = wait_list;
   ret->n_elements = n_elements;
   ret->index = index;
@@ -884,7 +591,7 @@ tesrecord::~tesrecord()
 
 TesRecord* tesrecord::get_TesRecord() const
 {
-  TesRecord* ret = new TesRecord;
+  TesRecord* ret = new TesRecord();
   ret->trigger_size = trigger_size;
   ret->time = time;
   ret->delta_t = delta_t;
@@ -913,7 +620,8 @@ data::data():
   n_record(0),
   last_record(0),
   all_pulses(0),
-  record_pulses(0)
+  record_pulses(0),
+  index(0)
 {
   
 }
@@ -924,7 +632,8 @@ data::data(const data& other):
   all_pulses(0),
   record_pulses(0),
   rec(other.rec),
-  rec_init(other.rec_init)
+  rec_init(other.rec_init),
+  index(other.index)
 {
   
 }
@@ -937,6 +646,7 @@ data& data::operator=(const data& other)
     last_record = other.last_record;
     rec = other.rec;
     rec_init = other.rec_init;
+    index = other.index;
   }
   return *this;
 }
@@ -79,6 +79,9 @@ struct data
   OptimalFilterSIRENA* optimal_filter;
   TesEventList* event_list;
 
+  /** Position of the record in the input order (starting at 0) */
+  unsigned int index;
+
   data();
   data(const data& other);
   data& operator=(const data& other);
@@ -87,6 +90,11 @@ struct data
 
 #define sirena_data data
 
+/** Number of records per worker thread which may be in the
+    reconstruction pipeline at the same time. If the limit is reached,
+    push_detection blocks until the oldest record has been finished. */
+#define SCHEDULER_RECORDS_PER_WORKER 4
+
 class scheduler
 {
  public:
@@ -99,9 +107,6 @@ class scheduler
                       PulsesCollection** pulsesInRecord,
                       OptimalFilterSIRENA** optimal,
                       TesEventList* event_list);
-  void finish_reconstruction(ReconstructInitSIRENA* reconstruct_init,
-                             PulsesCollection** pulsesAll, 
-                             OptimalFilterSIRENA** optimalFilter);
   void finish_reconstruction_v2(ReconstructInitSIRENA* reconstruct_init,
                                 PulsesCollection** pulsesAll, 
                                 OptimalFilterSIRENA** optimalFilter);
@@ -111,7 +116,19 @@ class scheduler
 
   inline void set_is_running_energy(bool val){ this->is_running_energy = val; }
 
-  inline bool has_records(){return(this->num_records > this->current_record);}
+  // If an output file is set, the event lists are written in record
+  // order as soon as they are available and the records are released.
+  // Otherwise they are kept until they are read with get_test_event.
+  inline void set_output(TesEventFile* file, double delta_t)
+  {
+    this->output_file = file;
+    this->output_delta_t = delta_t;
+  }
+
+  inline bool has_records()
+  {
+    return(this->finished_records.size() > this->current_record);
+  }
 
   void get_test_event(TesEventList** test_event, TesRecord** record);
 
@@ -126,16 +143,30 @@ class scheduler
   scheduler(const scheduler& copy){}
   scheduler& operator=(const scheduler&){}
 
-  void init();
   void init_v2();
 
+  void emit_records(unsigned int max_pending);
+  void emit_record(sirena_data* data);
+
   unsigned int num_cores;
   unsigned int max_detection_workers;
   unsigned int max_energy_workers;
   unsigned int num_records;
   unsigned int current_record;
 
-  sirena_data** data_array;
+  // Finished records which have not been emitted yet, indexed by
+  // the record index modulo max_pending_records
+  sirena_data** reorder_buffer;
+  unsigned int max_pending_records;
+  unsigned int records_emitted;
+
+  // Pulses of all the emitted records in record order
+  PulsesCollection* pulses_all;
+
+  TesEventFile* output_file;
+  double output_delta_t;
+
+  std::vector<sirena_data*> finished_records;
 
   bool is_running_energy;
   
@@ -25,8 +25,8 @@
 
 #include "sixt.h"
 
-#include "linkedpholist.h"
 #include "photon.h"
+#include "photonbuffer.h"
 #include "simput.h"
 
 
@@ -66,21 +66,15 @@ Source* newSource(int* const status);
 void freeSource(Source** const src);
 
 /** Create photons for a particular source in the specified time
-    interval. */
-LinkedPhoListElement* getXRayPhotons(Source* const src,
-				     SimputCtlg* const simput,
-				     const double t0,
-				     const double t1,
-				     const double mjdref,
-				     int* const status);
-
-/** Sort the list of Source objects with the specified number of
-    entries with respect to the requested coordinate axis using a
-    quick sort algorithm. */
-void quicksortSources(Source* const list,
-		      const long left,
-		      const long right,
-		      const int axis);
+    interval. The photons are appended to the PhotonBuffer as a new
+    time-ordered chunk. */
+void getXRayPhotons(Source* const src,
+		    SimputCtlg* const simput,
+		    const double t0,
+		    const double t1,
+		    const double mjdref,
+		    PhotonBuffer* const buf,
+		    int* const status);
 
 
 #endif /* SOURCE_H */
@@ -22,6 +22,41 @@
 
 #include "sourcecatalog.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/** Identifier of the file format of the source catalog index. */
+#define SOURCECATALOG_INDEX_MAGIC "SIXTKDT1"
+
+/** Header of the source catalog index file. It is followed by the
+    array of extended sources and the array of KDTree nodes. */
+typedef struct {
+  char magic[8];
+
+  /** Size of a KDTreeNode [byte] (to detect incompatible builds). */
+  long nodesize;
+
+  /** Size [byte] and modification time of the catalog file. */
+  long catsize;
+  long catmtime;
+
+  /** Number of entries in the SIMPUT catalog. */
+  long nentries;
+
+  long nextsources;
+  long nnodes;
+
+} SourceCatalogIndexHeader;
+
+/** Extended source in the source catalog index file. */
+typedef struct {
+  double ra, dec, extension;
+  long row;
+} SourceCatalogIndexSource;
+
 
 SourceCatalog* newSourceCatalog(int* const status)
 {
@@ -43,7 +78,7 @@ void freeSourceCatalog(SourceCatalog** const cat, int* const status)
   if (NULL!=*cat) {
     // Free the KD-Tree.
     if (NULL!=(*cat)->tree) {
-      freeKDTreeElement(&((*cat)->tree));
+      freeKDTree(&((*cat)->tree));
     }
     // Free the array of extended sources.
     if (NULL!=(*cat)->extsources) {
@@ -59,26 +94,10 @@ void freeSourceCatalog(SourceCatalog** const cat, int* const status)
 }
 
 
-SourceCatalog* loadSourceCatalog(const char* const filename,
-				 struct ARF* const arf,
-				 int* const status)
+/** Determine the point-like and the extended sources of the SIMPUT
+    catalog and build the KDTree. */
+static void scanSourceCatalog(SourceCatalog* const cat, int* const status)
 {
-  headas_chat(3, "load source catalog from file '%s' ...\n", filename);
-
-  SourceCatalog* cat=newSourceCatalog(status);
-  CHECK_STATUS_RET(*status, cat);
-
-  // Set refernce to the random number generator to be used by the
-  // SIMPUT library routines.
-  setSimputRndGen(sixt_get_random_number);
-
-  // Use the routines from the SIMPUT library to load the catalog.
-  cat->simput=openSimputCtlg(filename, READONLY, 0, 0, 0, 0, status);
-  CHECK_STATUS_RET(*status, cat);
-
-  // Set reference to ARF for SIMPUT library.
-  setSimputARF(cat->simput, arf);
-
   // Determine the number of point-like and the number of
   // extended sources.
   unsigned long nextended =0;
@@ -104,22 +123,22 @@ SourceCatalog* loadSourceCatalog(const char* const filename,
       npointlike++;
     }
   }
-  CHECK_STATUS_RET(*status, cat);
+  CHECK_STATUS_VOID(*status);
 
   // Allocate memory for an array of the point-like sources,
   // which will be converted into a KDTree afterwards.
   Source* list=(Source*)malloc(npointlike*sizeof(Source));
-  CHECK_NULL_RET(list, *status,
-		 "memory allocation for source list failed", cat);
+  CHECK_NULL_VOID(list, *status,
+		  "memory allocation for source list failed");
 
   // Allocate memory for the array of the extended sources.
   cat->extsources=(Source*)malloc(nextended*sizeof(Source));
-  CHECK_NULL_RET(list, *status,
-		 "memory allocation for source list failed", cat);
+  CHECK_NULL_VOID(cat->extsources, *status,
+		  "memory allocation for source list failed");
 
   // Empty template object.
   Source* templatesrc=newSource(status);
-  CHECK_STATUS_RET(*status, cat);
+  CHECK_STATUS_VOID(*status);
 
   // Loop over all entries in the SIMPUT source catalog.
   unsigned long cpointlike=0;
@@ -154,15 +173,227 @@ SourceCatalog* loadSourceCatalog(const char* const filename,
       list[cpointlike-1].row = ii+1;
     }
   }
-  CHECK_STATUS_RET(*status, cat);
+  CHECK_STATUS_VOID(*status);
   // END of loop over all entries in the FITS table.
 
   // Build a KDTree from the source list (array of Source objects).
-  cat->tree=buildKDTree2(list, npointlike, 0, status);
+  cat->tree=buildKDTree(list, npointlike, status);
+
+  // Release memory.
+  if (templatesrc) free(templatesrc);
+  if (list) free(list);
+}
+
+
+/** Determine the name of the index file for the given catalog. The
+    return value is 1 if the index is enabled and the catalog is a
+    regular file, otherwise 0. */
+static int getSourceCatalogIndexName(const char* const filename,
+				     char* const indexname,
+				     struct stat* const catstat)
+{
+  const char* env=getenv("SIXTE_KDTREE_CACHE");
+  if ((NULL==env)||('\0'==env[0])) return(0);
+
+  // Catalogs given with the extended filename syntax (HDU selection
+  // or row filters, including the 'file.fits+n' notation) are not
+  // cached, as the rows of the KDTree refer to the selected table,
+  // which cannot be identified by the index header.
+  const char* plus=strrchr(filename, '+');
+  if ((NULL!=strchr(filename, '['))||
+      ((NULL!=plus)&&('\0'!=plus[1])&&
+       (strlen(plus+1)==strspn(plus+1, "0123456789")))) {
+    headas_chat(3, "no index file for catalog '%s' with extended "
+		"filename syntax\n", filename);
+    return(0);
+  }
+
+  if (0!=stat(filename, catstat)) return(0);
+  if (!S_ISREG(catstat->st_mode)) return(0);
+
+  if (strlen(filename)+strlen(".kdtree")>=MAXFILENAME) return(0);
+  sprintf(indexname, "%s.kdtree", filename);
+
+  return(1);
+}
+
+
+/** Load the KDTree and the extended sources from the index file. The
+    return value is 1 if the index could be used, or 0 if it does not
+    exist or does not match the catalog. */
+static int loadSourceCatalogIndex(SourceCatalog* const cat,
+				  const char* const indexname,
+				  const struct stat* const catstat,
+				  int* const status)
+{
+  int fd=open(indexname, O_RDONLY);
+  if (fd<0) return(0);
+
+  struct stat indexstat;
+  if ((0!=fstat(fd, &indexstat))||
+      (indexstat.st_size<(off_t)sizeof(SourceCatalogIndexHeader))) {
+    close(fd);
+    return(0);
+  }
+  size_t mapsize=(size_t)indexstat.st_size;
+  void* map=mmap(NULL, mapsize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (MAP_FAILED==map) return(0);
+
+  // Check whether the index belongs to the catalog.
+  const SourceCatalogIndexHeader* header=(const SourceCatalogIndexHeader*)map;
+  if ((0!=memcmp(header->magic, SOURCECATALOG_INDEX_MAGIC, 8))||
+      (header->nodesize!=(long)sizeof(KDTreeNode))||
+      (header->catsize!=(long)catstat->st_size)||
+      (header->catmtime!=(long)catstat->st_mtime)||
+      (header->nentries!=cat->simput->nentries)||
+      (header->nextsources<0)||(header->nnodes<0)||
+      (mapsize!=sizeof(SourceCatalogIndexHeader)+
+       header->nextsources*sizeof(SourceCatalogIndexSource)+
+       header->nnodes*sizeof(KDTreeNode))) {
+    headas_chat(3, "index file '%s' does not match the catalog\n", indexname);
+    munmap(map, mapsize);
+    return(0);
+  }
+  headas_chat(3, "use index file '%s' ...\n", indexname);
+
+  // Copy the extended sources.
+  const SourceCatalogIndexSource* ext=
+    (const SourceCatalogIndexSource*)((const char*)map+
+				      sizeof(SourceCatalogIndexHeader));
+  cat->extsources=(Source*)malloc(MAX(header->nextsources, 1)*sizeof(Source));
+  if (NULL==cat->extsources) {
+    munmap(map, mapsize);
+  }
+  CHECK_NULL_RET(cat->extsources, *status,
+		 "memory allocation for source list failed", 0);
+  long ii;
+  for (ii=0; ii<header->nextsources; ii++) {
+    cat->extsources[ii].ra           =ext[ii].ra;
+    cat->extsources[ii].dec          =ext[ii].dec;
+    cat->extsources[ii].extension    =(float)ext[ii].extension;
+    cat->extsources[ii].row          =ext[ii].row;
+    cat->extsources[ii].t_next_photon=NULL;
+  }
+  cat->nextsources=header->nextsources;
+
+  // The KDTree nodes are used directly from the mapping.
+  KDTreeNode* nodes=(KDTreeNode*)&(ext[header->nextsources]);
+  cat->tree=mapKDTree(map, mapsize, nodes, header->nnodes, status);
+  CHECK_STATUS_RET(*status, 0);
+
+  return(1);
+}
+
+
+/** Store the KDTree and the extended sources in the index file. As
+    the index is only an optional cache, failures result in a
+    warning. */
+static void saveSourceCatalogIndex(const SourceCatalog* const cat,
+				   const char* const indexname,
+				   const struct stat* const catstat)
+{
+  int status=EXIT_SUCCESS;
+
+  // Write to a temporary file first, such that concurrent runs never
+  // see an incomplete index.
+  char tmpname[MAXFILENAME+32];
+  sprintf(tmpname, "%s.%ld", indexname, (long)getpid());
+
+  FILE* file=fopen(tmpname, "wb");
+  if (NULL==file) {
+    char msg[MAXMSG];
+    snprintf(msg, MAXMSG, "could not create index file '%s'", tmpname);
+    SIXT_WARNING(msg);
+    return;
+  }
+
+  do { // Beginning of ERROR HANDLING Loop.
+
+    SourceCatalogIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SOURCECATALOG_INDEX_MAGIC, 8);
+    header.nodesize   =(long)sizeof(KDTreeNode);
+    header.catsize    =(long)catstat->st_size;
+    header.catmtime   =(long)catstat->st_mtime;
+    header.nentries   =cat->simput->nentries;
+    header.nextsources=cat->nextsources;
+    header.nnodes     =cat->tree->nnodes;
+    if (1!=fwrite(&header, sizeof(header), 1, file)) {
+      status=EXIT_FAILURE;
+      break;
+    }
+
+    long ii;
+    for (ii=0; ii<cat->nextsources; ii++) {
+      SourceCatalogIndexSource ext;
+      memset(&ext, 0, sizeof(ext));
+      ext.ra       =cat->extsources[ii].ra;
+      ext.dec      =cat->extsources[ii].dec;
+      ext.extension=cat->extsources[ii].extension;
+      ext.row      =cat->extsources[ii].row;
+      if (1!=fwrite(&ext, sizeof(ext), 1, file)) {
+	status=EXIT_FAILURE;
+	break;
+      }
+    }
+    CHECK_STATUS_BREAK(status);
+
+    saveKDTree(cat->tree, file, &status);
+    CHECK_STATUS_BREAK(status);
+
+  } while(0); // END of ERROR HANDLING Loop.
+
+  if (0!=fclose(file)) {
+    status=EXIT_FAILURE;
+  }
+  if ((EXIT_SUCCESS!=status)||(0!=rename(tmpname, indexname))) {
+    remove(tmpname);
+    SIXT_WARNING("could not write index file for source catalog");
+  }
+}
+
+
+SourceCatalog* loadSourceCatalog(const char* const filename,
+				 struct ARF* const arf,
+				 int* const status)
+{
+  headas_chat(3, "load source catalog from file '%s' ...\n", filename);
+
+  SourceCatalog* cat=newSourceCatalog(status);
   CHECK_STATUS_RET(*status, cat);
 
-  // In a later development stage this could be directly stored in
-  // a memory-mapped space.
+  // Set refernce to the random number generator to be used by the
+  // SIMPUT library routines.
+  setSimputRndGen(sixt_get_random_number);
+
+  // Use the routines from the SIMPUT library to load the catalog.
+  cat->simput=openSimputCtlg(filename, READONLY, 0, 0, 0, 0, status);
+  CHECK_STATUS_RET(*status, cat);
+
+  // Set reference to ARF for SIMPUT library.
+  setSimputARF(cat->simput, arf);
+
+  // Try to use the KDTree and the extended sources stored by a
+  // previous run.
+  char indexname[MAXFILENAME];
+  struct stat catstat;
+  int use_index=getSourceCatalogIndexName(filename, indexname, &catstat);
+  int loaded=0;
+  if (0!=use_index) {
+    loaded=loadSourceCatalogIndex(cat, indexname, &catstat, status);
+    CHECK_STATUS_RET(*status, cat);
+  }
+
+  if (0==loaded) {
+    scanSourceCatalog(cat, status);
+    CHECK_STATUS_RET(*status, cat);
+
+    if (0!=use_index) {
+      saveSourceCatalogIndex(cat, indexname, &catstat);
+    }
+  }
+
 
   // Load spectra into the internal cache used by the SIMPUT library.
   // This works only if all spectra are contained as mission-independent
@@ -186,20 +417,17 @@ SourceCatalog* loadSourceCatalog(const char* const filename,
     CHECK_STATUS_RET(*status, cat);
   }
 
-  // Release memory.
-  if (templatesrc) free(templatesrc);
-  if (list) free(list);
-
   return(cat);
 }
 
 
-LinkedPhoListElement* genFoVXRayPhotons(SourceCatalog* const cat,
-					const Vector* const pointing,
-					const float fov,
-					const double t0, const double t1,
-					const double mjdref,
-					int* const status)
+void genFoVXRayPhotons(SourceCatalog* const cat,
+		       const Vector* const pointing,
+		       const float fov,
+		       const double t0, const double t1,
+		       const double mjdref,
+		       PhotonBuffer* const buf,
+		       int* const status)
 {
   assert(NULL!=cat);
 
@@ -211,9 +439,9 @@ LinkedPhoListElement* genFoVXRayPhotons(SourceCatalog* const cat,
   // Perform a range search over all sources in the KDTree and
   // generate new photons for the sources within the FoV.
   // The kdTree only contains point-like sources.
-  LinkedPhoListElement* list=
-    KDTreeRangeSearch(cat->tree, 0, pointing, close_fov_min_align,
-		      t0, t1, mjdref, cat->simput, status);
+  KDTreeRangeSearch(cat->tree, pointing, close_fov_min_align,
+		    t0, t1, mjdref, cat->simput, buf, status);
+  CHECK_STATUS_VOID(*status);
 
   // Loop over all extended sources.
   long ii;
@@ -229,15 +457,9 @@ LinkedPhoListElement* genFoVXRayPhotons(SourceCatalog* const cat,
 	  if (0==check_fov(&location, pointing,cos(min_align))) {
 
 		  // Generate photons for this particular source.
-		  LinkedPhoListElement* newlist=
-				  getXRayPhotons(&(cat->extsources[ii]), cat->simput,
-						  t0, t1, mjdref, status);
-		  CHECK_STATUS_RET(*status, list);
-
-		  // Merge the new photons into the existing list.
-		  list=mergeLinkedPhoLists(list, newlist);
+		  getXRayPhotons(&(cat->extsources[ii]), cat->simput,
+				  t0, t1, mjdref, buf, status);
+		  CHECK_STATUS_VOID(*status);
 	  }
   }
-
-  return(list);
 }
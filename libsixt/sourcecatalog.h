@@ -27,7 +27,7 @@
 #include "check_fov.h"
 #include "gendet.h"
 #include "kdtreeelement.h"
-#include "linkedpholist.h"
+#include "photonbuffer.h"
 #include "simput.h"
 #include "source.h"
 
@@ -41,7 +41,7 @@
 typedef struct {
   /** KDTree containing the Source objects for all point-like
       sources. */
-  KDTreeElement* tree;
+  KDTree* tree;
 
   /** Array containing Source objects for all extended sources. */
   Source* extsources;
@@ -66,7 +66,13 @@ SourceCatalog* newSourceCatalog(int* const status);
 /** Destructor. */
 void freeSourceCatalog(SourceCatalog** const cat, int* const status);
 
-/** Load a SIMPUT source catalog from a FITS file. */
+/** Load a SIMPUT source catalog from a FITS file. If the environment
+    variable SIXTE_KDTREE_CACHE is set, the KDTree and the list of
+    extended sources are stored in the file '<catalog>.kdtree' and
+    memory-mapped from there on later runs, as long as the modification
+    time and the size of the catalog file remain unchanged. Note that
+    modifications of referenced image extensions in other files are
+    not detected. */
 SourceCatalog* loadSourceCatalog(const char* const filename,
 				 struct ARF* const arf,
 				 int* const status);
@@ -74,13 +80,14 @@ SourceCatalog* loadSourceCatalog(const char* const filename,
 /** Create photons for all sources in the catalog for the specified
     time interval. Only sources within the FoV (diameter given in
     [rad]) around the telescope pointing direction are taken into
-    account. */
-LinkedPhoListElement* genFoVXRayPhotons(SourceCatalog* const cat,
-					const Vector* const pointing,
-					const float fov,
-					const double t0, const double t1,
-					const double mjdref,
-					int* const status);
+    account. The photons are appended to the PhotonBuffer. */
+void genFoVXRayPhotons(SourceCatalog* const cat,
+		       const Vector* const pointing,
+		       const float fov,
+		       const double t0, const double t1,
+		       const double mjdref,
+		       PhotonBuffer* const buf,
+		       int* const status);
 
 
 #endif /* SOURCECATALOG_H */
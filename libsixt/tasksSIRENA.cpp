@@ -2153,11 +2153,11 @@ int procRecord(ReconstructInitSIRENA** reconstruct_init, double tstartRecord, do
 		//?? Too many messages
 	}
 
-	// Low-pass filtering
-	status = lpf_boxcar(&record,record->size,scaleFactor,samprate);
+	// Low-pass filtering and differentiate after filtering (in a single pass)
+	status = lpf_boxcar_derivative(&record,record->size,scaleFactor,samprate);
 	if (status == EPFAIL)
 	{
-		message = "Cannot run routine lpf_boxcar for low pass filtering";
+		message = "Cannot run routine lpf_boxcar_derivative for low pass filtering and differentiating";
 		EP_PRINT_ERROR(message,EPFAIL); return(EPFAIL);
 	}
 	if (status == 3)
@@ -2166,16 +2166,9 @@ int procRecord(ReconstructInitSIRENA** reconstruct_init, double tstartRecord, do
 	}
 	if (status == 4)
 	{
-		message = "lpf_boxcar: scaleFactor too high => Cut-off frequency too low";
+		message = "lpf_boxcar_derivative: scaleFactor too high => Cut-off frequency too low";
 		EP_PRINT_ERROR(message,status); return(EPFAIL);
 	}
-	
-	// Differentiate after filtering
-	if (differentiate (&record, record->size))
-	{
-		message = "Cannot run routine differentiate for differentiating after filtering";
-		EP_PRINT_ERROR(message,EPFAIL); return(EPFAIL);
-	}
 	gsl_vector_memcpy(recordDERIVATIVE,record);
         
         // Smooth derivative
@@ -10353,15 +10346,13 @@ int calculateEnergy (gsl_vector *vector, int pulseGrade, gsl_vector *filter, gsl
 					//if ((pulseGrade == 4) || (LagsOrNot == 0))
 					if (LagsOrNot == 0)
                                         {
-                                                gsl_vector  *vectorSHORT = gsl_vector_alloc(filterFFT->size);
+                                                // The FFT is calculated directly from a view of the pulse (no copy)
                                                 temp = gsl_vector_subvector(vector,0,filterFFT->size);
-                                                gsl_vector_memcpy(vectorSHORT,&temp.vector);
-                                                if (FFT(vectorSHORT,vectorFFT,SelectedTimeDuration))
+                                                if (FFT(&temp.vector,vectorFFT,SelectedTimeDuration))
                                                 {
                                                     message = "Cannot run routine FFT";
                                                     EP_PRINT_ERROR(message,EPFAIL); return(EPFAIL);
                                                 }
-                                                gsl_vector_free(vectorSHORT);
                                                 
                                                 for (int i=0; i<filterFFT->size; i++)
                                                 {
@@ -10388,15 +10379,12 @@ int calculateEnergy (gsl_vector *vector, int pulseGrade, gsl_vector *filter, gsl
                                                 {
                                                     for (int j=0;j<numlags;j++)
                                                     {
-                                                            gsl_vector  *vectorSHORT = gsl_vector_alloc(filterFFT->size);
                                                             temp = gsl_vector_subvector(vector,(reconstruct_init->nLags)/2+j-1,filterFFT->size);
-                                                            gsl_vector_memcpy(vectorSHORT,&temp.vector);
-                                                            if (FFT(vectorSHORT,vectorFFT,SelectedTimeDuration))
+                                                            if (FFT(&temp.vector,vectorFFT,SelectedTimeDuration))
                                                             {
                                                                     message = "Cannot run routine FFT";
                                                                     EP_PRINT_ERROR(message,EPFAIL); return(EPFAIL);
                                                             }
-                                                            gsl_vector_free(vectorSHORT);
                                                     
                                                             for (int i=0; i<filterFFT->size; i++)
                                                             {
@@ -10446,15 +10434,12 @@ int calculateEnergy (gsl_vector *vector, int pulseGrade, gsl_vector *filter, gsl
                                                             //cout<<"newLag= "<<newLag<<endl;
                                                             //cout<<"(reconstruct_init->nLags)/2+newLag= "<<(reconstruct_init->nLags)/2+newLag<<endl;
                                                             
-                                                            gsl_vector  *vectorSHORT = gsl_vector_alloc(filterFFT->size);
                                                             temp = gsl_vector_subvector(vector,(reconstruct_init->nLags)/2+newLag,filterFFT->size);
-                                                            gsl_vector_memcpy(vectorSHORT,&temp.vector);
-                                                            if (FFT(vectorSHORT,vectorFFT,SelectedTimeDuration))
+                                                            if (FFT(&temp.vector,vectorFFT,SelectedTimeDuration))
                                                             {
                                                                 message = "Cannot run routine FFT";
                                                                 EP_PRINT_ERROR(message,EPFAIL); return(EPFAIL);
                                                             }
-                                                            gsl_vector_free(vectorSHORT);
                                                             
                                                             gsl_complex newEnergyComplex = gsl_complex_rect(0.0,0.0);
                                                             for (int i=0; i<filterFFT->size; i++)
@@ -10502,15 +10487,12 @@ int calculateEnergy (gsl_vector *vector, int pulseGrade, gsl_vector *filter, gsl
                                                 {
                                                     for (int j=0;j<numlags;j++)
                                                     {
-                                                            gsl_vector  *vectorSHORT = gsl_vector_alloc(filterFFT->size);
                                                             temp = gsl_vector_subvector(vector,(reconstruct_init->nLags)/2+j-2,filterFFT->size);
-                                                            gsl_vector_memcpy(vectorSHORT,&temp.vector);
-                                                            if (FFT(vectorSHORT,vectorFFT,SelectedTimeDuration))
+                                                            if (FFT(&temp.vector,vectorFFT,SelectedTimeDuration))
                                                             {
                                                                     message = "Cannot run routine FFT";
                                                                     EP_PRINT_ERROR(message,EPFAIL); return(EPFAIL);
                                                             }
-                                                            gsl_vector_free(vectorSHORT);
                                                     
                                                             for (int i=0; i<filterFFT->size; i++)
                                                             {
@@ -10562,15 +10544,12 @@ int calculateEnergy (gsl_vector *vector, int pulseGrade, gsl_vector *filter, gsl
                                                             //cout<<"indexmax= "<<indexmax<<endl;
                                                             //cout<<"newLag= "<<newLag<<endl;
                                                             
-                                                            gsl_vector  *vectorSHORT = gsl_vector_alloc(filterFFT->size);
                                                             temp = gsl_vector_subvector(vector,(reconstruct_init->nLags)/2+newLag,filterFFT->size);
-                                                            gsl_vector_memcpy(vectorSHORT,&temp.vector);
-                                                            if (FFT(vectorSHORT,vectorFFT,SelectedTimeDuration))
+                                                            if (FFT(&temp.vector,vectorFFT,SelectedTimeDuration))
                                                             {
                                                                 message = "Cannot run routine FFT";
                                                                 EP_PRINT_ERROR(message,EPFAIL); return(EPFAIL);
                                                             }
-                                                            gsl_vector_free(vectorSHORT);
                                                             
                                                             gsl_complex newEnergyComplex = gsl_complex_rect(0.0,0.0);
                                                             for (int i=0; i<filterFFT->size; i++)
@@ -22,6 +22,8 @@
 
 #include "tesdatastream.h"
 
+#include <unistd.h>
+
 TESDataStream* newTESDataStream(int* const status){
 
   TESDataStream* stream=(TESDataStream*)malloc(sizeof(TESDataStream));
@@ -346,6 +348,37 @@ void writeTESFitsStream(fitsfile *fptr,
 
 }
 
+/** Write the rows of a TESFitsStream into the current HDU starting at
+    the specified row. */
+static void writeTESFitsStreamRows(fitsfile *fptr,
+				   TESFitsStream *stream,
+				   LONGLONG firstrow,
+				   int* const status)
+{
+  long nrows=(long)stream->Ntime;
+
+  // get the required column numbers
+  int timecol;
+  fits_get_colnum(fptr,CASESEN,"TIME",&timecol,status);
+  int ii;
+  char ttype[9];
+  int colnum[stream->Npix+1];
+  for(ii=0; ii<stream->Npix; ii++){
+    sprintf(ttype, "PXL%05d", stream->pixID[ii]+1);
+    fits_get_colnum(fptr,CASESEN,ttype,colnum+ii,status);
+  }
+  CHECK_STATUS_VOID(*status);
+
+  // write data to the table
+  fits_write_col(fptr, TDOUBLE, timecol, firstrow, 1, nrows, stream->time, status);
+  CHECK_STATUS_VOID(*status);
+  for(ii=0; ii<stream->Npix; ii++){
+    fits_write_col(fptr, TUSHORT, colnum[ii], firstrow, 1, nrows,
+		   stream->adc_value[ii], status);
+    CHECK_STATUS_VOID(*status);
+  }
+}
+
 void appendTESFitsStream(fitsfile *fptr,
 			TESFitsStream *stream,
 			double tstart,
@@ -358,9 +391,6 @@ void appendTESFitsStream(fitsfile *fptr,
   //
   // NOTE: THIS FUNCTION IS NOT WELL TESTED YET - USE WITH CAUTION
   //
-  long nrows=(long)stream->Ntime;
-  int ncolumns=1+stream->Npix;
-
   fits_movnam_hdu(fptr,BINARY_TBL,"TESDATASTREAM",0,status);
   CHECK_STATUS_VOID(*status);
 
@@ -372,20 +402,9 @@ void appendTESFitsStream(fitsfile *fptr,
         &tstop, "Stop time of data stream", status);
   CHECK_STATUS_VOID(*status);
 
-  // get the required column numbers
-  int timecol;
-  fits_get_colnum(fptr,CASESEN,"TIME",&timecol,status);
-  int ii;
-  char ttype[9];
-  int colnum[ncolumns];
-  for(ii=0; ii<stream->Npix; ii++){
-    sprintf(ttype, "PXL%05d", stream->pixID[ii]+1);
-    fits_get_colnum(fptr,CASESEN,ttype,colnum+ii,status);
-  }
-  CHECK_STATUS_VOID(*status);
-
   // Update header keywords (doing this first avoid too many seeks in the
   // table)
+  int ii;
   for(ii=0;ii<stream->Npix; ii++) {
     char nev[9];
     sprintf(nev, "NES%05d", stream->pixID[ii]+1);
@@ -400,331 +419,1037 @@ void appendTESFitsStream(fitsfile *fptr,
   CHECK_STATUS_VOID(*status);
 
   // append data to the table
-  fits_write_col(fptr, TDOUBLE, timecol, tablenrows+1, 1, nrows, stream->time, status);
-  CHECK_STATUS_VOID(*status);
-  for(ii=0; ii<stream->Npix; ii++){
-    fits_write_col(fptr, TUSHORT, colnum[ii], tablenrows+1, 1, nrows,
-		   stream->adc_value[ii], status);
-    CHECK_STATUS_VOID(*status);
-  }
-
+  writeTESFitsStreamRows(fptr, stream, tablenrows+1, status);
 }
 
-void getTESDataStream(TESDataStream* TESData,
-		PixImpFile* PixFile,
-		TESProfiles* TESProf,
-		AdvDet* det,
-		double tstart,
-		double tstop,
-		int Ndetpix,
-		int Nactive,
-		int* activearray,
-		long* Nevts,
-		int *ismonoc,
-		float *monoen,
-		unsigned long int seed,
-		int* const status)
+/** Read the next impact for the generation of the data stream, either
+    from the impact buffer or directly from the impact file. */
+static int getNextTESStreamImpact(TESStreamGenerator* gen,
+				  PixImpact* impact,
+				  int* const status)
 {
+	if (gen->iimpact<gen->nimpacts) {
+		*impact=gen->impacts[gen->iimpact++];
+		return 1;
+	}
+	if (gen->impfile_eof) {
+		return 0;
+	}
 
-	/* Parameters that need to be obtained from elsewhere */
-
-	double SampleFreq;     /* Sample Frequency / From XML 10^6 Hz */
-	int Npix;              /* Number of active pixels*/
-	AdvPix** simulated_pixels = getSimulatedPixelArray(det,activearray,Ndetpix,Nactive,status); /* Array containing pointers to the pixels actually simulated */
-
-	/* Local variables */
-	int inoise;            /* Position index in noise buffer */
-	int ipix;              /* Pixel index */
-	double t;              /* Time index */
-	double PixVal;         /* Pixel value (double) */
-	PixImpact impact;      /* Current impact */
-
-
-	/* Status of getNextImpactFromPixImpFile */
-	int piximpstatus=0;
-	int evtpixid=-1; // PixID of event
-
-	// total number of simulated events
-	long ntot=0;
-
-	/* Initialize running indices */
-	t=tstart;
-	inoise=NOISEBUFFERSIZE;
-
-	/* Temporary definition of variables / Exposure of 10 ms */
-	SampleFreq=det->SampleFreq;    	/* Hertz */
-	Npix=Nactive;       		  	/* Number of pixels */
-
-	long Nt=(tstop-tstart)*SampleFreq; // Number of time steps
-	long tstep=0; // active timestep
-
-	/* Initialize rng */
-	gsl_rng *rng;
-	setNoiseGSLSeed(&rng, seed);
-
-	/* allocate output stream structure */
-	allocateTESDataStream(TESData, Nt, Npix, status);
-	CHECK_STATUS_VOID(*status);
+	if (gen->fitsmutex!=NULL) {
+		pthread_mutex_lock(gen->fitsmutex);
+	}
+	int piximpstatus=getNextImpactFromPixImpFile(gen->PixFile,impact,status);
+	if (gen->fitsmutex!=NULL) {
+		pthread_mutex_unlock(gen->fitsmutex);
+	}
+	return piximpstatus;
+}
 
-	/* Initialize Noise buffer */
-	NoiseBuffer* NBuffer=newNoiseBuffer(status, &Npix);
-	CHECK_STATUS_VOID(*status);
+/** Read the impacts up to the specified time from the impact file into
+    the impact buffer. The following time steps can then be generated
+    without accessing the FITS file, which might be written by another
+    thread at the same time. */
+static void fillTESStreamImpactBuffer(TESStreamGenerator* gen,
+				      double tend,
+				      int* const status)
+{
+	/* Remove the impacts which have already been processed */
+	long ii;
+	for (ii=gen->iimpact; ii<gen->nimpacts; ii++) {
+		gen->impacts[ii-gen->iimpact]=gen->impacts[ii];
+	}
+	gen->nimpacts-=gen->iimpact;
+	gen->iimpact=0;
 
-	/* Initialize 1/F noise arrays */
-	NoiseOoF** OFNoise=NULL;
-	if (det->oof_activated){
-		OFNoise = malloc(Nactive*sizeof(*OFNoise));
-		if(OFNoise==NULL){
-			*status=EXIT_FAILURE;
-			SIXT_ERROR("Memory allocation for OFNoise failed");
-			CHECK_STATUS_VOID(*status);
-		}
-		for(int i=0;i<Nactive;i++){
-			if(simulated_pixels[i]->TESNoise->OoFRMS!=0.){
-				OFNoise[i]=newNoiseOoF(status,&rng,SampleFreq,simulated_pixels[i]);
-				CHECK_STATUS_VOID(*status);
-			} else{
-				OFNoise[i]=NULL;
+	if (gen->fitsmutex!=NULL) {
+		pthread_mutex_lock(gen->fitsmutex);
+	}
+	while ((!gen->impfile_eof) &&
+	       ((gen->nimpacts==0)||(gen->impacts[gen->nimpacts-1].time<tend))) {
+		if (gen->nimpacts>=gen->maximpacts) {
+			long newsize=MAX(2*gen->maximpacts,1024);
+			PixImpact* impacts=(PixImpact*)realloc(gen->impacts,newsize*sizeof(PixImpact));
+			if (impacts==NULL) {
+				*status=EXIT_FAILURE;
+				SIXT_ERROR("memory allocation for impact buffer failed");
+				break;
 			}
+			gen->impacts=impacts;
+			gen->maximpacts=newsize;
+		}
+		if (getNextImpactFromPixImpFile(gen->PixFile,&(gen->impacts[gen->nimpacts]),status)>0) {
+			gen->nimpacts++;
+		} else {
+			gen->impfile_eof=1;
+		}
+		if (*status!=EXIT_SUCCESS) {
+			break;
 		}
 	}
-
-	/* Initialize array of linked lists containing active pulses */
-	EvtNode** ActPulses=NULL;
-	ActPulses=newEventNodes(&Npix,status);
-	CHECK_STATUS_VOID(*status);
-	if(ActPulses==NULL){
-		*status=EXIT_FAILURE;
-		SIXT_ERROR("ActPulses was NULL after memory allocation.");
+	if (gen->fitsmutex!=NULL) {
+		pthread_mutex_unlock(gen->fitsmutex);
 	}
-	CHECK_STATUS_VOID(*status);
-
-	t=tstart;
-	long t_long = 0;
-	EvtNode *current;
+}
 
-	printf("Simulate %ld time steps for %d pixels.\n", Nt, Npix);
+/** Append a pulse to the ring buffer of a pixel. */
+static void pushTESPulse(TESPulseRing* ring,
+			 long start,
+			 double energy,
+			 const double* adc,
+			 int* const status)
+{
+	if (ring->n>=ring->size) {
+		/* Enlarge the buffer and move the pulses to its beginning */
+		int newsize=MAX(2*ring->size,8);
+		long* newstart=(long*)malloc(newsize*sizeof(long));
+		double* newenergy=(double*)malloc(newsize*sizeof(double));
+		const double** newadc=(const double**)malloc(newsize*sizeof(const double*));
+		double* newcount=(double*)malloc(newsize*sizeof(double));
+		if ((newstart==NULL)||(newenergy==NULL)||(newadc==NULL)||(newcount==NULL)) {
+			free(newstart);
+			free(newenergy);
+			free(newadc);
+			free(newcount);
+			*status=EXIT_FAILURE;
+			SIXT_ERROR("memory allocation for active pulses failed");
+			return;
+		}
+		int ii;
+		for (ii=0; ii<ring->n; ii++) {
+			int kk=(ring->first+ii)%ring->size;
+			newstart[ii]=ring->start[kk];
+			newenergy[ii]=ring->energy[kk];
+			newadc[ii]=ring->adc[kk];
+			newcount[ii]=ring->count[kk];
+		}
+		free(ring->start);
+		free(ring->energy);
+		free(ring->adc);
+		free(ring->count);
+		ring->start=newstart;
+		ring->energy=newenergy;
+		ring->adc=newadc;
+		ring->count=newcount;
+		ring->size=newsize;
+		ring->first=0;
+	}
 
-	*ismonoc=1;
+	int kk=(ring->first+ring->n)%ring->size;
+	ring->start[kk]=start;
+	ring->energy[kk]=energy;
+	ring->adc[kk]=adc;
+	ring->count[kk]=0.;
+	ring->n++;
+}
 
-	/* While loop over all time bins */
-	while (tstep<Nt) {
+/** Generate the noise of the next n time steps and assign the
+    impacts of these time steps to the pixels. This part of the
+    generation uses the random number generator and the impact file
+    and is therefore done sequentially, in the same order as for a
+    step-by-step generation of the data stream. */
+static void getTESStreamNoise(TESStreamGenerator* gen,
+			      long n,
+			      int* const status)
+{
+	AdvDet* det=gen->det;
+	AdvPix** simulated_pixels=gen->simulated_pixels;
+	double SampleFreq=gen->SampleFreq;
+	int ipix;
+	int evtpixid=-1; // PixID of event
+	double PixVal;         /* Pixel value (double) */
 
+	long tt;
+	for (tt=0; tt<n; tt++) {
 		/* Write time stamp */
-		TESData->time[tstep]=t;
+		double t=gen->tstart+gen->tstep/SampleFreq;
+		gen->time_block[tt]=t;
 
 		/* Fill Noise buffer */
-		if (inoise==NOISEBUFFERSIZE) {
-			genNoiseSpectrum(simulated_pixels,NBuffer,&SampleFreq,&rng,status);
+		if (gen->inoise==NOISEBUFFERSIZE) {
+			genNoiseSpectrum(simulated_pixels,gen->NBuffer,&(gen->SampleFreq),&(gen->rng),status);
 			CHECK_STATUS_VOID(*status);
-			inoise=0;
+			gen->inoise=0;
 		}
 
 		/* Calculate next state of 1/f noise base array */
 		if(det->oof_activated){
-			getNextOoFNoiseSumval(OFNoise, &rng,Nactive);
+			getNextOoFNoiseSumval(gen->OFNoise,&(gen->rng),gen->Npix);
 		}
 
-
 		/* Get first event from the impact file */
-		if (tstep==0) {
-			piximpstatus=getNextImpactFromPixImpFile(PixFile,&impact,status);
+		if (gen->tstep==0) {
+			gen->piximpstatus=getNextTESStreamImpact(gen,&(gen->impact),status);
 			CHECK_STATUS_VOID(*status);
 		}
 
 		/* If the event occurs in this time bin and is in an active pixel, */
-		/* add it to the node list */
-		while ((piximpstatus>0) &&(impact.time>=t)&&(impact.time<t+(1.0/SampleFreq))) {
-			evtpixid=checkPixIfActive(impact.pixID, Ndetpix, activearray);
+		/* add it to the active pulses of the pixel */
+		PixImpact* impact=&(gen->impact);
+		while ((gen->piximpstatus>0) &&(impact->time>=t)&&(impact->time<t+(1.0/SampleFreq))) {
+			evtpixid=checkPixIfActive(impact->pixID, gen->Ndetpix, gen->activearray);
 			if(evtpixid>-1){
-				int profver=det->pix[impact.pixID].profVersionID;
-				int eindex=findTESProfileEnergyIndex(TESProf,
+				int profver=det->pix[impact->pixID].profVersionID;
+				int eindex=findTESProfileEnergyIndex(gen->TESProf,
 						profver,
-						impact.energy);
-				addEventToNode(ActPulses,TESProf,&impact,evtpixid,profver,eindex,status);
-				CHECK_STATUS_VOID(*status);
-				Nevts[impact.pixID]=Nevts[impact.pixID]+1;
-				if(ActPulses[evtpixid]==NULL){
-					*status=EXIT_FAILURE;
-					SIXT_ERROR("Added impact but pointer is NULL.");
-					CHECK_STATUS_VOID(*status);
-				}
+						impact->energy);
+				pushTESPulse(&(gen->pulses[evtpixid]),gen->tstep,impact->energy,
+					     gen->TESProf->profiles[profver].adc_value[eindex],status);
 				CHECK_STATUS_VOID(*status);
-				if(*ismonoc==1){
-					if(ntot==0){
-						*monoen=impact.energy;
+				gen->Nevts[impact->pixID]=gen->Nevts[impact->pixID]+1;
+				if(gen->ismonoc==1){
+					if(gen->ntot==0){
+						gen->monoen=impact->energy;
 					}else{
-						if(impact.energy!=(*monoen)){
-							*monoen=0.;
-							*ismonoc=0;
+						if(impact->energy!=gen->monoen){
+							gen->monoen=0.;
+							gen->ismonoc=0;
 						}
 					}
 				}
-				ntot++;
+				gen->ntot++;
 			}
 			CHECK_STATUS_VOID(*status);
-			piximpstatus=getNextImpactFromPixImpFile(PixFile,&impact,status);
+			gen->piximpstatus=getNextTESStreamImpact(gen,impact,status);
 			CHECK_STATUS_VOID(*status);
 		}
 
-		for (ipix=0;ipix<Npix;ipix++) {
-			/* Add the offset first */
-			TESData->adc_value[tstep][ipix]=(uint16_t)simulated_pixels[ipix]->ADCOffset;
+		for (ipix=0;ipix<gen->Npix;ipix++) {
 			PixVal=0.;
 
 			/* Add 1/f noise to the pixel value (double) */
-			CHECK_STATUS_VOID(*status);
 			if(det->oof_activated && simulated_pixels[ipix]->TESNoise->OoFRMS!=0.){
-				PixVal= PixVal + OFNoise[ipix]->Sumrval + gsl_ran_gaussian(rng,OFNoise[ipix]->Sigma);
+				PixVal= PixVal + gen->OFNoise[ipix]->Sumrval + gsl_ran_gaussian(gen->rng,gen->OFNoise[ipix]->Sigma);
 			}
-			CHECK_STATUS_VOID(*status);
 
 			/* Add noise to the pixel value (double) */
-			PixVal=PixVal + NBuffer->Buffer[inoise][ipix];
+			PixVal=PixVal + gen->NBuffer->Buffer[gen->inoise][ipix];
 
-			/* Loop over linked list and add pulse values */
-			current=ActPulses[ipix];
-			while (current!=NULL) {
-				PixVal=PixVal + simulated_pixels[ipix]->calfactor * current->adcpulse[(long)(current->count)];
-				CHECK_STATUS_VOID(*status);
-				current->count=current->count+(1./SampleFreq)/(current->time[1]-current->time[0]);
-				current=current->next;
+			gen->signal_block[ipix*TESSTREAMBLOCKSIZE+tt]=PixVal;
+		}
+
+		/* Go to next time step */
+		gen->inoise=gen->inoise+1;
+		gen->tstep++;
+	}
+}
+
+/** Add the active pulses to the signal of the pixels [ipix0,ipix1)
+    for the n time steps of the current block, which starts at time
+    step tstep0, and digitize the signal. The pulses are added in the
+    order of their arrival, such that the sums are identical to the
+    ones of a step-by-step generation. */
+static void getTESStreamPulses(TESStreamGenerator* gen,
+			       long tstep0,
+			       long n,
+			       int ipix0,
+			       int ipix1)
+{
+	int ipix;
+	for (ipix=ipix0; ipix<ipix1; ipix++) {
+		AdvPix* pix=gen->simulated_pixels[ipix];
+		TESPulseRing* ring=&(gen->pulses[ipix]);
+		double* restrict pixsignal=&(gen->signal_block[ipix*TESSTREAMBLOCKSIZE]);
+		double calfactor=pix->calfactor;
+
+		if (ring->n>0) {
+			/* All pulses of a pixel use the same template version */
+			TESProfilesEntries* prof=&(gen->TESProf->profiles[pix->profVersionID]);
+			double step=(1./gen->SampleFreq)/(prof->time[1]-prof->time[0]);
+			double end=(double)(prof->Nt-1);
+
+			int ii;
+			for (ii=0; ii<ring->n; ii++) {
+				int kk=(ring->first+ii)%ring->size;
+				double energy=ring->energy[kk];
+				const double* restrict adc=ring->adc[kk];
+				long tt=MAX(ring->start[kk]-tstep0,0);
+
+				if (step==1.0) {
+					/* Template and data stream have the same sampling, */
+					/* i.e., the template is added as a whole */
+					long count=(long)ring->count[kk];
+					long nsamples=MIN(n-tt,MAX(prof->Nt-1-count,1));
+					const double* restrict pulse=&(adc[count]);
+					long jj;
+					for (jj=0; jj<nsamples; jj++) {
+						pixsignal[tt+jj]=pixsignal[tt+jj] + calfactor * (energy * pulse[jj]);
+					}
+					ring->count[kk]+=(double)nsamples;
+				} else {
+					for (; tt<n; tt++) {
+						pixsignal[tt]=pixsignal[tt] + calfactor * (energy * adc[(long)(ring->count[kk])]);
+						ring->count[kk]=ring->count[kk]+step;
+						if (ring->count[kk]>=end) {
+							break;
+						}
+					}
+				}
 			}
 
-			/* The digitization step */
-			double tesdbl=TESData->adc_value[tstep][ipix] + PixVal;
+			/* If the end of the Pulse template is reached, remove the event */
+			while ((ring->n>0)&&(ring->count[ring->first]>=end)) {
+				ring->first=(ring->first+1)%ring->size;
+				ring->n--;
+			}
+		}
+
+		/* The digitization step */
+		uint16_t* restrict adc_value=&(gen->adc_block[ipix*TESSTREAMBLOCKSIZE]);
+		double offset=(double)(uint16_t)pix->ADCOffset;
+		long tt;
+		for (tt=0; tt<n; tt++) {
+			double tesdbl=offset + pixsignal[tt];
 			if(tesdbl<0.){
 				tesdbl=0.;
 			}
 			if(tesdbl>65534.){//maximum coded value -1
 				tesdbl=65534.;
 			}
-			TESData->adc_value[tstep][ipix]=(uint16_t)round(tesdbl); //TODO Noise buffer seems to contain repeated shapes. Needs to be investigated.
-			if(TESData->adc_value[tstep][ipix]==65535){
-				printf("tstep=%ld ipix=%d noise=%lf, inoise=%d, tesdbl=%le\n", tstep, ipix, PixVal, inoise, tesdbl);
-			}
+			adc_value[tt]=(uint16_t)round(tesdbl); //TODO Noise buffer seems to contain repeated shapes. Needs to be investigated.
+		}
+	}
+}
 
-			/* If the end of the Pulse template is reached, remove the event */
-			while (ActPulses[ipix]!=NULL && ActPulses[ipix]->count>=(double)(ActPulses[ipix]->Nt-1)) {
-				removeEventFromNode(ActPulses,&ipix);
-				CHECK_STATUS_VOID(*status);
-			}
+/** Persistent threads adding the pulses to the pixels. The pixels
+    are divided into nranges ranges, the first of which is processed
+    by the generating thread itself. For each block the generating
+    thread publishes the block parameters and waits until all threads
+    have finished their ranges. */
+typedef struct TESStreamThreads{
+	TESStreamGenerator* gen;
+
+	pthread_t* thread;
+	int nstarted;
+
+	/** Number of pixel ranges, i.e., the number of started threads
+	    plus the generating thread. */
+	int nranges;
+
+	/** Number of threads which have obtained their range index. */
+	int nids;
+
+	/** Sequence number and parameters of the current block. */
+	long block;
+	long tstep0;
+	long n;
+
+	/** Number of threads which have finished the current block. */
+	int ndone;
+
+	/** Flag whether the threads have to terminate. */
+	int quit;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t start;
+	pthread_cond_t done;
+}TESStreamThreads;
+
+static void getTESStreamPixelRange(const TESStreamGenerator* gen,
+				   int id,
+				   int nranges,
+				   int* ipix0,
+				   int* ipix1)
+{
+	*ipix0=(int)((long)gen->Npix*id/nranges);
+	*ipix1=(int)((long)gen->Npix*(id+1)/nranges);
+}
+
+static void* tesStreamPulsesThread(void* arg)
+{
+	TESStreamThreads* threads=(TESStreamThreads*)arg;
+	long seen=0;
+
+	pthread_mutex_lock(&(threads->mutex));
+	int id=++(threads->nids);
+	while (1) {
+		while ((threads->block==seen)&&(0==threads->quit)) {
+			pthread_cond_wait(&(threads->start),&(threads->mutex));
 		}
+		if (0!=threads->quit) {
+			break;
+		}
+		seen=threads->block;
+		long tstep0=threads->tstep0;
+		long n=threads->n;
+		int ipix0, ipix1;
+		getTESStreamPixelRange(threads->gen,id,threads->nranges,&ipix0,&ipix1);
+		pthread_mutex_unlock(&(threads->mutex));
+
+		getTESStreamPulses(threads->gen,tstep0,n,ipix0,ipix1);
+
+		pthread_mutex_lock(&(threads->mutex));
+		threads->ndone++;
+		if (threads->ndone==threads->nranges-1) {
+			pthread_cond_signal(&(threads->done));
+		}
+	}
+	pthread_mutex_unlock(&(threads->mutex));
 
-		/* Go to next time step */
-		inoise=inoise+1;
-		t_long++;
-		t=tstart+t_long/SampleFreq;
-		tstep++;
+	return(NULL);
+}
 
+/** Start nthreads-1 threads for the pulses of the following blocks.
+    If fewer threads can be started, the pixels are distributed to the
+    started ones. */
+static void startTESStreamThreads(TESStreamGenerator* gen,
+				  int nthreads,
+				  int* const status)
+{
+	TESStreamThreads* threads=(TESStreamThreads*)malloc(sizeof(TESStreamThreads));
+	CHECK_NULL_VOID(threads,*status,"memory allocation for TESStreamThreads failed");
+	threads->thread=(pthread_t*)malloc((nthreads-1)*sizeof(pthread_t));
+	if (threads->thread==NULL) {
+		free(threads);
+		*status=EXIT_FAILURE;
+		SIXT_ERROR("memory allocation for TESStreamThreads failed");
+		return;
+	}
+	threads->gen=gen;
+	threads->nstarted=0;
+	threads->nranges=1;
+	threads->nids=0;
+	threads->block=0;
+	threads->tstep0=0;
+	threads->n=0;
+	threads->ndone=0;
+	threads->quit=0;
+	pthread_mutex_init(&(threads->mutex),NULL);
+	pthread_cond_init(&(threads->start),NULL);
+	pthread_cond_init(&(threads->done),NULL);
+
+	/* The threads wait for the first block, i.e., the number of */
+	/* ranges can be set afterwards */
+	int ii;
+	for (ii=0; ii<nthreads-1; ii++) {
+		if (0!=pthread_create(&(threads->thread[ii]),NULL,tesStreamPulsesThread,threads)) {
+			SIXT_WARNING("could not create thread, continue with fewer threads");
+			break;
+		}
+		threads->nstarted++;
 	}
+	pthread_mutex_lock(&(threads->mutex));
+	threads->nranges=threads->nstarted+1;
+	pthread_mutex_unlock(&(threads->mutex));
 
-	/* Clean dynamic memory */
-	for (ipix=0;ipix<Npix;ipix++) {
-		destroyEventNode(ActPulses[ipix]);
+	gen->threads=threads;
+}
+
+static void stopTESStreamThreads(TESStreamGenerator* gen)
+{
+	TESStreamThreads* threads=gen->threads;
+	if (threads==NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&(threads->mutex));
+	threads->quit=1;
+	pthread_cond_broadcast(&(threads->start));
+	pthread_mutex_unlock(&(threads->mutex));
+
+	int ii;
+	for (ii=0; ii<threads->nstarted; ii++) {
+		pthread_join(threads->thread[ii],NULL);
 	}
-	destroyNoiseBuffer(NBuffer,status);
-	free(simulated_pixels);
+	pthread_mutex_destroy(&(threads->mutex));
+	pthread_cond_destroy(&(threads->start));
+	pthread_cond_destroy(&(threads->done));
+	free(threads->thread);
+	free(threads);
+	gen->threads=NULL;
 }
 
+/** Generate the next block of (at most TESSTREAMBLOCKSIZE) time
+    steps. The time stamps and the signal values of all simulated
+    pixels are stored in time_block and adc_block. */
+static void getTESStreamBlock(TESStreamGenerator* gen,
+			      long n,
+			      int* const status)
+{
+	long tstep0=gen->tstep;
+	getTESStreamNoise(gen,n,status);
+	CHECK_STATUS_VOID(*status);
 
-EvtNode** newEventNodes(int *NPixel, int* const status) {
-  int i;
-  EvtNode **ActPulses = NULL;
-  ActPulses = (EvtNode**)malloc(*NPixel*sizeof(EvtNode*));
-  if(ActPulses==NULL){
-    *status=EXIT_FAILURE;
-    SIXT_ERROR("memory allocation for ActPulses failed");
-    return(ActPulses);
-  }
-  for (i=0;i<*NPixel;i++) {
-    ActPulses[i]=NULL;
-  }
-  return ActPulses;
+	int nthreads=MIN(gen->nthreads,gen->Npix);
+	if ((nthreads>1)&&(gen->threads==NULL)) {
+		startTESStreamThreads(gen,nthreads,status);
+		CHECK_STATUS_VOID(*status);
+	}
+	TESStreamThreads* threads=gen->threads;
+	if ((threads==NULL)||(threads->nranges<=1)) {
+		getTESStreamPulses(gen,tstep0,n,0,gen->Npix);
+		return;
+	}
+
+	/* Pass the block to the threads and process the first range */
+	pthread_mutex_lock(&(threads->mutex));
+	threads->tstep0=tstep0;
+	threads->n=n;
+	threads->ndone=0;
+	threads->block++;
+	pthread_cond_broadcast(&(threads->start));
+	pthread_mutex_unlock(&(threads->mutex));
+
+	int ipix0, ipix1;
+	getTESStreamPixelRange(gen,0,threads->nranges,&ipix0,&ipix1);
+	getTESStreamPulses(gen,tstep0,n,ipix0,ipix1);
+
+	pthread_mutex_lock(&(threads->mutex));
+	while (threads->ndone<threads->nranges-1) {
+		pthread_cond_wait(&(threads->done),&(threads->mutex));
+	}
+	pthread_mutex_unlock(&(threads->mutex));
 }
 
-int addEventToNode(EvtNode** ActPulses,
-		   TESProfiles* Pulses,
-                   PixImpact* impact,
-		   int pixno,
-		   int versionID,
-		   int EnID,
-		   int* const status)
+TESStreamGenerator* newTESStreamGenerator(PixImpFile* PixFile,
+					  TESProfiles* TESProf,
+					  AdvDet* det,
+					  double tstart,
+					  double tstop,
+					  int Ndetpix,
+					  int Nactive,
+					  int* activearray,
+					  long* Nevts,
+					  unsigned long int seed,
+					  int* const status)
 {
-   int i;
+	TESStreamGenerator* gen=(TESStreamGenerator*)malloc(sizeof(TESStreamGenerator));
+	CHECK_NULL_RET(gen,*status,"memory allocation for TESStreamGenerator failed",gen);
+
+	/* Initialize pointers with NULL */
+	gen->simulated_pixels=NULL;
+	gen->rng=NULL;
+	gen->NBuffer=NULL;
+	gen->OFNoise=NULL;
+	gen->pulses=NULL;
+	gen->impacts=NULL;
+	gen->fitsmutex=NULL;
+	gen->time_block=NULL;
+	gen->signal_block=NULL;
+	gen->adc_block=NULL;
+	gen->threads=NULL;
+
+	/* Initialize values */
+	gen->PixFile=PixFile;
+	gen->TESProf=TESProf;
+	gen->det=det;
+	gen->tstart=tstart;
+	gen->SampleFreq=det->SampleFreq;
+	gen->Ndetpix=Ndetpix;
+	gen->Npix=Nactive;
+	gen->activearray=activearray;
+	gen->Nevts=Nevts;
+	gen->Nt=(tstop-tstart)*gen->SampleFreq; // Number of time steps
+	gen->tstep=0;
+	gen->inoise=NOISEBUFFERSIZE;
+	gen->piximpstatus=0;
+	gen->nimpacts=0;
+	gen->maximpacts=0;
+	gen->iimpact=0;
+	gen->impfile_eof=0;
+	gen->ntot=0;
+	gen->ismonoc=1;
+	gen->monoen=0.;
+	gen->nthreads=1;
+
+	/* Array containing pointers to the pixels actually simulated */
+	gen->simulated_pixels=getSimulatedPixelArray(det,activearray,Ndetpix,Nactive,status);
+	CHECK_STATUS_RET(*status,gen);
 
-   EvtNode *current=NULL, *end;
+	/* Initialize rng */
+	setNoiseGSLSeed(&(gen->rng), seed);
 
-   /* Allocate space for the new node */
-   current = (EvtNode*)malloc(sizeof(EvtNode));
-   if(current==NULL){
-      *status=EXIT_FAILURE;
-      SIXT_ERROR("memory allocation for current failed");
-      return(EXIT_FAILURE);
-   }
-   current->next=NULL;
+	/* Initialize Noise buffer */
+	gen->NBuffer=newNoiseBuffer(status, &(gen->Npix));
+	CHECK_STATUS_RET(*status,gen);
 
-   current->time=(double*)malloc(Pulses->profiles[versionID].Nt*sizeof(double));
-   if(current->time==NULL){
-      *status=EXIT_FAILURE;
-      SIXT_ERROR("memory allocation for current->time failed");
-      return(EXIT_FAILURE);
-   }
-   current->adcpulse=(double*)malloc(Pulses->profiles[versionID].Nt*sizeof(double));
-   if(current->adcpulse==NULL){
-      *status=EXIT_FAILURE;
-      SIXT_ERROR("memory allocation for current->adcpulse failed");
-      return(EXIT_FAILURE);
-   }
+	/* Initialize 1/F noise arrays */
+	if (det->oof_activated){
+		gen->OFNoise=(NoiseOoF**)calloc(Nactive,sizeof(*(gen->OFNoise)));
+		CHECK_NULL_RET(gen->OFNoise,*status,"Memory allocation for OFNoise failed",gen);
+		for(int i=0;i<Nactive;i++){
+			if(gen->simulated_pixels[i]->TESNoise->OoFRMS!=0.){
+				gen->OFNoise[i]=newNoiseOoF(status,&(gen->rng),gen->SampleFreq,gen->simulated_pixels[i]);
+				CHECK_STATUS_RET(*status,gen);
+			}
+		}
+	}
+
+	/* Initialize the (empty) buffers of active pulses */
+	gen->pulses=(TESPulseRing*)calloc(MAX(Nactive,1),sizeof(TESPulseRing));
+	CHECK_NULL_RET(gen->pulses,*status,"memory allocation for active pulses failed",gen);
 
-   for (i=0;i<Pulses->profiles[versionID].Nt;i++) {
-     current->time[i]=Pulses->profiles[versionID].time[i];
-     current->adcpulse[i]=impact->energy * Pulses->profiles[versionID].adc_value[EnID][i];
-   }
-   current->count=0.;
-   current->Nt=Pulses->profiles[versionID].Nt;
+	gen->time_block=(double*)malloc(TESSTREAMBLOCKSIZE*sizeof(double));
+	CHECK_NULL_RET(gen->time_block,*status,"memory allocation for time_block failed",gen);
+	gen->signal_block=(double*)malloc((size_t)MAX(Nactive,1)*TESSTREAMBLOCKSIZE*sizeof(double));
+	CHECK_NULL_RET(gen->signal_block,*status,"memory allocation for signal_block failed",gen);
+	gen->adc_block=(uint16_t*)malloc((size_t)MAX(Nactive,1)*TESSTREAMBLOCKSIZE*sizeof(uint16_t));
+	CHECK_NULL_RET(gen->adc_block,*status,"memory allocation for adc_block failed",gen);
 
-   if(ActPulses[pixno]==NULL){
-     ActPulses[pixno]=current;
-   }else{
-     end=ActPulses[pixno];    /* Set pointer to the head of the list */
-     while (end->next!=NULL) {  /* Go through the list to find the end */
-       end=end->next;
-     }
-     end->next=current;
-   }
+	printf("Simulate %ld time steps for %d pixels.\n", gen->Nt, gen->Npix);
 
-   return EXIT_SUCCESS;
+	return(gen);
+}
+
+void destroyTESStreamGenerator(TESStreamGenerator** gen)
+{
+	if (*gen==NULL) {
+		return;
+	}
+
+	stopTESStreamThreads(*gen);
+
+	int status=EXIT_SUCCESS;
+	int ipix;
+	if ((*gen)->pulses!=NULL) {
+		for (ipix=0;ipix<(*gen)->Npix;ipix++) {
+			free((*gen)->pulses[ipix].start);
+			free((*gen)->pulses[ipix].energy);
+			free((*gen)->pulses[ipix].adc);
+			free((*gen)->pulses[ipix].count);
+		}
+		free((*gen)->pulses);
+	}
+	if ((*gen)->OFNoise!=NULL) {
+		for (ipix=0;ipix<(*gen)->Npix;ipix++) {
+			destroyNoiseOoF((*gen)->OFNoise[ipix],&status);
+		}
+		free((*gen)->OFNoise);
+	}
+	destroyNoiseBuffer((*gen)->NBuffer,&status);
+	if ((*gen)->rng!=NULL) {
+		gsl_rng_free((*gen)->rng);
+	}
+	free((*gen)->simulated_pixels);
+	free((*gen)->impacts);
+	free((*gen)->time_block);
+	free((*gen)->signal_block);
+	free((*gen)->adc_block);
+	free(*gen);
+	*gen=NULL;
 }
 
+long getTESStreamChunk(TESStreamGenerator* gen,
+		       TESFitsStream** chunk,
+		       int Nstreams,
+		       long nmax,
+		       int* const status)
+{
+	long n=MAX(MIN(nmax,gen->Nt-gen->tstep),0);
+	int ii;
+
+	/* Read the impacts in advance if the FITS files are shared with */
+	/* another thread (the upper limit includes some margin for the */
+	/* rounding of the time steps) */
+	if ((gen->fitsmutex!=NULL)&&(n>0)) {
+		fillTESStreamImpactBuffer(gen,gen->tstart+(gen->tstep+n+1)/gen->SampleFreq,status);
+		CHECK_STATUS_RET(*status,0);
+	}
+
+	long tt;
+	for (tt=0; tt<n; tt+=TESSTREAMBLOCKSIZE) {
+		long nblock=MIN(n-tt,TESSTREAMBLOCKSIZE);
+		getTESStreamBlock(gen,nblock,status);
+		CHECK_STATUS_RET(*status,tt);
 
-void removeEventFromNode(EvtNode** ActPulses,
-			int* pixel)
+		/* Distribute the pixels to the FITS streams */
+		for (ii=0; ii<Nstreams; ii++) {
+			memcpy(&(chunk[ii]->time[tt]),gen->time_block,nblock*sizeof(double));
+		}
+		int ipix;
+		for (ipix=0; ipix<gen->Npix; ipix++) {
+			memcpy(&(chunk[ipix/TESFITSMAXPIX]->adc_value[ipix%TESFITSMAXPIX][tt]),
+			       &(gen->adc_block[ipix*TESSTREAMBLOCKSIZE]),nblock*sizeof(uint16_t));
+		}
+	}
+
+	for (ii=0; ii<Nstreams; ii++) {
+		chunk[ii]->Ntime=n;
+	}
+
+	return(n);
+}
+
+void getTESDataStream(TESDataStream* TESData,
+		PixImpFile* PixFile,
+		TESProfiles* TESProf,
+		AdvDet* det,
+		double tstart,
+		double tstop,
+		int Ndetpix,
+		int Nactive,
+		int* activearray,
+		long* Nevts,
+		int *ismonoc,
+		float *monoen,
+		unsigned long int seed,
+		int* const status)
 {
+	TESStreamGenerator* gen=newTESStreamGenerator(PixFile,TESProf,det,tstart,tstop,
+			Ndetpix,Nactive,activearray,Nevts,seed,status);
+
+	/* allocate output stream structure */
+	if (*status==EXIT_SUCCESS) {
+		allocateTESDataStream(TESData, gen->Nt, gen->Npix, status);
+	}
 
-   /* Set temporary pointers for pop-node and shift-node */
-   EvtNode *pop, *shift;
+	/* While loop over all blocks of time bins */
+	while ((*status==EXIT_SUCCESS) && (gen->tstep<gen->Nt)) {
+		long tstep0=gen->tstep;
+		long nblock=MIN(gen->Nt-tstep0,TESSTREAMBLOCKSIZE);
+		getTESStreamBlock(gen,nblock,status);
+		if (*status!=EXIT_SUCCESS) {
+			break;
+		}
+		long tt;
+		for (tt=0; tt<nblock; tt++) {
+			TESData->time[tstep0+tt]=gen->time_block[tt];
+			int ipix;
+			for (ipix=0; ipix<gen->Npix; ipix++) {
+				TESData->adc_value[tstep0+tt][ipix]=gen->adc_block[ipix*TESSTREAMBLOCKSIZE+tt];
+			}
+		}
+	}
 
-   /* Pointer to node that needs to go (pop) and it's replacement (shift) */
-   pop = ActPulses[*pixel];
-   shift = ActPulses[*pixel]->next;
-   ActPulses[*pixel] = shift;
+	if (*status==EXIT_SUCCESS) {
+		*ismonoc=gen->ismonoc;
+		if (gen->ntot>0) {
+			*monoen=gen->monoen;
+		}
+	}
 
-   /* Release memory of the node */
-   free(pop->time);
-   free(pop->adcpulse);
-   free(pop);
+	/* Clean dynamic memory */
+	destroyTESStreamGenerator(&gen);
 }
 
-void destroyEventNode(EvtNode* node) {
-  if (node!=NULL) {
-    destroyEventNode(node->next);
-    free(node->time);
-    free(node->adcpulse);
-    free(node);
+/** Writer for a data stream, which is generated in chunks. The chunks
+    are written by a separate thread. Two sets of buffers are used
+    alternately, such that the next chunk can be generated while the
+    previous one is written. */
+typedef struct{
+
+  /** Output file. */
+  fitsfile* fptr;
+
+  /** Number of FITS extensions. */
+  int Nstreams;
+
+  /** Buffers for the chunks and flags whether they contain data,
+      which have not been written yet. */
+  TESFitsStream** buffer[2];
+  int full[2];
+
+  /** HDU numbers of the FITS extensions. */
+  int* hdunum;
+
+  /** Number of rows written so far. */
+  long nrows;
+
+  double tstart, tstop, timeres;
+
+  /** Event numbers written to the header with the first chunk. The
+      final values are written at the end. */
+  long* Nevts0;
+
+  /** Flag whether the generation has been finished. */
+  int finished;
+
+  /** Error status of the writer thread. */
+  int status;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+
+  /** Mutex for the access to the FITS files. */
+  pthread_mutex_t fitsmutex;
+
+}TESStreamWriter;
+
+/** Write a chunk of the data stream. The first chunk creates the FITS
+    extensions, the following ones are appended. */
+static void writeTESStreamChunk(TESStreamWriter* writer,
+				TESFitsStream** chunk,
+				int* const status)
+{
+  int ii;
+  for(ii=0; ii<writer->Nstreams; ii++){
+    // The FITS file is only locked for a single extension, such that
+    // the generator is not blocked for too long.
+    pthread_mutex_lock(&(writer->fitsmutex));
+    if(writer->nrows==0){
+      writeTESFitsStream(writer->fptr, chunk[ii], writer->tstart,
+			 writer->tstop, writer->timeres, writer->Nevts0,
+			 0, 0., status);
+      fits_get_hdu_num(writer->fptr, &(writer->hdunum[ii]));
+    } else {
+      fits_movabs_hdu(writer->fptr, writer->hdunum[ii], NULL, status);
+      writeTESFitsStreamRows(writer->fptr, chunk[ii], writer->nrows+1, status);
+    }
+    pthread_mutex_unlock(&(writer->fitsmutex));
+    CHECK_STATUS_VOID(*status);
+  }
+  if(writer->Nstreams>0){
+    writer->nrows+=chunk[0]->Ntime;
   }
 }
 
+/** Thread function writing the chunks in the order of the buffers. */
+static void* tesStreamWriterThread(void* arg)
+{
+  TESStreamWriter* writer=(TESStreamWriter*)arg;
+  int status=EXIT_SUCCESS;
+  int ib=0;
+
+  while(1){
+    pthread_mutex_lock(&(writer->mutex));
+    while((0==writer->full[ib])&&(0==writer->finished)){
+      pthread_cond_wait(&(writer->cond), &(writer->mutex));
+    }
+    int full=writer->full[ib];
+    pthread_mutex_unlock(&(writer->mutex));
+    if(0==full){
+      break;
+    }
+
+    writeTESStreamChunk(writer, writer->buffer[ib], &status);
+
+    // Release the buffer.
+    pthread_mutex_lock(&(writer->mutex));
+    writer->full[ib]=0;
+    writer->status=status;
+    pthread_cond_broadcast(&(writer->cond));
+    pthread_mutex_unlock(&(writer->mutex));
+    if(EXIT_SUCCESS!=status){
+      break;
+    }
+    ib=1-ib;
+  }
+
+  return(NULL);
+}
+
+/** Write the final values of the header keywords, which are only
+    known after the generation of the whole data stream. */
+static void finishTESStreamWriter(TESStreamWriter* writer,
+				  long* Nevts,
+				  int ismonoc,
+				  float monoen,
+				  int* const status)
+{
+  int ii, pp;
+  for(ii=0; ii<writer->Nstreams; ii++){
+    TESFitsStream* stream=writer->buffer[0][ii];
+
+    // If no time steps have been simulated, the empty tables have
+    // not been created yet.
+    if(writer->nrows==0){
+      stream->Ntime=0;
+      writeTESFitsStream(writer->fptr, stream, writer->tstart,
+			 writer->tstop, writer->timeres, Nevts,
+			 ismonoc, monoen, status);
+      CHECK_STATUS_VOID(*status);
+      continue;
+    }
+
+    fits_movabs_hdu(writer->fptr, writer->hdunum[ii], NULL, status);
+    CHECK_STATUS_VOID(*status);
+    for(pp=0; pp<stream->Npix; pp++){
+      char nev[9];
+      sprintf(nev, "NES%05d", stream->pixID[pp]+1);
+      fits_update_key(writer->fptr, TLONG, nev, &Nevts[stream->pixID[pp]],
+		      "Number of simulated events in pixel stream", status);
+      CHECK_STATUS_VOID(*status);
+    }
+    if(ismonoc==1){
+      fits_update_key(writer->fptr, TFLOAT, "MONOEN",
+		      &monoen, "Monochromatic energy of photons [keV]", status);
+      CHECK_STATUS_VOID(*status);
+    }
+  }
+}
+
+void streamTESDataStream(fitsfile* fptr,
+			 PixImpFile* PixFile,
+			 TESProfiles* TESProf,
+			 AdvDet* det,
+			 double tstart,
+			 double tstop,
+			 int Ndetpix,
+			 int Nactive,
+			 int* activearray,
+			 long* Nevts,
+			 int *ismonoc,
+			 float *monoen,
+			 unsigned long int seed,
+			 int nthreads,
+			 int* const status)
+{
+  TESStreamGenerator* gen=NULL;
+  int* pixID=NULL;
+  pthread_t thread;
+  int thread_started=0;
+  int ii, ib;
+
+  TESStreamWriter writer;
+  writer.fptr=fptr;
+  writer.Nstreams=(Nactive+TESFITSMAXPIX-1)/TESFITSMAXPIX;
+  writer.buffer[0]=NULL;
+  writer.buffer[1]=NULL;
+  writer.full[0]=0;
+  writer.full[1]=0;
+  writer.hdunum=NULL;
+  writer.nrows=0;
+  writer.tstart=tstart;
+  writer.tstop=tstop;
+  writer.timeres=1./det->SampleFreq;
+  writer.Nevts0=NULL;
+  writer.finished=0;
+  writer.status=EXIT_SUCCESS;
+  pthread_mutex_init(&(writer.mutex), NULL);
+  pthread_cond_init(&(writer.cond), NULL);
+  pthread_mutex_init(&(writer.fitsmutex), NULL);
+
+  do { // Beginning of ERROR handling loop.
+
+    gen=newTESStreamGenerator(PixFile, TESProf, det, tstart, tstop,
+			      Ndetpix, Nactive, activearray, Nevts,
+			      seed, status);
+    CHECK_STATUS_BREAK(*status);
+    gen->fitsmutex=&(writer.fitsmutex);
+    if(nthreads<=0){
+      nthreads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    gen->nthreads=MAX(nthreads, 1);
+
+    // Number of time steps per chunk.
+    long chunksize=TESSTREAMCHUNKSAMPLES/MAX(Nactive, 1);
+    chunksize=MAX(chunksize, TESSTREAMMINCHUNKSIZE);
+    chunksize=MIN(chunksize, MAX(gen->Nt, 1));
+
+    // Find the original pixel IDs (reverse of the activearray).
+    pixID=(int*)malloc(MAX(Nactive, 1)*sizeof(int));
+    CHECK_NULL_BREAK(pixID, *status, "memory allocation for pixel IDs failed");
+    for(ii=0; ii<Nactive; ii++){
+      pixID[ii]=-1;
+    }
+    for(ii=0; ii<Ndetpix; ii++){
+      if((activearray[ii]>-1)&&(activearray[ii]<Nactive)){
+	pixID[activearray[ii]]=ii;
+      }
+    }
+    for(ii=0; ii<Nactive; ii++){
+      if(pixID[ii]==-1){
+	*status=EXIT_FAILURE;
+	SIXT_ERROR("Pixel ID not found.");
+	break;
+      }
+    }
+    CHECK_STATUS_BREAK(*status);
+
+    // Allocate the buffers.
+    for(ib=0; ib<2; ib++){
+      writer.buffer[ib]=(TESFitsStream**)calloc(writer.Nstreams, sizeof(TESFitsStream*));
+      CHECK_NULL_BREAK(writer.buffer[ib], *status,
+		       "memory allocation for FITS streams failed");
+      for(ii=0; ii<writer.Nstreams; ii++){
+	writer.buffer[ib][ii]=newTESFitsStream(status);
+	CHECK_STATUS_BREAK(*status);
+	sprintf(writer.buffer[ib][ii]->name, "ADC%03d", ii+1);
+
+	int extpix=MIN(TESFITSMAXPIX, Nactive-ii*TESFITSMAXPIX);
+	allocateTESFitsStream(writer.buffer[ib][ii], chunksize, extpix, status);
+	CHECK_STATUS_BREAK(*status);
+	int pp;
+	for(pp=0; pp<extpix; pp++){
+	  writer.buffer[ib][ii]->pixID[pp]=pixID[ii*TESFITSMAXPIX+pp];
+	}
+      }
+      CHECK_STATUS_BREAK(*status);
+    }
+    CHECK_STATUS_BREAK(*status);
+
+    writer.hdunum=(int*)malloc(MAX(writer.Nstreams, 1)*sizeof(int));
+    CHECK_NULL_BREAK(writer.hdunum, *status, "memory allocation for HDU numbers failed");
+    writer.Nevts0=(long*)calloc(MAX(Ndetpix, 1), sizeof(long));
+    CHECK_NULL_BREAK(writer.Nevts0, *status, "memory allocation for event numbers failed");
+
+    // Start the writer thread.
+    if(0!=pthread_create(&thread, NULL, tesStreamWriterThread, &writer)){
+      *status=EXIT_FAILURE;
+      SIXT_ERROR("failed to start the writer thread");
+      break;
+    }
+    thread_started=1;
+
+    // Generate the chunks.
+    ib=0;
+    while(gen->tstep<gen->Nt){
+      // Wait until the buffer has been written.
+      pthread_mutex_lock(&(writer.mutex));
+      while((0!=writer.full[ib])&&(EXIT_SUCCESS==writer.status)){
+	pthread_cond_wait(&(writer.cond), &(writer.mutex));
+      }
+      int wstatus=writer.status;
+      pthread_mutex_unlock(&(writer.mutex));
+      if(EXIT_SUCCESS!=wstatus){
+	break;
+      }
+
+      getTESStreamChunk(gen, writer.buffer[ib], writer.Nstreams, chunksize, status);
+      CHECK_STATUS_BREAK(*status);
+
+      // Pass the buffer to the writer thread.
+      pthread_mutex_lock(&(writer.mutex));
+      writer.full[ib]=1;
+      pthread_cond_broadcast(&(writer.cond));
+      pthread_mutex_unlock(&(writer.mutex));
+      ib=1-ib;
+    }
+
+  } while(0); // END of ERROR handling loop.
+
+  // Wait until all chunks have been written.
+  if(thread_started){
+    pthread_mutex_lock(&(writer.mutex));
+    writer.finished=1;
+    pthread_cond_broadcast(&(writer.cond));
+    pthread_mutex_unlock(&(writer.mutex));
+    pthread_join(thread, NULL);
+    if(EXIT_SUCCESS==*status){
+      *status=writer.status;
+    }
+  }
+
+  if(EXIT_SUCCESS==*status){
+    *ismonoc=gen->ismonoc;
+    if(gen->ntot>0){
+      *monoen=gen->monoen;
+    }
+    finishTESStreamWriter(&writer, Nevts, *ismonoc, *monoen, status);
+  }
+
+  // Release memory.
+  for(ib=0; ib<2; ib++){
+    if(writer.buffer[ib]!=NULL){
+      for(ii=0; ii<writer.Nstreams; ii++){
+	if(writer.buffer[ib][ii]!=NULL){
+	  destroyTESFitsStream(writer.buffer[ib][ii]);
+	  free(writer.buffer[ib][ii]);
+	}
+      }
+      free(writer.buffer[ib]);
+    }
+  }
+  free(writer.hdunum);
+  free(writer.Nevts0);
+  free(pixID);
+  destroyTESStreamGenerator(&gen);
+  pthread_cond_destroy(&(writer.cond));
+  pthread_mutex_destroy(&(writer.mutex));
+  pthread_mutex_destroy(&(writer.fitsmutex));
+}
+
+
 int checkPixIfActive(int pixID, int Npix, int* activearray){
   if(pixID<Npix && activearray[pixID]>-1){
     return activearray[pixID];
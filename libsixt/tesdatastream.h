@@ -29,9 +29,23 @@
 #include "pixelimpactfile.h"
 #include "tesnoisespectrum.h"
 #include <stdint.h>
+#include <pthread.h>
 
 #define TESFITSMAXPIX 40
 
+/** Number of ADC samples (time steps times pixels) in one chunk of a
+    streamed data stream. Determines the memory required by
+    streamTESDataStream(), independent of the exposure time. */
+#define TESSTREAMCHUNKSAMPLES (16777216)
+
+/** Minimum number of time steps in one chunk of a streamed data
+    stream. */
+#define TESSTREAMMINCHUNKSIZE (1024)
+
+/** Number of time steps, which are generated at once for all pixels
+    of the data stream. */
+#define TESSTREAMBLOCKSIZE (1024)
+
 /////////////////////////////////////////////////////////////////
 // Type Declarations.
 /////////////////////////////////////////////////////////////////
@@ -95,27 +109,133 @@ typedef struct{
 
 }TESFitsStream;
 
-/** Linked list containing active pulses */
-typedef struct node{
+/** Active pulses of a pixel in the order of their arrival. The pulses
+    are stored in a ring buffer with one array per property, such that
+    the templates can be added to the signal of a whole block of time
+    steps at once. */
+typedef struct{
 
-  /** Time array */
-  double *time;
+  /** Capacity of the ring buffer, index of the oldest pulse, and
+      number of active pulses. */
+  int size;
+  int first;
+  int n;
+
+  /** Time step of the data stream at which the pulse starts. */
+  long* start;
+
+  /** Photon energy [keV] the template is scaled with. */
+  double* energy;
+
+  /** Pulse template (not scaled). */
+  const double** adc;
+
+  /** Current position (index) in the pulse template. Saved as double
+      to account for different sampling for pulses and data stream. */
+  double* count;
+
+}TESPulseRing;
 
-  /** Pulse array containing scaled pulse */
-  double *adcpulse;
+/** State of the generation of a TES data stream. The data stream is
+    generated in consecutive chunks of time steps, such that it is not
+    required to keep the whole data stream in memory. */
+typedef struct{
+
+  /** Pixel impact file the events are read from. */
+  PixImpFile* PixFile;
+
+  /** Pulse templates. */
+  TESProfiles* TESProf;
+
+  /** Detector. */
+  AdvDet* det;
+
+  /** Start time of the data stream. */
+  double tstart;
+
+  /** Sample frequency [Hz]. */
+  double SampleFreq;
+
+  /** Number of pixels of the detector. */
+  int Ndetpix;
+
+  /** Number of active pixels. */
+  int Npix;
 
-  /** Number of time steps */
+  /** Index of each detector pixel in the data stream (-1 if the pixel
+      is not simulated). */
+  int* activearray;
+
+  /** Number of simulated events for each detector pixel. */
+  long* Nevts;
+
+  /** Total number of time steps. */
   long Nt;
 
-  /** Current position (index) in the pulse */
-  /** saved as double to account for different */
-  /** sampling for pulses and data stream */
-  double count;
+  /** Next time step to be generated. */
+  long tstep;
+
+  /** Pointers to the simulated pixels. */
+  AdvPix** simulated_pixels;
+
+  /** Random number generator for the noise. */
+  gsl_rng* rng;
+
+  /** Noise buffer and position of the next entry in the buffer. */
+  NoiseBuffer* NBuffer;
+  int inoise;
+
+  /** 1/f noise for each simulated pixel. */
+  NoiseOoF** OFNoise;
+
+  /** Active pulses of each pixel. */
+  TESPulseRing* pulses;
+
+  /** Next impact from the pixel impact file and the return value of
+      the corresponding call of getNextImpactFromPixImpFile(). */
+  PixImpact impact;
+  int piximpstatus;
+
+  /** Impacts which have already been read from the impact file, but
+      have not been processed yet. */
+  PixImpact* impacts;
+  long nimpacts;
+  long maximpacts;
+  long iimpact;
 
-  /** Next node */
-  struct node * next;
+  /** Flag whether the end of the impact file has been reached while
+      filling the impact buffer. */
+  int impfile_eof;
 
-}EvtNode;
+  /** Total number of simulated events. */
+  long ntot;
+
+  /** Flag whether all events have the same energy and value of this
+      energy [keV]. */
+  int ismonoc;
+  float monoen;
+
+  /** Mutex protecting the access to the FITS files, if the data
+      stream is written by another thread. NULL otherwise. */
+  pthread_mutex_t* fitsmutex;
+
+  /** Time stamps and signal values of the current block of time
+      steps. The values of each pixel are stored consecutively, i.e.,
+      the signal of pixel ipix at step tt is stored at
+      [ipix*TESSTREAMBLOCKSIZE+tt]. */
+  double* time_block;
+  double* signal_block;
+  uint16_t* adc_block;
+
+  /** Number of threads the pixels are distributed to. */
+  int nthreads;
+
+  /** Persistent threads adding the pulses to the pixels. They are
+      started with the first block and synchronized for each block.
+      NULL as long as no threads have been started. */
+  struct TESStreamThreads* threads;
+
+}TESStreamGenerator;
 
 /////////////////////////////////////////////////////////////////
 // Function Declarations.
@@ -203,24 +323,59 @@ void getTESDataStream(TESDataStream* TESData,
 		      unsigned long int seed,
 		      int* const status);
 
-/** Add an event to the node list */
-int addEventToNode(EvtNode** ActPulses,
-		   TESProfiles* Pulses,
-                   PixImpact* impact,
-		   int pixno,
-		   int versionID,
-		   int EnID,
-		   int* const status);
-
-/** Remove an event from the node list */
-void removeEventFromNode(EvtNode** ActPulses,
-			int* pixel);
-
-/** Destroy array of linked lists */
-void destroyEventNode(EvtNode* node);
-
-/** Initialize array of linked lists */
-EvtNode** newEventNodes(int *NPixel, int* const status);
+/** Generate the TES data stream and write it to a FITS file, which
+    has been created with createTESFitsStreamFile(). The data stream is
+    generated in chunks of time steps and written by a separate
+    thread, such that the required memory does not depend on the
+    exposure time and the generation and the output of the data run
+    in parallel. The output is the same as for getTESDataStream() with
+    a subsequent call of writeTESFitsStream() for each set of
+    TESFITSMAXPIX pixels. The pulses and the digitization of the
+    pixels are computed in nthreads threads (0: number of
+    processors). */
+void streamTESDataStream(fitsfile* fptr,
+			 PixImpFile* PixFile,
+			 TESProfiles* TESProf,
+			 AdvDet* det,
+			 double tstart,
+			 double tstop,
+			 int Ndetpix,
+			 int Nactive,
+			 int* activearray,
+			 long* Nevts,
+			 int *ismonoc,
+			 float *monoen,
+			 unsigned long int seed,
+			 int nthreads,
+			 int* const status);
+
+/** Constructor of the TES data stream generator. */
+TESStreamGenerator* newTESStreamGenerator(PixImpFile* PixFile,
+					  TESProfiles* TESProf,
+					  AdvDet* det,
+					  double tstart,
+					  double tstop,
+					  int Ndetpix,
+					  int Nactive,
+					  int* activearray,
+					  long* Nevts,
+					  unsigned long int seed,
+					  int* const status);
+
+/** Destructor of the TES data stream generator. */
+void destroyTESStreamGenerator(TESStreamGenerator** gen);
+
+/** Generate the next (at most nmax) time steps of the data
+    stream. The data are stored in the Nstreams TESFitsStream
+    structures, each of which contains (at most) TESFITSMAXPIX
+    subsequent pixels and must be allocated for at least nmax time
+    steps. The number of generated time steps is returned and stored
+    in the Ntime field of the TESFitsStream structures. */
+long getTESStreamChunk(TESStreamGenerator* gen,
+		       TESFitsStream** chunk,
+		       int Nstreams,
+		       long nmax,
+		       int* const status);
 
 /** Checks if the pixID is in the list of active pixels */
 int checkPixIfActive(int pixID, int Npix, int* activearray);
@@ -188,6 +188,7 @@ struct tesparams {
   double bias;   // bias percentage (%)
 
   unsigned long seed; // rng seed at start of simulation
+  gsl_rng *rng;        // random number generator used for the noise of this pixel
 
   int simnoise;  // simulate noise?
   int stochastic_integrator; //use stochastic integrator?
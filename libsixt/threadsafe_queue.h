@@ -15,11 +15,12 @@ template<typename T>
 class threadsafe_queue
 {
  public:
-  threadsafe_queue(){}
+  threadsafe_queue():closed(false){}
   threadsafe_queue(threadsafe_queue const& other)
     {
       std::lock_guard<std::mutex> lk(other.mut);
       data_queue = other.data_queue;
+      closed = other.closed;
     }
   void push(T value)
   {
@@ -46,12 +47,16 @@ class threadsafe_queue
       }
       return 0;
     }
-  void blck_wait_and_pop(T& value)
+  // Blocks until an element is available or the queue is closed.
+  // Returns false if the queue has been closed and is empty.
+  bool blck_wait_and_pop(T& value)
   {
     std::unique_lock<std::mutex> lk(mut);
-    data_cond.wait(lk,[this]{return !data_queue.empty();});
+    data_cond.wait(lk,[this]{return closed || !data_queue.empty();});
+    if(data_queue.empty()) return false;
     value = data_queue.front();
     data_queue.pop();
+    return true;
   }
   std::shared_ptr<T> blck_wait_and_pop()
     {
@@ -88,10 +93,27 @@ class threadsafe_queue
     return data_queue.size();
   }
 
+  // Wakes up all the threads waiting in blck_wait_and_pop, they
+  // return false as soon as the queue is empty
+  void close()
+  {
+    std::lock_guard<std::mutex> lk(mut);
+    closed = true;
+    data_cond.notify_all();
+  }
+
+  // Allows to use the queue again after close
+  void reopen()
+  {
+    std::lock_guard<std::mutex> lk(mut);
+    closed = false;
+  }
+
  private:
   mutable std::mutex mut;
   std::queue<T> data_queue;
   std::condition_variable data_cond;
+  bool closed;
 };
 
 #endif
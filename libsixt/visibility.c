@@ -0,0 +1,724 @@
+/*
+   This file is part of SIXTE.
+
+   SIXTE is free software: you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   any later version.
+
+   SIXTE is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   For a copy of the GNU General Public License see
+   <http://www.gnu.org/licenses/>.
+
+
+   Copyright 2019 Remeis-Sternwarte, Friedrich-Alexander-Universitaet
+                  Erlangen-Nuernberg
+*/
+
+#include "visibility.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+
+/////////////////////////////////////////////////////////////////
+// Type Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Source in the spatial index. */
+typedef struct {
+  double ra;
+  long src;
+} VisIndexEntry;
+
+
+/** Time interval during which a particular source is visible. */
+typedef struct {
+  long src;
+  double start, stop;
+} VisInterval;
+
+
+/** Spatial index of the source positions. The sources are sorted
+    into bands of equal declination width and within each band
+    according to their right ascension. */
+typedef struct {
+  /** Index of the first source of each band in the sorted arrays.
+      The array contains VISIBILITY_NBANDS+1 entries. */
+  long first[VISIBILITY_NBANDS+1];
+
+  /** Source indices and right ascensions [rad] in the range
+      [0,2pi) sorted by band and right ascension. */
+  VisIndexEntry* entries;
+
+  /** Maximum radius of the sources in the bands [rad]. */
+  double maxradius;
+
+  /** Sources that are not included in the bands due to their large
+      radius. */
+  long* wide;
+  long nwide;
+
+} VisIndex;
+
+
+/** Attitude segment between two subsequent attitude entries. The
+    pointing direction at the angle theta in [0,phi] along the
+    segment is cos(theta)*e1+sin(theta)*e2. */
+typedef struct {
+  Vector e1, e2;
+  double phi;
+
+  /** Times of the two attitude entries. */
+  double t0, t1;
+
+  /** Part of the segment within the regarded time interval. */
+  double tlo, thi;
+  double thetalo, thetahi;
+
+} VisSegment;
+
+
+/** Data of a thread processing a range of attitude segments. */
+typedef struct {
+  const Attitude* ac;
+  const Vector* srcpos;
+  const double* cosradius;
+  const double* radius;
+  const VisIndex* index;
+  double tstart, tstop;
+
+  /** Range of attitude segments [first,last). For a pointing
+      attitude there is a single segment with the index 0. */
+  long first, last;
+
+  /** Visibility intervals in time order for each source. */
+  VisInterval* intervals;
+  long nintervals;
+  long maxintervals;
+
+  int status;
+} VisThread;
+
+
+/////////////////////////////////////////////////////////////////
+// Static Functions.
+/////////////////////////////////////////////////////////////////
+
+
+/** Return the right ascension of the unit vector in the range
+    [0,2pi) and its declination [rad]. */
+static inline void getVisRaDec(const Vector* const v,
+			       double* const ra,
+			       double* const dec)
+{
+  calculate_ra_dec(*v, ra, dec);
+  if (*ra<0.) {
+    *ra+=2.*M_PI;
+  }
+  if (*ra>=2.*M_PI) {
+    *ra-=2.*M_PI;
+  }
+}
+
+
+/** Return the declination band of the specified declination [rad]. */
+static inline long getVisBand(const double dec)
+{
+  long band=(long)((dec+0.5*M_PI)/M_PI*VISIBILITY_NBANDS);
+  return(MIN(MAX(band, 0), VISIBILITY_NBANDS-1));
+}
+
+
+/** Order of the entries of the spatial index within a band. */
+static int compareVisIndexEntries(const void* a, const void* b)
+{
+  const VisIndexEntry* ea=(const VisIndexEntry*)a;
+  const VisIndexEntry* eb=(const VisIndexEntry*)b;
+  if (ea->ra<eb->ra) return(-1);
+  if (ea->ra>eb->ra) return(1);
+  return((ea->src>eb->src)-(ea->src<eb->src));
+}
+
+
+/** Build the spatial index of the sources. */
+static void buildVisIndex(VisIndex* const index,
+			  const Vector* const srcpos,
+			  const double* const radius,
+			  const long nsources,
+			  int* const status)
+{
+  index->entries=NULL;
+  index->wide=NULL;
+  index->nwide=0;
+  index->maxradius=0.;
+
+  index->entries=(VisIndexEntry*)malloc(MAX(nsources, 1)*sizeof(VisIndexEntry));
+  CHECK_NULL_VOID(index->entries, *status,
+		  "memory allocation for visibility index failed");
+  index->wide=(long*)malloc(MAX(nsources, 1)*sizeof(long));
+  CHECK_NULL_VOID(index->wide, *status,
+		  "memory allocation for visibility index failed");
+  long* band=(long*)malloc(MAX(nsources, 1)*sizeof(long));
+  CHECK_NULL_VOID(band, *status,
+		  "memory allocation for visibility index failed");
+  double* ra=(double*)malloc(MAX(nsources, 1)*sizeof(double));
+  if (NULL==ra) {
+    free(band);
+  }
+  CHECK_NULL_VOID(ra, *status,
+		  "memory allocation for visibility index failed");
+
+  // Sort the sources into the declination bands.
+  long ii;
+  for (ii=0; ii<=VISIBILITY_NBANDS; ii++) {
+    index->first[ii]=0;
+  }
+  for (ii=0; ii<nsources; ii++) {
+    if (radius[ii]>VISIBILITY_MAXINDEXRADIUS) {
+      index->wide[index->nwide++]=ii;
+      band[ii]=-1;
+      continue;
+    }
+    double dec;
+    getVisRaDec(&(srcpos[ii]), &(ra[ii]), &dec);
+    band[ii]=getVisBand(dec);
+    index->first[band[ii]+1]++;
+    index->maxradius=MAX(index->maxradius, radius[ii]);
+  }
+  for (ii=0; ii<VISIBILITY_NBANDS; ii++) {
+    index->first[ii+1]+=index->first[ii];
+  }
+  long next[VISIBILITY_NBANDS];
+  for (ii=0; ii<VISIBILITY_NBANDS; ii++) {
+    next[ii]=index->first[ii];
+  }
+  for (ii=0; ii<nsources; ii++) {
+    if (band[ii]<0) continue;
+    long jj=next[band[ii]]++;
+    index->entries[jj].ra =ra[ii];
+    index->entries[jj].src=ii;
+  }
+  free(band);
+  free(ra);
+
+  // Sort each band according to the right ascension.
+  long bb;
+  for (bb=0; bb<VISIBILITY_NBANDS; bb++) {
+    qsort(&(index->entries[index->first[bb]]),
+	  index->first[bb+1]-index->first[bb],
+	  sizeof(VisIndexEntry), compareVisIndexEntries);
+  }
+}
+
+
+static void freeVisIndex(VisIndex* const index)
+{
+  if (NULL!=index->entries) {
+    free(index->entries);
+    index->entries=NULL;
+  }
+  if (NULL!=index->wide) {
+    free(index->wide);
+    index->wide=NULL;
+  }
+}
+
+
+/** Return the position of the first source in the band with a right
+    ascension not below the specified value. */
+static inline long findVisIndexRa(const VisIndex* const index,
+				  const long band,
+				  const double ra)
+{
+  long lower=index->first[band], upper=index->first[band+1];
+  while (upper>lower) {
+    long mid=(lower+upper)/2;
+    if (index->entries[mid].ra<ra) {
+      lower=mid+1;
+    } else {
+      upper=mid;
+    }
+  }
+  return(lower);
+}
+
+
+/** Append the candidate source to the list, if it is within the
+    angle capradius from the center of the cap plus its own radius. */
+static inline void addVisCandidate(const VisThread* const vt,
+				   const Vector* const center,
+				   const double capradius,
+				   const long src,
+				   long** const cand,
+				   long* const ncand,
+				   long* const maxcand,
+				   int* const status)
+{
+  double angle=capradius+vt->radius[src];
+  if ((angle<M_PI)&&
+      (scalar_product(center, &(vt->srcpos[src]))<cos(angle))) {
+    return;
+  }
+
+  if (*ncand>=*maxcand) {
+    long newsize=MAX(2*(*maxcand), 256);
+    long* buffer=(long*)realloc(*cand, newsize*sizeof(long));
+    CHECK_NULL_VOID(buffer, *status,
+		    "memory allocation for visibility candidates failed");
+    *cand=buffer;
+    *maxcand=newsize;
+  }
+  (*cand)[(*ncand)++]=src;
+}
+
+
+/** Determine the sources that might be visible while the pointing
+    direction is within the cap of the specified angular radius [rad]
+    around the center. */
+static long getVisCandidates(const VisThread* const vt,
+			     const Vector* const center,
+			     const double capradius,
+			     long** const cand,
+			     long* const maxcand,
+			     int* const status)
+{
+  const VisIndex* index=vt->index;
+  long ncand=0;
+
+  double ra, dec;
+  getVisRaDec(center, &ra, &dec);
+  double search=capradius+index->maxradius;
+
+  // Range of declination bands and right ascensions.
+  long band0=getVisBand(dec-search);
+  long band1=getVisBand(dec+search);
+  int allra=1;
+  double dra=M_PI;
+  if ((search<0.5*M_PI)&&(fabs(dec)+search<0.5*M_PI-1.e-6)) {
+    dra=asin(sin(search)/cos(dec))+1.e-9;
+    allra=(dra>=M_PI);
+  }
+
+  long bb;
+  for (bb=0; bb<index->nwide; bb++) {
+    addVisCandidate(vt, center, capradius, index->wide[bb],
+		    cand, &ncand, maxcand, status);
+    CHECK_STATUS_RET(*status, ncand);
+  }
+  for (bb=band0; bb<=band1; bb++) {
+    if (0!=allra) {
+      long ii;
+      for (ii=index->first[bb]; ii<index->first[bb+1]; ii++) {
+	addVisCandidate(vt, center, capradius, index->entries[ii].src,
+			cand, &ncand, maxcand, status);
+	CHECK_STATUS_RET(*status, ncand);
+      }
+    } else {
+      // The right ascension range might wrap around 0.
+      double ralo=ra-dra, rahi=ra+dra;
+      double range[2][2]={{ralo, rahi}, {1., 0.}};
+      if (ralo<0.) {
+	range[0][0]=0.;
+	range[1][0]=ralo+2.*M_PI;
+	range[1][1]=2.*M_PI;
+      } else if (rahi>=2.*M_PI) {
+	range[0][1]=2.*M_PI;
+	range[1][0]=0.;
+	range[1][1]=rahi-2.*M_PI;
+      }
+      int rr;
+      for (rr=0; rr<2; rr++) {
+	if (range[rr][0]>range[rr][1]) continue;
+	long ii;
+	for (ii=findVisIndexRa(index, bb, range[rr][0]);
+	     (ii<index->first[bb+1])&&(index->entries[ii].ra<=range[rr][1]);
+	     ii++) {
+	  addVisCandidate(vt, center, capradius, index->entries[ii].src,
+			  cand, &ncand, maxcand, status);
+	  CHECK_STATUS_RET(*status, ncand);
+	}
+      }
+    }
+  }
+
+  return(ncand);
+}
+
+
+/** Set up the segment between the attitude entries kk and kk+1
+    (or the constant pointing direction of a pointing attitude). */
+static void setVisSegment(VisSegment* const seg,
+			  const Attitude* const ac,
+			  const long kk,
+			  const double tstart,
+			  const double tstop)
+{
+  if (1==ac->nentries) {
+    seg->e1=ac->entry[0].nz;
+    seg->phi=0.;
+    seg->t0=tstart;
+    seg->t1=tstop;
+  } else {
+    seg->e1=ac->entry[kk].nz;
+    seg->t0=ac->entry[kk].time;
+    seg->t1=ac->entry[kk+1].time;
+    Vector v2=ac->entry[kk+1].nz;
+    double cosphi=scalar_product(&(seg->e1), &v2);
+    seg->phi=0.;
+    if (cosphi<1.-1.e-15) {
+      seg->phi=acos(MAX(cosphi, -1.));
+      seg->e2.x=v2.x-cosphi*seg->e1.x;
+      seg->e2.y=v2.y-cosphi*seg->e1.y;
+      seg->e2.z=v2.z-cosphi*seg->e1.z;
+      seg->e2=normalize_vector(seg->e2);
+    }
+  }
+
+  seg->tlo=MAX(seg->t0, tstart);
+  seg->thi=MIN(seg->t1, tstop);
+  seg->thetalo=0.;
+  seg->thetahi=0.;
+  if ((seg->phi>0.)&&(seg->t1>seg->t0)) {
+    seg->thetalo=(seg->tlo-seg->t0)/(seg->t1-seg->t0)*seg->phi;
+    seg->thetahi=(seg->thi-seg->t0)/(seg->t1-seg->t0)*seg->phi;
+  }
+}
+
+
+/** Convert the angle along the segment to the corresponding time. The
+    boundaries of the regarded part of the segment are returned
+    exactly, such that intervals of subsequent segments can be
+    joined. */
+static inline double getVisSegmentTime(const VisSegment* const seg,
+				       const double theta)
+{
+  if (theta<=seg->thetalo) return(seg->tlo);
+  if (theta>=seg->thetahi) return(seg->thi);
+  return(seg->t0+theta/seg->phi*(seg->t1-seg->t0));
+}
+
+
+/** Append a visibility interval of the source. If it directly
+    continues the last interval of the same source, the two intervals
+    are joined. */
+static void addVisInterval(VisThread* const vt,
+			   const long src,
+			   const double start,
+			   const double stop,
+			   int* const status)
+{
+  if (stop<=start) return;
+
+  if ((vt->nintervals>0)&&(vt->intervals[vt->nintervals-1].src==src)&&
+      (vt->intervals[vt->nintervals-1].stop>=start)) {
+    vt->intervals[vt->nintervals-1].stop=
+      MAX(vt->intervals[vt->nintervals-1].stop, stop);
+    return;
+  }
+
+  if (vt->nintervals>=vt->maxintervals) {
+    long newsize=MAX(2*vt->maxintervals, 1024);
+    VisInterval* buffer=
+      (VisInterval*)realloc(vt->intervals, newsize*sizeof(VisInterval));
+    CHECK_NULL_VOID(buffer, *status,
+		    "memory allocation for visibility intervals failed");
+    vt->intervals=buffer;
+    vt->maxintervals=newsize;
+  }
+  vt->intervals[vt->nintervals].src  =src;
+  vt->intervals[vt->nintervals].start=start;
+  vt->intervals[vt->nintervals].stop =stop;
+  vt->nintervals++;
+}
+
+
+/** Determine the visibility intervals of the source during the
+    segment. */
+static void getVisSegmentIntervals(VisThread* const vt,
+				   const VisSegment* const seg,
+				   const long src,
+				   int* const status)
+{
+  if (seg->thi<=seg->tlo) return;
+
+  const Vector* s=&(vt->srcpos[src]);
+  double c=vt->cosradius[src];
+  double a=scalar_product(&(seg->e1), s);
+
+  // Constant pointing direction.
+  if (0.==seg->phi) {
+    if (a>=c) {
+      addVisInterval(vt, src, seg->tlo, seg->thi, status);
+    }
+    return;
+  }
+
+  // The scalar product of the pointing direction and the source
+  // position along the segment is a*cos(theta)+b*sin(theta)
+  // = r*cos(theta-delta).
+  double b=scalar_product(&(seg->e2), s);
+  double r=sqrt(a*a+b*b);
+  if (c>r) return;
+  if (c<=-r) {
+    addVisInterval(vt, src, seg->tlo, seg->thi, status);
+    return;
+  }
+  double delta=atan2(b, a);
+  double w=acos(c/r);
+
+  // The source is visible for theta in [delta-w,delta+w] modulo 2pi.
+  int kk;
+  for (kk=-1; kk<=1; kk++) {
+    double lo=MAX(delta-w+kk*2.*M_PI, seg->thetalo);
+    double hi=MIN(delta+w+kk*2.*M_PI, seg->thetahi);
+    if (hi<=lo) continue;
+    addVisInterval(vt, src, getVisSegmentTime(seg, lo),
+		   getVisSegmentTime(seg, hi), status);
+    CHECK_STATUS_VOID(*status);
+  }
+}
+
+
+/** Process the range of attitude segments assigned to the thread. */
+static void* visibilityThread(void* arg)
+{
+  VisThread* vt=(VisThread*)arg;
+  const Attitude* ac=vt->ac;
+  int* status=&(vt->status);
+
+  VisSegment seg[VISIBILITY_CHUNKSEGMENTS];
+  long* cand=NULL;
+  long maxcand=0;
+
+  long kk=vt->first;
+  while (kk<vt->last) {
+    // Combine subsequent segments to a chunk, as long as the
+    // pointing directions stay within a small cap around the first
+    // one.
+    Vector center;
+    double capradius=0.;
+    long nseg=0;
+    if (1==ac->nentries) {
+      setVisSegment(&(seg[0]), ac, 0, vt->tstart, vt->tstop);
+      center=seg[0].e1;
+      nseg=1;
+    } else {
+      center=ac->entry[kk].nz;
+      while ((nseg<VISIBILITY_CHUNKSEGMENTS)&&(kk+nseg<vt->last)) {
+	double cosangle=scalar_product(&center, &(ac->entry[kk+nseg+1].nz));
+	double angle=acos(MIN(MAX(cosangle, -1.), 1.));
+	if ((nseg>0)&&(angle>VISIBILITY_CHUNKRADIUS)) break;
+	capradius=MAX(capradius, angle);
+	setVisSegment(&(seg[nseg]), ac, kk+nseg, vt->tstart, vt->tstop);
+	nseg++;
+      }
+      // For a single long segment, use the cap around the center of
+      // the great circle arc.
+      if ((1==nseg)&&(capradius>VISIBILITY_CHUNKRADIUS)&&
+	  (seg[0].phi<M_PI-1.e-6)) {
+	center.x=seg[0].e1.x+ac->entry[kk+1].nz.x;
+	center.y=seg[0].e1.y+ac->entry[kk+1].nz.y;
+	center.z=seg[0].e1.z+ac->entry[kk+1].nz.z;
+	center=normalize_vector(center);
+	capradius=0.5*seg[0].phi;
+      }
+    }
+    // Margin for rounding errors.
+    capradius+=1.e-9;
+
+    // Determine the intervals for all sources close to the chunk.
+    long ncand=getVisCandidates(vt, &center, capradius, &cand, &maxcand,
+				status);
+    CHECK_STATUS_BREAK(*status);
+    long ii;
+    for (ii=0; ii<ncand; ii++) {
+      long jj;
+      for (jj=0; jj<nseg; jj++) {
+	getVisSegmentIntervals(vt, &(seg[jj]), cand[ii], status);
+	CHECK_STATUS_BREAK(*status);
+      }
+      CHECK_STATUS_BREAK(*status);
+    }
+    CHECK_STATUS_BREAK(*status);
+
+    kk+=nseg;
+  }
+
+  if (NULL!=cand) {
+    free(cand);
+  }
+  return(NULL);
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Program Code.
+/////////////////////////////////////////////////////////////////
+
+
+GTI** getVisibilityGTIs(const Attitude* const ac,
+			const Vector* const srcpos,
+			const double* const radius,
+			const long nsources,
+			const double tstart,
+			const double tstop,
+			const int nthreads,
+			int* const status)
+{
+  GTI** gtis=NULL;
+  double* cosradius=NULL;
+  VisThread* vt=NULL;
+  VisIndex index;
+  index.entries=NULL;
+  index.wide=NULL;
+
+  // Range of attitude segments [first,last) covering the regarded
+  // time interval.
+  long first=0, last=1;
+  if (ac->nentries>1) {
+    if ((ac->entry[0].time>tstart)||(ac->entry[ac->nentries-1].time<tstop)) {
+      *status=EXIT_FAILURE;
+      char msg[MAXMSG];
+      sprintf(msg, "attitude does not cover the required period from %lf to %lf",
+	      tstart, tstop);
+      SIXT_ERROR(msg);
+      return(NULL);
+    }
+    while ((first<ac->nentries-2)&&(ac->entry[first+1].time<=tstart)) {
+      first++;
+    }
+    last=first+1;
+    while ((last<ac->nentries-1)&&(ac->entry[last].time<tstop)) {
+      last++;
+    }
+  }
+
+  int nt=nthreads;
+  if (nt<=0) {
+    nt=(int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  nt=(int)MIN((long)MAX(nt, 1), last-first);
+
+  do { // Beginning of ERROR handling loop.
+
+    gtis=(GTI**)calloc(MAX(nsources, 1), sizeof(GTI*));
+    CHECK_NULL_BREAK(gtis, *status, "memory allocation for GTIs failed");
+    long ii;
+    for (ii=0; ii<nsources; ii++) {
+      gtis[ii]=newGTI(status);
+      CHECK_STATUS_BREAK(*status);
+      gtis[ii]->mjdref=ac->mjdref;
+    }
+    CHECK_STATUS_BREAK(*status);
+
+    cosradius=(double*)malloc(MAX(nsources, 1)*sizeof(double));
+    CHECK_NULL_BREAK(cosradius, *status,
+		     "memory allocation for visibility radii failed");
+    for (ii=0; ii<nsources; ii++) {
+      cosradius[ii]=(radius[ii]<M_PI) ? cos(radius[ii]) : -1.;
+    }
+
+    buildVisIndex(&index, srcpos, radius, nsources, status);
+    CHECK_STATUS_BREAK(*status);
+
+    // Distribute the attitude segments to the threads.
+    vt=(VisThread*)calloc(nt, sizeof(VisThread));
+    CHECK_NULL_BREAK(vt, *status, "memory allocation for threads failed");
+    for (ii=0; ii<nt; ii++) {
+      vt[ii].ac       =ac;
+      vt[ii].srcpos   =srcpos;
+      vt[ii].radius   =radius;
+      vt[ii].cosradius=cosradius;
+      vt[ii].index    =&index;
+      vt[ii].tstart   =tstart;
+      vt[ii].tstop    =tstop;
+      vt[ii].first    =first+(last-first)*ii/nt;
+      vt[ii].last     =first+(last-first)*(ii+1)/nt;
+      vt[ii].status   =EXIT_SUCCESS;
+    }
+    if (1==nt) {
+      visibilityThread(&vt[0]);
+    } else {
+      pthread_t thread[nt];
+      int started[nt];
+      for (ii=0; ii<nt; ii++) {
+	started[ii]=
+	  (0==pthread_create(&thread[ii], NULL, visibilityThread, &vt[ii]));
+	if (!started[ii]) {
+	  // Process the segments in the current thread.
+	  visibilityThread(&vt[ii]);
+	}
+      }
+      for (ii=0; ii<nt; ii++) {
+	if (started[ii]) {
+	  pthread_join(thread[ii], NULL);
+	}
+      }
+    }
+    for (ii=0; ii<nt; ii++) {
+      if (EXIT_SUCCESS!=vt[ii].status) {
+	*status=vt[ii].status;
+      }
+    }
+    CHECK_STATUS_BREAK(*status);
+
+    // Collect the intervals of each source in time order. The threads
+    // have processed subsequent time ranges. Intervals touching each
+    // other at the boundaries of chunks or thread ranges are joined.
+    int tt;
+    for (tt=0; tt<nt; tt++) {
+      for (ii=0; ii<vt[tt].nintervals; ii++) {
+	const VisInterval* iv=&(vt[tt].intervals[ii]);
+	GTI* gti=gtis[iv->src];
+	if ((gti->ngti>0)&&(gti->stop[gti->ngti-1]>=iv->start)) {
+	  gti->stop[gti->ngti-1]=MAX(gti->stop[gti->ngti-1], iv->stop);
+	} else {
+	  appendGTI(gti, iv->start, iv->stop, status);
+	  CHECK_STATUS_BREAK(*status);
+	}
+      }
+      CHECK_STATUS_BREAK(*status);
+    }
+    CHECK_STATUS_BREAK(*status);
+
+  } while(0); // END of ERROR handling loop.
+
+  // Release memory.
+  if (NULL!=vt) {
+    int tt;
+    for (tt=0; tt<nt; tt++) {
+      if (NULL!=vt[tt].intervals) {
+	free(vt[tt].intervals);
+      }
+    }
+    free(vt);
+  }
+  freeVisIndex(&index);
+  if (NULL!=cosradius) {
+    free(cosradius);
+  }
+
+  if (EXIT_SUCCESS!=*status) {
+    freeVisibilityGTIs(&gtis, nsources);
+  }
+  return(gtis);
+}
+
+
+void freeVisibilityGTIs(GTI*** const gtis, const long nsources)
+{
+  if (NULL!=*gtis) {
+    long ii;
+    for (ii=0; ii<nsources; ii++) {
+      freeGTI(&((*gtis)[ii]));
+    }
+    free(*gtis);
+    *gtis=NULL;
+  }
+}
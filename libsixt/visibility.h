@@ -0,0 +1,96 @@
+/*
+   This file is part of SIXTE.
+
+   SIXTE is free software: you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   any later version.
+
+   SIXTE is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   For a copy of the GNU General Public License see
+   <http://www.gnu.org/licenses/>.
+
+
+   Copyright 2019 Remeis-Sternwarte, Friedrich-Alexander-Universitaet
+                  Erlangen-Nuernberg
+*/
+
+#ifndef VISIBILITY_H
+#define VISIBILITY_H 1
+
+#include "sixt.h"
+#include "attitude.h"
+#include "gti.h"
+#include "vector.h"
+
+
+/////////////////////////////////////////////////////////////////
+// Constants.
+/////////////////////////////////////////////////////////////////
+
+
+/** Maximum number of attitude segments (intervals between two
+    subsequent attitude entries) that are combined to a chunk. The
+    sources that can be visible during a chunk are looked up at once
+    in the spatial index. */
+#define VISIBILITY_CHUNKSEGMENTS (64)
+
+/** Maximum angular radius of the cap enclosing the pointing
+    directions of a chunk of several attitude segments [rad]. */
+#define VISIBILITY_CHUNKRADIUS (2.*M_PI/180.)
+
+/** Number of declination bands of the spatial index of the
+    sources. */
+#define VISIBILITY_NBANDS (180)
+
+/** Sources with a radius larger than this value [rad] are not
+    included in the spatial index, but are regarded for every chunk,
+    such that they do not enlarge the search region for all other
+    sources. */
+#define VISIBILITY_MAXINDEXRADIUS (5.*M_PI/180.)
+
+
+/////////////////////////////////////////////////////////////////
+// Function Declarations.
+/////////////////////////////////////////////////////////////////
+
+
+/** Determine for each of the nsources source positions (unit
+    vectors) the time intervals within [tstart,tstop] during which the
+    angle between the telescope pointing direction and the source
+    position does not exceed the respective radius [rad], i.e., during
+    which check_fov() with min_align=cos(radius) considers the source
+    to be inside the FOV.
+
+    Between two subsequent attitude entries, the pointing direction
+    moves along a great circle with constant angular velocity as
+    interpolated by getTelescopeNz(). The entry and exit times are
+    therefore determined analytically for each attitude segment
+    instead of sampling the attitude in fixed time steps. The sources
+    are assigned to chunks of subsequent segments with a spatial index
+    over declination bands, such that only the sources close to the
+    path of the pointing direction are regarded.
+
+    The attitude segments are distributed to the requested number of
+    threads (1: serial, 0: number of processors). The resulting GTIs
+    do not depend on the number of threads. The return value is an
+    array of nsources GTIs, which has to be released with
+    freeVisibilityGTIs(). */
+GTI** getVisibilityGTIs(const Attitude* const ac,
+			const Vector* const srcpos,
+			const double* const radius,
+			const long nsources,
+			const double tstart,
+			const double tstop,
+			const int nthreads,
+			int* const status);
+
+/** Release the array of GTIs obtained from getVisibilityGTIs(). */
+void freeVisibilityGTIs(GTI*** const gtis, const long nsources);
+
+
+#endif /* VISIBILITY_H */
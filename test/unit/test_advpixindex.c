@@ -0,0 +1,213 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "advdet.h"
+#include "rndstream.h"
+
+
+/** Detector with a regular array of 16x16 touching pixels and a few
+    larger pixels of different size partially covering the array. */
+static AdvDet* create_test_det(){
+	int status=EXIT_SUCCESS;
+	AdvDet* det=newAdvDet(&status);
+	det->sx=0.001;
+	det->sy=-0.002;
+	det->npix=16*16+3;
+	det->pix=calloc(det->npix, sizeof(AdvPix));
+
+	for (int ii=0; ii<16*16; ii++){
+		det->pix[ii].sx=(ii%16-7.5)*2.5e-4;
+		det->pix[ii].sy=(ii/16-7.5)*2.5e-4;
+		det->pix[ii].width=2.5e-4;
+		det->pix[ii].height=2.5e-4;
+		det->pix[ii].pindex=ii;
+	}
+	const double sx[3]={0., 2.5e-3, -1.e-3};
+	const double sy[3]={0., 0., 1.5e-3};
+	const double width[3]={1.e-3, 3.e-3, 1.e-4};
+	const double height[3]={5.e-4, 1.e-3, 2.e-3};
+	for (int ii=0; ii<3; ii++){
+		AdvPix* pix=&(det->pix[16*16+ii]);
+		pix->sx=sx[ii];
+		pix->sy=sy[ii];
+		pix->width=width[ii];
+		pix->height=height[ii];
+		pix->pindex=16*16+ii;
+	}
+	det->cpix=det->npix;
+
+	return det;
+}
+
+/** Return the pixel impacts of a single impact. The spatial index is
+    only used if requested. */
+static int get_piximpacts(AdvDet* det, Impact* imp, PixImpact** piximp,
+			  int use_index){
+	AdvPixIndex* index=det->pixindex;
+	if (!use_index){
+		det->pixindex=NULL;
+	}
+	int n=AdvImpactList(det, imp, piximp);
+	det->pixindex=index;
+	return n;
+}
+
+
+void test_advpixindex_equals_linear(){
+	int status=EXIT_SUCCESS;
+	AdvDet* det=create_test_det();
+	det->pixindex=newAdvPixIndex(det->pix, det->npix, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+
+	RndStream rs;
+	initRndStream(&rs, 0, 0);
+
+	for (int ii=0; ii<20000; ii++){
+		Impact imp;
+		imp.time=ii;
+		imp.energy=1.;
+		imp.ph_id=ii;
+		imp.src_id=0;
+		if (ii%2==0){
+			// Random positions, including some outside the detector.
+			imp.position.x=det->sx+(getRndStreamUniform(&rs)-0.5)*1.e-2;
+			imp.position.y=det->sy+(getRndStreamUniform(&rs)-0.5)*1.e-2;
+		} else {
+			// Positions on the pixel boundaries.
+			imp.position.x=det->sx+((int)(getRndStreamUniform(&rs)*20)-10)*1.25e-4;
+			imp.position.y=det->sy+((int)(getRndStreamUniform(&rs)*20)-10)*1.25e-4;
+		}
+
+		PixImpact *piximp1=NULL, *piximp2=NULL;
+		int n1=get_piximpacts(det, &imp, &piximp1, 1);
+		int n2=get_piximpacts(det, &imp, &piximp2, 0);
+		assert_int_equal(n1, n2);
+		for (int jj=0; jj<n1; jj++){
+			assert_int_equal(piximp1[jj].pixID, piximp2[jj].pixID);
+			assert_true(piximp1[jj].pixposition.x==piximp2[jj].pixposition.x);
+			assert_true(piximp1[jj].pixposition.y==piximp2[jj].pixposition.y);
+		}
+		free(piximp1);
+		free(piximp2);
+	}
+
+	destroyAdvDet(&det);
+}
+
+void test_advpixindex_batch(){
+	int status=EXIT_SUCCESS;
+	AdvDet* det=create_test_det();
+	det->pixindex=newAdvPixIndex(det->pix, det->npix, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+
+	RndStream rs;
+	initRndStream(&rs, 0, 1);
+
+	const long n=5000;
+	Impact* imp=malloc(n*sizeof(Impact));
+	for (long ii=0; ii<n; ii++){
+		imp[ii].time=ii;
+		imp[ii].energy=1.;
+		imp[ii].ph_id=ii;
+		imp[ii].src_id=0;
+		imp[ii].position.x=det->sx+(getRndStreamUniform(&rs)-0.5)*6.e-3;
+		imp[ii].position.y=det->sy+(getRndStreamUniform(&rs)-0.5)*6.e-3;
+	}
+
+	PixImpact* batch=NULL;
+	long maxbatch=0;
+	long nbatch=AdvImpactListBatch(det, imp, n, &batch, &maxbatch, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	assert_true(nbatch<=maxbatch);
+
+	long kk=0;
+	for (long ii=0; ii<n; ii++){
+		PixImpact* piximp=NULL;
+		int nsingle=AdvImpactList(det, &(imp[ii]), &piximp);
+		for (int jj=0; jj<nsingle; jj++){
+			assert_true(kk<nbatch);
+			assert_int_equal(batch[kk].pixID, piximp[jj].pixID);
+			assert_int_equal(batch[kk].ph_id, imp[ii].ph_id);
+			kk++;
+		}
+		free(piximp);
+	}
+	assert_int_equal(kk, nbatch);
+
+	free(batch);
+	free(imp);
+	destroyAdvDet(&det);
+}
+
+void test_advpixindex_removeoverlapping(){
+	int status=EXIT_SUCCESS;
+	AdvDet* det=create_test_det();
+
+	// Separate the regular pixels, such that only the large pixels
+	// overlap with them.
+	for (int ii=0; ii<16*16; ii++){
+		det->pix[ii].width=2.4e-4;
+		det->pix[ii].height=2.4e-4;
+	}
+
+	// Determine the surviving pixels with a pairwise comparison (the
+	// newest pixel survives).
+	int npix=det->npix;
+	int* active=malloc(npix*sizeof(int));
+	double* sx=malloc(npix*sizeof(double));
+	double* sy=malloc(npix*sizeof(double));
+	for (int ii=0; ii<npix; ii++){
+		active[ii]=1;
+		AdvPix* p1=&(det->pix[ii]);
+		for (int jj=0; jj<ii; jj++){
+			AdvPix* p2=&(det->pix[jj]);
+			if (!(p1->sx-.5*p1->width > p2->sx+.5*p2->width ||
+			      p1->sx+.5*p1->width < p2->sx-.5*p2->width ||
+			      p1->sy-.5*p1->height > p2->sy+.5*p2->height ||
+			      p1->sy+.5*p1->height < p2->sy-.5*p2->height)){
+				active[jj]=0;
+			}
+		}
+	}
+	int nactive=0;
+	for (int ii=0; ii<npix; ii++){
+		if (active[ii]){
+			sx[nactive]=det->pix[ii].sx;
+			sy[nactive]=det->pix[ii].sy;
+			nactive++;
+		}
+	}
+
+	removeOverlapping(det, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	assert_int_equal(det->npix, nactive);
+	for (int ii=0; ii<nactive; ii++){
+		assert_true(det->pix[ii].sx==sx[ii]);
+		assert_true(det->pix[ii].sy==sy[ii]);
+		assert_int_equal(det->pix[ii].pindex, ii);
+	}
+	assert_non_null(det->pixindex);
+	assert_int_equal(det->pixindex->npix, nactive);
+
+	free(active);
+	free(sx);
+	free(sy);
+	destroyAdvDet(&det);
+}
+
+
+int main(void)
+{
+
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_advpixindex_equals_linear),
+    cmocka_unit_test(test_advpixindex_batch),
+    cmocka_unit_test(test_advpixindex_removeoverlapping)
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_TAP);
+
+  return cmocka_run_group_tests_name("Default",tests,NULL,NULL);
+}
@@ -0,0 +1,170 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "attitude.h"
+#include "rndstream.h"
+#include "testattitude.h"
+
+
+/** Survey attitude with irregular time steps. */
+typedef struct{
+	RndStream* rs;
+	double time;
+}SurveyState;
+
+static void fill_survey_entry(long ii, AttitudeEntry* entry, void* data){
+	SurveyState* state=(SurveyState*)data;
+	RndStream* rs=state->rs;
+	entry->time=state->time;
+	entry->nz=unit_vector(ii*0.002, 0.1*getRndStreamUniform(rs));
+	entry->roll_angle=getRndStreamUniform(rs);
+	state->time+=(getRndStreamUniform(rs)<0.5) ? 1. : 3.*getRndStreamUniform(rs)+0.01;
+}
+
+static Attitude* create_survey_attitude(long nentries, AttNxAlign align,
+					RndStream* rs){
+	SurveyState state={rs, 0.};
+	return create_test_attitude(nentries, align, fill_survey_entry, &state);
+}
+
+/** Determine the attitude segment by walking the entries one by one
+    starting at the given segment. */
+static long walk_segment(const Attitude* ac, double time, long seg){
+	while ((time<ac->entry[seg].time)&&(seg>0)){
+		seg--;
+	}
+	while ((time>ac->entry[seg+1].time)&&(seg<ac->nentries-2)){
+		seg++;
+	}
+	return seg;
+}
+
+static double random_time(const Attitude* ac, RndStream* rs){
+	// Include the exact times of the attitude entries.
+	if (getRndStreamUniform(rs)<0.3){
+		return ac->entry[(long)(getRndStreamUniform(rs)*ac->nentries)].time;
+	}
+	return ac->tstop*getRndStreamUniform(rs);
+}
+
+
+void test_attitude_cursor_equals_walk(){
+	int status=EXIT_SUCCESS;
+	RndStream rs;
+	initRndStream(&rs, 0, 0);
+	Attitude* ac=create_survey_attitude(5000, ATTNX_NORTH, &rs);
+
+	long cursor=0, seg=0;
+	for (int ii=0; ii<20000; ii++){
+		double time;
+		if (ii%2==0){
+			time=random_time(ac, &rs);
+		} else {
+			// Small steps from the previous time.
+			time=ac->entry[seg].time+3.*(getRndStreamUniform(&rs)-0.3);
+			time=MIN(MAX(time, ac->tstart), ac->tstop);
+		}
+
+		seg=walk_segment(ac, time, seg);
+		Vector nz=getAttitudeNz(ac, time, &cursor, &status);
+		assert_int_equal(status, EXIT_SUCCESS);
+		assert_int_equal(cursor, seg);
+
+		Vector ref=interpolateCircleVector(ac->entry[seg].nz,
+						   ac->entry[seg+1].nz,
+						   (time-ac->entry[seg].time)/
+						   (ac->entry[seg+1].time-ac->entry[seg].time));
+		assert_memory_equal(&nz, &ref, sizeof(Vector));
+
+		// Without a cursor the search starts at the first segment.
+		Vector nz2=getAttitudeNz(ac, time, NULL, &status);
+		long seg2=walk_segment(ac, time, 0);
+		ref=interpolateCircleVector(ac->entry[seg2].nz,
+					    ac->entry[seg2+1].nz,
+					    (time-ac->entry[seg2].time)/
+					    (ac->entry[seg2+1].time-ac->entry[seg2].time));
+		assert_memory_equal(&nz2, &ref, sizeof(Vector));
+	}
+
+	// Times outside the attitude.
+	getAttitudeNz(ac, ac->tstop+1., &cursor, &status);
+	assert_int_not_equal(status, EXIT_SUCCESS);
+	assert_int_equal(cursor, ac->nentries-2);
+	status=EXIT_SUCCESS;
+	getAttitudeNz(ac, ac->tstart-1., &cursor, &status);
+	assert_int_not_equal(status, EXIT_SUCCESS);
+	assert_int_equal(cursor, 0);
+
+	freeAttitude(&ac);
+}
+
+void test_attitude_axes(){
+	int status=EXIT_SUCCESS;
+	RndStream rs;
+	initRndStream(&rs, 0, 1);
+
+	for (int align=0; align<2; align++){
+		Attitude* ac=create_survey_attitude(2000, (AttNxAlign)align, &rs);
+
+		const long n=3000;
+		double* time=malloc(n*sizeof(double));
+		Vector* nx=malloc(n*sizeof(Vector));
+		Vector* ny=malloc(n*sizeof(Vector));
+		Vector* nz=malloc(n*sizeof(Vector));
+		for (long ii=0; ii<n; ii++){
+			time[ii]=random_time(ac, &rs);
+		}
+
+		long cursor=0;
+		getAttitudeAxesBatch(ac, time, n, nx, ny, nz, &cursor, &status);
+		assert_int_equal(status, EXIT_SUCCESS);
+
+		// The batch call gives the same axes as single calls of the
+		// shared attitude and of the routines with the internal cursor.
+		long cursor2=0;
+		ac->currentry=0;
+		for (long ii=0; ii<n; ii++){
+			Vector x, y, z;
+			getAttitudeAxes(ac, &x, &y, &z, time[ii], &cursor2, &status);
+			assert_memory_equal(&x, &nx[ii], sizeof(Vector));
+			assert_memory_equal(&y, &ny[ii], sizeof(Vector));
+			assert_memory_equal(&z, &nz[ii], sizeof(Vector));
+
+			getTelescopeAxes(ac, &x, &y, &z, time[ii], &status);
+			assert_memory_equal(&x, &nx[ii], sizeof(Vector));
+			assert_memory_equal(&z, &nz[ii], sizeof(Vector));
+			assert_int_equal(ac->currentry, cursor2);
+			assert_true(getRollAngle(ac, time[ii], &status)==
+				    getAttitudeRollAngle(ac, time[ii], &cursor2, &status));
+
+			// The axes are orthonormal.
+			assert_true(fabs(scalar_product(&x, &y))<1.e-12);
+			assert_true(fabs(scalar_product(&x, &z))<1.e-12);
+			assert_true(fabs(scalar_product(&x, &x)-1.)<1.e-12);
+		}
+		assert_int_equal(status, EXIT_SUCCESS);
+		assert_int_equal(cursor, cursor2);
+
+		free(time);
+		free(nx);
+		free(ny);
+		free(nz);
+		freeAttitude(&ac);
+	}
+}
+
+
+int main(void)
+{
+
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_attitude_cursor_equals_walk),
+    cmocka_unit_test(test_attitude_axes)
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_TAP);
+
+  return cmocka_run_group_tests_name("Default",tests,NULL,NULL);
+}
@@ -0,0 +1,274 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "eventfile.h"
+#include "gendet.h"
+#include "gendetline.h"
+#include "phpat.h"
+#include "rndstream.h"
+
+
+/** Detector with ywidth lines of xwidth pixels. The read-out events
+    are passed to a pattern engine, which keeps them in its frame
+    list, as long as the frame number does not change. Therefore the
+    pattern file is never written and only kept in memory. */
+static GenDet* create_test_det(int xwidth, int ywidth){
+	int status=EXIT_SUCCESS;
+	GenDet* det=newGenDet(&status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	det->pixgrid->xwidth=xwidth;
+	det->pixgrid->ywidth=ywidth;
+	det->line=(GenDetLine**)malloc(ywidth*sizeof(GenDetLine*));
+	assert_non_null(det->line);
+	for (int ii=0; ii<ywidth; ii++){
+		det->line[ii]=newGenDetLine(xwidth, &status);
+		assert_int_equal(status, EXIT_SUCCESS);
+	}
+
+	EventFile* elf=newEventFile(&status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	fits_create_file(&elf->fptr, "mem://", &status);
+	fits_create_tbl(elf->fptr, BINARY_TBL, 0, 0, NULL, NULL, NULL, "EVENTS",
+			&status);
+	assert_int_equal(status, EXIT_SUCCESS);
+
+	PatternEngine* engine=newPatternEngine(det, elf, 0, 0, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	setGenDetPatternEngine(det, engine);
+
+	return det;
+}
+
+static void destroy_test_det(GenDet** det){
+	int status=EXIT_SUCCESS;
+	EventFile* elf=(*det)->patengine->dest;
+	destroyPatternEngine(&(*det)->patengine);
+	freeEventFile(&elf, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	destroyGenDet(det);
+	assert_null(*det);
+}
+
+/** Read out the line and return the number of events. The events are
+    kept in the frame list of the pattern engine until the next call
+    of clear_events(). */
+static long readout(GenDet* det, int lineindex){
+	int status=EXIT_SUCCESS;
+	assert_int_equal(det->patengine->nframelist, 0);
+	GenDetReadoutLine(det, lineindex, lineindex, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	return det->patengine->nframelist;
+}
+
+static void clear_events(GenDet* det){
+	for (long ii=0; ii<det->patengine->nframelist; ii++){
+		freeEvent(&det->patengine->framelist[ii]);
+	}
+	det->patengine->nframelist=0;
+}
+
+static void assert_event(const Event* event, int rawx, int rawy,
+			 float signal, long ph_id0, long ph_id1){
+	assert_int_equal(event->rawx, rawx);
+	assert_int_equal(event->rawy, rawy);
+	assert_true(event->signal==signal);
+	assert_int_equal(event->ph_id[0], ph_id0);
+	assert_int_equal(event->ph_id[1], ph_id1);
+}
+
+static void assert_line_empty(const GenDetLine* line){
+	for (int ii=0; ii<line->xwidth; ii++){
+		assert_true(line->charge[ii]==0.);
+		assert_true(line->ccarry[ii]==0.);
+		assert_int_equal(line->ph_id[ii][0], 0);
+	}
+	assert_int_equal(line->anycharge, 0);
+	assert_int_equal(line->anycarry, 0);
+	assert_int_equal(line->nchargedpix, 0);
+	assert_int_equal(line->dense, 0);
+}
+
+
+void test_gendetline_readout(){
+	GenDet* det=create_test_det(16, 2);
+	det->cte=0.5;
+
+	// Two photons in the same pixel, one in front of it, and one in
+	// the second line.
+	addGenDetCharge2Pixel(det, 5, 0, 1.0, -1., 1, 1);
+	addGenDetCharge2Pixel(det, 5, 0, 0.5, -1., 2, 1);
+	addGenDetCharge2Pixel(det, 2, 0, 0.25, -1., 3, 1);
+	addGenDetCharge2Pixel(det, 9, 1, 2.0, -1., 4, 1);
+	assert_int_equal(det->line[0]->nchargedpix, 2);
+	assert_int_equal(det->line[0]->dense, 0);
+
+	// The pixels are read out in increasing order.
+	assert_int_equal(readout(det, 0), 2);
+	assert_event(det->patengine->framelist[0], 2, 0, 0.25, 3, 0);
+	assert_event(det->patengine->framelist[1], 5, 0, 1.5, 1, 2);
+	clear_events(det);
+	assert_line_empty(det->line[0]);
+
+	// The charge of the second line is shifted into the first one
+	// with the CTE applied.
+	GenDetLine* line1=det->line[1];
+	GenDetLineShift(det);
+	assert_true(det->line[1]==line1);
+	assert_line_empty(line1);
+	assert_true(det->line[0]->charge[9]==1.0);
+
+	assert_int_equal(readout(det, 0), 1);
+	assert_event(det->patengine->framelist[0], 9, 0, 1.0, 4, 0);
+	clear_events(det);
+	assert_line_empty(det->line[0]);
+
+	// An empty line does not produce any events.
+	assert_int_equal(readout(det, 0), 0);
+
+	destroy_test_det(&det);
+}
+
+void test_gendetline_carry(){
+	GenDet* det=create_test_det(16, 1);
+	GenDetLine* line=det->line[0];
+
+	// A carry charge without a charge is not read out in the current
+	// cycle, but becomes the charge of the next one.
+	line->ccarry[7]=0.75;
+	line->carry_ph_id[7][0]=9;
+	line->anycarry=1;
+	line->anycharge=1;
+	markGenDetLinePixel(line, 7);
+	addGenDetCharge2Pixel(det, 3, 0, 0.5, -1., 8, 1);
+
+	assert_int_equal(readout(det, 0), 1);
+	assert_event(det->patengine->framelist[0], 3, 0, 0.5, 8, 0);
+	clear_events(det);
+	assert_true(line->charge[7]==0.75);
+	assert_true(line->ccarry[7]==0.);
+	assert_int_equal(line->ph_id[7][0], 9);
+	assert_int_equal(line->carry_ph_id[7][0], 0);
+	assert_int_equal(line->anycharge, 1);
+	assert_int_equal(line->nchargedpix, 1);
+
+	assert_int_equal(readout(det, 0), 1);
+	assert_event(det->patengine->framelist[0], 7, 0, 0.75, 9, 0);
+	clear_events(det);
+	assert_line_empty(line);
+
+	destroy_test_det(&det);
+}
+
+void test_gendetline_dense(){
+	const int xwidth=64;
+	GenDet* det=create_test_det(xwidth, 1);
+	GenDetLine* line=det->line[0];
+
+	// More charged pixels than the list can hold switch the line to
+	// the dense mode.
+	int npixels=0;
+	for (int x=xwidth-1; x>=0; x-=3){
+		addGenDetCharge2Pixel(det, x, 0, (float)(x+1), -1., x+1, 1);
+		npixels++;
+	}
+	assert_true(npixels>xwidth/GENDETLINE_DENSE_FRACTION);
+	assert_int_equal(line->dense, 1);
+
+	assert_int_equal(readout(det, 0), npixels);
+	for (int ii=0; ii<npixels; ii++){
+		int x=(xwidth-1)%3+3*ii;
+		assert_event(det->patengine->framelist[ii], x, 0, (float)(x+1),
+			     x+1, 0);
+	}
+	clear_events(det);
+
+	// After the read-out the line returns to the sparse mode.
+	assert_line_empty(line);
+	addGenDetCharge2Pixel(det, 40, 0, 1.0, -1., 1, 1);
+	addGenDetCharge2Pixel(det, 4, 0, 2.0, -1., 2, 1);
+	assert_int_equal(line->nchargedpix, 2);
+	assert_int_equal(readout(det, 0), 2);
+	assert_event(det->patengine->framelist[0], 4, 0, 2.0, 2, 0);
+	assert_event(det->patengine->framelist[1], 40, 0, 1.0, 1, 0);
+	clear_events(det);
+
+	destroy_test_det(&det);
+}
+
+void test_gendetline_sparse_equals_dense(){
+	const int xwidth=256;
+
+	// The first detector switches automatically between the sparse
+	// and the dense mode, the second one is always in dense mode.
+	GenDet* sparse=create_test_det(xwidth, 2);
+	GenDet* dense=create_test_det(xwidth, 2);
+	sparse->cte=0.99;
+	dense->cte=0.99;
+
+	RndStream rs;
+	initRndStream(&rs, 0, 0);
+
+	int nsparse=0, ndensemode=0;
+	for (int step=0; step<2000; step++){
+		for (int ii=0; ii<2; ii++){
+			dense->line[ii]->dense=1;
+		}
+
+		// Occasionally fill a large fraction of the pixels in order to
+		// trigger the dense mode.
+		int ncharges=(step%100==0) ? 100 : (int)(getRndStreamUniform(&rs)*5);
+		for (int jj=0; jj<ncharges; jj++){
+			int row=(int)(getRndStreamUniform(&rs)*2);
+			int x=(int)(getRndStreamUniform(&rs)*xwidth);
+			float signal=getRndStreamUniform(&rs);
+			addGenDetCharge2Pixel(sparse, x, row, signal, -1., step*1000+jj+1, 1);
+			addGenDetCharge2Pixel(dense, x, row, signal, -1., step*1000+jj+1, 1);
+		}
+		if (0!=sparse->line[0]->dense){
+			ndensemode++;
+		} else {
+			nsparse++;
+		}
+
+		GenDetLineShift(sparse);
+		GenDetLineShift(dense);
+
+		long n=readout(sparse, 0);
+		assert_int_equal(readout(dense, 0), n);
+		for (long jj=0; jj<n; jj++){
+			const Event* ev=dense->patengine->framelist[jj];
+			assert_event(sparse->patengine->framelist[jj], ev->rawx, 0,
+				     ev->signal, ev->ph_id[0], ev->ph_id[1]);
+			if (jj>0){
+				assert_true(ev->rawx>dense->patengine->framelist[jj-1]->rawx);
+			}
+		}
+		clear_events(sparse);
+		clear_events(dense);
+	}
+
+	// Both modes have been used.
+	assert_true(nsparse>0);
+	assert_true(ndensemode>0);
+
+	destroy_test_det(&sparse);
+	destroy_test_det(&dense);
+}
+
+
+int main(void)
+{
+
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_gendetline_readout),
+    cmocka_unit_test(test_gendetline_carry),
+    cmocka_unit_test(test_gendetline_dense),
+    cmocka_unit_test(test_gendetline_sparse_equals_dense)
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_TAP);
+
+  return cmocka_run_group_tests_name("Default",tests,NULL,NULL);
+}
@@ -0,0 +1,151 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "ladsignallist.h"
+#include "rndstream.h"
+
+
+static void set_signal(LADSignal* signal, double time, long element,
+		       long anode, long ph_id){
+	memset(signal, 0, sizeof(LADSignal));
+	signal->time=time;
+	signal->element=element;
+	signal->anode=anode;
+	signal->signal=1.;
+	signal->ph_id[0]=ph_id;
+}
+
+
+void test_ladsignalbuffer_equals_list(){
+	int status=EXIT_SUCCESS;
+	LADSignalBuffer* buf=newLADSignalBuffer(&status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	LADSignalListItem* list=NULL;
+
+	RndStream rs;
+	initRndStream(&rs, 0, 0);
+
+	// Insert more signals than the initial size of the buffer, many
+	// of them with identical times, and compare the order with the
+	// time-ordered linked list.
+	long npopped=0;
+	for (long ii=0; ii<5000; ii++){
+		LADSignal signal;
+		set_signal(&signal, (int)(getRndStreamUniform(&rs)*100)+ii/50,
+			   0, 0, ii+1);
+		insertLADSignalBuffer(buf, &signal, &status);
+		assert_int_equal(status, EXIT_SUCCESS);
+
+		LADSignalListItem** el=&list;
+		while (NULL!=*el){
+			if (signal.time<(*el)->signal.time) break;
+			el=&((*el)->next);
+		}
+		LADSignalListItem* newel=newLADSignalListItem(&status);
+		copyLADSignal(&(newel->signal), &signal);
+		newel->next=*el;
+		*el=newel;
+
+		if (ii%3==0){
+			LADSignal* first=getLADSignalBufferFirst(buf);
+			assert_non_null(first);
+			assert_int_equal(first->ph_id[0], list->signal.ph_id[0]);
+			removeLADSignalBufferFirst(buf);
+			LADSignalListItem* next=list->next;
+			free(list);
+			list=next;
+			npopped++;
+		}
+	}
+	while (NULL!=list){
+		LADSignal* first=getLADSignalBufferFirst(buf);
+		assert_non_null(first);
+		assert_true(first->time==list->signal.time);
+		assert_int_equal(first->ph_id[0], list->signal.ph_id[0]);
+		removeLADSignalBufferFirst(buf);
+		LADSignalListItem* next=list->next;
+		free(list);
+		list=next;
+		npopped++;
+	}
+	assert_int_equal(npopped, 5000);
+	assert_null(getLADSignalBufferFirst(buf));
+
+	freeLADSignalBuffer(&buf);
+	assert_null(buf);
+}
+
+void test_ladsignalcache_neighbour(){
+	int status=EXIT_SUCCESS;
+	LADSignalCache* cache=newLADSignalCache(&status);
+	assert_int_equal(status, EXIT_SUCCESS);
+
+	// Anodes 0-7 form the bottom line, 8-15 the top line.
+	const long element[6]={0, 0, 1, 0, 0, 0};
+	const long anode[6]  ={3, 5, 4, 8, 4, 2};
+	for (long ii=0; ii<6; ii++){
+		LADSignal signal;
+		set_signal(&signal, ii*1.e-7, element[ii], anode[ii], ii+1);
+		appendLADSignalCache(cache, &signal, &status);
+		assert_int_equal(status, EXIT_SUCCESS);
+	}
+	assert_int_equal(cache->nsignals, 6);
+
+	LADSignal* first=getLADSignalCacheFirst(cache);
+	assert_int_equal(first->ph_id[0], 1);
+	long anodes[8]={first->anode};
+	removeLADSignalCache(cache, first);
+
+	// The signal on anode 4 of element 1 and the one on anode 8 on
+	// the top line are not adjacent. Among the signals on anodes 2 and
+	// 4, the earlier one is returned.
+	LADSignal* item=findLADSignalCacheNeighbour(cache, 0, 0, 0, anodes, 1,
+						    0, 8);
+	assert_non_null(item);
+	assert_int_equal(item->ph_id[0], 5);
+	anodes[1]=item->anode;
+	removeLADSignalCache(cache, item);
+
+	item=findLADSignalCacheNeighbour(cache, 0, 0, 0, anodes, 2, 0, 8);
+	assert_non_null(item);
+	assert_int_equal(item->ph_id[0], 2);
+	anodes[2]=item->anode;
+	removeLADSignalCache(cache, item);
+
+	item=findLADSignalCacheNeighbour(cache, 0, 0, 0, anodes, 3, 0, 8);
+	assert_non_null(item);
+	assert_int_equal(item->ph_id[0], 6);
+	removeLADSignalCache(cache, item);
+
+	item=findLADSignalCacheNeighbour(cache, 0, 0, 0, anodes, 3, 0, 8);
+	assert_null(item);
+
+	// The remaining signals are still in insertion order.
+	first=getLADSignalCacheFirst(cache);
+	assert_int_equal(first->ph_id[0], 3);
+	removeLADSignalCache(cache, first);
+	first=getLADSignalCacheFirst(cache);
+	assert_int_equal(first->ph_id[0], 4);
+	removeLADSignalCache(cache, first);
+	assert_null(getLADSignalCacheFirst(cache));
+	assert_int_equal(cache->nsignals, 0);
+
+	freeLADSignalCache(&cache);
+	assert_null(cache);
+}
+
+
+int main(void)
+{
+
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_ladsignalbuffer_equals_list),
+    cmocka_unit_test(test_ladsignalcache_neighbour)
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_TAP);
+
+  return cmocka_run_group_tests_name("Default",tests,NULL,NULL);
+}
@@ -0,0 +1,115 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "photonbuffer.h"
+
+
+static void fillChunk(PhotonBuffer* buf, const double* times, int n, long src_id){
+	int status=EXIT_SUCCESS;
+	startPhotonBufferChunk(buf, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	for (int ii=0; ii<n; ii++){
+		Photon* ph=appendPhotonBuffer(buf, &status);
+		assert_int_equal(status, EXIT_SUCCESS);
+		ph->time=times[ii];
+		ph->energy=1.;
+		ph->ra=0.;
+		ph->dec=0.;
+		ph->ph_id=0;
+		ph->src_id=src_id;
+	}
+}
+
+
+void test_photonbuffer_merge(){
+	int status=EXIT_SUCCESS;
+	PhotonBuffer* buf=newPhotonBuffer(&status);
+	assert_int_equal(status, EXIT_SUCCESS);
+
+	const double t1[]={0.1, 0.5, 0.9};
+	const double t2[]={0.2, 0.5, 0.6, 1.5};
+	const double t3[]={0.05};
+	fillChunk(buf, t1, 3, 1);
+	fillChunk(buf, t2, 4, 2);
+	fillChunk(buf, NULL, 0, 3);
+	fillChunk(buf, t3, 1, 4);
+	mergePhotonBuffer(buf, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	assert_int_equal(getPhotonBufferNPhotons(buf), 8);
+
+	// Photons with the same time are taken from the chunk that has
+	// been filled first.
+	const double ref_time[]={0.05, 0.1, 0.2, 0.5, 0.5, 0.6, 0.9, 1.5};
+	const long ref_src[]={4, 1, 2, 1, 2, 2, 1, 2};
+
+	// Take the photons in batches of different size.
+	Photon ph[8];
+	long nph=getPhotonBufferPhotons(buf, ph, 3, &status);
+	assert_int_equal(nph, 3);
+	nph+=getPhotonBufferPhotons(buf, &ph[3], 10, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	assert_int_equal(nph, 8);
+	for (int ii=0; ii<8; ii++){
+		assert_true(ph[ii].time==ref_time[ii]);
+		assert_int_equal(ph[ii].src_id, ref_src[ii]);
+	}
+
+	// The buffer is empty and can be filled again.
+	assert_int_equal(getPhotonBufferNPhotons(buf), 0);
+	fillChunk(buf, t3, 1, 5);
+	mergePhotonBuffer(buf, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	assert_int_equal(getPhotonBufferPhotons(buf, ph, 8, &status), 1);
+	assert_int_equal(ph[0].src_id, 5);
+
+	freePhotonBuffer(&buf);
+	assert_null(buf);
+}
+
+void test_photonbuffer_large(){
+	int status=EXIT_SUCCESS;
+	PhotonBuffer* buf=newPhotonBuffer(&status);
+
+	// Exceed the initial size of the arena and of the chunk list.
+	const int nchunks=3*PHOTONBUFFER_INITCHUNKS;
+	const int nperchunk=100;
+	for (int ii=0; ii<nchunks; ii++){
+		startPhotonBufferChunk(buf, &status);
+		for (int jj=0; jj<nperchunk; jj++){
+			Photon* ph=appendPhotonBuffer(buf, &status);
+			ph->time=jj*1.+ii*1.e-3;
+			ph->src_id=ii;
+		}
+	}
+	assert_int_equal(status, EXIT_SUCCESS);
+	mergePhotonBuffer(buf, &status);
+
+	Photon ph;
+	double last=-1.;
+	long nph=0;
+	while (getPhotonBufferPhotons(buf, &ph, 1, &status)>0){
+		assert_true(ph.time>=last);
+		last=ph.time;
+		nph++;
+	}
+	assert_int_equal(status, EXIT_SUCCESS);
+	assert_int_equal(nph, nchunks*nperchunk);
+
+	freePhotonBuffer(&buf);
+}
+
+
+int main(void)
+{
+
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_photonbuffer_merge),
+    cmocka_unit_test(test_photonbuffer_large)
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_TAP);
+
+  return cmocka_run_group_tests_name("Default",tests,NULL,NULL);
+}
@@ -0,0 +1,121 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "rmfsampler.h"
+#include "rndgen.h"
+
+
+/** Small response matrix with 4 energy bins and 6 channels starting
+    at channel 1. The second energy bin consists of two channel
+    groups, the last energy bin is not normalized. */
+static struct RMF* create_test_rmf(){
+	const long nbins=4, ngroups=5;
+	const float lo[4]={1., 2., 3., 4.};
+	const float hi[4]={2., 3., 4., 5.};
+	const long numgrp[4]={1, 2, 1, 1};
+	const long fgrp[4]={0, 1, 3, 4};
+	const long fchan[5]={0, 0, 3, 2, 1};
+	const long nchan[5]={2, 2, 3, 2, 3};
+	const long felem[5]={0, 2, 4, 7, 9};
+	const float matrix[12]={0.25, 0.75, 0.1, 0.2, 0.3, 0.3, 0.1, 0.5, 0.5,
+				0.2, 0.2, 0.2};
+
+	struct RMF* rmf=calloc(1, sizeof(struct RMF));
+	rmf->NumberChannels=6;
+	rmf->NumberEnergyBins=nbins;
+	rmf->NumberTotalGroups=ngroups;
+	rmf->NumberTotalElements=12;
+	rmf->FirstChannel=1;
+	rmf->LowEnergy=malloc(nbins*sizeof(float));
+	rmf->HighEnergy=malloc(nbins*sizeof(float));
+	rmf->NumberGroups=malloc(nbins*sizeof(long));
+	rmf->FirstGroup=malloc(nbins*sizeof(long));
+	rmf->FirstChannelGroup=malloc(ngroups*sizeof(long));
+	rmf->NumberChannelGroups=malloc(ngroups*sizeof(long));
+	rmf->FirstElement=malloc(ngroups*sizeof(long));
+	rmf->OrderGroup=calloc(ngroups, sizeof(long));
+	rmf->Matrix=malloc(12*sizeof(float));
+	rmf->ChannelLowEnergy=calloc(6, sizeof(float));
+	rmf->ChannelHighEnergy=calloc(6, sizeof(float));
+
+	for (int ii=0; ii<nbins; ii++){
+		rmf->LowEnergy[ii]=lo[ii];
+		rmf->HighEnergy[ii]=hi[ii];
+		rmf->NumberGroups[ii]=numgrp[ii];
+		rmf->FirstGroup[ii]=fgrp[ii];
+	}
+	for (int ii=0; ii<ngroups; ii++){
+		rmf->FirstChannelGroup[ii]=fchan[ii];
+		rmf->NumberChannelGroups[ii]=nchan[ii];
+		rmf->FirstElement[ii]=felem[ii];
+	}
+	for (int ii=0; ii<12; ii++){
+		rmf->Matrix[ii]=matrix[ii];
+	}
+
+	return rmf;
+}
+
+
+void test_rmfsampler_equals_returnRMFChannel(){
+	int status=EXIT_SUCCESS;
+	struct RMF* rmf=create_test_rmf();
+	RMFSampler* sampler=newRMFSampler(rmf, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+
+	// Include the bin boundaries and energies outside the RMF.
+	const int n=1000;
+	float energy[1000];
+	for (int ii=0; ii<n; ii++){
+		energy[ii]=0.5+(ii%10)*0.5;
+	}
+
+	long channel[1000];
+	sixt_init_rng(1, &status);
+	getRMFSamplerChannels(sampler, energy, n, channel, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	sixt_destroy_rng();
+
+	sixt_init_rng(1, &status);
+	for (int ii=0; ii<n; ii++){
+		long ref;
+		returnRMFChannel(rmf, energy[ii], &ref);
+		assert_int_equal(channel[ii], ref);
+	}
+	sixt_destroy_rng();
+
+	freeRMFSampler(&sampler);
+	assert_null(sampler);
+	freeRMF(rmf);
+}
+
+void test_rmfsampler_shared(){
+	int status=EXIT_SUCCESS;
+	struct RMF* rmf=create_test_rmf();
+
+	const RMFSampler* s1=getSharedRMFSampler(rmf, &status);
+	const RMFSampler* s2=getSharedRMFSampler(rmf, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	assert_non_null(s1);
+	assert_ptr_equal(s1, s2);
+	assert_ptr_equal(s1->rmf, rmf);
+
+	// Releases the RMF together with the sampler.
+	releaseSharedRMF(rmf);
+}
+
+
+int main(void)
+{
+
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_rmfsampler_equals_returnRMFChannel),
+    cmocka_unit_test(test_rmfsampler_shared)
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_TAP);
+
+  return cmocka_run_group_tests_name("Default",tests,NULL,NULL);
+}
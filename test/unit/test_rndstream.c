@@ -0,0 +1,132 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "rndstream.h"
+
+
+// Known answer test of the Philox4x32-10 block cipher (counter and
+// key equal to zero), see the Random123 test vectors.
+uint32_t ref_philox_zero[4] = {
+		0x6627e8d5,
+		0xe169c58d,
+		0xbc57ac4c,
+		0x9b00dbd8
+};
+
+
+void test_rndstream_known_answer(){
+	RndStream rs;
+	initRndStream(&rs, 0, 0);
+
+	for (int ii=0; ii<4; ii++){
+		assert_int_equal(getRndStreamUInt32(&rs), ref_philox_zero[ii]);
+	}
+}
+
+void test_rndstream_reproducibility(){
+	RndStream rs1, rs2;
+	initRndStream(&rs1, 42, getRndStreamId(3, 17));
+	initRndStream(&rs2, 42, getRndStreamId(3, 17));
+
+	for (int ii=0; ii<1000; ii++){
+		assert_true(getRndStreamUniform(&rs1)==getRndStreamUniform(&rs2));
+	}
+}
+
+void test_rndstream_independence(){
+	RndStream rs1, rs2;
+	initRndStream(&rs1, 42, getRndStreamId(0, 1));
+	initRndStream(&rs2, 42, getRndStreamId(1, 0));
+
+	int nequal=0;
+	for (int ii=0; ii<1000; ii++){
+		if (getRndStreamUInt32(&rs1)==getRndStreamUInt32(&rs2)) nequal++;
+	}
+	assert_in_range(nequal, 0, 1);
+}
+
+void test_rndstream_seek(){
+	RndStream rs1, rs2;
+	initRndStream(&rs1, 7, 5);
+	initRndStream(&rs2, 7, 5);
+
+	// Skip an odd number of words in order to test the position
+	// within a block.
+	for (int ii=0; ii<13; ii++){
+		getRndStreamUInt32(&rs1);
+	}
+	seekRndStream(&rs2, 13);
+
+	for (int ii=0; ii<100; ii++){
+		assert_int_equal(getRndStreamUInt32(&rs1), getRndStreamUInt32(&rs2));
+	}
+}
+
+void test_rndstream_bulk_equals_single(){
+	const int n=101;
+	double bulk[101];
+
+	RndStream rs1, rs2;
+	initRndStream(&rs1, 1, 2);
+	initRndStream(&rs2, 1, 2);
+
+	fillRndStreamGauss(&rs1, bulk, n);
+	for (int ii=0; ii<n; ii++){
+		assert_true(bulk[ii]==getRndStreamGauss(&rs2));
+	}
+
+	fillRndStreamUniform(&rs1, bulk, n);
+	for (int ii=0; ii<n; ii++){
+		assert_true(bulk[ii]==getRndStreamUniform(&rs2));
+	}
+}
+
+void test_rndstream_distributions(){
+	const long n=100000;
+	RndStream rs;
+	initRndStream(&rs, 0, 1);
+
+	double mean_uni=0., mean_gauss=0., var_gauss=0., mean_exp=0.;
+	double mean_pois_lo=0., mean_pois_hi=0.;
+	for (long ii=0; ii<n; ii++){
+		double val=getRndStreamUniform(&rs);
+		assert_true((val>=0.)&&(val<1.));
+		mean_uni+=val;
+
+		val=getRndStreamGauss(&rs);
+		mean_gauss+=val;
+		var_gauss+=val*val;
+
+		mean_exp+=getRndStreamExp(&rs, 2.);
+		mean_pois_lo+=getRndStreamPoisson(&rs, 3.);
+		mean_pois_hi+=getRndStreamPoisson(&rs, 50.);
+	}
+
+	// be very conservative here
+	assert_true(fabs(mean_uni/n-0.5)<0.01);
+	assert_true(fabs(mean_gauss/n)<0.02);
+	assert_true(fabs(var_gauss/n-1.)<0.02);
+	assert_true(fabs(mean_exp/n-2.)<0.05);
+	assert_true(fabs(mean_pois_lo/n-3.)<0.05);
+	assert_true(fabs(mean_pois_hi/n-50.)<0.2);
+}
+
+
+int main(void)
+{
+
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_rndstream_known_answer),
+    cmocka_unit_test(test_rndstream_reproducibility),
+    cmocka_unit_test(test_rndstream_independence),
+    cmocka_unit_test(test_rndstream_seek),
+    cmocka_unit_test(test_rndstream_bulk_equals_single),
+    cmocka_unit_test(test_rndstream_distributions)
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_TAP);
+
+  return cmocka_run_group_tests_name("Default",tests,NULL,NULL);
+}
@@ -0,0 +1,177 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "visibility.h"
+#include "rndstream.h"
+#include "testattitude.h"
+
+
+/** Survey-like attitude: the pointing direction scans a great circle
+    through the poles with a period of 4 hours, while the scan plane
+    slowly rotates. Some entries are slightly displaced. The time step
+    is given by data. */
+static void fill_scan_entry(long ii, AttitudeEntry* entry, void* data){
+	double time=ii*(*(double*)data);
+	double phase=2.*M_PI/14400.*time;
+	double plane=2.*M_PI/86400.*time;
+	Vector nz={cos(phase)*cos(plane), cos(phase)*sin(plane), sin(phase)};
+	if (ii%97==5){
+		nz.x+=0.005;
+		nz=normalize_vector(nz);
+	}
+	entry->time=time;
+	entry->nz=nz;
+}
+
+static Attitude* create_scan_attitude(long nentries, double dt){
+	return create_test_attitude(nentries, ATTNX_NORTH, fill_scan_entry, &dt);
+}
+
+/** Check the GTIs of each source against the pointing direction
+    sampled in small time steps. Samples very close to the FOV
+    boundary are not regarded. */
+static void check_sampled(Attitude* ac, const Vector* pos,
+			  const double* radius, long nsources,
+			  double tstart, double tstop, GTI** gtis){
+	int status=EXIT_SUCCESS;
+	long nvisible=0;
+	for (long ii=0; ii<nsources; ii++){
+		double min_align=(radius[ii]<M_PI) ? cos(radius[ii]) : -1.;
+		GTI* gti=gtis[ii];
+		for (int jj=0; jj<gti->ngti; jj++){
+			assert_true(gti->start[jj]<gti->stop[jj]);
+			assert_true(gti->start[jj]>=tstart);
+			assert_true(gti->stop[jj]<=tstop);
+			if (jj>0){
+				assert_true(gti->start[jj]>gti->stop[jj-1]);
+			}
+		}
+
+		int jj=0;
+		for (double time=tstart; time<tstop; time+=0.137){
+			Vector nz=getTelescopeNz(ac, time, &status);
+			assert_int_equal(status, EXIT_SUCCESS);
+			double align=scalar_product(&nz, &pos[ii]);
+			while ((jj<gti->ngti)&&(gti->stop[jj]<time)){
+				jj++;
+			}
+			int ingti=(jj<gti->ngti)&&(gti->start[jj]<=time);
+			if (fabs(align-min_align)>1.e-9){
+				assert_int_equal(ingti, (align>=min_align));
+			}
+			nvisible+=ingti;
+		}
+	}
+	assert_true(nvisible>0);
+}
+
+
+void test_visibility_equals_sampling(){
+	int status=EXIT_SUCCESS;
+	Attitude* ac=create_scan_attitude(3000, 1.);
+
+	RndStream rs;
+	initRndStream(&rs, 0, 0);
+
+	// Random sources, most of them close to the scanned path, and a
+	// few special cases: a source at the pole, a source that is
+	// visible all the time, and a source on a node of the scan.
+	const long nsources=200;
+	Vector pos[200];
+	double radius[200];
+	for (long ii=0; ii<nsources; ii++){
+		double ra=getRndStreamUniform(&rs)*0.3;
+		double dec=asin(2.*getRndStreamUniform(&rs)-1.);
+		pos[ii]=unit_vector(ra, dec);
+		radius[ii]=0.51*M_PI/180.;
+		if (ii%10==0){
+			radius[ii]+=getRndStreamUniform(&rs)*0.02;
+		}
+	}
+	pos[0]=unit_vector(0.3, 0.5*M_PI);
+	radius[1]=4.;
+	pos[2]=unit_vector(0., 0.);
+
+	const double tstart=13.3, tstop=2990.1;
+	GTI** gtis=getVisibilityGTIs(ac, pos, radius, nsources, tstart, tstop,
+				     1, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	assert_non_null(gtis);
+	check_sampled(ac, pos, radius, nsources, tstart, tstop, gtis);
+
+	// The source covering the whole sky is visible all the time.
+	assert_int_equal(gtis[1]->ngti, 1);
+	assert_true(gtis[1]->start[0]==tstart);
+	assert_true(gtis[1]->stop[0]==tstop);
+
+	freeVisibilityGTIs(&gtis, nsources);
+	assert_null(gtis);
+	freeAttitude(&ac);
+}
+
+void test_visibility_threads(){
+	int status=EXIT_SUCCESS;
+	Attitude* ac=create_scan_attitude(20000, 1.);
+
+	RndStream rs;
+	initRndStream(&rs, 0, 1);
+
+	const long nsources=500;
+	Vector pos[500];
+	double radius[500];
+	for (long ii=0; ii<nsources; ii++){
+		double ra=getRndStreamUniform(&rs)*2.*M_PI;
+		double dec=asin(2.*getRndStreamUniform(&rs)-1.);
+		pos[ii]=unit_vector(ra, dec);
+		radius[ii]=0.51*M_PI/180.;
+	}
+
+	// The results must not depend on the number of threads.
+	GTI** serial=getVisibilityGTIs(ac, pos, radius, nsources, 0., 19999.,
+				       1, &status);
+	GTI** parallel=getVisibilityGTIs(ac, pos, radius, nsources, 0., 19999.,
+					 3, &status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	for (long ii=0; ii<nsources; ii++){
+		assert_int_equal(serial[ii]->ngti, parallel[ii]->ngti);
+		for (int jj=0; jj<serial[ii]->ngti; jj++){
+			assert_true(serial[ii]->start[jj]==parallel[ii]->start[jj]);
+			assert_true(serial[ii]->stop[jj]==parallel[ii]->stop[jj]);
+		}
+	}
+
+	freeVisibilityGTIs(&serial, nsources);
+	freeVisibilityGTIs(&parallel, nsources);
+	freeAttitude(&ac);
+}
+
+void test_visibility_coverage(){
+	int status=EXIT_SUCCESS;
+	Attitude* ac=create_scan_attitude(100, 1.);
+	Vector pos=unit_vector(0., 0.);
+	double radius=0.01;
+
+	// The attitude does not cover the requested time interval.
+	GTI** gtis=getVisibilityGTIs(ac, &pos, &radius, 1, 0., 200., 1, &status);
+	assert_int_not_equal(status, EXIT_SUCCESS);
+	assert_null(gtis);
+
+	freeAttitude(&ac);
+}
+
+
+int main(void)
+{
+
+  const struct CMUnitTest tests[] = {
+    cmocka_unit_test(test_visibility_equals_sampling),
+    cmocka_unit_test(test_visibility_threads),
+    cmocka_unit_test(test_visibility_coverage)
+  };
+
+  cmocka_set_message_output(CM_OUTPUT_TAP);
+
+  return cmocka_run_group_tests_name("Default",tests,NULL,NULL);
+}
@@ -0,0 +1,26 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "testattitude.h"
+
+
+Attitude* create_test_attitude(long nentries, AttNxAlign align,
+			       TestAttitudeEntry fill, void* data){
+	int status=EXIT_SUCCESS;
+	Attitude* ac=getAttitude(&status);
+	assert_int_equal(status, EXIT_SUCCESS);
+	ac->nentries=nentries;
+	ac->entry=calloc(nentries, sizeof(AttitudeEntry));
+	assert_non_null(ac->entry);
+	ac->align=align;
+
+	for (long ii=0; ii<nentries; ii++){
+		fill(ii, &ac->entry[ii], data);
+	}
+	ac->tstart=ac->entry[0].time;
+	ac->tstop=ac->entry[nentries-1].time;
+
+	return ac;
+}
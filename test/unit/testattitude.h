@@ -0,0 +1,20 @@
+#ifndef TESTATTITUDE_H
+#define TESTATTITUDE_H 1
+
+#include "attitude.h"
+
+
+/** Set the time and the pointing direction (and optionally the roll
+    angle) of attitude entry ii. The entries are filled in increasing
+    order. */
+typedef void (*TestAttitudeEntry)(long ii, AttitudeEntry* entry,
+				  void* data);
+
+/** Attitude with nentries entries set by the given function. The
+    covered time interval is taken from the first and the last
+    entry. */
+Attitude* create_test_attitude(long nentries, AttNxAlign align,
+			       TestAttitudeEntry fill, void* data);
+
+
+#endif /* TESTATTITUDE_H */
@@ -22,13 +22,276 @@
 
 #include "athenawfisim.h"
 
+/** Determine the chip whose pixel array contains the impact
+    position. Returns -1 if the impact misses all chips. Impacts
+    outside the pixel array of a chip do not produce any signal in
+    that chip, independent of the split model. */
+static int getWFIChip(GenInst** const subinst, const int nchips,
+		const Impact* const imp) {
+	int ii;
+	for (ii = 0; ii < nchips; ii++) {
+		int xi, yi;
+		double xp, yp;
+		getGenDetAffectedPixel(subinst[ii]->det->pixgrid, imp->position.x,
+				imp->position.y, &xi, &yi, &xp, &yp);
+		if ((xi >= 0) && (yi >= 0)) {
+			return ii;
+		}
+	}
+	return -1;
+}
+
+/** Detect the impacts of one batch and finalize the chips at the end
+    of a GTI interval. */
+static void processWFIBatch(void* const data, const int iworker,
+		BatchPoolBatch* const batch, int* const status) {
+	WFIWorker* worker = &(((WFIWorker*) data)[iworker]);
+	WFIPipeline* pipe = worker->pipe;
+
+	long kk;
+	for (kk = 0; kk < batch->nitems; kk++) {
+		int chip = batch->unit[kk];
+
+		// All random numbers of a chip are taken from its own stream.
+		sixt_set_thread_rndstream(&(pipe->rs[chip]));
+
+		phdetGenDet(pipe->subinst[chip]->det,
+				&(((Impact*) batch->items)[kk]), batch->t1, status);
+		CHECK_STATUS_VOID(*status);
+	}
+
+	if (0 == batch->endgti)
+		return;
+
+	// Clear the detectors and prepare them for the next interval.
+	int chip;
+	for (chip = worker->id; chip < WFI_NCHIPS; chip += worker->nworkers) {
+		sixt_set_thread_rndstream(&(pipe->rs[chip]));
+		GenDet* det = pipe->subinst[chip]->det;
+		phdetGenDet(det, NULL, batch->t1, status);
+		CHECK_STATUS_VOID(*status);
+		long jj;
+		for (jj = 0; jj < det->pixgrid->ywidth; jj++) {
+			GenDetClearLine(det, jj);
+		}
+		if (0 != batch->nextgti) {
+			setGenDetStartTime(det, batch->t0next);
+		}
+	}
+}
+
+/** Pattern analysis, sky projection, and PI correction of one chip
+    after the end of the simulation. */
+static void postprocessWFIChip(WFIWorker* const worker, const int chip,
+		int* const status) {
+	WFIPipeline* pipe = worker->pipe;
+	GenInst* inst = pipe->subinst[chip];
+
+	sixt_set_thread_rndstream(&(pipe->rs[chip]));
+
+	// Perform a pattern analysis, only if split events are simulated.
+	if (GS_NONE != inst->det->split->type) {
+		phpat(inst->det, pipe->elf[chip], pipe->patf[chip],
+				pipe->par->SkipInvalids, status);
+		CHECK_STATUS_VOID(*status);
+	} else {
+		// If no split events are simulated, simply copy the event lists
+		// to pattern lists.
+		copyEventFile(pipe->elf[chip], pipe->patf[chip],
+				inst->det->threshold_event_lo_keV,
+				inst->det->threshold_pattern_up_keV, status);
+		CHECK_STATUS_VOID(*status);
+		fits_update_key(pipe->patf[chip]->fptr, TSTRING, "EVTYPE", "PATTERN",
+				"event type", status);
+		CHECK_STATUS_VOID(*status);
+	}
+
+	// Store the GTI extension in the event file and close it in
+	// order to save memory.
+	saveGTIExt(pipe->elf[chip]->fptr, "STDGTI", pipe->gti, status);
+	CHECK_STATUS_VOID(*status);
+	freeEventFile(&(pipe->elf[chip]), status);
+	CHECK_STATUS_VOID(*status);
+
+	// Run the event projection.
+	phproj(inst, worker->ac, pipe->patf[chip], pipe->par->TSTART,
+			pipe->par->Exposure, status);
+	CHECK_STATUS_VOID(*status);
+
+	// Store the GTI extension in the pattern file.
+	saveGTIExt(pipe->patf[chip]->fptr, "STDGTI", pipe->gti, status);
+	CHECK_STATUS_VOID(*status);
+
+	// Run PI correction on the pattern file.
+	if (NULL != pipe->p2p[chip]) {
+		pha2pi_correct_eventfile(pipe->patf[chip], pipe->p2p[chip],
+				inst->filepath, inst->det->rmf_filename, status);
+		CHECK_STATUS_VOID(*status);
+	}
+}
+
+/** Post-processing of the chips of a thread after the end of the
+    simulation. */
+static void finishWFIWorker(void* const data, const int iworker,
+		int* const status) {
+	WFIWorker* worker = &(((WFIWorker*) data)[iworker]);
+	int chip;
+	for (chip = worker->id; chip < WFI_NCHIPS; chip += worker->nworkers) {
+		postprocessWFIChip(worker, chip, status);
+		CHECK_STATUS_VOID(*status);
+	}
+}
+
+/** Simulate the detector chips in nworkers threads. The photons are
+    generated and imaged in the calling thread. Each impact is passed
+    to the thread of the chip it hits. Each chip uses its own random
+    number stream, such that the result does not depend on the number
+    of threads. The photon and impact list files are closed after the
+    photon generation. */
+static void runWFIPipeline(WFIPipeline* const pipe, Attitude* const ac,
+		SourceCatalog** const srccat, PhotonFile** const plf,
+		ImpactFile** const ilf, const int nworkers,
+		FILE* const progressfile, int* const status) {
+
+	WFIWorker worker[WFI_NCHIPS];
+	BatchPool* pool = NULL;
+
+	int ii;
+	for (ii = 0; ii < nworkers; ii++) {
+		worker[ii].pipe = pipe;
+		worker[ii].id = ii;
+		worker[ii].nworkers = nworkers;
+		worker[ii].ac = ac;
+	}
+
+	// Set the start time for the detector models.
+	for (ii = 0; ii < WFI_NCHIPS; ii++) {
+		setGenDetStartTime(pipe->subinst[ii]->det, pipe->gti->start[0]);
+	}
+
+	do { // Beginning of ERROR HANDLING Loop.
+
+		pool = newBatchPool(nworkers, sizeof(Impact), WFI_BATCHSIZE,
+				WFI_NBATCHES, &processWFIBatch, &finishWFIWorker, worker,
+				status);
+		CHECK_STATUS_BREAK(*status);
+
+	} while (0); // END of ERROR HANDLING Loop.
+
+	// Simulation progress status (running from 0 to 100).
+	unsigned int progress = 0;
+	double totalsimtime = sumGTI(pipe->gti);
+
+	// Loop over all intervals in the GTI collection.
+	double simtime = 0.;
+	int gtibin = 0;
+	int failed = 0;
+	while (EXIT_SUCCESS == *status) {
+		// Currently regarded interval.
+		double t0 = pipe->gti->start[gtibin];
+		double t1 = pipe->gti->stop[gtibin];
+
+		do {
+			// Photon generation.
+			Photon ph;
+			int isph = phgen(ac, srccat, MAX_N_SIMPUT, t0, t1,
+					pipe->par->MJDREF, pipe->par->dt,
+					pipe->subinst[0]->tel->fov_diameter, &ph, status);
+			CHECK_STATUS_BREAK(*status);
+
+			// If no photon has been generated, break the loop.
+			if (0 == isph)
+				break;
+
+			// Check if the photon still is within the requested
+			// exposure time.
+			assert(ph.time <= t1);
+
+			// If requested, write the photon to the output file.
+			if (NULL != *plf) {
+				*status = addPhoton2File(*plf, &ph);
+				CHECK_STATUS_BREAK(*status);
+			}
+
+			// Photon imaging.
+			Impact imp;
+			int isimg = phimg(pipe->subinst[0]->tel, ac, &ph, &imp, status);
+			CHECK_STATUS_BREAK(*status);
+
+			if (0 != isimg) {
+				// If requested, write the impact to the output file.
+				if (NULL != *ilf) {
+					addImpact2File(*ilf, &imp, status);
+					CHECK_STATUS_BREAK(*status);
+				}
+
+				// Add the impact to the batch of the thread processing
+				// the affected chip.
+				int chip = getWFIChip(pipe->subinst, WFI_NCHIPS, &imp);
+				if (chip >= 0) {
+					failed |= addBatchPoolItem(pool, chip % nworkers, &imp,
+							chip, t1);
+					if (0 != failed)
+						break;
+				}
+			}
+
+			// Program progress output.
+			while ((unsigned int) ((ph.time - t0 + simtime) * 100.
+					/ totalsimtime) > progress) {
+				progress++;
+				if (NULL == progressfile) {
+					headas_chat(2, "\r%.0lf %%", progress * 1.);
+					fflush(NULL);
+				} else {
+					rewind(progressfile);
+					fprintf(progressfile, "%.2lf", progress * 1. / 100.);
+					fflush(progressfile);
+				}
+			}
+
+		} while (1);
+		if ((EXIT_SUCCESS != *status) || (0 != failed))
+			break;
+
+		// Proceed to the next GTI interval.
+		simtime += t1 - t0;
+		gtibin++;
+
+		// Let the chip threads finalize the detectors at the end of
+		// the interval.
+		int nextgti = (gtibin < pipe->gti->ngti);
+		failed |= endBatchPoolInterval(pool, t1, nextgti,
+				nextgti ? pipe->gti->start[gtibin] : 0.);
+		if ((0 != failed) || (0 == nextgti))
+			break;
+	}
+
+	// Terminate the chip threads in case of an error.
+	if (NULL != pool) {
+		stopBatchPool(pool);
+	}
+
+	// The photon and impact lists are complete. Close them in order
+	// to save memory, while the chip threads are still working.
+	freePhotonFile(plf, status);
+	freeImpactFile(ilf, status);
+
+	// Wait for the readout and post-processing in the chip threads.
+	if (NULL != pool) {
+		joinBatchPool(pool, status);
+		freeBatchPool(&pool);
+	}
+}
+
+
 int athenapwfisim_main() {
 
 	// Program parameters.
 	struct Parameters par;
 
 	// Number of detector chips
-	unsigned int nchips = 4;
+	unsigned int nchips = WFI_NCHIPS;
 
 	unsigned long ii;
 
@@ -74,7 +337,7 @@ int athenapwfisim_main() {
 	// Pha2Pi correction files
 	Pha2Pi* p2p[nchips];
 	for (ii = 0; ii < nchips; ii++) {
-		patf[ii] = NULL;
+		p2p[ii] = NULL;
 	}
 	// Error status.
 	int status = EXIT_SUCCESS;
@@ -513,187 +776,243 @@ int athenapwfisim_main() {
 		}
 		CHECK_STATUS_BREAK(status);
 
-		// Loop over all intervals in the GTI collection.
-		double simtime = 0.;
-		int gtibin = 0;
-		do {
-			// Currently regarded interval.
-			double t0 = gti->start[gtibin];
-			double t1 = gti->stop[gtibin];
+		// Determine the number of threads for the detector chips.
+		int nworkers = par.nthreads;
+		if (nworkers <= 0) {
+			nworkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+		}
+		nworkers = MAX(MIN(nworkers, (int) nchips), 1);
+		if ((nworkers > 1) && (0 == fits_is_reentrant())) {
+			SIXT_WARNING("CFITSIO is not thread-safe, simulate the detector "
+					"chips in a single thread");
+			nworkers = 1;
+		}
+		// The cosmic ray background model draws from a single random
+		// number generator and keeps a common time, which are shared
+		// by all chips.
+		for (ii = 0; (ii < nchips) && (nworkers > 1); ii++) {
+			if ((1 == subinst[ii]->det->auxbackground)
+					&& (0 == subinst[ii]->det->ignore_bkg)) {
+				SIXT_WARNING("the cosmic ray background is shared by the "
+						"detector chips, simulate them in a single thread");
+				nworkers = 1;
+			}
+		}
 
-			// Set the start time for the detector models.
+		if (nworkers > 1) {
+			headas_chat(3, "using %d thread(s) for the detector chips ...\n",
+					nworkers);
+
+			WFIPipeline pipe;
+			pipe.par = &par;
+			pipe.subinst = subinst;
+			pipe.elf = elf;
+			pipe.patf = patf;
+			pipe.p2p = p2p;
+			pipe.gti = gti;
 			for (ii = 0; ii < nchips; ii++) {
-				setGenDetStartTime(subinst[ii]->det, t0);
+				initRndStream(&pipe.rs[ii], sixt_get_rng_seed(),
+						getRndStreamId(0, ii));
+			}
+
+			runWFIPipeline(&pipe, ac, srccat, &plf, &ilf, nworkers,
+					progressfile, &status);
+			CHECK_STATUS_BREAK(status);
+
+			// Progress output.
+			if (NULL == progressfile) {
+				headas_chat(2, "\r%.0lf %%\n", 100.);
+				fflush(NULL);
+			} else {
+				rewind(progressfile);
+				fprintf(progressfile, "%.2lf", 1.);
+				fflush(progressfile);
 			}
 
-			// Loop over photon generation and processing
-			// till the time of the photon exceeds the requested
-			// time interval.
+		} else {
+			// Loop over all intervals in the GTI collection.
+			double simtime = 0.;
+			int gtibin = 0;
 			do {
+				// Currently regarded interval.
+				double t0 = gti->start[gtibin];
+				double t1 = gti->stop[gtibin];
 
-				// Photon generation.
-				Photon ph;
-				int isph = phgen(ac, srccat, MAX_N_SIMPUT, t0, t1, par.MJDREF,
-						par.dt, subinst[0]->tel->fov_diameter, &ph, &status);
-				CHECK_STATUS_BREAK(status);
+				// Set the start time for the detector models.
+				for (ii = 0; ii < nchips; ii++) {
+					setGenDetStartTime(subinst[ii]->det, t0);
+				}
 
-				// If no photon has been generated, break the loop.
-				if (0 == isph)
-					break;
+				// Loop over photon generation and processing
+				// till the time of the photon exceeds the requested
+				// time interval.
+				do {
+
+					// Photon generation.
+					Photon ph;
+					int isph = phgen(ac, srccat, MAX_N_SIMPUT, t0, t1, par.MJDREF,
+							par.dt, subinst[0]->tel->fov_diameter, &ph, &status);
+					CHECK_STATUS_BREAK(status);
+
+					// If no photon has been generated, break the loop.
+					if (0 == isph)
+						break;
 
-				// Check if the photon still is within the requested
-				// exposre time.
-				assert(ph.time <= t1);
+					// Check if the photon still is within the requested
+					// exposre time.
+					assert(ph.time <= t1);
 
-				// If requested, write the photon to the output file.
-				if (NULL != plf) {
-					status = addPhoton2File(plf, &ph);
+					// If requested, write the photon to the output file.
+					if (NULL != plf) {
+						status = addPhoton2File(plf, &ph);
+						CHECK_STATUS_BREAK(status);
+					}
+
+					// Photon imaging.
+					Impact imp;
+					int isimg = phimg(subinst[0]->tel, ac, &ph, &imp, &status);
 					CHECK_STATUS_BREAK(status);
-				}
 
-				// Photon imaging.
-				Impact imp;
-				int isimg = phimg(subinst[0]->tel, ac, &ph, &imp, &status);
-				CHECK_STATUS_BREAK(status);
+					// If the photon is not imaged but lost in the optical system,
+					// continue with the next one.
+					if (0 == isimg)
+						continue;
 
-				// If the photon is not imaged but lost in the optical system,
-				// continue with the next one.
-				if (0 == isimg)
-					continue;
+					// If requested, write the impact to the output file.
+					if (NULL != ilf) {
+						addImpact2File(ilf, &imp, &status);
+						CHECK_STATUS_BREAK(status);
+					}
 
-				// If requested, write the impact to the output file.
-				if (NULL != ilf) {
-					addImpact2File(ilf, &imp, &status);
+					// Photon Detection.
+					for (ii = 0; ii < nchips; ii++) {
+						phdetGenDet(subinst[ii]->det, &imp, t1, &status);
+						CHECK_STATUS_BREAK(status);
+					}
 					CHECK_STATUS_BREAK(status);
-				}
 
-				// Photon Detection.
+					// Program progress output.
+					while ((unsigned int) ((ph.time - t0 + simtime) * 100.
+							/ totalsimtime) > progress) {
+						progress++;
+						if (NULL == progressfile) {
+							headas_chat(2, "\r%.0lf %%", progress * 1.);
+							fflush(NULL);
+						} else {
+							rewind(progressfile);
+							fprintf(progressfile, "%.2lf", progress * 1. / 100.);
+							fflush(progressfile);
+						}
+					}
+
+				} while (1);
+				CHECK_STATUS_BREAK(status);
+				// END of photon processing loop for the current interval.
+
+				// Clear the detectors.
 				for (ii = 0; ii < nchips; ii++) {
-					phdetGenDet(subinst[ii]->det, &imp, t1, &status);
+					phdetGenDet(subinst[ii]->det, NULL, t1, &status);
 					CHECK_STATUS_BREAK(status);
+					long jj;
+					for (jj = 0; jj < subinst[ii]->det->pixgrid->ywidth; jj++) {
+						GenDetClearLine(subinst[ii]->det, jj);
+					}
 				}
 				CHECK_STATUS_BREAK(status);
 
-				// Program progress output.
-				while ((unsigned int) ((ph.time - t0 + simtime) * 100.
-						/ totalsimtime) > progress) {
-					progress++;
-					if (NULL == progressfile) {
-						headas_chat(2, "\r%.0lf %%", progress * 1.);
-						fflush(NULL);
-					} else {
-						rewind(progressfile);
-						fprintf(progressfile, "%.2lf", progress * 1. / 100.);
-						fflush(progressfile);
-					}
-				}
+				// Proceed to the next GTI interval.
+				simtime += gti->stop[gtibin] - gti->start[gtibin];
+				gtibin++;
+				if (gtibin >= gti->ngti)
+					break;
 
 			} while (1);
 			CHECK_STATUS_BREAK(status);
-			// END of photon processing loop for the current interval.
+			// End of loop over the individual GTI intervals.
+
+			// Progress output.
+			if (NULL == progressfile) {
+				headas_chat(2, "\r%.0lf %%\n", 100.);
+				fflush(NULL);
+			} else {
+				rewind(progressfile);
+				fprintf(progressfile, "%.2lf", 1.);
+				fflush(progressfile);
+			}
 
-			// Clear the detectors.
+			// Use parallel computation via OpenMP.
+			// #pragma omp parallel for reduction(+:status)
 			for (ii = 0; ii < nchips; ii++) {
-				phdetGenDet(subinst[ii]->det, NULL, t1, &status);
-				CHECK_STATUS_BREAK(status);
-				long jj;
-				for (jj = 0; jj < subinst[ii]->det->pixgrid->ywidth; jj++) {
-					GenDetClearLine(subinst[ii]->det, jj);
+				status = EXIT_SUCCESS;
+
+				// Perform a pattern analysis, only if split events are simulated.
+				if (GS_NONE != subinst[ii]->det->split->type) {
+					// Pattern analysis.
+					headas_chat(3, "start event pattern analysis ...\n");
+					phpat(subinst[ii]->det, elf[ii], patf[ii], par.SkipInvalids,
+							&status);
+					//CHECK_STATUS_BREAK(status);
+				} else {
+					// If no split events are simulated, simply copy the event lists
+					// to pattern lists.
+					headas_chat(3, "copy events to pattern files ...\n");
+					copyEventFile(elf[ii], patf[ii],
+							subinst[ii]->det->threshold_event_lo_keV,
+							subinst[ii]->det->threshold_pattern_up_keV, &status);
+					//CHECK_STATUS_BREAK(status);
+					fits_update_key(patf[ii]->fptr, TSTRING, "EVTYPE", "PATTERN",
+							"event type", &status);
+					//CHECK_STATUS_BREAK(status);
 				}
+				//CHECK_STATUS_BREAK(status);
+				// END of loop over all events in the list.
 			}
 			CHECK_STATUS_BREAK(status);
 
-			// Proceed to the next GTI interval.
-			simtime += gti->stop[gtibin] - gti->start[gtibin];
-			gtibin++;
-			if (gtibin >= gti->ngti)
-				break;
-
-		} while (1);
-		CHECK_STATUS_BREAK(status);
-		// End of loop over the individual GTI intervals.
-
-		// Progress output.
-		if (NULL == progressfile) {
-			headas_chat(2, "\r%.0lf %%\n", 100.);
-			fflush(NULL);
-		} else {
-			rewind(progressfile);
-			fprintf(progressfile, "%.2lf", 1.);
-			fflush(progressfile);
-		}
-
-		// Use parallel computation via OpenMP.
-		// #pragma omp parallel for reduction(+:status)
-		for (ii = 0; ii < nchips; ii++) {
-			status = EXIT_SUCCESS;
-
-			// Perform a pattern analysis, only if split events are simulated.
-			if (GS_NONE != subinst[ii]->det->split->type) {
-				// Pattern analysis.
-				headas_chat(3, "start event pattern analysis ...\n");
-				phpat(subinst[ii]->det, elf[ii], patf[ii], par.SkipInvalids,
-						&status);
-				//CHECK_STATUS_BREAK(status);
-			} else {
-				// If no split events are simulated, simply copy the event lists
-				// to pattern lists.
-				headas_chat(3, "copy events to pattern files ...\n");
-				copyEventFile(elf[ii], patf[ii],
-						subinst[ii]->det->threshold_event_lo_keV,
-						subinst[ii]->det->threshold_pattern_up_keV, &status);
-				//CHECK_STATUS_BREAK(status);
-				fits_update_key(patf[ii]->fptr, TSTRING, "EVTYPE", "PATTERN",
-						"event type", &status);
-				//CHECK_STATUS_BREAK(status);
+			// Store the GTI extension in the event files.
+			for (ii = 0; ii < nchips; ii++) {
+				saveGTIExt(elf[ii]->fptr, "STDGTI", gti, &status);
+				CHECK_STATUS_BREAK(status);
 			}
-			//CHECK_STATUS_BREAK(status);
-			// END of loop over all events in the list.
-		}
-		CHECK_STATUS_BREAK(status);
-
-		// Store the GTI extension in the event files.
-		for (ii = 0; ii < nchips; ii++) {
-			saveGTIExt(elf[ii]->fptr, "STDGTI", gti, &status);
 			CHECK_STATUS_BREAK(status);
-		}
-		CHECK_STATUS_BREAK(status);
 
-		// Close files in order to save memory.
-		freePhotonFile(&plf, &status);
-		freeImpactFile(&ilf, &status);
-		CHECK_STATUS_BREAK(status);
-		for (ii = 0; ii < nchips; ii++) {
-			freeEventFile(&elf[ii], &status);
+			// Close files in order to save memory.
+			freePhotonFile(&plf, &status);
+			freeImpactFile(&ilf, &status);
+			CHECK_STATUS_BREAK(status);
+			for (ii = 0; ii < nchips; ii++) {
+				freeEventFile(&elf[ii], &status);
+				CHECK_STATUS_BREAK(status);
+			}
 			CHECK_STATUS_BREAK(status);
-		}
-		CHECK_STATUS_BREAK(status);
 
-		// Run the event projection.
-		headas_chat(3, "start sky projection ...\n");
-		for (ii = 0; ii < nchips; ii++) {
-			phproj(subinst[ii], ac, patf[ii], par.TSTART, par.Exposure,
-					&status);
+			// Run the event projection.
+			headas_chat(3, "start sky projection ...\n");
+			for (ii = 0; ii < nchips; ii++) {
+				phproj(subinst[ii], ac, patf[ii], par.TSTART, par.Exposure,
+						&status);
+				CHECK_STATUS_BREAK(status);
+			}
 			CHECK_STATUS_BREAK(status);
-		}
-		CHECK_STATUS_BREAK(status);
 
-		// Store the GTI extension in the pattern files.
-		for (ii = 0; ii < nchips; ii++) {
-			saveGTIExt(patf[ii]->fptr, "STDGTI", gti, &status);
+			// Store the GTI extension in the pattern files.
+			for (ii = 0; ii < nchips; ii++) {
+				saveGTIExt(patf[ii]->fptr, "STDGTI", gti, &status);
+				CHECK_STATUS_BREAK(status);
+			}
 			CHECK_STATUS_BREAK(status);
-		}
-		CHECK_STATUS_BREAK(status);
 
-		// Run PI correction on Pattern file.
-		for (ii = 0; ii < nchips; ii++) {
-			if (p2p[ii] != NULL) {
-				headas_chat(3, "start Pha2Pi correction ...\n");
-				pha2pi_correct_eventfile(patf[ii], p2p[ii],
-						subinst[ii]->filepath, subinst[ii]->det->rmf_filename,
-						&status);
-				CHECK_STATUS_BREAK_WITH_FITSERROR(status);
+			// Run PI correction on Pattern file.
+			for (ii = 0; ii < nchips; ii++) {
+				if (p2p[ii] != NULL) {
+					headas_chat(3, "start Pha2Pi correction ...\n");
+					pha2pi_correct_eventfile(patf[ii], p2p[ii],
+							subinst[ii]->filepath, subinst[ii]->det->rmf_filename,
+							&status);
+					CHECK_STATUS_BREAK_WITH_FITSERROR(status);
+				}
 			}
+			CHECK_STATUS_BREAK_WITH_FITSERROR(status);
 		}
 		CHECK_STATUS_BREAK_WITH_FITSERROR(status);
 
@@ -954,6 +1273,12 @@ int athenapwfisim_getpar(struct Parameters* const par) {
 	strcpy(par->ProgressFile, sbuffer);
 	free(sbuffer);
 
+	status = ape_trad_query_int("nthreads", &par->nthreads);
+	if (EXIT_SUCCESS != status) {
+		SIXT_ERROR("failed reading the number of threads");
+		return (status);
+	}
+
 	status = ape_trad_query_bool("clobber", &par->clobber);
 	if (EXIT_SUCCESS != status) {
 		SIXT_ERROR("failed reading the clobber parameter");
@@ -24,8 +24,11 @@
 #define ATHENAPWFISIM_H 1
 
 #include "sixt.h"
+#include <pthread.h>
+#include <unistd.h>
 
 #include "attitude.h"
+#include "batchpool.h"
 #include "eventfile.h"
 #include "geninst.h"
 #include "gentel.h"
@@ -38,6 +41,8 @@
 #include "pha2pilib.h"
 #include "phpat.h"
 #include "phproj.h"
+#include "rndgen.h"
+#include "rndstream.h"
 #include "sourcecatalog.h"
 #include "vector.h"
 
@@ -48,6 +53,16 @@
 /** Maximum number of SIMPUT catalogs. */
 #define MAX_N_SIMPUT 6
 
+/** Number of detector chips. */
+#define WFI_NCHIPS 4
+
+/** Number of impacts passed at once to a chip thread. */
+#define WFI_BATCHSIZE 1024
+
+/** Number of impact batches per chip thread, which can be filled in
+    advance. */
+#define WFI_NBATCHES 8
+
 
 struct Parameters {
   char Prefix[MAXFILENAME];
@@ -86,10 +101,41 @@ struct Parameters {
   /** Skip invalid patterns when producing the output file. */
   char SkipInvalids;
 
+  /** Number of threads processing the detector chips. If 1, all
+      chips are simulated in the main thread. */
+  int nthreads;
+
   char clobber;
 };
 
 
+/** Data shared by the photon generation and the chip threads. */
+typedef struct {
+  struct Parameters* par;
+
+  GenInst** subinst;
+  EventFile** elf;
+  EventFile** patf;
+  Pha2Pi** p2p;
+  GTI* gti;
+
+  /** Independent random number stream for each chip. */
+  RndStream rs[WFI_NCHIPS];
+
+} WFIPipeline;
+
+
+/** Thread processing the chips ii with ii%nworkers==id. */
+typedef struct {
+  WFIPipeline* pipe;
+  int id, nworkers;
+
+  /** Attitude shared by all threads. */
+  const Attitude* ac;
+
+} WFIWorker;
+
+
 int athenapwfisim_getpar(struct Parameters* const par);
 
 
@@ -48,11 +48,7 @@ int comarecon_main() {
   ReadEvent* ea=NULL;
   ReadEvent* ear=NULL;
   double* ReconImage1d=NULL;
-  double* EventImage1d=NULL;
-  fftw_complex* fftReconArray=NULL;
-  fftw_complex* fftEventArray=NULL;
-  fftw_complex* Multiply = NULL;
-  fftw_complex* fftInvMultiply=NULL;
+  FFTCorrelator* corr=NULL;
 
   int status=EXIT_SUCCESS; // Error status.
 
@@ -276,8 +272,13 @@ int comarecon_main() {
         //Get the 1d image of the reconstruction array -> needed by FFTW
        ReconImage1d=SaveReconArray1d(recon, &status);
 
-       //perform a fft with the ReconArray
-       fftReconArray=FFTOfArray_1d(ReconImage1d, Size1, Size2, -1);
+       //perform a fft with the ReconArray and set up the FFTs for the
+       //correlation with the EventArray, which are reused during IROS
+       if (par.nthreads<=0){
+	 par.nthreads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+       }
+       corr=newFFTCorrelator(ReconImage1d, Size1, Size2, par.nthreads, &status);
+       CHECK_STATUS_BREAK(status);
 
        //get repixeled mask from ReconArray, which is needed later for building the mask shadow during IROS
        //basic constructor for both,the whole re-pixeled mask&/shadow element
@@ -288,36 +289,23 @@ int comarecon_main() {
        do{ //search for sources as long as pixval is above certain value
 	 //run as long as threshold==1
 
-	 //Get the 1d image of the event array -> needed by FFTW
-	 EventImage1d=SaveEventArray1d(ea, &status);
 	 //Check whether the ReconArray and the EventArray have the same size
 	 if ((recon->naxis1 != ea->naxis1) || (recon->naxis2 != ea->naxis2)){
 	   printf ("Error: ReconArrray and EventArray must have the same size!\n");
 	   break;
 	 }
 
-	 //perform a fft with the EventArray
-	 fftEventArray=FFTOfArray_1d(EventImage1d, Size1, Size2, -1);
-
-       //multiply fftEventArray with komplex conjugate of fftReconArray
-       //Re-part: E(Re)*R(Re)+E(Im)*R(Im); Im-part: E(Re)*R(Im)-E(Im)*R(Re)
-       Multiply=(fftw_complex*) fftw_malloc(sizeof(fftw_complex)*(Size1*Size2));
-       for(ii=0; ii<Size1; ii++){
-	 for(jj=0; jj<Size2; jj++){
-	   Multiply[ii+Size1*jj][0]=fftEventArray[ii+Size1*jj][0]*fftReconArray[ii+Size1*jj][0]
-	     +fftEventArray[ii+Size1*jj][1]*(fftReconArray[ii+Size1*jj][1]);
-	   Multiply[ii+Size1*jj][1]=-fftEventArray[ii+Size1*jj][0]*(fftReconArray[ii+Size1*jj][1])
-	     +fftEventArray[ii+Size1*jj][1]*fftReconArray[ii+Size1*jj][0];
-	 }
-       }
+	 //Get the 1d image of the event array -> needed by FFTW
+	 CopyEventArray1d(ea, corr->image);
 
-       //Inverse FFT of Multilpy which already is of type fftw_complex
-       fftInvMultiply=FFTOfArray(Multiply, Size1, Size2, +1);
+       //correlate the EventArray with the ReconArray:
+       //FFTInv(FFT(EA)*FFT(RAcomplexconjugate))/(Size1*Size2)
+       correlateFFTArray(corr);
 
-       //save real part of inverse fft in sky image
+       //save result in sky image
        for(ii=0; ii<Size1; ii++){
 	 for(jj=0; jj<Size2; jj++){
-	   sky_pixels->pixel[ii][jj]=fftInvMultiply[ii+Size1*jj][0]/(Size1*Size2);
+	   sky_pixels->pixel[ii][jj]=corr->image[ii+Size1*jj];
 	 }
        }
 
@@ -357,9 +345,6 @@ int comarecon_main() {
        }else{
 	 threshold=2;
        }
-       FreeEventArray1d(EventImage1d);
-       fftw_free(fftEventArray);
-       fftw_free(fftInvMultiply);
         }while(threshold==1);
 
     //create FITS-file with all pix-coordinates
@@ -382,7 +367,7 @@ int comarecon_main() {
   FreeEventArray(ea);
   FreePixPositionList(position_list);
   FreeMaskShadow(mask_shadow,Size1);
-  fftw_free(fftReconArray);
+  freeFFTCorrelator(&corr);
   wcsfree(&wcs);
   wcsfree(&wcs2);
   free_SourceImage(sky_pixels);
@@ -470,6 +455,11 @@ int comarecon_getpar(struct Parameters* par)
   else if ((status=PILGetReal("Sigma", &par->Sigma))) {
     SIXT_ERROR("failed reading value of Sigma");
   }
+
+  //Read the number of threads.
+  else if ((status=PILGetInt("nthreads", &par->nthreads))) {
+    SIXT_ERROR("failed reading the number of threads");
+  }
   CHECK_STATUS_RET(status, status);
 
   return(status);
@@ -25,6 +25,7 @@
 
 
 #include "sixt.h"
+#include <unistd.h>
 #include "comaevent.h"
 #include "comaeventfile.h"
 #include "squarepixels.h"
@@ -74,6 +75,9 @@ struct Parameters {
 
   /**threshold for sources, factor to mulpilpy sigma with. */
   double Sigma;
+
+  /** Number of threads for the FFTs (0: number of processors). */
+  int nthreads;
 };
 
 
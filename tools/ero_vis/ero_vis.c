@@ -27,6 +27,7 @@
 #include "check_fov.h"
 #include "gti.h"
 #include "simput.h"
+#include "visibility.h"
 
 #define TOOLSUB ero_vis_main
 #include "headas_main.c"
@@ -46,11 +47,20 @@ struct Parameters {
 
   double TSTART;
   double Exposure;
+
+  /** Time step for sampling the attitude [s]. If 0, the exact
+      boundaries of the GTIs are determined. */
   double dt;
 
   /** [rad]. */
   double visibility_range;
 
+  /** Flag whether a separate GTI extension is produced for each
+      source in the SIMPUT catalog. */
+  int PerSource;
+
+  int nthreads;
+
   int clobber;
 };
 
@@ -58,6 +68,160 @@ struct Parameters {
 int ero_vis_getpar(struct Parameters *parameters);
 
 
+/** Insert the columns 'DATE-START', 'TIME-START', 'DATE-STOP', and
+    'TIME-STOP' into the GTI table in the current HDU. They contain the
+    same information as the columns 'START' and 'STOP', but are better
+    readable for human beings than large numbers of seconds. */
+static void addGTIDateColumns(fitsfile* const fptr,
+			      const GTI* const gti,
+			      int* const status)
+{
+  // Determine the number of rows.
+  long nrows;
+  fits_get_num_rows(fptr, &nrows, status);
+  CHECK_STATUS_VOID(*status);
+
+  // Insert the new columns.
+  fits_insert_col(fptr, 3, "DATE-START", "10A", status);
+  fits_insert_col(fptr, 4, "TIME-START", "8A", status);
+  fits_insert_col(fptr, 5, "DATE-STOP", "10A", status);
+  fits_insert_col(fptr, 6, "TIME-STOP", "8A", status);
+  CHECK_STATUS_VOID(*status);
+
+  // Loop over all entries.
+  char datebuffer[20], timebuffer[20];
+  char* datestr=datebuffer;
+  char* timestr=timebuffer;
+  long jj;
+  for (jj=0; jj<nrows; jj++) {
+    // Determine the start date and time.
+    sixt_get_date_time(gti->mjdref, gti->start[jj], datestr, timestr, status);
+    CHECK_STATUS_VOID(*status);
+    fits_write_col(fptr, TSTRING, 3, jj+1, 1, 1, &datestr, status);
+    fits_write_col(fptr, TSTRING, 4, jj+1, 1, 1, &timestr, status);
+    CHECK_STATUS_VOID(*status);
+
+    // Determine the stop date and time.
+    sixt_get_date_time(gti->mjdref, gti->stop[jj], datestr, timestr, status);
+    CHECK_STATUS_VOID(*status);
+    fits_write_col(fptr, TSTRING, 5, jj+1, 1, 1, &datestr, status);
+    fits_write_col(fptr, TSTRING, 6, jj+1, 1, 1, &timestr, status);
+    CHECK_STATUS_VOID(*status);
+  }
+}
+
+
+/** Determine the visibility GTIs of each source in the SIMPUT catalog
+    and store them in separate extensions 'GTI_<SRC_ID>' of the
+    output file. */
+static void saveSourceGTIs(const struct Parameters* const par,
+			   const Attitude* const ac,
+			   SimputCtlg* const cat,
+			   int* const status)
+{
+  long nsources=cat->nentries;
+  Vector* srcpos=NULL;
+  double* radius=NULL;
+  long* src_id=NULL;
+  GTI** gtis=NULL;
+  fitsfile* fptr=NULL;
+
+  do { // Beginning of ERROR handling loop.
+
+    srcpos=(Vector*)malloc(nsources*sizeof(Vector));
+    CHECK_NULL_BREAK(srcpos, *status,
+		     "memory allocation for source positions failed");
+    radius=(double*)malloc(nsources*sizeof(double));
+    CHECK_NULL_BREAK(radius, *status,
+		     "memory allocation for source positions failed");
+    src_id=(long*)malloc(nsources*sizeof(long));
+    CHECK_NULL_BREAK(src_id, *status,
+		     "memory allocation for source positions failed");
+
+    // Determine the positions and angular extensions of the sources.
+    long ii;
+    for (ii=0; ii<nsources; ii++) {
+      SimputSrc* src=getSimputSrc(cat, ii+1, status);
+      CHECK_STATUS_BREAK(*status);
+      srcpos[ii]=unit_vector(src->ra, src->dec);
+      src_id[ii]=src->src_id;
+      float extension=getSimputSrcExt(cat, src, 0., 0., status);
+      CHECK_STATUS_BREAK(*status);
+      radius[ii]=0.5*par->visibility_range+extension;
+    }
+    CHECK_STATUS_BREAK(*status);
+
+    headas_chat(3, "calculate the visibility GTIs of %ld sources ...\n",
+		nsources);
+    gtis=getVisibilityGTIs(ac, srcpos, radius, nsources, par->TSTART,
+			   par->TSTART+par->Exposure, par->nthreads, status);
+    CHECK_STATUS_BREAK(*status);
+
+    // Create the output file.
+    int exists;
+    fits_file_exists(par->GTIfile, &exists, status);
+    CHECK_STATUS_BREAK(*status);
+    if (0!=exists) {
+      if (0!=par->clobber) {
+	remove(par->GTIfile);
+      } else {
+	char msg[MAXMSG];
+	sprintf(msg, "file '%s' already exists", par->GTIfile);
+	SIXT_ERROR(msg);
+	*status=EXIT_FAILURE;
+	break;
+      }
+    }
+    fits_create_file(&fptr, par->GTIfile, status);
+    CHECK_STATUS_BREAK(*status);
+
+    // Store the GTIs of each source in a separate extension.
+    for (ii=0; ii<nsources; ii++) {
+      char extname[MAXMSG];
+      sprintf(extname, "GTI_%ld", src_id[ii]);
+      HDgti_write(fptr, gtis[ii], extname, "START", "STOP", status);
+      CHECK_STATUS_BREAK(*status);
+
+      // The new extension is the last one in the file. Move there
+      // directly instead of searching it by its name, which would
+      // scan all previous extensions.
+      int nhdus;
+      fits_get_num_hdus(fptr, &nhdus, status);
+      fits_movabs_hdu(fptr, nhdus, NULL, status);
+      CHECK_STATUS_BREAK(*status);
+
+      fits_update_key(fptr, TLONG, "SRC_ID", &src_id[ii],
+		      "source ID in the SIMPUT catalog", status);
+      double ra, dec;
+      calculate_ra_dec(srcpos[ii], &ra, &dec);
+      ra*=180./M_PI;
+      dec*=180./M_PI;
+      fits_update_key(fptr, TDOUBLE, "RA_OBJ", &ra,
+		      "source right ascension [deg]", status);
+      fits_update_key(fptr, TDOUBLE, "DEC_OBJ", &dec,
+		      "source declination [deg]", status);
+      CHECK_STATUS_BREAK(*status);
+
+      addGTIDateColumns(fptr, gtis[ii], status);
+      CHECK_STATUS_BREAK(*status);
+    }
+    CHECK_STATUS_BREAK(*status);
+
+  } while(0); // END of ERROR handling loop.
+
+  // Close the file.
+  if (NULL!=fptr) {
+    fits_close_file(fptr, status);
+  }
+
+  // Release memory.
+  freeVisibilityGTIs(&gtis, nsources);
+  if (NULL!=srcpos) free(srcpos);
+  if (NULL!=radius) free(radius);
+  if (NULL!=src_id) free(src_id);
+}
+
+
 int ero_vis_main()
 {
   // Program parameters.
@@ -68,16 +232,13 @@ int ero_vis_main()
   GTI* gti=NULL;
   fitsfile* fptr=NULL;
 
-  char* datestr=NULL;
-  char* timestr=NULL;
-
   // Error status.
   int status=EXIT_SUCCESS;
 
 
   // Register HEATOOL:
   set_toolname("ero_vis");
-  set_toolversion("0.09");
+  set_toolversion("0.10");
 
 
   do { // Beginning of the ERROR handling loop.
@@ -105,6 +266,21 @@ int ero_vis_main()
     }
     // Otherwise use the specified RA and Dec source position.
 
+    // Determine separate GTIs for each source in the catalog.
+    if (0!=par.PerSource) {
+      if (NULL==cat) {
+	SIXT_ERROR("separate GTIs for each source require a SIMPUT catalog");
+	status=EXIT_FAILURE;
+	break;
+      }
+      if (par.dt>0.) {
+	SIXT_WARNING("separate GTIs for each source are always computed "
+		     "with exact boundaries, dt is ignored");
+      }
+      saveSourceGTIs(&par, ac, cat, &status);
+      break;
+    }
+
     // Set up a new GTI collection.
     gti=newGTI(&status);
     CHECK_STATUS_BREAK(status);
@@ -195,11 +371,28 @@ int ero_vis_main()
 
     headas_chat(3, "calculate the visibility GTIs ...\n");
 
+    if (par.dt<=0.) {
+      // Determine the exact entry and exit times of the search cone.
+      GTI** vis=getVisibilityGTIs(ac, &refpos, &search_angle, 1, par.TSTART,
+				  par.TSTART+par.Exposure, par.nthreads,
+				  &status);
+      CHECK_STATUS_BREAK(status);
+      int jj;
+      for (jj=0; jj<vis[0]->ngti; jj++) {
+	appendGTI(gti, vis[0]->start[jj], vis[0]->stop[jj], &status);
+	CHECK_STATUS_BREAK(status);
+      }
+      freeVisibilityGTIs(&vis, 1);
+      CHECK_STATUS_BREAK(status);
+    }
+
     // LOOP over the given time interval in steps of dt.
     double time;
     double start=0;
     double ininterval=0;
-    for (time=par.TSTART; time<par.TSTART+par.Exposure; time+=par.dt) {
+    for (time=par.TSTART;
+	 (par.dt>0.)&&(time<par.TSTART+par.Exposure);
+	 time+=par.dt) {
 
     	// Print the current time (program status information for the user).
     	headas_chat(5, "\rtime: %.1lf s ", time);
@@ -246,39 +439,7 @@ int ero_vis_main()
     fits_movabs_hdu(fptr, 2, &hdutype, &status);
     CHECK_STATUS_BREAK(status);
 
-    // Determine the number of rows.
-    long nrows;
-    fits_get_num_rows(fptr, &nrows, &status);
-    CHECK_STATUS_BREAK(status);
-
-    // Insert the new columns.
-    fits_insert_col(fptr, 3, "DATE-START", "10A", &status);
-    fits_insert_col(fptr, 4, "TIME-START", "8A", &status);
-    fits_insert_col(fptr, 5, "DATE-STOP", "10A", &status);
-    fits_insert_col(fptr, 6, "TIME-STOP", "8A", &status);
-    CHECK_STATUS_BREAK(status);
-
-    // Loop over all entries.
-    datestr=(char*)malloc(20*sizeof(char));
-    CHECK_NULL_BREAK(datestr, status, "memory allocation for string buffer failed");
-    timestr=(char*)malloc(20*sizeof(char));
-    CHECK_NULL_BREAK(datestr, status, "memory allocation for string buffer failed");
-    long jj;
-    for (jj=0; jj<nrows; jj++) {
-      // Determine the start date and time.
-      sixt_get_date_time(gti->mjdref, gti->start[jj], datestr, timestr, &status);
-      CHECK_STATUS_BREAK(status);
-      fits_write_col(fptr, TSTRING, 3, jj+1, 1, 1, &datestr, &status);
-      fits_write_col(fptr, TSTRING, 4, jj+1, 1, 1, &timestr, &status);
-      CHECK_STATUS_BREAK(status);
-
-      // Determine the stop date and time.
-      sixt_get_date_time(gti->mjdref, gti->stop[jj], datestr, timestr, &status);
-      CHECK_STATUS_BREAK(status);
-      fits_write_col(fptr, TSTRING, 5, jj+1, 1, 1, &datestr, &status);
-      fits_write_col(fptr, TSTRING, 6, jj+1, 1, 1, &timestr, &status);
-      CHECK_STATUS_BREAK(status);
-    }
+    addGTIDateColumns(fptr, gti, &status);
     CHECK_STATUS_BREAK(status);
 
     // Close the file.
@@ -298,8 +459,6 @@ int ero_vis_main()
   }
 
   // Release memory.
-  if (NULL!=datestr) free(datestr);
-  if (NULL!=timestr) free(timestr);
   freeAttitude(&ac);
   freeGTI(&gti);
 
@@ -334,6 +493,8 @@ int ero_vis_getpar(struct Parameters *par)
   query_simput_parameter_double("TSTART", &par->TSTART, &status);
   query_simput_parameter_double("Exposure", &par->Exposure, &status);
   query_simput_parameter_double("dt", &par->dt, &status);
+  query_simput_parameter_bool("PerSource", &par->PerSource, &status);
+  query_simput_parameter_int("nthreads", &par->nthreads, &status);
   query_simput_parameter_bool("clobber", &par->clobber, &status);
 
   return(status);
@@ -85,6 +85,248 @@ void free_cumulARF(float** arf, long nener) {
 	}
 }
 
+/** Process the photons of one batch and finalize the detectors at the
+    end of a GTI interval. */
+static void processEroBatch(void* const data, const int iworker,
+		BatchPoolBatch* const batch, int* const status) {
+	EroWorker* worker = &(((EroWorker*) data)[iworker]);
+	EroPipeline* pipe = worker->pipe;
+
+	long kk;
+	for (kk = 0; kk < batch->nitems; kk++) {
+		int tel = batch->unit[kk];
+		Photon* ph = &(((Photon*) batch->items)[kk]);
+
+		// All random numbers of a telescope module are taken from its
+		// own stream.
+		sixt_set_thread_rndstream(&(pipe->rs[tel]));
+
+		// If requested, write the photon to the output file.
+		if (NULL != pipe->plf[tel]) {
+			*status = addPhoton2File(pipe->plf[tel], ph);
+			CHECK_STATUS_VOID(*status);
+		}
+
+		// Photon imaging.
+		Impact imp;
+		int isimg = phimgCursor(pipe->subinst[tel]->tel, worker->ac,
+				&(worker->attcursor), ph, &imp, status);
+		CHECK_STATUS_VOID(*status);
+		if (0 == isimg)
+			continue;
+
+		// If requested, write the impact to the output file.
+		if (NULL != pipe->ilf[tel]) {
+			addImpact2File(pipe->ilf[tel], &imp, status);
+			CHECK_STATUS_VOID(*status);
+		}
+
+		// Photon Detection.
+		phdetGenDet(pipe->subinst[tel]->det, &imp, batch->t1, status);
+		CHECK_STATUS_VOID(*status);
+	}
+
+	if (0 == batch->endgti)
+		return;
+
+	// Clear the detectors and prepare them for the next interval.
+	int tel;
+	for (tel = worker->id; tel < NUM_TELS; tel += worker->nworkers) {
+		sixt_set_thread_rndstream(&(pipe->rs[tel]));
+		GenDet* det = pipe->subinst[tel]->det;
+		phdetGenDet(det, NULL, batch->t1, status);
+		CHECK_STATUS_VOID(*status);
+		long jj;
+		for (jj = 0; jj < det->pixgrid->ywidth; jj++) {
+			GenDetClearLine(det, jj);
+		}
+		if (0 != batch->nextgti) {
+			setGenDetStartTime(det, batch->t0next);
+		}
+	}
+}
+
+/** Pattern analysis, sky projection, and PI correction of one
+    telescope module after the end of the simulation. */
+static void postprocessEroTel(EroWorker* const worker, const int tel,
+		int* const status) {
+	EroPipeline* pipe = worker->pipe;
+	GenInst* inst = pipe->subinst[tel];
+
+	sixt_set_thread_rndstream(&(pipe->rs[tel]));
+
+	// Perform a pattern analysis, only if split events are simulated.
+	if (GS_NONE != inst->det->split->type) {
+		phpat(inst->det, pipe->elf[tel], pipe->patf[tel],
+				pipe->par->SkipInvalids, status);
+		CHECK_STATUS_VOID(*status);
+	} else {
+		// If no split events are simulated, simply copy the event lists
+		// to pattern lists.
+		copyEventFile(pipe->elf[tel], pipe->patf[tel],
+				inst->det->threshold_event_lo_keV,
+				inst->det->threshold_pattern_up_keV, status);
+		CHECK_STATUS_VOID(*status);
+		fits_update_key(pipe->patf[tel]->fptr, TSTRING, "EVTYPE", "PATTERN",
+				"event type", status);
+		CHECK_STATUS_VOID(*status);
+	}
+
+	// Store the GTI extension in the event file and close the files,
+	// which are not needed any more.
+	saveGTIExt(pipe->elf[tel]->fptr, "STDGTI", pipe->gti, status);
+	CHECK_STATUS_VOID(*status);
+	freePhotonFile(&(pipe->plf[tel]), status);
+	freeImpactFile(&(pipe->ilf[tel]), status);
+	freeEventFile(&(pipe->elf[tel]), status);
+	CHECK_STATUS_VOID(*status);
+
+	// Run the event projection.
+	phproj(inst, worker->ac, pipe->patf[tel], pipe->tstart,
+			pipe->tstop - pipe->tstart, status);
+	CHECK_STATUS_VOID(*status);
+
+	// Store the GTI extension in the pattern file.
+	saveGTIExt(pipe->patf[tel]->fptr, "STDGTI", pipe->gti, status);
+	CHECK_STATUS_VOID(*status);
+
+	// Run PI correction on the pattern file.
+	if (NULL != pipe->p2p[tel]) {
+		pha2pi_correct_eventfile(pipe->patf[tel], pipe->p2p[tel],
+				inst->filepath, inst->det->rmf_filename, status);
+		CHECK_STATUS_VOID(*status);
+	}
+}
+
+/** Post-processing of the telescope modules of a worker thread
+    after the end of the simulation. The modules are independent of
+    each other. */
+static void finishEroWorker(void* const data, const int iworker,
+		int* const status) {
+	EroWorker* worker = &(((EroWorker*) data)[iworker]);
+	int tel;
+	for (tel = worker->id; tel < NUM_TELS; tel += worker->nworkers) {
+		postprocessEroTel(worker, tel, status);
+		CHECK_STATUS_VOID(*status);
+	}
+}
+
+/** Simulate the telescope modules in nworkers threads. The photons
+    are generated and assigned to the telescope modules in the calling
+    thread and passed in batches to the worker threads. Each module
+    uses its own random number stream, such that the result does not
+    depend on the number of threads. */
+static void runEroPipeline(EroPipeline* const pipe, Attitude* const ac,
+		SourceCatalog** const srccat, const float fov7,
+		float** const cumulARF, const struct ARF* const arf7,
+		const int nworkers, FILE* const progressfile, int* const status) {
+
+	EroWorker worker[NUM_TELS];
+	BatchPool* pool = NULL;
+
+	int ii;
+	for (ii = 0; ii < nworkers; ii++) {
+		worker[ii].pipe = pipe;
+		worker[ii].id = ii;
+		worker[ii].nworkers = nworkers;
+		worker[ii].ac = ac;
+		worker[ii].attcursor = 0;
+	}
+
+	// Set the start time for the detector models.
+	for (ii = 0; ii < NUM_TELS; ii++) {
+		setGenDetStartTime(pipe->subinst[ii]->det, pipe->gti->start[0]);
+	}
+
+	do { // Beginning of ERROR HANDLING Loop.
+
+		pool = newBatchPool(nworkers, sizeof(Photon), EROSIM_BATCHSIZE,
+				EROSIM_NBATCHES, &processEroBatch, &finishEroWorker, worker,
+				status);
+		CHECK_STATUS_BREAK(*status);
+
+	} while (0); // END of ERROR HANDLING Loop.
+
+	// Simulation progress status (running from 0 to 100).
+	unsigned int progress = 0;
+	double totalsimtime = sumGTI(pipe->gti);
+
+	// Loop over all intervals in the GTI collection.
+	double simtime = 0.;
+	int gtibin = 0;
+	int failed = 0;
+	while (EXIT_SUCCESS == *status) {
+		// Currently regarded interval.
+		double t0 = pipe->gti->start[gtibin];
+		double t1 = pipe->gti->stop[gtibin];
+
+		do {
+			// Photon generation.
+			Photon ph;
+			int isph = phgen(ac, srccat, MAX_N_SIMPUT, t0, t1,
+					pipe->par->MJDREF, pipe->par->dt, fov7, &ph, status);
+			CHECK_STATUS_BREAK(*status);
+
+			// If no photon has been generated, break the loop.
+			if (0 == isph)
+				break;
+
+			// Check if the photon still is within the requested
+			// exposure time.
+			assert(ph.time <= t1);
+
+			// Randomly assign the photon to one of the 7 sub-telescopes.
+			int tel = get_telid_arf(cumulARF, ph.energy,
+					arf7->NumberEnergyBins, arf7->LowEnergy, NUM_TELS, status);
+			CHECK_STATUS_BREAK(*status);
+			assert(tel < NUM_TELS);
+
+			// Add the photon to the batch of the respective worker.
+			failed |= addBatchPoolItem(pool, tel % nworkers, &ph, tel, t1);
+			if (0 != failed)
+				break;
+
+			// Program progress output.
+			while ((unsigned int) ((ph.time - t0 + simtime) * 100.
+					/ totalsimtime) > progress) {
+				progress++;
+				if (NULL == progressfile) {
+					headas_chat(2, "\r%.0lf %%", progress * 1.);
+					fflush(NULL);
+				} else {
+					rewind(progressfile);
+					fprintf(progressfile, "%.2lf", progress * 1. / 100.);
+					fflush(progressfile);
+				}
+			}
+
+		} while (1);
+		if ((EXIT_SUCCESS != *status) || (0 != failed))
+			break;
+
+		// Proceed to the next GTI interval.
+		simtime += t1 - t0;
+		gtibin++;
+
+		// Let the workers finalize the detectors at the end of the
+		// interval.
+		int nextgti = (gtibin < pipe->gti->ngti);
+		failed |= endBatchPoolInterval(pool, t1, nextgti,
+				nextgti ? pipe->gti->start[gtibin] : 0.);
+		if ((0 != failed) || (0 == nextgti))
+			break;
+	}
+
+	if (NULL != pool) {
+		// Terminate the workers in case of an error.
+		stopBatchPool(pool);
+
+		// Wait for the pattern analysis and projection in the workers.
+		joinBatchPool(pool, status);
+		freeBatchPool(&pool);
+	}
+}
+
 int erosim_main() {
 	// Program parameters.
 	struct Parameters par;
@@ -693,192 +935,252 @@ int erosim_main() {
 		}
 		CHECK_STATUS_BREAK(status);
 
-		// Loop over all intervals in the GTI collection.
-		double simtime = 0.;
-		int gtibin = 0;
-		do {
-			// Currently regarded interval.
-			double t0 = gti->start[gtibin];
-			double t1 = gti->stop[gtibin];
+		// Determine the number of threads for the telescope modules.
+		int nworkers = par.nthreads;
+		if (nworkers <= 0) {
+			nworkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+		}
+		nworkers = MAX(MIN(nworkers, NUM_TELS), 1);
+		if ((nworkers > 1) && (0 == fits_is_reentrant())) {
+			SIXT_WARNING("CFITSIO is not thread-safe, simulate the telescope "
+					"modules in a single thread");
+			nworkers = 1;
+		}
+		// The cosmic ray background model draws from a single random
+		// number generator and keeps a common time, which are shared
+		// by all telescope modules.
+		for (ii = 0; (ii < NUM_TELS) && (nworkers > 1); ii++) {
+			if ((1 == subinst[ii]->det->auxbackground)
+					&& (0 == subinst[ii]->det->ignore_bkg)) {
+				SIXT_WARNING("the cosmic ray background is shared by the "
+						"telescope modules, simulate them in a single thread");
+				nworkers = 1;
+			}
+		}
 
-			// Set the start time for the detector models.
-			for (ii = 0; ii < 7; ii++) {
-				setGenDetStartTime(subinst[ii]->det, t0);
+		if (nworkers > 1) {
+			headas_chat(3, "using %d thread(s) for the telescope modules ...\n",
+					nworkers);
+
+			EroPipeline pipe;
+			pipe.par = &par;
+			pipe.subinst = subinst;
+			pipe.plf = plf;
+			pipe.ilf = ilf;
+			pipe.elf = elf;
+			pipe.patf = patf;
+			pipe.p2p = p2p;
+			pipe.gti = gti;
+			pipe.tstart = tstart;
+			pipe.tstop = tstop;
+			for (ii = 0; ii < NUM_TELS; ii++) {
+				initRndStream(&pipe.rs[ii], sixt_get_rng_seed(),
+						getRndStreamId(0, ii));
+			}
+
+			runEroPipeline(&pipe, ac, srccat, fov7, cumulARF, arf7, nworkers,
+					progressfile, &status);
+			CHECK_STATUS_BREAK(status);
+
+			// Progress output.
+			if (NULL == progressfile) {
+				headas_chat(2, "\r%.0lf %%\n", 100.);
+				fflush(NULL);
+			} else {
+				rewind(progressfile);
+				fprintf(progressfile, "%.2lf", 1.);
+				fflush(progressfile);
 			}
 
-			// Loop over photon generation and processing
-			// till the time of the photon exceeds the requested
-			// time interval.
+		} else {
+			// Loop over all intervals in the GTI collection.
+			double simtime = 0.;
+			int gtibin = 0;
 			do {
+				// Currently regarded interval.
+				double t0 = gti->start[gtibin];
+				double t1 = gti->stop[gtibin];
 
-				// Photon generation.
-				Photon ph;
-				int isph = phgen(ac, srccat, MAX_N_SIMPUT, t0, t1, par.MJDREF,
-						par.dt, fov7, &ph, &status);
-				CHECK_STATUS_BREAK(status);
+				// Set the start time for the detector models.
+				for (ii = 0; ii < 7; ii++) {
+					setGenDetStartTime(subinst[ii]->det, t0);
+				}
 
-				// If no photon has been generated, break the loop.
-				if (0 == isph)
-					break;
+				// Loop over photon generation and processing
+				// till the time of the photon exceeds the requested
+				// time interval.
+				do {
 
-				// Check if the photon still is within the requested
-				// exposure time.
-				assert(ph.time <= t1);
+					// Photon generation.
+					Photon ph;
+					int isph = phgen(ac, srccat, MAX_N_SIMPUT, t0, t1, par.MJDREF,
+							par.dt, fov7, &ph, &status);
+					CHECK_STATUS_BREAK(status);
 
-				// Randomly assign the photon to one of the 7 sub-telescopes.
-				//ii=(unsigned int)(sixt_get_random_number(&status)*7.0);
-				//CHECK_STATUS_BREAK(status);
+					// If no photon has been generated, break the loop.
+					if (0 == isph)
+						break;
 
-				// Randomly assign the photon to one of the 7 sub-telescopes.
-				// TODO: need to change this (as ARFs are and can be different)
-				ii = get_telid_arf(cumulARF, ph.energy, arf7->NumberEnergyBins,
-						arf7->LowEnergy, NUM_TELS, &status);
-				CHECK_STATUS_BREAK(status);
+					// Check if the photon still is within the requested
+					// exposure time.
+					assert(ph.time <= t1);
 
-				assert(ii < NUM_TELS);
+					// Randomly assign the photon to one of the 7 sub-telescopes.
+					//ii=(unsigned int)(sixt_get_random_number(&status)*7.0);
+					//CHECK_STATUS_BREAK(status);
 
-				// If requested, write the photon to the output file.
-				if (NULL != plf[ii]) {
-					status = addPhoton2File(plf[ii], &ph);
+					// Randomly assign the photon to one of the 7 sub-telescopes.
+					// TODO: need to change this (as ARFs are and can be different)
+					ii = get_telid_arf(cumulARF, ph.energy, arf7->NumberEnergyBins,
+							arf7->LowEnergy, NUM_TELS, &status);
 					CHECK_STATUS_BREAK(status);
-				}
 
-				// Photon imaging.
-				Impact imp;
-				int isimg = phimg(subinst[ii]->tel, ac, &ph, &imp, &status);
-				CHECK_STATUS_BREAK(status);
+					assert(ii < NUM_TELS);
 
-				// If the photon is not imaged but lost in the optical system,
-				// continue with the next one.
-				if (0 == isimg)
-					continue;
+					// If requested, write the photon to the output file.
+					if (NULL != plf[ii]) {
+						status = addPhoton2File(plf[ii], &ph);
+						CHECK_STATUS_BREAK(status);
+					}
 
-				// If requested, write the impact to the output file.
-				if (NULL != ilf[ii]) {
-					addImpact2File(ilf[ii], &imp, &status);
+					// Photon imaging.
+					Impact imp;
+					int isimg = phimg(subinst[ii]->tel, ac, &ph, &imp, &status);
 					CHECK_STATUS_BREAK(status);
-				}
 
-				// Photon Detection.
-				phdetGenDet(subinst[ii]->det, &imp, t1, &status);
+					// If the photon is not imaged but lost in the optical system,
+					// continue with the next one.
+					if (0 == isimg)
+						continue;
+
+					// If requested, write the impact to the output file.
+					if (NULL != ilf[ii]) {
+						addImpact2File(ilf[ii], &imp, &status);
+						CHECK_STATUS_BREAK(status);
+					}
+
+					// Photon Detection.
+					phdetGenDet(subinst[ii]->det, &imp, t1, &status);
+					CHECK_STATUS_BREAK(status);
+
+					// Program progress output.
+					while ((unsigned int) ((ph.time - t0 + simtime) * 100.
+							/ totalsimtime) > progress) {
+						progress++;
+						if (NULL == progressfile) {
+							headas_chat(2, "\r%.0lf %%", progress * 1.);
+							fflush(NULL);
+						} else {
+							rewind(progressfile);
+							fprintf(progressfile, "%.2lf", progress * 1. / 100.);
+							fflush(progressfile);
+						}
+					}
+
+				} while (1);
 				CHECK_STATUS_BREAK(status);
+				// END of photon processing loop for the current interval.
 
-				// Program progress output.
-				while ((unsigned int) ((ph.time - t0 + simtime) * 100.
-						/ totalsimtime) > progress) {
-					progress++;
-					if (NULL == progressfile) {
-						headas_chat(2, "\r%.0lf %%", progress * 1.);
-						fflush(NULL);
-					} else {
-						rewind(progressfile);
-						fprintf(progressfile, "%.2lf", progress * 1. / 100.);
-						fflush(progressfile);
+				// Clear the detectors.
+				for (ii = 0; ii < 7; ii++) {
+					phdetGenDet(subinst[ii]->det, NULL, t1, &status);
+					CHECK_STATUS_BREAK(status);
+					long jj;
+					for (jj = 0; jj < subinst[ii]->det->pixgrid->ywidth; jj++) {
+						GenDetClearLine(subinst[ii]->det, jj);
 					}
 				}
+				CHECK_STATUS_BREAK(status);
+
+				// Proceed to the next GTI interval.
+				simtime += gti->stop[gtibin] - gti->start[gtibin];
+				gtibin++;
+				if (gtibin >= gti->ngti)
+					break;
 
 			} while (1);
 			CHECK_STATUS_BREAK(status);
-			// END of photon processing loop for the current interval.
+			// End of loop over the individual GTI intervals.
+
+			// Progress output.
+			if (NULL == progressfile) {
+				headas_chat(2, "\r%.0lf %%\n", 100.);
+				fflush(NULL);
+			} else {
+				rewind(progressfile);
+				fprintf(progressfile, "%.2lf", 1.);
+				fflush(progressfile);
+			}
 
-			// Clear the detectors.
+			// Use parallel computation via OpenMP.
+			// #pragma omp parallel for reduction(+:status)
 			for (ii = 0; ii < 7; ii++) {
-				phdetGenDet(subinst[ii]->det, NULL, t1, &status);
-				CHECK_STATUS_BREAK(status);
-				long jj;
-				for (jj = 0; jj < subinst[ii]->det->pixgrid->ywidth; jj++) {
-					GenDetClearLine(subinst[ii]->det, jj);
+				status = EXIT_SUCCESS;
+				// Perform a pattern analysis, only if split events are simulated.
+				if (GS_NONE != subinst[ii]->det->split->type) {
+					// Pattern analysis.
+					headas_chat(3, "start event pattern analysis ...\n");
+					phpat(subinst[ii]->det, elf[ii], patf[ii], par.SkipInvalids,
+							&status);
+					//CHECK_STATUS_BREAK(status);
+				} else {
+					// If no split events are simulated, simply copy the event lists
+					// to pattern lists.
+					headas_chat(3, "copy events to pattern files ...\n");
+					copyEventFile(elf[ii], patf[ii],
+							subinst[ii]->det->threshold_event_lo_keV,
+							subinst[ii]->det->threshold_pattern_up_keV, &status);
+					//CHECK_STATUS_BREAK(status);
+					fits_update_key(patf[ii]->fptr, TSTRING, "EVTYPE", "PATTERN",
+							"event type", &status);
+					//CHECK_STATUS_BREAK(status);
 				}
 			}
 			CHECK_STATUS_BREAK(status);
 
-			// Proceed to the next GTI interval.
-			simtime += gti->stop[gtibin] - gti->start[gtibin];
-			gtibin++;
-			if (gtibin >= gti->ngti)
-				break;
-
-		} while (1);
-		CHECK_STATUS_BREAK(status);
-		// End of loop over the individual GTI intervals.
-
-		// Progress output.
-		if (NULL == progressfile) {
-			headas_chat(2, "\r%.0lf %%\n", 100.);
-			fflush(NULL);
-		} else {
-			rewind(progressfile);
-			fprintf(progressfile, "%.2lf", 1.);
-			fflush(progressfile);
-		}
-
-		// Use parallel computation via OpenMP.
-		// #pragma omp parallel for reduction(+:status)
-		for (ii = 0; ii < 7; ii++) {
-			status = EXIT_SUCCESS;
-			// Perform a pattern analysis, only if split events are simulated.
-			if (GS_NONE != subinst[ii]->det->split->type) {
-				// Pattern analysis.
-				headas_chat(3, "start event pattern analysis ...\n");
-				phpat(subinst[ii]->det, elf[ii], patf[ii], par.SkipInvalids,
-						&status);
-				//CHECK_STATUS_BREAK(status);
-			} else {
-				// If no split events are simulated, simply copy the event lists
-				// to pattern lists.
-				headas_chat(3, "copy events to pattern files ...\n");
-				copyEventFile(elf[ii], patf[ii],
-						subinst[ii]->det->threshold_event_lo_keV,
-						subinst[ii]->det->threshold_pattern_up_keV, &status);
-				//CHECK_STATUS_BREAK(status);
-				fits_update_key(patf[ii]->fptr, TSTRING, "EVTYPE", "PATTERN",
-						"event type", &status);
-				//CHECK_STATUS_BREAK(status);
+			// Store the GTI extension in the event files.
+			for (ii = 0; ii < 7; ii++) {
+				saveGTIExt(elf[ii]->fptr, "STDGTI", gti, &status);
+				CHECK_STATUS_BREAK(status);
 			}
-		}
-		CHECK_STATUS_BREAK(status);
-
-		// Store the GTI extension in the event files.
-		for (ii = 0; ii < 7; ii++) {
-			saveGTIExt(elf[ii]->fptr, "STDGTI", gti, &status);
 			CHECK_STATUS_BREAK(status);
-		}
-		CHECK_STATUS_BREAK(status);
 
-		// Close files in order to save memory.
-		for (ii = 0; ii < 7; ii++) {
-			freePhotonFile(&plf[ii], &status);
-			freeImpactFile(&ilf[ii], &status);
-			freeEventFile(&elf[ii], &status);
-		}
-		CHECK_STATUS_BREAK(status);
+			// Close files in order to save memory.
+			for (ii = 0; ii < 7; ii++) {
+				freePhotonFile(&plf[ii], &status);
+				freeImpactFile(&ilf[ii], &status);
+				freeEventFile(&elf[ii], &status);
+			}
+			CHECK_STATUS_BREAK(status);
 
-		// Run the event projection.
-		headas_chat(3, "start sky projection ...\n");
-		for (ii = 0; ii < 7; ii++) {
-			phproj(subinst[ii], ac, patf[ii], tstart, tstop - tstart, &status);
+			// Run the event projection.
+			headas_chat(3, "start sky projection ...\n");
+			for (ii = 0; ii < 7; ii++) {
+				phproj(subinst[ii], ac, patf[ii], tstart, tstop - tstart, &status);
+				CHECK_STATUS_BREAK(status);
+			}
 			CHECK_STATUS_BREAK(status);
-		}
-		CHECK_STATUS_BREAK(status);
 
-		// Store the GTI extension in the pattern files.
-		for (ii = 0; ii < 7; ii++) {
-			saveGTIExt(patf[ii]->fptr, "STDGTI", gti, &status);
+			// Store the GTI extension in the pattern files.
+			for (ii = 0; ii < 7; ii++) {
+				saveGTIExt(patf[ii]->fptr, "STDGTI", gti, &status);
+				CHECK_STATUS_BREAK(status);
+			}
 			CHECK_STATUS_BREAK(status);
-		}
-		CHECK_STATUS_BREAK(status);
 
-		// Run PI correction on Pattern file.
-		for (ii = 0; ii < 7; ii++) {
-			if (p2p[ii] != NULL) {
-				headas_chat(3, "start Pha2Pi correction ...\n");
-				pha2pi_correct_eventfile(patf[ii], p2p[ii],
-						subinst[ii]->filepath, subinst[ii]->det->rmf_filename,
-						&status);
-				CHECK_STATUS_BREAK_WITH_FITSERROR(status);
+			// Run PI correction on Pattern file.
+			for (ii = 0; ii < 7; ii++) {
+				if (p2p[ii] != NULL) {
+					headas_chat(3, "start Pha2Pi correction ...\n");
+					pha2pi_correct_eventfile(patf[ii], p2p[ii],
+							subinst[ii]->filepath, subinst[ii]->det->rmf_filename,
+							&status);
+					CHECK_STATUS_BREAK_WITH_FITSERROR(status);
+				}
 			}
+			CHECK_STATUS_BREAK_WITH_FITSERROR(status);
+
 		}
-		CHECK_STATUS_BREAK_WITH_FITSERROR(status);
 
 		// --- End of simulation process ---
 
@@ -1170,6 +1472,12 @@ int erosim_getpar(struct Parameters* const par) {
 	strcpy(par->ProgressFile, sbuffer);
 	free(sbuffer);
 
+	status = ape_trad_query_int("nthreads", &par->nthreads);
+	if (EXIT_SUCCESS != status) {
+		SIXT_ERROR("failed reading the number of threads");
+		return (status);
+	}
+
 	status = ape_trad_query_bool("clobber", &par->clobber);
 	if (EXIT_SUCCESS != status) {
 		SIXT_ERROR("failed reading the clobber parameter");
@@ -25,7 +25,11 @@
 
 #include "sixt.h"
 
+#include <pthread.h>
+#include <unistd.h>
+
 #include "attitude.h"
+#include "batchpool.h"
 #include "eventfile.h"
 #include "geninst.h"
 #include "gentel.h"
@@ -38,6 +42,8 @@
 #include "pha2pilib.h"
 #include "phpat.h"
 #include "phproj.h"
+#include "rndgen.h"
+#include "rndstream.h"
 #include "sourcecatalog.h"
 #include "vector.h"
 
@@ -50,6 +56,13 @@
 
 #define NUM_TELS 7
 
+/** Number of photons passed at once from the photon generation to the
+    threads processing the telescope modules. */
+#define EROSIM_BATCHSIZE (1024)
+
+/** Maximum number of photon batches waiting for a worker thread. */
+#define EROSIM_NBATCHES (8)
+
 struct Parameters {
   char Prefix[MAXFILENAME];
   char PhotonList[MAXFILENAME];
@@ -91,10 +104,48 @@ struct Parameters {
   /** Skip invalid patterns when producing the output file. */
   char SkipInvalids;
 
+  /** Number of threads processing the telescope modules. If 1, all
+      modules are simulated in the main thread. */
+  int nthreads;
+
   char clobber;
 };
 
 
+/** Data shared by the photon generation and the worker threads. */
+typedef struct {
+  struct Parameters* par;
+
+  GenInst** subinst;
+  PhotonFile** plf;
+  ImpactFile** ilf;
+  EventFile** elf;
+  EventFile** patf;
+  Pha2Pi** p2p;
+  GTI* gti;
+
+  /** Independent random number stream for each telescope module. */
+  RndStream rs[NUM_TELS];
+
+  double tstart, tstop;
+
+} EroPipeline;
+
+
+/** Worker thread processing the telescope modules ii with
+    ii%nworkers==id. */
+typedef struct {
+  EroPipeline* pipe;
+  int id, nworkers;
+
+  /** Attitude shared by all threads and the cursor of this thread
+      for the search of the telescope pointing. */
+  const Attitude* ac;
+  long attcursor;
+
+} EroWorker;
+
+
 
 
 ////////////////////////////////////////////////////////////////////////
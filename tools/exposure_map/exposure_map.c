@@ -22,6 +22,8 @@
 
 #include "exposure_map.h"
 
+#include <unistd.h>
+
 
 void saveExpoMap(float** const map,
 		 const char* const filename,
@@ -432,51 +434,253 @@ static int get_pixel_hit(GenInst **inst,int ninst, Vector pixel_skypos, double t
 	return 0;
 }
 
-static float get_single_expos_value(int x,int y, struct wcsprm *wcs,
-		struct Telescope telescope, GenInst **inst, int ninst, int proj, int *status){
+static void init_expo_geometry(struct Parameters par, struct wcsprm *wcs,
+		GenInst **inst, int ninst, const Vignetting *vignetting,
+		ExpoMapGeometry *geo, int *status){
+
+	geo->naxis1 = par.ra_bins;
+	geo->naxis2 = par.dec_bins;
+	geo->inst = inst;
+	geo->ninst = ninst;
+	geo->fov_radius = inst[0]->tel->fov_diameter*0.5;
+	geo->cos_fov = cos(geo->fov_radius);
+	geo->field_center = unit_vector(0.5*(par.ra1+par.ra2), 0.5*(par.dec1+par.dec2));
+	geo->field_min_align = get_min_fov_align(inst[0], par);
+
+	// Sky positions of the map pixels. As the projection does not
+	// change with time, they are only calculated once.
+	long npix = geo->naxis1*geo->naxis2;
+	geo->pixpos = (Vector*)malloc(npix*sizeof(Vector));
+	CHECK_NULL_VOID(geo->pixpos,*status,"malloc failed");
+	geo->valid = (char*)malloc(npix*sizeof(char));
+	CHECK_NULL_VOID(geo->valid,*status,"malloc failed");
+
+	long x, y;
+	for (x=0; x<geo->naxis1; x++) {
+		for (y=0; y<geo->naxis2; y++) {
+			long idx = x*geo->naxis2+y;
+			double world[2], theta, phi;
+			geo->valid[idx] = 0;
+			// if we do not have valid sky coordinates to the pixel, it never gets any exposure
+			if (get_world_coords(x,y,wcs,world,&theta,&phi,status)!=1){
+				CHECK_STATUS_VOID(*status);
+				continue;
+			}
+			// galactic projection -> need to convert coordinates
+			if (par.projection>=3){
+				convert_galLB2RAdec(world);
+			}
+			geo->pixpos[idx] = unit_vector(world[0]*M_PI/180., world[1]*M_PI/180.);
+			geo->valid[idx] = 1;
+		}
+	}
 
-	// get world coordinates from the projection
-	double *world, theta, phi;
-	world =(double*)malloc(2*sizeof(float));
-	CHECK_NULL_RET(world,*status,"malloc failed",-1);
+	// Divide the map into blocks and determine the circle on the sky
+	// enclosing the valid pixels of each block.
+	long nbx = (geo->naxis1+EXPOMAP_BLOCKSIZE-1)/EXPOMAP_BLOCKSIZE;
+	long nby = (geo->naxis2+EXPOMAP_BLOCKSIZE-1)/EXPOMAP_BLOCKSIZE;
+	geo->nblocks = nbx*nby;
+	geo->blocks = (ExpoMapBlock*)malloc(geo->nblocks*sizeof(ExpoMapBlock));
+	CHECK_NULL_VOID(geo->blocks,*status,"malloc failed");
+
+	long ii;
+	for (ii=0; ii<geo->nblocks; ii++){
+		ExpoMapBlock *block = &(geo->blocks[ii]);
+		block->x0 = (ii/nby)*EXPOMAP_BLOCKSIZE;
+		block->x1 = MIN(block->x0+EXPOMAP_BLOCKSIZE, geo->naxis1);
+		block->y0 = (ii%nby)*EXPOMAP_BLOCKSIZE;
+		block->y1 = MIN(block->y0+EXPOMAP_BLOCKSIZE, geo->naxis2);
+		block->nvalid = 0;
+
+		Vector sum = {0., 0., 0.};
+		for (x=block->x0; x<block->x1; x++) {
+			for (y=block->y0; y<block->y1; y++) {
+				long idx = x*geo->naxis2+y;
+				if (geo->valid[idx]){
+					sum.x += geo->pixpos[idx].x;
+					sum.y += geo->pixpos[idx].y;
+					sum.z += geo->pixpos[idx].z;
+					block->nvalid++;
+				}
+			}
+		}
 
-	// if we do not have valid sky coordinates to the pixels, we return a 0 expsoure value
-	if (get_world_coords(x,y,wcs,world,&theta,&phi,status)!=1){
-		free(world);
-		return 0.0;
+		// By default, the block is never skipped.
+		block->min_align = -2.;
+		block->center = geo->field_center;
+		double norm = sqrt(scalar_product(&sum, &sum));
+		if ((0==block->nvalid) || (norm<1.e-6)) {
+			continue;
+		}
+		block->center = normalize_vector(sum);
+
+		double min_cos = 1.;
+		for (x=block->x0; x<block->x1; x++) {
+			for (y=block->y0; y<block->y1; y++) {
+				long idx = x*geo->naxis2+y;
+				if (geo->valid[idx]){
+					min_cos = MIN(min_cos, scalar_product(&block->center, &geo->pixpos[idx]));
+				}
+			}
+		}
+		// Add a small margin to be on the safe side.
+		double radius = acos(MAX(MIN(min_cos, 1.), -1.)) + 1.e-6;
+		if (geo->fov_radius+radius<M_PI) {
+			block->min_align = cos(geo->fov_radius+radius);
+		}
 	}
-	CHECK_STATUS_RET(*status,0.0);
 
-	// galactic projection -> need to convert coordinates
-	if (proj>=3){
-		convert_galLB2RAdec(world);
+	// Look-up table of the vignetting factor at 1 keV.
+	geo->vignlut = (float*)malloc((EXPOMAP_VIGN_NBINS+1)*sizeof(float));
+	CHECK_NULL_VOID(geo->vignlut,*status,"malloc failed");
+	geo->vignlut_step = geo->fov_radius/EXPOMAP_VIGN_NBINS;
+	for (ii=0; ii<=EXPOMAP_VIGN_NBINS; ii++){
+		geo->vignlut[ii] = get_Vignetting_Factor(vignetting, 1., ii*geo->vignlut_step, 0.);
 	}
+}
 
-	// Determine a unit vector for the calculated RA and Dec.
-	Vector pixpos=unit_vector(world[0]*M_PI/180., world[1]*M_PI/180.);
-	free(world);
+static void free_expo_geometry(ExpoMapGeometry *geo){
+	if (NULL!=geo->pixpos){
+		free(geo->pixpos);
+		geo->pixpos = NULL;
+	}
+	if (NULL!=geo->valid){
+		free(geo->valid);
+		geo->valid = NULL;
+	}
+	if (NULL!=geo->blocks){
+		free(geo->blocks);
+		geo->blocks = NULL;
+	}
+	if (NULL!=geo->vignlut){
+		free(geo->vignlut);
+		geo->vignlut = NULL;
+	}
+}
 
-	// instrument is the same
-	const double fov_min_align=inst[0]->tel->fov_diameter*0.5;
+static float get_vign_lut(const ExpoMapGeometry *geo, double theta){
+	if (geo->vignlut_step<=0.){
+		return geo->vignlut[0];
+	}
+	double pos = theta/geo->vignlut_step;
+	long ii = (long)pos;
+	if (ii>=EXPOMAP_VIGN_NBINS){
+		return geo->vignlut[EXPOMAP_VIGN_NBINS];
+	}
+	return geo->vignlut[ii] + (geo->vignlut[ii+1]-geo->vignlut[ii])*(pos-ii);
+}
+
+/** Add the exposure of a dwell (telescope pointing with a duration
+ *  of weight seconds) to the given maps. Only the blocks of the map
+ *  that overlap with the FOV are regarded. */
+static void add_expos_dwell(const ExpoMapGeometry *geo, const struct Telescope *telescope,
+		double weight, float *map, float *rawmap){
 
+	// Check if the specified field of the sky might be within the FOV.
+	if (check_fov(&geo->field_center, &telescope->nz, geo->field_min_align)!=0) {
+		return;
+	}
 
-	// Check if the current pixel lies within the FOV.
-	//  (only a rough, conservative estimate to reduce computing power)
-	if (check_fov(&pixpos, &telescope.nz, cos(fov_min_align))==0) {
-		// Pixel lies inside the FOV!
+	long ii;
+	for (ii=0; ii<geo->nblocks; ii++){
+		const ExpoMapBlock *block = &(geo->blocks[ii]);
+		if ((0==block->nvalid) ||
+				(scalar_product(&block->center, &telescope->nz)<block->min_align)){
+			continue;
+		}
+
+		long x;
+		for (x=block->x0; x<block->x1; x++){
+			long y;
+			for (y=block->y0; y<block->y1; y++){
+				long idx = x*geo->naxis2+y;
+				if (!geo->valid[idx]) continue;
+
+				// Check if the current pixel lies within the FOV.
+				//  (only a rough, conservative estimate to reduce computing power)
+				if (check_fov(&geo->pixpos[idx], &telescope->nz, geo->cos_fov)!=0) continue;
+
+				if (get_pixel_hit(geo->inst,geo->ninst,geo->pixpos[idx],0.,0.,*telescope)!=1) continue;
+
+				// Add the exposure time weighted with the vignetting
+				// factor for this particular off-axis angle at 1 keV.
+				double cos_theta = MIN(scalar_product(&telescope->nz, &geo->pixpos[idx]), 1.);
+				map[idx] += weight*get_vign_lut(geo, acos(cos_theta));
+				if (NULL!=rawmap){
+					rawmap[idx] += weight;
+				}
+			}
+		}
+	}
+}
 
-		if (get_pixel_hit(inst,ninst,pixpos,theta,phi,telescope)==1){
+static int is_same_dwell(const struct Telescope *t1, const struct Telescope *t2){
+	Vector dz = vector_difference(t1->nz, t2->nz);
+	Vector dx = vector_difference(t1->nx, t2->nx);
+	return (scalar_product(&dz, &dz)<EXPOMAP_DWELL_TOLERANCE*EXPOMAP_DWELL_TOLERANCE) &&
+			(scalar_product(&dx, &dx)<EXPOMAP_DWELL_TOLERANCE*EXPOMAP_DWELL_TOLERANCE);
+}
 
-			// Add the exposure time step weighted with the vignetting
-			// factor for this particular off-axis angle at 1 keV.
-			// Calculate the off-axis angle ([rad])
-			return  acos(scalar_product(&telescope.nz, &pixpos));
+static void update_progress(ExpoMapProgress *prog, long nsteps){
+	pthread_mutex_lock(&prog->mutex);
+	prog->ndone += nsteps;
+	while ((unsigned int)(prog->ndone*100./prog->ntotal)>prog->progress) {
+		prog->progress++;
+		if (NULL==prog->progressfile) {
+			headas_chat(2, "\r%.0lf %%", prog->progress*1.);
+			fflush(NULL);
 		} else {
-			return -1.0;
+			rewind(prog->progressfile);
+			fprintf(prog->progressfile, "%.2lf", prog->progress*1./100.);
+			fflush(prog->progressfile);
 		}
-	} else {
-		return -1.0;
 	}
+	pthread_mutex_unlock(&prog->mutex);
+}
+
+/** Calculate the exposure for the time steps of a work package.
+ *  Subsequent time steps with (almost) identical telescope axes are
+ *  combined to a single dwell, such that the map is only evaluated
+ *  once for them. */
+static void* expo_map_thread(void *arg){
+	ExpoMapThread *th = (ExpoMapThread*)arg;
+
+	struct Telescope dwell;
+	double weight = 0.;
+	long nreport = 0;
+
+	long ii;
+	for (ii=th->step0; ii<th->step1; ii++){
+		double time = th->tstart + ii*th->dt;
+
+		// Determine the telescope pointing direction at the current time.
+		struct Telescope telescope;
+		getAttitudeAxes(th->ac, &telescope.nx, &telescope.ny, &telescope.nz,
+				time, &th->attcursor, &th->status);
+		if (EXIT_SUCCESS!=th->status) break;
+
+		if ((weight>0.) && is_same_dwell(&dwell, &telescope)){
+			weight += th->dt;
+		} else {
+			if (weight>0.){
+				add_expos_dwell(th->geo, &dwell, weight, th->map, th->rawmap);
+			}
+			dwell = telescope;
+			weight = th->dt;
+		}
+
+		if (++nreport>=EXPOMAP_PROGRESS_STEPS){
+			update_progress(th->progress, nreport);
+			nreport = 0;
+		}
+	}
+
+	if ((EXIT_SUCCESS==th->status) && (weight>0.)){
+		add_expos_dwell(th->geo, &dwell, weight, th->map, th->rawmap);
+	}
+	update_progress(th->progress, nreport);
+
+	return NULL;
 }
 
 static void get_geninst_all(GenInst **inst,xmlarray xmls,const unsigned int seed,int *status){
@@ -542,6 +746,7 @@ int exposure_map_main()
   Vignetting* vignetting=NULL;
   FILE* progressfile=NULL;
   Attitude* ac=NULL;
+  ExpoMapGeometry geo={ .pixpos=NULL, .valid=NULL, .blocks=NULL, .vignlut=NULL };
 
 
   do { // Beginning of the ERROR handling loop.
@@ -609,7 +814,10 @@ int exposure_map_main()
     if (par.fov_diameter > 0){
     	inst[0]->tel->fov_diameter = par.fov_diameter; // we only use the [0] one in the following
     }
-    double field_min_align = get_min_fov_align(inst[0], par);
+
+    // Pixel positions, FOV footprint blocks, and vignetting look-up table.
+    init_expo_geometry(par,&wcs,inst,xmls.n,vignetting,&geo,&status);
+    CHECK_STATUS_BREAK(status);
 
     // ######## --- END of Initialization --- ######### //
 
@@ -619,74 +827,95 @@ int exposure_map_main()
     // Simulation progress status (running from 0 to 100).
     unsigned int progress= init_progress(progressfile);
 
-    // LOOP over the given time interval from TSTART to TSTART+timespan in steps of dt.
-    // int intermaps=0;
-    double time;
-    for (time=par.TSTART; time<par.TSTART+par.timespan; time+=par.dt) {
-
-
-      // Determine the telescope pointing direction at the current time.
-      struct Telescope telescope;
-      getTelescopeAxes(ac, &telescope.nx, &telescope.ny, &telescope.nz,
-    		     time, &status);
-     CHECK_STATUS_BREAK(status);
-
-      // Calculate the RA and DEC of the pointing direction.
-      double telescope_ra, telescope_dec;
-      calculate_ra_dec(telescope.nz, &telescope_ra, &telescope_dec);
-
-      // printf("RA: %.4f Dec: %.4f \n",telescope_ra*180/M_PI, telescope_dec*180/M_PI);
-
-      // if desired, we convert to galactic coordinates  ** GLAT / GLONG
-
-
-      // Check if the specified field of the sky might be within the FOV.
-      // Otherwise break this run and continue at the beginning of the loop
-      // with the next time step.
-      Vector pixpos=unit_vector(0.5*(par.ra1+par.ra2), 0.5*(par.dec1+par.dec2));
-      if (check_fov(&pixpos, &telescope.nz, field_min_align)!=0) {
-    	  continue;
+    // The time interval from TSTART to TSTART+timespan is evaluated
+    // in steps of dt. The steps are split into contiguous work packages
+    // for the individual threads, which accumulate partial maps.
+    long nsteps=(long)ceil(par.timespan/par.dt);
+    int nthreads=par.nthreads;
+    if (nthreads<=0) {
+      nthreads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    nthreads=(int)MAX(MIN(nthreads, nsteps), 1);
+    headas_chat(3, "using %d thread(s) ...\n", nthreads);
+
+    ExpoMapProgress prog;
+    pthread_mutex_init(&prog.mutex, NULL);
+    prog.ndone=0;
+    prog.ntotal=MAX(nsteps, 1);
+    prog.progress=progress;
+    prog.progressfile=progressfile;
+
+    long npix=geo.naxis1*geo.naxis2;
+    ExpoMapThread threads[nthreads];
+    pthread_t tid[nthreads];
+    int ii;
+    for (ii=0; ii<nthreads; ii++){
+      threads[ii].map=NULL;
+      threads[ii].rawmap=NULL;
+    }
+    for (ii=0; ii<nthreads; ii++){
+      threads[ii].geo=&geo;
+      threads[ii].ac=ac;
+      threads[ii].attcursor=ac->currentry;
+      threads[ii].tstart=par.TSTART;
+      threads[ii].dt=par.dt;
+      threads[ii].step0=nsteps*ii/nthreads;
+      threads[ii].step1=nsteps*(ii+1)/nthreads;
+      threads[ii].progress=&prog;
+      threads[ii].status=EXIT_SUCCESS;
+      threads[ii].map=(float*)calloc(npix, sizeof(float));
+      CHECK_NULL_BREAK(threads[ii].map,status,"malloc failed");
+      if (rawMap==1){
+        threads[ii].rawmap=(float*)calloc(npix, sizeof(float));
+        CHECK_NULL_BREAK(threads[ii].rawmap,status,"malloc failed");
       }
-     // printf("Current Pointing (t=%f):  %f %f %f\n",time,telescope.nz.x,telescope.nz.y,telescope.nz.z);
-
-      // 2d Loop over the exposure map in order to determine all pixels that
-      // are currently within the FOV.
-
-      long x;
-      float delta;
-      for (x=0; x<par.ra_bins; x++) {
-    	  long y;
-    	  for (y=0; y<par.dec_bins; y++) {
-    		  delta = get_single_expos_value(x,y,&wcs,
-    				  telescope,inst,xmls.n, par.projection, &status);
-    		  CHECK_STATUS_BREAK(status);
-    		  if (delta>=0){
-    			  expoMap[x][y]+=par.dt*get_Vignetting_Factor(vignetting, 1., delta, 0.);
-    			  if (rawMap==1){
-    				  rawExpoMap[x][y]+=par.dt;
-    			  }
-    		  }
-
-    		  CHECK_STATUS_BREAK(status);
-    	  }
-		  CHECK_STATUS_BREAK(status);
-     }
-
-      // Program progress output.
-      while((unsigned int)((time-par.TSTART)*100./par.timespan)>progress) {
-    	  progress++;
-    	  if (NULL==progressfile) {
-    		  headas_chat(2, "\r%.0lf %%", progress*1.);
-    		  fflush(NULL);
-    	  } else {
-    		  rewind(progressfile);
-    		  fprintf(progressfile, "%.2lf", progress*1./100.);
-    		  fflush(progressfile);
-    	  }
+    }
+    if (EXIT_SUCCESS!=status){
+      for (ii=0; ii<nthreads; ii++){
+        free(threads[ii].map);
+        free(threads[ii].rawmap);
       }
+      pthread_mutex_destroy(&prog.mutex);
+      break;
     }
 
+    // The first work package is processed by the main thread.
+    int nstarted;
+    for (nstarted=1; nstarted<nthreads; nstarted++){
+      if (0!=pthread_create(&tid[nstarted], NULL, expo_map_thread, &threads[nstarted])){
+        SIXT_ERROR("creation of thread failed");
+        status=EXIT_FAILURE;
+        break;
+      }
+    }
+    if (EXIT_SUCCESS==status){
+      expo_map_thread(&threads[0]);
+    }
+    for (ii=1; ii<nstarted; ii++){
+      pthread_join(tid[ii], NULL);
+    }
+    pthread_mutex_destroy(&prog.mutex);
 
+    // Sum up the partial maps.
+    for (ii=0; ii<nthreads; ii++){
+      if (EXIT_SUCCESS!=threads[ii].status){
+        status=threads[ii].status;
+      }
+      if (EXIT_SUCCESS==status){
+        long x;
+        for (x=0; x<par.ra_bins; x++) {
+          long y;
+          for (y=0; y<par.dec_bins; y++) {
+            expoMap[x][y]+=threads[ii].map[x*par.dec_bins+y];
+            if (rawMap==1){
+              rawExpoMap[x][y]+=threads[ii].rawmap[x*par.dec_bins+y];
+            }
+          }
+        }
+      }
+      free(threads[ii].map);
+      free(threads[ii].rawmap);
+    }
     CHECK_STATUS_BREAK(status);
     // END of LOOP over the specified time interval.
 
@@ -719,7 +948,6 @@ int exposure_map_main()
     }
 
 
-    int ii;
     for (ii=0;ii<xmls.n;ii++){
     	destroyGenInst(&(inst[ii]),&status);
     }
@@ -739,6 +967,7 @@ int exposure_map_main()
   // Release memory.
   freeAttitude(&ac);
   destroyVignetting(&vignetting);
+  free_expo_geometry(&geo);
   wcsfree(&wcs);
 
 
@@ -791,6 +1020,8 @@ int exposure_map_getpar(struct Parameters *par)
 
   query_simput_parameter_int("seed",&(par->seed), &status);
 
+  query_simput_parameter_int("nthreads",&(par->nthreads), &status);
+
   query_simput_parameter_string("ProgressFile",&(par->ProgressFile), &status);
 
   query_simput_parameter_bool("clobber",&par->clobber, &status);
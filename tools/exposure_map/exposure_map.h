@@ -36,10 +36,33 @@
 #include "parinput.h"
 #include "sys/stat.h"
 
+#include <pthread.h>
+
 #define TOOLSUB exposure_map_main
 #include "headas_main.c"
 
 
+////////////////////////////////////////////////////////////////////////
+// Constants.
+////////////////////////////////////////////////////////////////////////
+
+/** Number of bins of the vignetting look-up table covering the
+    off-axis angles from 0 to the radius of the FOV. */
+#define EXPOMAP_VIGN_NBINS (4096)
+
+/** Edge length of the square blocks of map pixels, which are checked
+    against the FOV as a whole [pixel]. */
+#define EXPOMAP_BLOCKSIZE (16)
+
+/** Maximum change of the telescope axes between subsequent time steps
+    that are combined to a single dwell [rad] (1 arcsec, i.e., well
+    below the size of a detector pixel). */
+#define EXPOMAP_DWELL_TOLERANCE (4.8481368e-6)
+
+/** Number of time steps after which a thread reports its progress. */
+#define EXPOMAP_PROGRESS_STEPS (1000)
+
+
 ////////////////////////////////////////////////////
 
 /* Program parameters */
@@ -76,6 +99,9 @@ struct Parameters {
   /** Number of interim maps to be stored. */
   int intermaps;
 
+  /** Number of threads (0: number of available processors). */
+  int nthreads;
+
   int clobber;
 };
 
@@ -84,6 +110,91 @@ typedef struct {
 	int n;
 }xmlarray;
 
+/** Block of map pixels, which is enclosed by a circle on the sky. */
+typedef struct {
+  /** Pixel range of the block (upper limits are exclusive). */
+  long x0, x1, y0, y1;
+
+  /** Center of the enclosing circle and minimum cosine of the angle
+      between the center and the telescope axis for the block to
+      overlap with the FOV. */
+  Vector center;
+  double min_align;
+
+  /** Number of pixels with valid sky coordinates. */
+  long nvalid;
+} ExpoMapBlock;
+
+/** Time-independent data used for the calculation of the exposure
+    map. They are set up once and shared by all threads. */
+typedef struct {
+  /** Dimensions of the map. */
+  long naxis1, naxis2;
+
+  /** Unit vectors of the sky positions of the map pixels and flags
+      whether the pixels correspond to valid sky coordinates. The
+      pixel (x,y) has the index x*naxis2+y. */
+  Vector* pixpos;
+  char* valid;
+
+  /** Blocks of map pixels. */
+  ExpoMapBlock* blocks;
+  long nblocks;
+
+  /** Radius of the FOV [rad] and its cosine. */
+  double fov_radius, cos_fov;
+
+  /** Center of the requested sky section and minimum cosine of the
+      angle to the telescope axis for the section to be within the
+      FOV. */
+  Vector field_center;
+  double field_min_align;
+
+  /** Vignetting factor at 1 keV on an equidistant grid of off-axis
+      angles with EXPOMAP_VIGN_NBINS+1 nodes. */
+  float* vignlut;
+  double vignlut_step;
+
+  /** Instruments defining the detector geometry. */
+  GenInst** inst;
+  int ninst;
+} ExpoMapGeometry;
+
+/** Progress status shared by all threads. */
+typedef struct {
+  pthread_mutex_t mutex;
+  long ndone, ntotal;
+  unsigned int progress;
+  FILE* progressfile;
+} ExpoMapProgress;
+
+/** Work package of a single thread. Each thread evaluates a
+    contiguous range of time steps and accumulates the result in its
+    own partial maps, which are summed up afterwards. */
+typedef struct {
+  const ExpoMapGeometry* geo;
+
+  /** Attitude shared by all threads. */
+  const Attitude* ac;
+
+  /** Thread-specific search cursor within the attitude. */
+  long attcursor;
+
+  /** Time range given by the start time, the time step, and the
+      indices of the first and the last (exclusive) time step. */
+  double tstart, dt;
+  long step0, step1;
+
+  /** Partial exposure maps (flat arrays with the same indexing as the
+      pixel positions). The raw map is NULL if not required. */
+  float* map;
+  float* rawmap;
+
+  ExpoMapProgress* progress;
+
+  int status;
+} ExpoMapThread;
+
 ////////////////////////////////////////////////////////////////////////
 // Function declarations.
 ////////////////////////////////////////////////////////////////////////
@@ -174,13 +174,17 @@ int fudgexp_main() {
     // END of loading the exposure map.
 
 
+    // Rows to be removed from the photon list.
+    long* delrows=(long*)malloc(MAX(plf->nrows, 1)*sizeof(long));
+    CHECK_NULL_BREAK(delrows, status, "memory allocation failed");
+    long ndelrows=0;
+
     // Loop over all photons in the list.
-    long row=1;
     for (ii=0; ii<plf->nrows; ii++) {
 
       // Get the next photon from the list.
       Photon ph;
-      status=PhotonFile_getRow(plf, &ph, row);
+      status=PhotonFile_getRow(plf, &ph, ii+1);
       CHECK_STATUS_BREAK(status);
 
       // Determine the pixel coordinates corresponding to the photon
@@ -207,14 +211,19 @@ int fudgexp_main() {
       long yy = (long)(pixcrd[1]-0.5);
       if ((xx<0)||(xx>=naxes[0]) || (yy<0)||(yy>=naxes[1]) ||
 	  (p > map[xx][yy]/par.ExposureTime)) {
-	// Delete the photon from the list.
-	fits_delete_rows(plf->fptr, row, 1, &status);
-	CHECK_STATUS_BREAK(status);
-      } else {
-	// Proceed with the next line.
-	row++;
+	// Mark the photon for deletion.
+	delrows[ndelrows++]=ii+1;
       }
     }
+
+    // Delete the discarded photons from the list. The buffered rows
+    // of the PhotonFile become invalid by this operation.
+    if ((EXIT_SUCCESS==status)&&(ndelrows>0)) {
+      resetFitsBlockBuffer(plf->buffer, &status);
+      fits_delete_rowlist(plf->fptr, delrows, ndelrows, &status);
+      plf->nrows-=ndelrows;
+    }
+    free(delrows);
     CHECK_STATUS_BREAK(status);
     // END loop over all photons.
 
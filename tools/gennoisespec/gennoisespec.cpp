@@ -51,6 +51,8 @@ MAP OF SECTIONS IN THIS FILE:
  - 9. findPulsesNoise
  - 10. findTstartNoise
  - 11. weightMatrixNoise
+ - 12. covarianceNoise
+ - 13. weightMatrixesNoise
  
 *******************************************************************************/
 
@@ -86,6 +88,7 @@ MAP OF SECTIONS IN THIS FILE:
 * - LbT: Baseline averaging length in seconds (only in notcreationlib mode)
 * - namelog: Output log file name
 * - verbosity: Verbosity level of the output log file
+* - nthreads: Number of threads to calculate the weight matrixes (0: number of processors)
 * 
 * Steps:
 * 
@@ -546,41 +549,14 @@ int main (int argc, char **argv)
                 
                 if (NumMeanSamples >= nintervals)
                 {
-                        for (int i=0;i<weightpoints->size;i++)
-                        {	
-                                weightMatrix = gsl_matrix_alloc(gsl_vector_get(weightpoints,i),gsl_vector_get(weightpoints,i));
-                                noiseIntervals_weightPoints = gsl_matrix_alloc(nintervals,gsl_vector_get(weightpoints,i));
-                                
-                                tempm = gsl_matrix_submatrix(noiseIntervals,0,0,nintervals,gsl_vector_get(weightpoints,i));
-                                gsl_matrix_memcpy(noiseIntervals_weightPoints,&tempm.matrix);
-                                //weightMatrixNoise(noiseIntervals_weightPoints, &weightMatrix);
-
-				if (matrixSize == 0){ //do all sizes
-				    weightMatrixNoise(noiseIntervals_weightPoints, &weightMatrix);
-				    for (int j=0;j<gsl_vector_get(weightpoints,i);j++)
-				    {
-                                        for (int k=0;k<gsl_vector_get(weightpoints,i);k++)
-					{
-					    gsl_matrix_set(weightMatrixes,i,j*gsl_vector_get(weightpoints,i)+k,gsl_matrix_get(weightMatrix,j,k));
-					}
-				    }
-				    gsl_matrix_free(noiseIntervals_weightPoints);
-				    gsl_matrix_free(weightMatrix);
-
-				}else if (gsl_vector_get(weightpoints,i) == matrixSize){ // do only input param size
-				    weightMatrixNoise(noiseIntervals_weightPoints, &weightMatrix);
-				    for (int j=0;j<gsl_vector_get(weightpoints,i);j++)
-				    {
-                                        for (int k=0;k<gsl_vector_get(weightpoints,i);k++)
-					{
-					    gsl_matrix_set(weightMatrixes,i,j*gsl_vector_get(weightpoints,i)+k,gsl_matrix_get(weightMatrix,j,k));
-					}
-				    }
-				    gsl_matrix_free(noiseIntervals_weightPoints);
-				    gsl_matrix_free(weightMatrix);
-				    break;
-				} // different matrix sizes ?
-                        } // foreach matrix size
+                        // All the matrix sizes use the same pulse-free intervals, so their covariance matrixes are
+                        // leading submatrixes of the largest one and only one factorization is necessary
+                        tempm = gsl_matrix_submatrix(noiseIntervals,0,0,nintervals,gsl_vector_get(weightpoints,0));
+                        if (weightMatrixesNoise(&tempm.matrix, weightpoints, matrixSize, weightMatrixes))
+                        {
+                                message = "Cannot run weightMatrixesNoise routine";
+                                EP_EXIT_ERROR(message,EPFAIL);
+                        }
                 }
                 else
                 {
@@ -743,7 +719,7 @@ int initModule(int argc, char **argv)
 
 	// Define GENNOISESPEC input parameters and assign values to variables
 	// Parameter definition and assignation of default values
-	const int npars = 17, npars1 = 18;
+	const int npars = 18, npars1 = 19;
 	inparam gennoisespecPars[npars];
 	int optidx =0, par=0, fst=0, ipar;
 	string message="";
@@ -874,6 +850,14 @@ int initModule(int argc, char **argv)
 	gennoisespecPars[16].maxValInt = 8192;
 	gennoisespecPars[16].ValInt = gennoisespecPars[16].defValInt;
 
+	gennoisespecPars[17].name = "nthreads";
+	gennoisespecPars[17].description = "Number of threads to calculate the weight matrixes (0: number of processors)";
+	gennoisespecPars[17].defValInt = 1;
+	gennoisespecPars[17].type = "int";
+	gennoisespecPars[17].minValInt = 0;
+	gennoisespecPars[17].maxValInt = 1024;
+	gennoisespecPars[17].ValInt = gennoisespecPars[17].defValInt;
+
 	
 	// Define structure for command line options
 	static struct option long_options[npars1];
@@ -1019,6 +1003,12 @@ int initModule(int argc, char **argv)
 		{
 			matrixSize = gennoisespecPars[i].ValInt;
 		}
+		else if(gennoisespecPars[i].name == "nthreads")
+		{
+			nthreads = gennoisespecPars[i].ValInt;
+			if (nthreads == 0)	nthreads = std::thread::hardware_concurrency();
+			if (nthreads < 1)	nthreads = 1;
+		}
 		else if (gennoisespecPars[i].name == "clobber")
 		{
 			strcpy(clobberStr, gennoisespecPars[i].ValStr.c_str());
@@ -2222,7 +2212,7 @@ int findTstartNoise
 * Di: Pulse free interval
 * V: Covariance matrix
 * 
-*  Vij = E[DiDj]-E[Di]E[Dj] 
+*  Vij = E[(Di-E[Di])(Dj-E[Dj])] 
 * 
 * Di^p: Value of the ith-sample of the pulse-free interval i
 * N: Number of samples
@@ -2235,9 +2225,9 @@ int findTstartNoise
 *                 |<DnD1> <DnD2>...<DnDn>|
 *  W = 1/V
 *
-* - Calculate the elements of the diagonal of the covariance matrix
-* - Calculate the elements out of the diagonal of the covariance matrix
-* - Calculate the weight matrix
+* - Calculate the covariance matrix (covarianceNoise)
+* - Calculate the weight matrix by means of the Cholesky decomposition of the covariance matrix
+*   (the LU decomposition is used if the covariance matrix is not positive definite)
 *
 * Parameters:
 * - intervalMatrix: GSL matrix containing pulse-free intervals whose baseline is 0 (baseline previously subtracted) [nintervals x intervalMinSamples]
@@ -2248,93 +2238,274 @@ int weightMatrixNoise (gsl_matrix *intervalMatrix, gsl_matrix **weight)
 	string message = "";
 	char valERROR[256];
 	
-	double elementValue;
-	double elementValue1 = 0.0;
-	double elementValue2 = 0.0;
-	double elementValue3 = 0.0;
-	gsl_permutation *perm = gsl_permutation_alloc((*weight)->size1);
-	int s=0;
-        
-        gsl_matrix *covariance = gsl_matrix_alloc((*weight)->size1,(*weight)->size2);
-	
-        /*clock_t t;
-        t=clock();*/
-	// Elements of the diagonal of the covariance matrix
-	for (int i=0;i<intervalMatrix->size2;i++)
+	// It is not necessary to check the allocation because 'covarianze' size must already be > 0
+	gsl_matrix *covariance = gsl_matrix_alloc((*weight)->size1,(*weight)->size2);
+	if (covarianceNoise(intervalMatrix, covariance))
 	{
-		for (int p=0;p<intervalMatrix->size1;p++)
+		gsl_matrix_free(covariance);
+		message = "Cannot run covarianceNoise routine";
+		EP_PRINT_ERROR(message,EPFAIL);	return(EPFAIL);
+	}
+	
+	// Calculate the weight matrix
+	// The default GSL error handler aborts if the matrix is not positive definite
+	gsl_matrix_memcpy(*weight,covariance);
+	gsl_error_handler_t *handler = gsl_set_error_handler_off();
+	int cholesky = gsl_linalg_cholesky_decomp(*weight);
+	if (cholesky == 0)	cholesky = gsl_linalg_cholesky_invert(*weight);
+	gsl_set_error_handler(handler);
+	
+	if (cholesky != 0)
+	{
+		gsl_permutation *perm = gsl_permutation_alloc((*weight)->size1);
+		int s=0;
+		gsl_matrix *covarianceaux = gsl_matrix_alloc(covariance->size1,covariance->size2);
+		gsl_matrix_memcpy(covarianceaux,covariance);
+		gsl_linalg_LU_decomp(covarianceaux, perm, &s);
+		if (gsl_linalg_LU_invert(covarianceaux, perm, *weight) != 0) 
 		{
-			elementValue1 = elementValue1 + pow(gsl_matrix_get(intervalMatrix,p,i),2.0);
-			elementValue2 = elementValue2 + gsl_matrix_get(intervalMatrix,p,i);
+			sprintf(valERROR,"%d",__LINE__-2);
+			string str(valERROR);
+			gsl_matrix_free(covarianceaux);
+			gsl_permutation_free(perm);
+			gsl_matrix_free(covariance);
+			message = "Singular matrix in line " + str + " (" + __FILE__ + ")";
+			EP_PRINT_ERROR(message,EPFAIL);	return(EPFAIL);
 		}
-		
-		elementValue1 = elementValue1/intervalMatrix->size1;
-		elementValue2 = elementValue2/intervalMatrix->size1;
-		elementValue = elementValue1-elementValue2*elementValue2;
-		
-		gsl_matrix_set(covariance,i,i,elementValue);
-
-		elementValue = 0.0;
-		elementValue1 = 0.0;
-		elementValue2 = 0.0;
+		gsl_matrix_free(covarianceaux);
+		gsl_permutation_free(perm);
 	}
-	/*cout<<"Final de la diagonal de la matriz "<<covariance->size1<<"x"<<covariance->size1<<endl;
-        t = clock() - t;
-        cout<<"Consumidos "<<((float)t)/CLOCKS_PER_SEC<<" segundos"<<endl;*/
 
-        //t = clock();
-	// Other elements
-	for (int i=0;i<intervalMatrix->size2;i++)
+	gsl_matrix_free(covariance);
+	
+	return (EPOK);
+}
+/*xxxx end of SECTION 11 xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx*/
+
+
+/***** SECTION 12 ************************************************************
+* covarianceNoise function: This function calculates the covariance matrix of the pulse-free intervals
+*
+* The columns (samples) of the pulse-free intervals are centered once and the covariance matrix is
+* calculated as V = (1/N)X^T X by blocks of COVBLOCK x COVBLOCK elements (diagonal blocks by
+* means of 'gsl_blas_dsyrk' and the others by means of 'gsl_blas_dgemm'). Only the lower triangle
+* blocks are calculated; they are distributed among 'nthreads' threads and mirrored at the end.
+*
+* - Center the samples of the pulse-free intervals
+* - Calculate the lower triangle blocks of the covariance matrix
+* - Fill in the upper triangle
+*
+* Parameters:
+* - intervalMatrix: GSL matrix containing pulse-free intervals [nintervals x samples]
+* - covariance: GSL matrix with the covariance matrix of the first covariance->size1 samples
+******************************************************************************/
+int covarianceNoise (gsl_matrix *intervalMatrix, gsl_matrix *covariance)
+{
+	string message = "";
+	const size_t COVBLOCK = 256;
+	
+	size_t n = intervalMatrix->size1;
+	size_t m = covariance->size1;
+	if ((n == 0) || (m > intervalMatrix->size2))
+	{
+		message = "Pulse-free intervals do not match the covariance matrix size";
+		EP_PRINT_ERROR(message,EPFAIL);	return(EPFAIL);
+	}
+	
+	// Center the samples of the pulse-free intervals
+	gsl_matrix *centered = gsl_matrix_alloc(n,m);
+	gsl_matrix_view tempm = gsl_matrix_submatrix(intervalMatrix,0,0,n,m);
+	gsl_matrix_memcpy(centered,&tempm.matrix);
+	gsl_vector *mean = gsl_vector_calloc(m);
+	for (size_t p=0;p<n;p++)
 	{
-		for (int j=i+1;j<intervalMatrix->size2;j++)
+		gsl_vector_view row = gsl_matrix_row(centered,p);
+		gsl_vector_add(mean,&row.vector);
+	}
+	gsl_vector_scale(mean,1.0/n);
+	for (size_t p=0;p<n;p++)
+	{
+		gsl_vector_view row = gsl_matrix_row(centered,p);
+		gsl_vector_sub(&row.vector,mean);
+	}
+	gsl_vector_free(mean);
+	
+	// Lower triangle blocks
+	size_t nblocks = (m+COVBLOCK-1)/COVBLOCK;
+	vector<pair<size_t,size_t> > blocks;
+	for (size_t bi=0;bi<nblocks;bi++)
+	{
+		for (size_t bj=0;bj<=bi;bj++)	blocks.push_back(make_pair(bi,bj));
+	}
+	
+	auto calculateBlocks = [&](size_t first, size_t step)
+	{
+		for (size_t b=first;b<blocks.size();b+=step)
 		{
-			for (int p=0;p<intervalMatrix->size1;p++)
+			size_t i0 = blocks[b].first*COVBLOCK;
+			size_t j0 = blocks[b].second*COVBLOCK;
+			size_t wi = min(COVBLOCK,m-i0);
+			size_t wj = min(COVBLOCK,m-j0);
+			gsl_matrix_view xi = gsl_matrix_submatrix(centered,0,i0,n,wi);
+			gsl_matrix_view vij = gsl_matrix_submatrix(covariance,i0,j0,wi,wj);
+			if (i0 == j0)
 			{
-				elementValue1 = elementValue1 + (gsl_matrix_get(intervalMatrix,p,i)*gsl_matrix_get(intervalMatrix,p,j));		
-				elementValue2 = elementValue2 + gsl_matrix_get(intervalMatrix,p,i);
-				elementValue3 = elementValue3 + gsl_matrix_get(intervalMatrix,p,j);
+				gsl_blas_dsyrk(CblasLower,CblasTrans,1.0/n,&xi.matrix,0.0,&vij.matrix);
+			}
+			else
+			{
+				gsl_matrix_view xj = gsl_matrix_submatrix(centered,0,j0,n,wj);
+				gsl_blas_dgemm(CblasTrans,CblasNoTrans,1.0/n,&xi.matrix,&xj.matrix,0.0,&vij.matrix);
 			}
-			
-			elementValue1 = elementValue1/intervalMatrix->size1;
-			elementValue2 = elementValue2/intervalMatrix->size1;
-			elementValue3 = elementValue3/intervalMatrix->size1;
-			elementValue = elementValue1-elementValue2*elementValue3;
-
-			gsl_matrix_set(covariance,i,j,elementValue);
-			gsl_matrix_set(covariance,j,i,elementValue);
-
-			elementValue = 0.0;
-			elementValue1 = 0.0;
-			elementValue2 = 0.0;
-			elementValue3 = 0.0;
 		}
+	};
+	
+	size_t nthr = min((size_t) max(nthreads,1),blocks.size());
+	if (nthr <= 1)
+	{
+		calculateBlocks(0,1);
 	}
-	/*cout<<"Final de los elementos FUERA de la diagonal de la matriz "<<covariance->size1<<"x"<<covariance->size1<<endl;
-        t = clock() - t;
-        cout<<"Consumidos "<<((float)t)/CLOCKS_PER_SEC<<" segundos"<<endl;*/
+	else
+	{
+		vector<std::thread> threads;
+		for (size_t t=0;t<nthr;t++)	threads.push_back(std::thread(calculateBlocks,t,nthr));
+		for (size_t t=0;t<nthr;t++)	threads[t].join();
+	}
+	gsl_matrix_free(centered);
 	
-        //t = clock();
-	// Calculate the weight matrix
-	// It is not necessary to check the allocation because 'covarianze' size must already be > 0
-	gsl_matrix *covarianceaux = gsl_matrix_alloc(covariance->size1,covariance->size2);
-	gsl_matrix_memcpy(covarianceaux,covariance);
-        /*cout<<"Final de la preparacion de la inversion "<<covariance->size1<<"x"<<covariance->size1<<endl;
-        t = clock() - t;
-        cout<<"Consumidos "<<((float)t)/CLOCKS_PER_SEC<<" segundos"<<endl;
-        t = clock();*/
-	gsl_linalg_LU_decomp(covarianceaux, perm, &s);
-	if (gsl_linalg_LU_invert(covarianceaux, perm, *weight) != 0) 
-	{
-		sprintf(valERROR,"%d",__LINE__-2);
-		string str(valERROR);
-		message = "Singular matrix in line " + str + " (" + __FILE__ + ")";
-		EP_PRINT_ERROR(message,EPFAIL);	return(EPFAIL);
+	// Upper triangle
+	for (size_t i=0;i<m;i++)
+	{
+		for (size_t j=i+1;j<m;j++)	gsl_matrix_set(covariance,i,j,gsl_matrix_get(covariance,j,i));
 	}
+	
+	return (EPOK);
+}
+/*xxxx end of SECTION 12 xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx*/
 
-	gsl_matrix_free(covarianceaux);
-        gsl_matrix_free(covariance);
-	gsl_permutation_free(perm);
+
+/***** SECTION 13 ************************************************************
+* weightMatrixesNoise function: This function calculates the weight matrixes of the noise of all the
+*                               lengths in 'weightpoints' from the same pulse-free intervals
+*
+* The covariance matrix of a length w is the leading w x w submatrix of the covariance matrix of the
+* largest length, and so is its Cholesky factor. Therefore, the covariance matrix is calculated and
+* factorized only once and the weight matrix of each length is obtained by inverting the leading
+* submatrix of the factor. The inversions of the different lengths are distributed among 'nthreads'
+* threads. If the covariance matrix is not positive definite, each length is inverted by means of
+* the LU decomposition (weightMatrixNoise).
+*
+* - Select the lengths to be calculated (all of them or only 'matrixSize')
+* - Calculate the covariance matrix of the largest length
+* - Cholesky decomposition
+* - Invert the leading submatrixes of the factor and store them in 'weightMatrixes'
+*
+* Parameters:
+* - intervalMatrix: GSL matrix containing pulse-free intervals whose baseline is 0 (baseline previously subtracted) [nintervals x intervalMinSamples]
+* - weightpoints: GSL vector with the lengths of the weight matrixes (in decreasing order)
+* - matrixSize: Length of the only weight matrix to be calculated (0 in order to calculate all of them)
+* - weightMatrixes: GSL matrix whose row i stores the weight matrix of length weightpoints(i) (row by row)
+******************************************************************************/
+int weightMatrixesNoise (gsl_matrix *intervalMatrix, gsl_vector *weightpoints, int matrixSize, gsl_matrix *weightMatrixes)
+{
+	string message = "";
+	
+	// Lengths to be calculated
+	vector<size_t> index;
+	for (size_t i=0;i<weightpoints->size;i++)
+	{
+		if ((matrixSize == 0) || (gsl_vector_get(weightpoints,i) == matrixSize))
+		{
+			index.push_back(i);
+			if (matrixSize != 0)	break;
+		}
+	}
+	if (index.size() == 0)	return (EPOK);
+	
+	size_t maxSize = 0;
+	for (size_t i=0;i<index.size();i++)	maxSize = max(maxSize,(size_t) gsl_vector_get(weightpoints,index[i]));
+	
+	// Covariance matrix of the largest length
+	gsl_matrix *covariance = gsl_matrix_alloc(maxSize,maxSize);
+	if (covarianceNoise(intervalMatrix, covariance))
+	{
+		gsl_matrix_free(covariance);
+		message = "Cannot run covarianceNoise routine";
+		EP_PRINT_ERROR(message,EPFAIL);	return(EPFAIL);
+	}
+	
+	// Cholesky decomposition
+	gsl_matrix *factor = gsl_matrix_alloc(maxSize,maxSize);
+	gsl_matrix_memcpy(factor,covariance);
+	gsl_error_handler_t *handler = gsl_set_error_handler_off();
+	int cholesky = gsl_linalg_cholesky_decomp(factor);
+	
+	vector<int> statusLength(index.size(),EPOK);
+	if (cholesky == 0)
+	{
+		// Invert the leading submatrixes of the factor (the largest lengths first)
+		auto invertLengths = [&](size_t first, size_t step)
+		{
+			for (size_t l=first;l<index.size();l+=step)
+			{
+				size_t i = index[l];
+				size_t w = gsl_vector_get(weightpoints,i);
+				gsl_matrix *weight = gsl_matrix_alloc(w,w);
+				gsl_matrix_view tempm = gsl_matrix_submatrix(factor,0,0,w,w);
+				gsl_matrix_memcpy(weight,&tempm.matrix);
+				if (gsl_linalg_cholesky_invert(weight) != 0)	statusLength[l] = EPFAIL;
+				for (size_t j=0;j<w;j++)
+				{
+					for (size_t k=0;k<w;k++)
+					{
+						gsl_matrix_set(weightMatrixes,i,j*w+k,gsl_matrix_get(weight,j,k));
+					}
+				}
+				gsl_matrix_free(weight);
+			}
+		};
+		
+		size_t nthr = min((size_t) max(nthreads,1),index.size());
+		if (nthr <= 1)
+		{
+			invertLengths(0,1);
+		}
+		else
+		{
+			vector<std::thread> threads;
+			for (size_t t=0;t<nthr;t++)	threads.push_back(std::thread(invertLengths,t,nthr));
+			for (size_t t=0;t<nthr;t++)	threads[t].join();
+		}
+	}
+	gsl_set_error_handler(handler);
+	gsl_matrix_free(factor);
+	gsl_matrix_free(covariance);
+	
+	for (size_t l=0;l<index.size();l++)
+	{
+		if ((cholesky == 0) && (statusLength[l] == EPOK))	continue;
+		
+		// Not positive definite => LU decomposition of each length
+		size_t i = index[l];
+		size_t w = gsl_vector_get(weightpoints,i);
+		gsl_matrix *weight = gsl_matrix_alloc(w,w);
+		gsl_matrix_view tempm = gsl_matrix_submatrix(intervalMatrix,0,0,intervalMatrix->size1,w);
+		if (weightMatrixNoise(&tempm.matrix, &weight))
+		{
+			gsl_matrix_free(weight);
+			message = "Cannot run weightMatrixNoise routine";
+			EP_PRINT_ERROR(message,EPFAIL);	return(EPFAIL);
+		}
+		for (size_t j=0;j<w;j++)
+		{
+			for (size_t k=0;k<w;k++)
+			{
+				gsl_matrix_set(weightMatrixes,i,j*w+k,gsl_matrix_get(weight,j,k));
+			}
+		}
+		gsl_matrix_free(weight);
+	}
 	
 	return (EPOK);
 }
-/*xxxx end of SECTION A11 xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx*/
+/*xxxx end of SECTION 13 xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx*/
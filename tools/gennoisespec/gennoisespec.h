@@ -43,6 +43,8 @@
 	#include "inoututils.h"
 	
 	#include <time.h>
+	#include <thread>
+	#include <algorithm>
 
 // CFITSIO helpers
 
@@ -109,6 +111,7 @@
 	double Lrs;			// LrsT in samples
 	double Lb;			// LbT in samples
         int matrixSize;                 // noise Matrix size if only one to be created
+	int nthreads;			// Number of threads to calculate the weight matrixes
 	
 	char weightMSStr[4];		// WeightMS=yes then write output weight noise matrixes
 	int weightMS=0;
@@ -216,6 +219,10 @@
 	
 	int weightMatrixNoise (gsl_matrix *intervalMatrix, gsl_matrix **weight);
 
+	int covarianceNoise (gsl_matrix *intervalMatrix, gsl_matrix *covariance);
+
+	int weightMatrixesNoise (gsl_matrix *intervalMatrix, gsl_vector *weightpoints, int matrixSize, gsl_matrix *weightMatrixes);
+
 	using namespace std;
 
 #endif /*GENNOISESPEC_H_*/
@@ -183,7 +183,7 @@ static inline LADImpact* ladphimg(const LAD* const lad,
 static inline void ladphdet(const LAD* const lad,
 			    LADImpact* const imp,
 			    const int conv_with_rmf,
-			    LADSignalListItem** const siglist,
+			    LADSignalBuffer* const sigbuf,
 			    int* const status)
 {
   // Determine the measured signal.
@@ -284,8 +284,6 @@ static inline void ladphdet(const LAD* const lad,
   fraction1=1.0-fraction2;
 
   // Produce a signal.
-  LADSignalListItem** el=siglist;
-
   LADSignal newsignal;
   newsignal.time     =imp->time+drifttime;
   newsignal.panel    =imp->panel;
@@ -303,44 +301,33 @@ static inline void ladphdet(const LAD* const lad,
   newsignal.signal=fraction1*signal;
   newsignal.anode =anode1;
 
-  // Insert into the time-ordered list.
-  while(NULL!=*el) {
-    if (newsignal.time<(*el)->signal.time) break;
-    el=&((*el)->next);
-  }
-  LADSignalListItem* newel=newLADSignalListItem(status);
+  // Insert into the time-ordered buffer.
+  insertLADSignalBuffer(sigbuf, &newsignal, status);
   CHECK_STATUS_VOID(*status);
-  copyLADSignal(&(newel->signal), &newsignal);
-  newel->next=*el;
-  *el=newel;
 
   // Secondary signal fraction.
   if (anode1!=anode2) {
     newsignal.signal=fraction2*signal;
     newsignal.anode =anode2;
 
-    // Insert into the time-ordered list.
-    while(NULL!=*el) {
-      if (newsignal.time<(*el)->signal.time) break;
-      el=&((*el)->next);
-    }
-    LADSignalListItem* newel=newLADSignalListItem(status);
+    // Insert into the time-ordered buffer.
+    insertLADSignalBuffer(sigbuf, &newsignal, status);
     CHECK_STATUS_VOID(*status);
-    copyLADSignal(&(newel->signal), &newsignal);
-    newel->next=*el;
-    *el=newel;
   }
   // END of loop over adjacent anodes.
 }
 
 
-/** Return recombined events from the detected signals. */
+/** Return recombined events from the detected signals. The signals
+    that might still be combined with subsequent ones are kept in the
+    cache. */
 static inline LADEvent* ladevrecomb(const LAD* const lad,
+				    LADSignalCache* const cache,
 				    LADSignal* const signal,
 				    int* const status)
 {
-  // List of raw event signals.
-  static LADSignalListItem* first=NULL;
+  // First raw event signal in the cache.
+  LADSignal* first=getLADSignalCacheFirst(cache);
 
   // Flag if an event is complete (there will be no further
   // signal contributions).
@@ -348,37 +335,35 @@ static inline LADEvent* ladevrecomb(const LAD* const lad,
   if (NULL!=first) {
     if (NULL==signal) {
       complete=1;
-    } else if (signal->time-first->signal.time>lad->coincidencetime) {
+    } else if (signal->time-first->time>lad->coincidencetime) {
       complete=1;
     }
   }
 
   // Produce a new event.
-  while ((1==complete) && (NULL!=first)) {
+  while ((1==complete) && (NULL!=(first=getLADSignalCacheFirst(cache)))) {
     // Create a new empty event.
     LADEvent* ev=getLADEvent(status);
     CHECK_STATUS_RET(*status, NULL);
 
     // Construct a combined event for output.
-    ev->panel  =first->signal.panel;
-    ev->module =first->signal.module;
-    ev->element=first->signal.element;
-    ev->anode  =first->signal.anode;
-    ev->time   =first->signal.time;
-    ev->signal =first->signal.signal;
+    ev->panel  =first->panel;
+    ev->module =first->module;
+    ev->element=first->element;
+    ev->anode  =first->anode;
+    ev->time   =first->time;
+    ev->signal =first->signal;
     // Set PH_IDs and SRC_IDs.
     long jj;
     for (jj=0; jj<NLADSIGNALPHOTONS; jj++) {
-      ev->ph_id[jj] =first->signal.ph_id[jj];
-      ev->src_id[jj]=first->signal.src_id[jj];
+      ev->ph_id[jj] =first->ph_id[jj];
+      ev->src_id[jj]=first->src_id[jj];
     }
 
-    // Delete the first element from the list.
-    LADSignalListItem* next=first->next;
-    free(first);
-    first=next;
+    // Delete the first element from the cache.
+    removeLADSignalCache(cache, first);
 
-    // Search the list in order to find adjacent signals.
+    // Search the cache in order to find adjacent signals.
     float maxsignal=ev->signal;
 
     long nanodes=
@@ -386,77 +371,47 @@ static inline LADEvent* ladevrecomb(const LAD* const lad,
       element[ev->element]->nanodes;
     long* anodes=malloc(nanodes/2*sizeof(long));
     CHECK_NULL_RET(anodes, *status, "memory allocation for list failed", NULL);
-    long ii;
-    for (ii=1; ii<nanodes/2; ii++) {
-      anodes[ii]=-1;
-    }
     anodes[0]=ev->anode;
+    long nevanodes=1;
+
+    // Only signals on the same (bottom or top) anode line belong to
+    // the event.
+    long anode_min=0, anode_max=nanodes/2;
+    if (ev->anode>=nanodes/2) {
+      anode_min=nanodes/2;
+      anode_max=nanodes;
+    }
 
-    int new=1;
-    while(1==new) {
-      new=0;
-
-      LADSignalListItem** item=&first;
-      while (NULL!=(*item)) {
-
-	// Check if the regarded signal in the list seems to belong to
-	// the same photon event.
-	// Check for the panel, module, and element.
-	if (((*item)->signal.panel==ev->panel) &&
-	    ((*item)->signal.module==ev->module) &&
-	    ((*item)->signal.element==ev->element)) {
-	  // Check for the anode, considering the different (bottom and top)
-	  // anode lines.
-	  if ((((*item)->signal.anode>=nanodes/2)&&(ev->anode>=nanodes/2)) ||
-	      (((*item)->signal.anode< nanodes/2)&&(ev->anode< nanodes/2))) {
-	    for (ii=0; ii<nanodes/2; ii++) {
-	      if (anodes[ii]==-1) break;
-	      if (((*item)->signal.anode==anodes[ii]-1) ||
-		  ((*item)->signal.anode==anodes[ii]+1)) {
-		// Add the signal to the event.
-		ev->signal+=(*item)->signal.signal;
-		if ((*item)->signal.signal>maxsignal) {
-		  maxsignal=(*item)->signal.signal;
-		  ev->anode=(*item)->signal.anode;
-		}
-		long jj;
-		for (jj=0; jj<NLADSIGNALPHOTONS; jj++) {
-		  long kk;
-		  for (kk=0; kk<NLADEVENTPHOTONS; kk++) {
-		    if ((*item)->signal.ph_id[jj]==ev->ph_id[kk]) break;
-		    if (0==ev->ph_id[kk]) {
-		      ev->ph_id[kk] =(*item)->signal.ph_id[jj];
-		      ev->src_id[kk]=(*item)->signal.src_id[jj];
-		      break;
-		    }
-		  }
-		}
-		for (ii=0; ii<nanodes/2; ii++) {
-		  if (anodes[ii]==-1) {
-		    anodes[ii]=(*item)->signal.anode;
-		    break;
-		  }
-		}
-
-		// Delete the signal entry from the list.
-		next=(*item)->next;
-		free((*item));
-		(*item)=next;
-
-		new=1;
-		break;
-	      }
-	    }
-	    // END of loop over all anodes belonging to this signal.
+    // Take the signals on anodes adjacent to the event in the order
+    // in which they have been detected.
+    LADSignal* item;
+    while (NULL!=(item=findLADSignalCacheNeighbour(cache, ev->panel,
+						   ev->module, ev->element,
+						   anodes, nevanodes,
+						   anode_min, anode_max))) {
+      // Add the signal to the event.
+      ev->signal+=item->signal;
+      if (item->signal>maxsignal) {
+	maxsignal=item->signal;
+	ev->anode=item->anode;
+      }
+      for (jj=0; jj<NLADSIGNALPHOTONS; jj++) {
+	long kk;
+	for (kk=0; kk<NLADEVENTPHOTONS; kk++) {
+	  if (item->ph_id[jj]==ev->ph_id[kk]) break;
+	  if (0==ev->ph_id[kk]) {
+	    ev->ph_id[kk] =item->ph_id[jj];
+	    ev->src_id[kk]=item->src_id[jj];
+	    break;
 	  }
 	}
-	// End of check for adjacent signal.
-	if (1==new) break;
-
-	// Move to the next signal in the list.
-	item=&((*item)->next);
       }
-      // End of loop over all signals in the cache.
+      if (nevanodes<nanodes/2) {
+	anodes[nevanodes++]=item->anode;
+      }
+
+      // Delete the signal entry from the cache.
+      removeLADSignalCache(cache, item);
     }
     // End of searching adjacent signals.
 
@@ -481,16 +436,9 @@ static inline LADEvent* ladevrecomb(const LAD* const lad,
 
 
   if (NULL!=signal) {
-    // Move to the end of the list.
-    LADSignalListItem** item=&first;
-    while (NULL!=(*item)) {
-      item=&((*item)->next);
-    }
-
-    // Append the new signal to the end of the list.
-    (*item)=newLADSignalListItem(status);
+    // Append the new signal to the end of the cache.
+    appendLADSignalCache(cache, signal, status);
     CHECK_STATUS_RET(*status, NULL);
-    copyLADSignal(&(*item)->signal, signal);
   }
   return(NULL);
 }
@@ -522,8 +470,11 @@ int ladsim_main()
   // Recombined event list file.
   LADEventFile* elf=NULL;
 
-  // List of measured signals.
-  LADSignalListItem* siglist=NULL;
+  // Time-ordered buffer of measured signals.
+  LADSignalBuffer* sigbuf=NULL;
+
+  // Cache of signals to be recombined to events.
+  LADSignalCache* sigcache=NULL;
 
   // Output file for progress status.
   FILE* progressfile=NULL;
@@ -873,6 +824,12 @@ int ladsim_main()
 
     headas_chat(3, "start simulation ...\n");
 
+    // Buffers for the measured signals.
+    sigbuf=newLADSignalBuffer(&status);
+    CHECK_STATUS_BREAK(status);
+    sigcache=newLADSignalCache(&status);
+    CHECK_STATUS_BREAK(status);
+
     // Simulation progress status (running from 0 to 100).
     int progress=0;
     if (NULL==progressfile) {
@@ -982,7 +939,7 @@ int ladsim_main()
 	  bkgimp->src_id=0;
 
 	  // Insert the background impact into the time-ordered cache.
-	  ladphdet(lad, bkgimp, 0, &siglist, &status);
+	  ladphdet(lad, bkgimp, 0, sigbuf, &status);
 	  CHECK_STATUS_BREAK(status);
 	  readouttime=bkgimp->time;
 
@@ -1005,7 +962,7 @@ int ladsim_main()
 	} else {
 	  // Insert the foreground event.
 	  if (imp->energy>=0.) {
-	    ladphdet(lad, imp, 1, &siglist, &status);
+	    ladphdet(lad, imp, 1, sigbuf, &status);
 	    CHECK_STATUS_BREAK(status);
 	  }
 	  readouttime=imp->time;
@@ -1013,9 +970,8 @@ int ladsim_main()
 	}
 
 	// Determine the signals at the individual anodes.
-	while (NULL!=siglist) {
-
-	  LADSignal* signal=&siglist->signal;
+	LADSignal* signal;
+	while (NULL!=(signal=getLADSignalBufferFirst(sigbuf))) {
 
 	  // Go through the cache of detected signals and read out
 	  // all which happend before imp->time-tDmax. We need to
@@ -1055,10 +1011,8 @@ int ladsim_main()
 		(signal->time-element->asic_readout_time[asic]<
 		 lad->coincidencetime+element->asic_deadtime[asic])) {
 
-	      // Delete the element from the buffered list.
-	      LADSignalListItem* next=siglist->next;
-	      free(siglist);
-	      siglist=next;
+	      // Delete the element from the buffer.
+	      removeLADSignalBufferFirst(sigbuf);
 	      continue;
 	    }
 	  }
@@ -1069,10 +1023,8 @@ int ladsim_main()
 		  (signal->time-element->asic_readout_time[asic2]<
 		   lad->coincidencetime+element->asic_deadtime[asic2])) {
 
-		// Delete the element from the buffered list.
-		LADSignalListItem* next=siglist->next;
-		free(siglist);
-		siglist=next;
+		// Delete the element from the buffer.
+		removeLADSignalBufferFirst(sigbuf);
 		continue;
 	      }
 	    }
@@ -1096,7 +1048,7 @@ int ladsim_main()
 
 	  // Recombine neighboring signals to events.
 	  LADEvent* ev;
-	  while ((ev=ladevrecomb(lad, &siglist->signal, &status))) {
+	  while ((ev=ladevrecomb(lad, sigcache, signal, &status))) {
 	    CHECK_STATUS_BREAK(status);
 
 	    // Add the event to the output file.
@@ -1109,9 +1061,7 @@ int ladsim_main()
 	  // END of loop over all events.
 
 	  // Move to the next entry.
-	  LADSignalListItem* next=siglist->next;
-	  free(siglist);
-	  siglist=next;
+	  removeLADSignalBufferFirst(sigbuf);
 	}
 	CHECK_STATUS_BREAK(status);
 	// END of loop over all signals.
@@ -1139,8 +1089,8 @@ int ladsim_main()
 
     // Make sure that the signal list has been processed until
     // the end of the simulated interval.
-    if (siglist!=NULL) {
-      assert(siglist->signal.time>par.TSTART+par.Exposure);
+    if (NULL!=getLADSignalBufferFirst(sigbuf)) {
+      assert(getLADSignalBufferFirst(sigbuf)->time>par.TSTART+par.Exposure);
     }
 
     // Store the GTI extension in the event file.
@@ -1179,7 +1129,8 @@ int ladsim_main()
   freePhotonFile(&plf, &status);
   freeSourceCatalog(&srccat, &status);
   freeAttitude(&ac);
-  freeLADSignalList(&siglist);
+  freeLADSignalBuffer(&sigbuf);
+  freeLADSignalCache(&sigcache);
   freeLAD(&lad, &status);
   freeSimputSrc(&bkgsrc);
   freeARF(bkgarf);
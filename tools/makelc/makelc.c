@@ -29,8 +29,9 @@ int makelc_main() {
   // Program parameters.
   struct Parameters par;
 
-  // Input event file.
+  // Input event file and the buffer for reading it block-wise.
   fitsfile* infptr=NULL;
+  FitsBlockBuffer* buf=NULL;
 
   // Output light curve.
   long* counts=NULL;
@@ -134,6 +135,21 @@ int makelc_main() {
       counts[ii]=0;
     }
 
+    // The events are read block by block with a single CFITSIO call
+    // per column.
+    buf=newFitsBlockBuffer(infptr, &status);
+    CHECK_STATUS_BREAK(status);
+    int btime=addFitsBlockColumn(buf, ctime, TDOUBLE, 1, &status);
+    int bsignal=-1;
+    if (csignal>0) {
+      bsignal=addFitsBlockColumn(buf, csignal, TFLOAT, 1, &status);
+    }
+    int bpha=-1;
+    if (cpha>0) {
+      bpha=addFitsBlockColumn(buf, cpha, TLONG, 1, &status);
+    }
+    CHECK_STATUS_BREAK(status);
+
     // --- END of Initialization ---
 
 
@@ -143,14 +159,13 @@ int makelc_main() {
     // LOOP over all events in the FITS table.
     for (ii=0; ii<nrows; ii++) {
 
-      // Read the time of the next event from the file.
-      double time;
-      double dnull=0.0;
-      int anynul=0;
-      fits_read_col(infptr, TDOUBLE, ctime, ii+1, 1, 1,
-		    &dnull, &time, &anynul, &status);
+      // Make sure the next event is available in the buffer.
+      long idx=readFitsBlockRow(buf, ii+1, nrows, &status);
       CHECK_STATUS_BREAK(status);
 
+      // Time of the event.
+      double time=FITSBLOCK_COL(buf, btime, double)[idx];
+
       // If the event was detected before the start of the light
       // curve, we have to neglect it.
       if (time<par.TSTART) continue;
@@ -158,11 +173,7 @@ int makelc_main() {
 
       // If necessary, read the energy/signal of the event.
       if (csignal>0) {
-	float signal;
-	float fnull=0.0;
-	fits_read_col(infptr, TFLOAT, csignal, ii+1, 1, 1,
-		      &fnull, &signal, &anynul, &status);
-	CHECK_STATUS_BREAK(status);
+	float signal=FITSBLOCK_COL(buf, bsignal, float)[idx];
 
 	// Check if the energy of the event lies within the
 	// requested range.
@@ -171,11 +182,7 @@ int makelc_main() {
 
       // If necessary, read the energy/signal of the event.
       if (cpha>0) {
-	long pha;
-	long lnull=0;
-	fits_read_col(infptr, TLONG, cpha, ii+1, 1, 1,
-		      &lnull, &pha, &anynul, &status);
-	CHECK_STATUS_BREAK(status);
+	long pha=FITSBLOCK_COL(buf, bpha, long)[idx];
 
 	// Check if the energy of the event lies within the
 	// requested range.
@@ -267,11 +274,7 @@ int makelc_main() {
     // is determined as t(n)=TIMEZERO + TIMEDEL*(n-1).
 
     // Write the data into the table.
-    for (ii=0; ii<nbins; ii++) {
-      fits_write_col(outfptr, TLONG, ccounts, ii+1, 1, 1,
-		     &(counts[ii]), &status);
-      CHECK_STATUS_BREAK(status);
-    }
+    fits_write_col(outfptr, TLONG, ccounts, 1, 1, nbins, counts, &status);
     CHECK_STATUS_BREAK(status);
 
   } while(0); // END of the error handling loop.
@@ -281,6 +284,7 @@ int makelc_main() {
   headas_chat(3, "cleaning up ...\n");
 
   // Close the files.
+  freeFitsBlockBuffer(&buf, &status);
   if (NULL!= infptr) fits_close_file( infptr, &status);
   if (NULL!=outfptr) fits_close_file(outfptr, &status);
 
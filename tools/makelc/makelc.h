@@ -24,6 +24,7 @@
 #define MAKELC_H 1
 
 #include "sixt.h"
+#include "fitsblockbuffer.h"
 
 #define TOOLSUB makelc_main
 #include "headas_main.c"
@@ -32,8 +32,9 @@ int makespec_main() {
   // Full file name with filter.
   char evtlistfiltered[2*MAXFILENAME];
 
-  // Input event file.
+  // Input event file and the buffer for reading it block-wise.
   fitsfile* ef=NULL;
+  FitsBlockBuffer* buf=NULL;
 
   // Output spectrum.
   long* spec=NULL;
@@ -388,6 +389,13 @@ int makespec_main() {
       spec[ii]=0;
     }
 
+    // The events are read block by block with a single CFITSIO call.
+    buf=newFitsBlockBuffer(ef, &status);
+    CHECK_STATUS_BREAK(status);
+    int bsignal=addFitsBlockColumn(buf, csignal,
+				   (1==usesignal) ? TFLOAT : TLONG, 1, &status);
+    CHECK_STATUS_BREAK(status);
+
     // --- END of Initialization ---
 
 
@@ -399,12 +407,9 @@ int makespec_main() {
         for (ii=0; ii<nrows; ii++) {
 
           // Read the next event from the file.
-          float signal;
-          float fnull=0.0;
-          int anynul=0;
-          fits_read_col(ef, TFLOAT, csignal, ii+1, 1, 1,
-    		    &fnull, &signal, &anynul, &status);
+          long bidx=readFitsBlockRow(buf, ii+1, nrows, &status);
           CHECK_STATUS_BREAK(status);
+          float signal=FITSBLOCK_COL(buf, bsignal, float)[bidx];
 
           // Determine the PHA channel.
           long pha=getEBOUNDSChannel(signal, rmf);
@@ -425,12 +430,9 @@ int makespec_main() {
     	for (ii=0; ii<nrows; ii++) {
 
     		// Read the next event from the file.
-    		long signal;
-    		long fnull=0;
-    		int anynul=0;
-    		fits_read_col(ef, TLONG, csignal, ii+1, 1, 1,
-    				&fnull, &signal, &anynul, &status);
+    		long bidx=readFitsBlockRow(buf, ii+1, nrows, &status);
     		CHECK_STATUS_BREAK(status);
+    		long signal=FITSBLOCK_COL(buf, bsignal, long)[bidx];
 
     		// Add the event to the spectrum.
     		long idx=signal-rmf->FirstChannel;
@@ -507,6 +509,7 @@ int makespec_main() {
   headas_chat(3, "cleaning up ...\n");
 
   // Close the files.
+  freeFitsBlockBuffer(&buf, &status);
   if (NULL!=ef) fits_close_file(ef, &status);
   if (NULL!=sf) fits_close_file(sf, &status);
 
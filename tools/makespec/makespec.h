@@ -24,6 +24,7 @@
 #define MAKESPEC_H 1
 
 #include "sixt.h"
+#include "fitsblockbuffer.h"
 #include "rmf.h"
 #include "arf.h"
 #include "gti.h"
@@ -42,6 +42,10 @@ int phogen_main()
   // Photon list file.
   PhotonFile* plf=NULL;
 
+  // Photon generator and buffer for a batch of photons.
+  PhotonGenerator* gen=NULL;
+  Photon* phbuf=NULL;
+
   // Error status.
   int status=EXIT_SUCCESS;
 
@@ -144,28 +148,41 @@ int phogen_main()
     // the requested exposure time.
     // Simulation progress status (running from 0 to 1000).
     int progress=0;
+    gen=newPhotonGenerator(&status);
+    CHECK_STATUS_BREAK(status);
+    phbuf=(Photon*)malloc(PHOGEN_BATCHSIZE*sizeof(Photon));
+    CHECK_NULL_BREAK(phbuf, status, "memory allocation for photon batch failed");
+    int finished=0;
     do {
 
       // Photon generation.
-      Photon ph;
-      int isph=phgen(ac, &srccat, 1,
-		     par.TSTART, par.TSTART+par.Exposure,
-		     par.MJDREF, par.dt,
-		     inst->tel->fov_diameter, &ph, &status);
+      long nph=phgenBatch(gen, ac, &srccat, 1,
+			  par.TSTART, par.TSTART+par.Exposure,
+			  par.MJDREF, par.dt,
+			  inst->tel->fov_diameter, phbuf, PHOGEN_BATCHSIZE,
+			  &status);
       CHECK_STATUS_BREAK(status);
 
       // If no photon has been generated, break the loop.
-      if (0==isph) break;
-
-      // Check if the photon still is within the requested exposre time.
-      if (ph.time>par.TSTART+par.Exposure) break;
-
-      // Write the photon to the output file.
-      status=addPhoton2File(plf, &ph);
+      if (0==nph) break;
+
+      long ii;
+      for (ii=0; ii<nph; ii++) {
+	// Check if the photon still is within the requested exposre time.
+	if (phbuf[ii].time>par.TSTART+par.Exposure) {
+	  finished=1;
+	  break;
+	}
+
+	// Write the photon to the output file.
+	status=addPhoton2File(plf, &phbuf[ii]);
+	CHECK_STATUS_BREAK(status);
+      }
       CHECK_STATUS_BREAK(status);
+      if (0!=finished) break;
 
       // Program progress output.
-      while ((int)((ph.time-par.TSTART)*100./par.Exposure)>progress) {
+      while ((int)((phbuf[ii-1].time-par.TSTART)*100./par.Exposure)>progress) {
 	progress++;
 	headas_chat(2, "\r%.1lf %%", progress*1.);
 	fflush(NULL);
@@ -188,6 +205,8 @@ int phogen_main()
   headas_chat(3, "\ncleaning up ...\n");
 
   // Release memory.
+  if (NULL!=phbuf) free(phbuf);
+  freePhotonGenerator(&gen);
   freePhotonFile(&plf, &status);
   freeSourceCatalog(&srccat, &status);
   freeAttitude(&ac);
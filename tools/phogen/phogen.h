@@ -34,6 +34,9 @@
 #include "simput.h"
 #include "sourcecatalog.h"
 
+/** Number of photons taken from the photon generator at once. */
+#define PHOGEN_BATCHSIZE (1024)
+
 #define TOOLSUB phogen_main
 #include "headas_main.c"
 
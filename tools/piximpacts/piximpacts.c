@@ -39,6 +39,10 @@ int piximpacts_main() {
   // Pixel impact list
   PixImpFile* plf=NULL;
 
+  // Block of impacts and the resulting pixel impacts.
+  Impact* detimp=NULL;
+  PixImpact* piximp=NULL;
+
   // Error status.
   int status=EXIT_SUCCESS;
 
@@ -114,40 +118,38 @@ int piximpacts_main() {
 			   &status);
     CHECK_STATUS_BREAK(status);
 
-    int ii;
-
-    while (ilf->row<ilf->nrows){
-      // event pixel index array
-      long *pixindex=NULL;
-
-      // detector impact
-      Impact detimp;
+    // Impacts are assigned to the pixels in blocks
+    const long blocksize=1024;
+    detimp=(Impact*)malloc(blocksize*sizeof(Impact));
+    CHECK_NULL_BREAK(detimp, status, "memory allocation for impacts failed");
 
-      // pixel impact array
-      PixImpact *piximp=NULL;
+    // pixel impact array
+    long maxpiximp=0;
 
-      // load next impact
-      getNextImpactFromFile(ilf, &detimp, &status);
+    while (ilf->row<ilf->nrows){
+      // load next block of impacts
+      long nimpacts=0;
+      while ((nimpacts<blocksize)&&(ilf->row<ilf->nrows)){
+	getNextImpactFromFile(ilf, &(detimp[nimpacts]), &status);
+	CHECK_STATUS_BREAK(status);
+	nimpacts++;
+      }
       CHECK_STATUS_BREAK(status);
 
-
       // calculate pixel impact parameters
-      int newPixImpacts=AdvImpactList(det, &detimp, &piximp);
-
+      long newPixImpacts=AdvImpactListBatch(det, detimp, nimpacts,
+					    &piximp, &maxpiximp, &status);
+      CHECK_STATUS_BREAK(status);
 
-      if(newPixImpacts>0){
-	for(ii=0; ii<newPixImpacts; ii++){
-	  addImpact2PixImpFile(plf, &(piximp[ii]), &status);
-	}
+      long ii;
+      for(ii=0; ii<newPixImpacts; ii++){
+	addImpact2PixImpFile(plf, &(piximp[ii]), &status);
       }
-
-
-      free(pixindex);
-      free(piximp);
+      CHECK_STATUS_BREAK(status);
     }
+    CHECK_STATUS_BREAK(status);
 
     // Copy the GTI extension into the new file
-    CHECK_STATUS_BREAK(status);
     if(!fits_movnam_hdu(ilf->fptr, BINARY_TBL, "STDGTI", 0, &status)){
       fits_copy_hdu(ilf->fptr, plf->fptr, 0, &status);
       CHECK_STATUS_BREAK(status);
@@ -165,6 +167,8 @@ int piximpacts_main() {
   freeImpactFile(&ilf, &status);
 
   destroyAdvDet(&det);
+  free(detimp);
+  free(piximp);
 
   if (EXIT_SUCCESS==status) {
     headas_chat(3, "finished successfully!\n\n");
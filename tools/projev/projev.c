@@ -49,6 +49,10 @@ struct Parameters {
 
   int Seed;
 
+  /** Number of threads for the sky projection (1: serial, 0: number
+      of available processors). */
+  int nthreads;
+
   char clobber;
   char ProjCenter;
 };
@@ -160,7 +164,8 @@ int projev_main() {
 
     // Run the pattern projection.
     if (NULL!=elf){
-    	phproj(inst, ac, elf, par.TSTART, par.Exposure,&status);
+    	phproj_threads(inst, ac, elf, par.TSTART, par.Exposure, par.nthreads,
+		   &status);
     } else {
     	adv_det = loadAdvDet(par.AdvXml,&status);
 		CHECK_STATUS_BREAK(status);
@@ -310,6 +315,12 @@ int projev_getpar(struct Parameters* par)
     return(status);
   }
 
+  status=ape_trad_query_int("nthreads", &par->nthreads);
+  if (EXIT_SUCCESS!=status) {
+    SIXT_ERROR("failed reading the number of threads");
+    return(status);
+  }
+
   status=ape_trad_query_bool("clobber", &par->clobber);
   if (EXIT_SUCCESS!=status) {
     SIXT_ERROR("failed reading the clobber parameter");
@@ -78,6 +78,8 @@ int psfgen_main()
     psf->energies=NULL;
     psf->thetas  =NULL;
     psf->phis    =NULL;
+    psf->sinphis =NULL;
+    psf->cosphis =NULL;
 
 
     if ((status=PILGetInt("Width", &width))) {
@@ -206,6 +208,9 @@ int psfgen_main()
 		psf->data[count1][count2][count3].naxis2 = width;
 		psf->data[count1][count2][count3].cdelt1 = pixelwidth;
 		psf->data[count1][count2][count3].cdelt2 = pixelwidth;
+		psf->data[count1][count2][count3].cdf    = NULL;
+		psf->data[count1][count2][count3].guide  = NULL;
+		psf->data[count1][count2][count3].nguide = 0;
 
 		psf->data[count1][count2][count3].data = (double**)
 		  malloc(psf->data[count1][count2][count3].naxis1 * sizeof(double**));
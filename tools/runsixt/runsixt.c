@@ -57,6 +57,9 @@ int runsixt_main()
   // Pattern event file.
   EventFile* patf=NULL;
 
+  // Online pattern recombination (if no RawData file is requested).
+  PatternEngine* patengine=NULL;
+
   // Output file for progress status.
   FILE* progressfile=NULL;
 
@@ -290,18 +293,28 @@ int runsixt_main()
       CHECK_STATUS_BREAK(status);
     }
 
+    // If the single-pixel events are not requested and split events
+    // are simulated, the patterns are recombined directly from the
+    // read-out events without an intermediate event file.
+    int online_patterns=0;
+    if ((0!=delete_rawdata)&&(GS_NONE!=inst->det->split->type)) {
+      online_patterns=1;
+    }
+
     // Open the output event list file.
-    elf=openNewEventFile(rawdata_filename,
-			 telescop, instrume, filter,
-			 inst->tel->arf_filename, inst->det->rmf_filename,
-			 par.MJDREF, 0.0, par.TSTART, tstop,
-			 inst->det->pixgrid->xwidth,
-			 inst->det->pixgrid->ywidth,
-			 par.clobber, &status);
-    CHECK_STATUS_BREAK(status);
+    if (0==online_patterns) {
+      elf=openNewEventFile(rawdata_filename,
+			   telescop, instrume, filter,
+			   inst->tel->arf_filename, inst->det->rmf_filename,
+			   par.MJDREF, 0.0, par.TSTART, tstop,
+			   inst->det->pixgrid->xwidth,
+			   inst->det->pixgrid->ywidth,
+			   par.clobber, &status);
+      CHECK_STATUS_BREAK(status);
 
-    // Define the event file as output file.
-    setGenDetEventFile(inst->det, elf);
+      // Define the event file as output file.
+      setGenDetEventFile(inst->det, elf);
+    }
 
     // Open the output pattern list file.
     patf=openNewEventFile(evtfile_filename,
@@ -313,8 +326,22 @@ int runsixt_main()
 			  par.clobber, &status);
     CHECK_STATUS_BREAK(status);
 
+    // Set up the online pattern recombination.
+    if (0!=online_patterns) {
+      char ucase_telescop[MAXMSG];
+      strcpy(ucase_telescop, telescop);
+      strtoupper(ucase_telescop);
+      int iseROSITA=(0==strcmp(ucase_telescop, "EROSITA")) ? 1 : 0;
+      patengine=newPatternEngine(inst->det, patf, par.SkipInvalids,
+				 iseROSITA, &status);
+      CHECK_STATUS_BREAK(status);
+      setGenDetPatternEngine(inst->det, patengine);
+    }
+
     float rotation_angle=inst->det->pixgrid->rota*180./M_PI;
-    fits_update_key(elf->fptr, TFLOAT, "CCDROTA", &rotation_angle, "CCD rotation angle [deg]", &status);
+    if (NULL!=elf) {
+      fits_update_key(elf->fptr, TFLOAT, "CCDROTA", &rotation_angle, "CCD rotation angle [deg]", &status);
+    }
     fits_update_key(patf->fptr, TFLOAT, "CCDROTA", &rotation_angle, "CCD rotation angle [deg]", &status);
     CHECK_STATUS_BREAK(status);
 
@@ -362,13 +389,15 @@ int runsixt_main()
       }
 
       // Event list file.
-      fits_update_key(elf->fptr, TDOUBLE, "RA_PNT", &ra,
-		      "RA of pointing direction [deg]", &status);
-      fits_update_key(elf->fptr, TDOUBLE, "DEC_PNT", &dec,
-		      "Dec of pointing direction [deg]", &status);
-      fits_update_key(elf->fptr, TFLOAT, "PA_PNT", &rollangle,
-		      "Roll angle [deg]", &status);
-      CHECK_STATUS_BREAK(status);
+      if (NULL!=elf) {
+	fits_update_key(elf->fptr, TDOUBLE, "RA_PNT", &ra,
+			"RA of pointing direction [deg]", &status);
+	fits_update_key(elf->fptr, TDOUBLE, "DEC_PNT", &dec,
+			"Dec of pointing direction [deg]", &status);
+	fits_update_key(elf->fptr, TFLOAT, "PA_PNT", &rollangle,
+			"Roll angle [deg]", &status);
+	CHECK_STATUS_BREAK(status);
+      }
 
       // Pattern list file.
       fits_update_key(patf->fptr, TDOUBLE, "RA_PNT", &ra,
@@ -389,28 +418,32 @@ int runsixt_main()
 	fits_update_key(ilf->fptr, TSTRING, "ATTITUDE", par.Attitude,
 			"attitude file", &status);
       }
-      fits_update_key(elf->fptr, TSTRING, "ATTITUDE", par.Attitude,
-		      "attitude file", &status);
+      if (NULL!=elf) {
+	fits_update_key(elf->fptr, TSTRING, "ATTITUDE", par.Attitude,
+			"attitude file", &status);
+      }
       fits_update_key(patf->fptr, TSTRING, "ATTITUDE", par.Attitude,
 		      "attitude file", &status);
       CHECK_STATUS_BREAK(status);
     }
 
-    // Event type.
-    fits_update_key(elf->fptr, TSTRING, "EVTYPE", "PIXEL",
-		    "event type", &status);
-    CHECK_STATUS_BREAK(status);
-
-    // TLMIN and TLMAX of PI column.
     char keystr[MAXMSG];
     long value;
-    sprintf(keystr, "TLMIN%d", elf->cpha);
-    value=inst->det->rmf->FirstChannel;
-    fits_update_key(elf->fptr, TLONG, keystr, &value, "", &status);
-    sprintf(keystr, "TLMAX%d", elf->cpha);
-    value=inst->det->rmf->FirstChannel+inst->det->rmf->NumberChannels-1;
-    fits_update_key(elf->fptr, TLONG, keystr, &value, "", &status);
-    CHECK_STATUS_BREAK(status);
+    if (NULL!=elf) {
+      // Event type.
+      fits_update_key(elf->fptr, TSTRING, "EVTYPE", "PIXEL",
+		      "event type", &status);
+      CHECK_STATUS_BREAK(status);
+
+      // TLMIN and TLMAX of PI column.
+      sprintf(keystr, "TLMIN%d", elf->cpha);
+      value=inst->det->rmf->FirstChannel;
+      fits_update_key(elf->fptr, TLONG, keystr, &value, "", &status);
+      sprintf(keystr, "TLMAX%d", elf->cpha);
+      value=inst->det->rmf->FirstChannel+inst->det->rmf->NumberChannels-1;
+      fits_update_key(elf->fptr, TLONG, keystr, &value, "", &status);
+      CHECK_STATUS_BREAK(status);
+    }
 
     sprintf(keystr, "TLMIN%d", patf->cpha);
     value=inst->det->rmf->FirstChannel;
@@ -545,7 +578,12 @@ int runsixt_main()
     }
 
     // Perform a pattern analysis, only if split events are simulated.
-    if (GS_NONE!=inst->det->split->type) {
+    if (NULL!=patengine) {
+    	// Recombine the events of the last frame.
+    	finalizePatternEngine(patengine, &status);
+    	CHECK_STATUS_BREAK(status);
+
+    } else if (GS_NONE!=inst->det->split->type) {
     	// Pattern analysis.
     	headas_chat(3, "start event pattern analysis ...\n");
     	phpat(inst->det, elf, patf, par.SkipInvalids, &status);
@@ -566,8 +604,10 @@ int runsixt_main()
     }
 
     // Store the GTI extension in the event file.
-    saveGTIExt(elf->fptr, "STDGTI", gti, &status);
-    CHECK_STATUS_BREAK(status);
+    if (NULL!=elf) {
+    	saveGTIExt(elf->fptr, "STDGTI", gti, &status);
+    	CHECK_STATUS_BREAK(status);
+    }
 
     // Close files in order to save memory.
     freePhotonFile(&plf, &status);
@@ -592,7 +632,7 @@ int runsixt_main()
 
     // --- End of simulation process ---
     // remove RawData files if not requested
-    if (delete_rawdata){
+    if (delete_rawdata && (0==online_patterns)){
     	headas_chat(5,"removing unwanted RawData file %s \n",rawdata_filename);
     	status = remove (rawdata_filename);
     	CHECK_STATUS_BREAK(status);
@@ -607,6 +647,7 @@ int runsixt_main()
   headas_chat(3, "\ncleaning up ...\n");
 
   // Release memory.
+  destroyPatternEngine(&patengine);
   freeEventFile(&patf, &status);
   freeEventFile(&elf, &status);
   freeImpactFile(&ilf, &status);
@@ -126,8 +126,7 @@ int tes_grades_main() {
       }
 
       // Update the event information in the file.
-      fits_write_col(elf->fptr, TINT, elf->ctype, row1+1,
-		     1, 1, &ev1.type, &status);
+      updateEventInFile(elf, row1+1, &ev1, &status);
       CHECK_STATUS_BREAK(status);
     }
     CHECK_STATUS_BREAK(status);
@@ -458,6 +458,10 @@ int tesreconstruction_main() {
             CHECK_STATUS_BREAK(status);
             freeTesTriggerFile(&record_fileAux2,&status);
             
+            // In THREADING mode, the scheduler writes the event lists in record
+            // order as soon as they are available
+            if(is_threading()) th_set_output(outfile, record_file->delta_t);
+            
             // Iterate of records and do the reconstruction
             lastRecord = 0, nrecord = 0;    //last record required for SIRENA library creation
             while(getNextRecord(record_file,record,&status))
@@ -498,8 +502,8 @@ int tesreconstruction_main() {
 
                     if ((strcmp(par.EnergyMethod,"PCA") != 0) || ((strcmp(par.EnergyMethod,"PCA") == 0) && lastRecord == 1))
                     {
-                            // In THREADING mode, saveEventListToFile is not called until finishing with calculus 
-                            // (ordering is necessary previously)  
+                            // In THREADING mode, saveEventListToFile is called by the scheduler
+                            // (in record order)
                             if(!is_threading()){    
                                     //printf("\n %p - %f", outfile, record_file->delta_t);
                                     //printf("\nRecord single");
@@ -73,9 +73,17 @@
 #include <sys/time.h>
 
 #include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "rndstream.h"
 
 gsl_rng *rng=NULL; // initialize to NULL and set it in tes_init
 
+// serializes the access to the FITS files when several pixels are
+// propagated in parallel
+pthread_mutex_t tessim_fits_mutex=PTHREAD_MUTEX_INITIALIZER;
+
 const double kBoltz=1.3806488e-23; // Boltzmann constant [m^2 kg/s^2]
 const double eV=1.602176565e-19 ;  // 1eV [J]
 const double keV=1.602176565e-16 ;  // 1keV [J]
@@ -218,7 +226,7 @@ double tnoi(tesparams *tes) {
     gamma=1.;
   }
 
-  return(gsl_ran_gaussian(rng, sqrt(4*kBoltz*tes->T1*tes->T1*G1*gamma*tes->bandwidth) ));
+  return(gsl_ran_gaussian(tes->rng, sqrt(4*kBoltz*tes->T1*tes->T1*G1*gamma*tes->bandwidth) ));
 }
 
 double tpow(tesparams *tes) {
@@ -639,6 +647,7 @@ tesparams *tes_init(tespxlparams *par,int *status) {
     tes->seed=par->seed;
   }
   gsl_rng_set(rng,tes->seed);
+  tes->rng=rng;
 
   // ID of this pixel
   tes->type=strdup(par->type);
@@ -865,244 +874,697 @@ void tes_free(tesparams *tes) {
 
 
 //
-// logic problem in multiple calls: a photon read here that is
-// after tstop will get lost
-int tes_propagate(AdvDet *det, double tstop, int *status) {
-  CHECK_STATUS_RET(*status,-1);
-  // Setup
-  unsigned long samplestep[det->npix];
-  unsigned int samples[det->npix];
-  unsigned long step_nb[det->npix];
+// Is the FDM crosstalk between the pixels of the readout channels
+// simulated?
+static int tes_has_crosstalk(AdvDet *det) {
+  return(det->npix>1 && det->readout_channels != NULL);
+}
 
-  // For FDM Crosstalk: Get initial conditions
-  if (det->npix>1 && det->readout_channels != NULL) {
-    for (int ii=0; ii<det->readout_channels->num_channels; ii++){
-      solve_FDM(&(det->readout_channels->channels[ii]));
+//
+// get the first photon of a pixel and write its initial status to the stream
+static int tes_propagate_start(tesparams *tes, int crosstalk, double tstop, int *status) {
+  // get first photon to deal with
+  tes->impact->time=tstop+100; // initialize to NO photon
+  int success=1; // for tes->get_photon
+  if (tes->get_photon != NULL) {
+    do {
+      success=tes->get_photon(tes->impact,tes->photoninfo,status);
+      CHECK_STATUS_RET(*status,-1);
+      if (success==0) {
+        // there is no further photon to read. Set next impact time to
+        // a time outside much after this
+        tes->impact->time=tstop+100.;
+      }
+    } while (tes->impact->time<tes->tstart && success!=0); // skip over all impacts before tstart
+  }
+
+  // write initial status of the TES to the stream
+  // NB we will need logic in tes->write_to_stream that
+  // disallows duplicate writes of the same element
+  if (tes->write_to_stream != NULL) {
+    double pulse = 0.0;
+    if (crosstalk) {
+      // include Crosstalk
+      tes->Iout_start = gsl_complex_mul(gsl_complex_add_real(tes->Ioverlap , tes->I0_start),gsl_complex_polar(1.,-tes->theta_Vb));
+      gsl_complex Iout; // output current including crosstalk and phase shift
+      // Need to rotate by -1*theta_Vb
+      Iout = gsl_complex_mul(gsl_complex_add_real(tes->Ioverlap, tes->I0),gsl_complex_polar(1.,-tes->theta_Vb));
+
+      if (tes->readoutMode == READOUT_TOTAL){
+        pulse = gsl_complex_abs(tes->Iout_start) - gsl_complex_abs(Iout); // total
+      } else if (tes->readoutMode == READOUT_ICHANNEL){
+        pulse = (GSL_REAL(tes->Iout_start))- GSL_REAL(Iout); // I-Channel
+      } else if (tes->readoutMode == READOUT_QCHANNEL){
+        pulse = GSL_IMAG(tes->Iout_start) - GSL_IMAG(Iout); // Q-Channel
+      }
+    } else {
+      pulse=tes->I0_start-tes->I0;
     }
+    if (tes->simnoise) {
+      pulse += gsl_ran_gaussian(tes->rng,tes->squid_noise*sqrt(tes->bandwidth));
+    }
+    tes->write_to_stream(tes,tes->time,pulse,status);
   }
+  return(0);
+}
 
-  for (int ii=0;ii<det->npix;ii++) {
-    // get the current TES
-    tesparams *tes = det->pix[ii].tes;
-    // get first photon to deal with
-    tes->impact->time=tstop+100; // initialize to NO photon
-    int success=1; // for tes->get_photon
-    if (tes->get_photon != NULL) {
-      do {
-        success=tes->get_photon(tes->impact,tes->photoninfo,status);
-        CHECK_STATUS_RET(*status,-1);
-        if (success==0) {
-          // there is no further photon to read. Set next impact time to
-          // a time outside much after this
-          tes->impact->time=tstop+100.;
-        }
-      } while (tes->impact->time<tes->tstart && success!=0); // skip over all impacts before tstart
+//
+// integrate the differential equations of a pixel over one time step
+static int tes_propagate_step(tesparams *tes, unsigned long *samplestep, unsigned int *samples,
+                              unsigned long *step_nb, double tstop, int *status) {
+  // update progress bar
+  if (tes->progressbar!=NULL && *samplestep == 100000) {
+    progressbar_update(tes->progressbar,
+                       (unsigned long) ((tes->time - tes->tstart)*PROGRESSBAR_FACTOR));
+    *samplestep=0;
+  } else {
+    (*samplestep)++;
+  }
+
+  double Y[2];
+  Y[0]=tes->I0; // current
+  Y[1]=tes->T1; // temperature
+  double dRdI=tes->dRdI(tes, Y); //To reduce computational time!
+
+  if (tes->simnoise) {
+    // thermal noise
+    tes->Pnb1=tnoi(tes);
+
+    // Johnson noise terms
+    // (this should now be ok for the excess noise, but needs somebody
+    // else to check this again to be 100% sure)
+    tes->Vdn =gsl_ran_gaussian(tes->rng,sqrt(4.*kBoltz*tes->T1*tes->RT*tes->bandwidth));
+    tes->Vexc=gsl_ran_gaussian(tes->rng,sqrt(4.*kBoltz*tes->T1*tes->RT*tes->bandwidth*2.*dRdI*tes->I0/tes->RT));
+    tes->Vcn =gsl_ran_gaussian(tes->rng,sqrt(4.*kBoltz*tes->Tb(tes)*tes->Reff*tes->bandwidth));
+    tes->Vunk=gsl_ran_gaussian(tes->rng,sqrt(4.*kBoltz*tes->T1*tes->RT*tes->bandwidth*(1.+2*dRdI*tes->I0/tes->RT)*tes->m_excess*tes->m_excess) );
+    tes->Vbn=gsl_ran_gaussian(tes->rng,tes->bias_noise*sqrt(tes->bandwidth));
+  }
+
+  // absorb next photon?
+  tes->En1=0.;
+  tes->n_absorbed=0;
+  // This while loop handles pileup correctly
+  // i.e. if two photons arrive within one delta_t
+  // their energies are summed up
+  while (tes->time>=tes->impact->time) {
+    tes->Nevts++;
+    tes->n_absorbed++;
+    // increase En1 (note the +=)
+    tes->En1+=tes->impact->energy*keV/(tes->delta_t*tes->therm);
+
+    // remember that we've processed this photon
+    if (tes->write_photon!=NULL) {
+      tes->write_photon(tes,tes->impact->time,tes->impact->ph_id,status);
     }
 
-    // write initial status of the TES to the stream
-    // NB we will need logic in tes->write_to_stream that
-    // disallows duplicate writes of the same element
-    if (tes->write_to_stream != NULL) {
-      double pulse = 0.0;
-      if (det->npix>1 && det->readout_channels != NULL) {
-        // include Crosstalk
-        tes->Iout_start = gsl_complex_mul(gsl_complex_add_real(tes->Ioverlap , tes->I0_start),gsl_complex_polar(1.,-tes->theta_Vb));
-        gsl_complex Iout; // output current including crosstalk and phase shift
-        // Need to rotate by -1*theta_Vb
-        Iout = gsl_complex_mul(gsl_complex_add_real(tes->Ioverlap, tes->I0),gsl_complex_polar(1.,-tes->theta_Vb));
-
-        if (tes->readoutMode == READOUT_TOTAL){
-          pulse = gsl_complex_abs(tes->Iout_start) - gsl_complex_abs(Iout); // total
-        } else if (tes->readoutMode == READOUT_ICHANNEL){
-          pulse = (GSL_REAL(tes->Iout_start))- GSL_REAL(Iout); // I-Channel
-        } else if (tes->readoutMode == READOUT_QCHANNEL){
-          pulse = GSL_IMAG(tes->Iout_start) - GSL_IMAG(Iout); // Q-Channel
-        }
-      } else {
-        pulse=tes->I0_start-tes->I0;
+    // get the next photon
+    int success=tes->get_photon(tes->impact,tes->photoninfo,status);
+    CHECK_STATUS_RET(*status,-1);
+    if (success==0) {
+      // there is no further photon to read. Set next impact time to
+      // a time outside much after this
+      tes->impact->time=tstop+100.;
+    }
+  }
+  int s = GSL_SUCCESS;
+  if (tes->stochastic_integrator) {
+    // number of noise terms included in the stochastic differential equation system
+    int noise_terms = 0;
+    if (tes->simnoise) {
+      noise_terms = 3;
+    }
+    s=sde_step(TES_sde_deterministic,TES_sde_noise,2,noise_terms,Y,tes->delta_t,tes->rng,tes);
+  } else {
+    s=gsl_odeiv2_driver_apply_fixed_step(tes->odedriver,&(tes->time),tes->delta_t,1,Y);
+  }
+  (*samples)++;
+  (*step_nb)++;
+
+  tes->time=tes->tstart+(*step_nb)*tes->delta_t;
+  if (s!=GSL_SUCCESS) {
+    fprintf(stderr,"Driver error: %d\n",s);
+    return(1);
+  }
+
+
+  tes->I0=Y[0];
+  tes->T1=Y[1];
+
+  // Update system properties
+
+  // New resistance value assuming a simple
+  // linear transition with alpha and beta dependence
+  tes->RT=tes->RTI(tes, Y);//tes->R0+tes->dRdT(tes)*(tes->T1-tes->T_start)+tes->dRdI(tes)*(tes->I0-tes->I0_start);
+
+  // thermal power flow
+  tes->Pb1=tpow(tes);
+
+  return(0);
+}
+
+//
+// write the output of a pixel after a time step if the decimation
+// condition is met
+static void tes_propagate_output(tesparams *tes, int crosstalk, unsigned int *samples, int *status) {
+  // TODO: BBFB loop is simulated here at pixel level whereas it should be done at channel level
+  double bbfb_output=0.0;
+  if (tes->dobbfb){
+    // Need to apply SQUID noise before BBFB loop
+    double squid_noise_value = 0;
+    if (tes->simnoise) {
+      squid_noise_value=gsl_ran_gaussian(tes->rng,tes->squid_noise*sqrt(tes->bandwidth));
+    }
+    bbfb_output = tes->apply_bbfb(tes,tes->time,tes->I0,squid_noise_value,tes->rng);
+    tes->decimation_buffer[*samples-1] = bbfb_output;
+  }
+
+  // put the pulse data and the time data into arrays
+  // if the decimation condition is met
+  if (*samples==tes->decimate_factor) {
+
+    // write pulse data
+    // we also add the SQUID/readout noise and subtract the
+    // baseline (the equilibrium bias current) and invert the
+    // pulses so they are all +ve
+    double pulse = 0.0;
+    if (crosstalk) {
+      // Include crosstalk
+      // Calculate output current including phase shift
+      // Need to rotate by -1*theta_Vb
+      gsl_complex Iout = gsl_complex_mul(gsl_complex_add_real(tes->Ioverlap, tes->I0),gsl_complex_polar(1.,-tes->theta_Vb));
+      // write readout to pulse
+      if (tes->readoutMode == READOUT_TOTAL){
+        pulse = gsl_complex_abs(tes->Iout_start) - gsl_complex_abs(Iout); // total
+      }
+      if (tes->readoutMode == READOUT_ICHANNEL){
+        pulse = GSL_REAL(tes->Iout_start) - GSL_REAL(Iout); // I-Channel
+      }
+      if (tes->readoutMode == READOUT_QCHANNEL){
+        pulse = GSL_IMAG(tes->Iout_start) - GSL_IMAG(Iout); // Q-Channel
+      }
+
+    } else if (tes->dobbfb) {
+      // Apply decimation filter to BBFB output if requested, otherwise, use directly last BBFB output
+      double decimation_result=0.;
+      for (unsigned int ii=0;ii<tes->decimate_factor;ii++){
+        decimation_result+=tes->decimation_buffer[ii];
       }
-      if (tes->simnoise) {
-        pulse += gsl_ran_gaussian(rng,tes->squid_noise*sqrt(tes->bandwidth));
+      if (tes->decimation_filter){
+        pulse=sqrt(2)*tes->I0_start-decimation_result/tes->decimate_factor; // SQRT(2) needed for rms to amplitude conversion
+      } else {
+        pulse=sqrt(2)*tes->I0_start-bbfb_output; // SQRT(2) needed for rms to amplitude conversion
       }
+    } else{
+      pulse=tes->I0_start-tes->I0;
+      //pulse=tes->T1;
+    }
+    if (tes->simnoise && !(tes->dobbfb)){
+      pulse += gsl_ran_gaussian(tes->rng,tes->squid_noise);
+    }
+
+    // write the sucker
+    // (note that we do allow NULL here. This could be used,
+    // e.g., to propagate the TES for a while without producing
+    // output)
+    if (tes->write_to_stream != NULL ) {
       tes->write_to_stream(tes,tes->time,pulse,status);
     }
-    samplestep[ii]=100000;
-    samples[ii]=0;
-    step_nb[ii]=0;
+
+    *samples=0;
   }
-  // simulation
-  while (det->pix[0].tes->time<tstop) {
-    for (int ii=0;ii<det->npix;ii++) {
-      // get the current TES
-      tesparams *tes = det->pix[ii].tes;
-
-      // update progress bar
-      if (tes->progressbar!=NULL && samplestep[ii] == 100000) {
-        progressbar_update(tes->progressbar,
-                           (unsigned long) ((tes->time - tes->tstart)*PROGRESSBAR_FACTOR));
-        samplestep[ii]=0;
-      } else {
-        samplestep[ii]++;
-      }
+}
 
-      double Y[2];
-      Y[0]=tes->I0; // current
-      Y[1]=tes->T1; // temperature
-      double dRdI=tes->dRdI(tes, Y); //To reduce computational time!
-
-      if (tes->simnoise) {
-        // thermal noise
-        tes->Pnb1=tnoi(tes);
-
-        // Johnson noise terms
-        // (this should now be ok for the excess noise, but needs somebody
-        // else to check this again to be 100% sure)
-        tes->Vdn =gsl_ran_gaussian(rng,sqrt(4.*kBoltz*tes->T1*tes->RT*tes->bandwidth));
-        tes->Vexc=gsl_ran_gaussian(rng,sqrt(4.*kBoltz*tes->T1*tes->RT*tes->bandwidth*2.*dRdI*tes->I0/tes->RT));
-        tes->Vcn =gsl_ran_gaussian(rng,sqrt(4.*kBoltz*tes->Tb(tes)*tes->Reff*tes->bandwidth));
-        tes->Vunk=gsl_ran_gaussian(rng,sqrt(4.*kBoltz*tes->T1*tes->RT*tes->bandwidth*(1.+2*dRdI*tes->I0/tes->RT)*tes->m_excess*tes->m_excess) );
-        tes->Vbn=gsl_ran_gaussian(rng,tes->bias_noise*sqrt(tes->bandwidth));
-      }
+//
+// group of pixels that is propagated together. The pixels of a
+// readout channel are coupled by the FDM crosstalk and have to be
+// propagated in lockstep, all other pixels are independent.
+typedef struct {
+  tesparams **pixels; // pixels of this group
+  int npix;           // number of pixels
+  Channel *channel;   // readout channel (NULL if there is no crosstalk)
+  double time0;       // simulation time of the first pixel at the start
+
+  unsigned long *samplestep; // progress bar counter of each pixel
+  unsigned int *samples;     // samples since the last output of each pixel
+  unsigned long *step_nb;    // number of time steps of each pixel
+
+  int nteam;          // number of threads working on this group
+  pthread_barrier_t barrier; // synchronizes the threads in each time step
+  int *failed;        // error flag of each thread of the team
+} tes_pixel_group;
+
+// information shared by all threads of the parallel propagation
+typedef struct {
+  tes_pixel_group *groups;
+  int ngroups;
+  int nextgroup;      // next group to be taken by a thread without team
+  double tstop;
+  int ret;            // return value (first error)
+  int status;         // error status
+  int start;          // 0: wait, 1: propagate, -1: abort
+  pthread_cond_t startcond;
+  pthread_mutex_t mutex;
+} tes_propagate_info;
+
+// argument of a thread of the parallel propagation
+typedef struct {
+  tes_propagate_info *info;
+  tes_pixel_group *group; // group of the team or NULL
+  int rank;               // index of the thread in the team
+} tes_propagate_thread_info;
 
-      // absorb next photon?
-      tes->En1=0.;
-      tes->n_absorbed=0;
-      // This while loop handles pileup correctly
-      // i.e. if two photons arrive within one delta_t
-      // their energies are summed up
-      while (tes->time>=tes->impact->time) {
-        tes->Nevts++;
-        tes->n_absorbed++;
-        // increase En1 (note the +=)
-        tes->En1+=tes->impact->energy*keV/(tes->delta_t*tes->therm);
-
-        // remember that we've processed this photon
-        if (tes->write_photon!=NULL) {
-          tes->write_photon(tes,tes->impact->time,tes->impact->ph_id,status);
-        }
+//
+// propagate a group of pixels until tstop. If the group is handled by
+// a team of several threads, each thread deals with every nteam-th
+// pixel and the threads are synchronized before and after the
+// calculation of the crosstalk.
+static int tes_propagate_group(tes_pixel_group *group, int rank, double tstop, int *status) {
+  int crosstalk=(group->channel!=NULL);
+  int ret=0;
+
+  // initial conditions of the crosstalk
+  if (crosstalk && rank==0) {
+    solve_FDM(group->channel);
+  }
+  if (group->nteam>1) {
+    pthread_barrier_wait(&group->barrier);
+  }
+  for (int ii=rank;ii<group->npix && ret==0;ii+=group->nteam) {
+    ret=tes_propagate_start(group->pixels[ii],crosstalk,tstop,status);
+  }
 
-        // get the next photon
-        int success=tes->get_photon(tes->impact,tes->photoninfo,status);
-        CHECK_STATUS_RET(*status,-1);
-        if (success==0) {
-          // there is no further photon to read. Set next impact time to
-          // a time outside much after this
-          tes->impact->time=tstop+100.;
-        }
+  // the time of the first pixel determines the end of the simulation
+  // (the same way as in the serial propagation)
+  tesparams *tes0=group->pixels[0];
+  double time=group->time0;
+  unsigned long nstep=0;
+  while (time<tstop) {
+    for (int ii=rank;ii<group->npix && ret==0;ii+=group->nteam) {
+      ret=tes_propagate_step(group->pixels[ii],&group->samplestep[ii],&group->samples[ii],
+                             &group->step_nb[ii],tstop,status);
+    }
+    group->failed[rank]=(ret!=0 || *status!=EXIT_SUCCESS);
+
+    if (group->nteam>1) {
+      pthread_barrier_wait(&group->barrier);
+    }
+    int failed=0;
+    for (int jj=0;jj<group->nteam;jj++) {
+      failed|=group->failed[jj];
+    }
+    if (failed) {
+      break;
+    }
+
+    // Calculate FDM Crosstalk.
+    if (crosstalk) {
+      if (rank==0) {
+        solve_FDM(group->channel);
       }
-      int s = GSL_SUCCESS;
-      if (tes->stochastic_integrator) {
-		  // number of noise terms included in the stochastic differential equation system
-		  int noise_terms = 0;
-		  if (tes->simnoise) {
-			  noise_terms = 3;
-		  }
-		  s=sde_step(TES_sde_deterministic,TES_sde_noise,2,noise_terms,Y,tes->delta_t,rng,tes);
-	  } else {
-		  s=gsl_odeiv2_driver_apply_fixed_step(tes->odedriver,&(tes->time),tes->delta_t,1,Y);
-	  }
-      samples[ii]++;
-      step_nb[ii]++;
-
-      tes->time=tes->tstart+step_nb[ii]*tes->delta_t;
-      if (s!=GSL_SUCCESS) {
-        fprintf(stderr,"Driver error: %d\n",s);
-        return(1);
+      if (group->nteam>1) {
+        pthread_barrier_wait(&group->barrier);
       }
+    }
 
+    for (int ii=rank;ii<group->npix;ii+=group->nteam) {
+      tes_propagate_output(group->pixels[ii],crosstalk,&group->samples[ii],status);
+    }
+
+    nstep++;
+    time=tes0->tstart+nstep*tes0->delta_t;
+  }
 
-      tes->I0=Y[0];
-      tes->T1=Y[1];
+  return(ret);
+}
 
-      // Update system properties
+static void *tes_propagate_thread(void *arg) {
+  tes_propagate_thread_info *thr=(tes_propagate_thread_info *) arg;
+  tes_propagate_info *info=thr->info;
+  int status=EXIT_SUCCESS;
+  int ret=0;
 
-      // New resistance value assuming a simple
-      // linear transition with alpha and beta dependence
-      tes->RT=tes->RTI(tes, Y);//tes->R0+tes->dRdT(tes)*(tes->T1-tes->T_start)+tes->dRdI(tes)*(tes->I0-tes->I0_start);
+  // wait until all threads have been started
+  pthread_mutex_lock(&info->mutex);
+  while (info->start==0) {
+    pthread_cond_wait(&info->startcond,&info->mutex);
+  }
+  int abort=(info->start<0);
+  pthread_mutex_unlock(&info->mutex);
+  if (abort) {
+    return(NULL);
+  }
 
-      // thermal power flow
-      tes->Pb1=tpow(tes);
+  if (thr->group!=NULL) {
+    // member of the team of a single group
+    ret=tes_propagate_group(thr->group,thr->rank,info->tstop,&status);
+  } else {
+    // take one group after the other
+    while (ret==0 && status==EXIT_SUCCESS) {
+      pthread_mutex_lock(&info->mutex);
+      int ig=info->nextgroup++;
+      pthread_mutex_unlock(&info->mutex);
+      if (ig>=info->ngroups) {
+        break;
+      }
+      ret=tes_propagate_group(&info->groups[ig],0,info->tstop,&status);
     }
+  }
 
-    // Calculate FDM Crosstalk.
-    if (det->npix>1 && det->readout_channels != NULL) {
+  pthread_mutex_lock(&info->mutex);
+  if (status!=EXIT_SUCCESS) {
+    info->status=status;
+  }
+  if (ret!=0 && info->ret==0) {
+    info->ret=ret;
+  }
+  pthread_mutex_unlock(&info->mutex);
+
+  return(NULL);
+}
+
+//
+// read all impacts of a pixel into memory, such that the threads do
+// not need to access the impact files
+static tes_impactbuffer_info *tes_preload_impacts(tesparams *tes, int *status) {
+  tes_impactbuffer_info *buf=malloc(sizeof(tes_impactbuffer_info));
+  CHECK_NULL_RET(buf,*status,"Memory allocation failed for impact buffer",NULL);
+  buf->impacts=NULL;
+  buf->numimpacts=0;
+  buf->nextimpact=0;
+
+  long maximpacts=0;
+  while (1) {
+    if (buf->numimpacts>=maximpacts) {
+      maximpacts=MAX(2*maximpacts,1024);
+      PixImpact *impacts=realloc(buf->impacts,maximpacts*sizeof(PixImpact));
+      CHECK_NULL_BREAK(impacts,*status,"Memory allocation failed for impact buffer");
+      buf->impacts=impacts;
+    }
+    if (tes->get_photon(&buf->impacts[buf->numimpacts],tes->photoninfo,status)==0) {
+      break;
+    }
+    CHECK_STATUS_BREAK(*status);
+    buf->numimpacts++;
+  }
+  return(buf);
+}
+
+//
+// propagate the pixels in several threads. Each pixel gets its own
+// random number generator and impact buffer. Pixels without FDM
+// crosstalk are independent, readout channels with crosstalk are
+// propagated as a whole. If there are less groups than threads,
+// the pixels of a group are distributed over a team of threads,
+// which are synchronized in each time step.
+static int tes_propagate_parallel(AdvDet *det, double tstop, int nthreads, int *status) {
+  int crosstalk=tes_has_crosstalk(det);
+  if (nthreads<=0) {
+    nthreads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  nthreads=MAX(nthreads,1);
+
+  tes_propagate_info info;
+  info.groups=calloc(det->npix,sizeof(tes_pixel_group));
+  CHECK_NULL_RET(info.groups,*status,"Memory allocation failed for pixel groups",-1);
+  info.ngroups=0;
+  info.nextgroup=0;
+  info.tstop=tstop;
+  info.ret=0;
+  info.status=EXIT_SUCCESS;
+  info.start=0;
+  pthread_cond_init(&info.startcond,NULL);
+  pthread_mutex_init(&info.mutex,NULL);
+
+  tes_impactbuffer_info **impbuf=calloc(det->npix,sizeof(tes_impactbuffer_info *));
+  void **photoninfo=calloc(det->npix,sizeof(void *));
+  tes_photon_provider *get_photon=calloc(det->npix,sizeof(tes_photon_provider));
+  gsl_rng **shared_rng=calloc(det->npix,sizeof(gsl_rng *));
+  int *assigned=calloc(det->npix,sizeof(int));
+  tes_propagate_thread_info *thr=NULL;
+  pthread_t *tid=NULL;
+  int nstarted=0;
+
+  do { // start of error handling loop
+    if (impbuf==NULL || photoninfo==NULL || get_photon==NULL ||
+        shared_rng==NULL || assigned==NULL) {
+      SIXT_ERROR("Memory allocation failed for parallel propagation");
+      *status=EXIT_FAILURE;
+      break;
+    }
+
+    // set up the pixel groups: one per readout channel with crosstalk
+    // and one per remaining pixel
+    if (crosstalk) {
       for (int ii=0; ii<det->readout_channels->num_channels; ii++){
-        solve_FDM(&(det->readout_channels->channels[ii]));
+        Channel *chan=&(det->readout_channels->channels[ii]);
+        if (chan->num_pixels==0) {
+          continue;
+        }
+        tes_pixel_group *group=&info.groups[info.ngroups++];
+        group->channel=chan;
+        group->npix=chan->num_pixels;
+        group->pixels=malloc(group->npix*sizeof(tesparams *));
+        CHECK_NULL_BREAK(group->pixels,*status,"Memory allocation failed for pixel groups");
+        for (int jj=0; jj<chan->num_pixels; jj++) {
+          group->pixels[jj]=chan->pixels[jj]->tes;
+          long ip=chan->pixels[jj]-det->pix;
+          if (ip>=0 && ip<det->npix) {
+            assigned[ip]=1;
+          }
+        }
       }
+      CHECK_STATUS_BREAK(*status);
     }
-
     for (int ii=0;ii<det->npix;ii++) {
-      // get the current TES
-      tesparams *tes = det->pix[ii].tes;
-
+      if (assigned[ii]) {
+        continue;
+      }
+      tes_pixel_group *group=&info.groups[info.ngroups++];
+      group->channel=NULL;
+      group->npix=1;
+      group->pixels=malloc(sizeof(tesparams *));
+      CHECK_NULL_BREAK(group->pixels,*status,"Memory allocation failed for pixel groups");
+      group->pixels[0]=det->pix[ii].tes;
+    }
+    CHECK_STATUS_BREAK(*status);
+
+    // distribute the threads: either each thread takes complete
+    // groups or each group gets a team of threads
+    int team=(info.ngroups<nthreads);
+    int nthr=0;
+    for (int ii=0;ii<info.ngroups;ii++) {
+      tes_pixel_group *group=&info.groups[ii];
+      group->nteam=1;
+      if (team) {
+        group->nteam=nthreads/info.ngroups+(ii<nthreads%info.ngroups);
+        group->nteam=MAX(MIN(group->nteam,group->npix),1);
+        nthr+=group->nteam;
+      }
+      group->time0=group->pixels[0]->time;
+      group->samplestep=malloc(group->npix*sizeof(unsigned long));
+      group->samples=malloc(group->npix*sizeof(unsigned int));
+      group->step_nb=malloc(group->npix*sizeof(unsigned long));
+      group->failed=calloc(group->nteam,sizeof(int));
+      if (group->samplestep==NULL || group->samples==NULL ||
+          group->step_nb==NULL || group->failed==NULL) {
+        SIXT_ERROR("Memory allocation failed for pixel groups");
+        *status=EXIT_FAILURE;
+        break;
+      }
+      for (int jj=0;jj<group->npix;jj++) {
+        group->samplestep[jj]=100000;
+        group->samples[jj]=0;
+        group->step_nb[jj]=0;
+      }
+      if (group->nteam>1) {
+        pthread_barrier_init(&group->barrier,NULL,group->nteam);
+      }
+    }
+    CHECK_STATUS_BREAK(*status);
+    if (!team) {
+      nthr=nthreads;
+    }
 
-      // TODO: BBFB loop is simulated here at pixel level whereas it should be done at channel level
-      double bbfb_output=0.0;
-      if (tes->dobbfb){
-    	// Need to apply SQUID noise before BBFB loop
-		double squid_noise_value = 0;
-		if (tes->simnoise) {
-		  squid_noise_value=gsl_ran_gaussian(rng,tes->squid_noise*sqrt(tes->bandwidth));
-		}
-    	bbfb_output = tes->apply_bbfb(tes,tes->time,tes->I0,squid_noise_value,rng);
-    	tes->decimation_buffer[samples[ii]-1] = bbfb_output;
+    // random number generators and impact buffers of the pixels
+    for (int ii=0;ii<det->npix;ii++) {
+      tesparams *tes=det->pix[ii].tes;
+      shared_rng[ii]=tes->rng;
+      tes->rng=gsl_rng_alloc(gsl_rng_taus);
+      CHECK_NULL_BREAK(tes->rng,*status,"Memory allocation failed for random number generator");
+      // derive an independent seed for each pixel
+      RndStream rs;
+      initRndStream(&rs,(unsigned int) tes->seed,getRndStreamId(0,(uint32_t) tes->id));
+      gsl_rng_set(tes->rng,getRndStreamUInt32(&rs));
+
+      photoninfo[ii]=tes->photoninfo;
+      get_photon[ii]=tes->get_photon;
+      if (tes->get_photon!=NULL) {
+        impbuf[ii]=tes_preload_impacts(tes,status);
+        CHECK_STATUS_BREAK(*status);
+        tes->photoninfo=impbuf[ii];
+        tes->get_photon=&tes_photon_from_impactbuffer;
       }
+    }
+    CHECK_STATUS_BREAK(*status);
 
-      // put the pulse data and the time data into arrays
-      // if the decimation condition is met
-      if (samples[ii]==tes->decimate_factor) {
-
-        // write pulse data
-        // we also add the SQUID/readout noise and subtract the
-        // baseline (the equilibrium bias current) and invert the
-        // pulses so they are all +ve
-        double pulse = 0.0;
-        if (det->npix>1 && det->readout_channels != NULL) {
-          // Include crosstalk
-          // Calculate output current including phase shift
-          // Need to rotate by -1*theta_Vb
-          gsl_complex Iout = gsl_complex_mul(gsl_complex_add_real(tes->Ioverlap, tes->I0),gsl_complex_polar(1.,-tes->theta_Vb));
-          // write readout to pulse
-          if (tes->readoutMode == READOUT_TOTAL){
-            pulse = gsl_complex_abs(tes->Iout_start) - gsl_complex_abs(Iout); // total
-          }
-          if (tes->readoutMode == READOUT_ICHANNEL){
-            pulse = GSL_REAL(tes->Iout_start) - GSL_REAL(Iout); // I-Channel
-          }
-          if (tes->readoutMode == READOUT_QCHANNEL){
-            pulse = GSL_IMAG(tes->Iout_start) - GSL_IMAG(Iout); // Q-Channel
-          }
+    headas_chat(3,"propagate %d pixel group(s) with %d thread(s) ...\n",info.ngroups,nthr);
 
-        } else if (tes->dobbfb) {
-          // Apply decimation filter to BBFB output if requested, otherwise, use directly last BBFB output
-          double decimation_result=0.;
-          for (unsigned int ii=0;ii<tes->decimate_factor;ii++){
-            decimation_result+=tes->decimation_buffer[ii];
-          }
-          if (tes->decimation_filter){
-            pulse=sqrt(2)*tes->I0_start-decimation_result/tes->decimate_factor; // SQRT(2) needed for rms to amplitude conversion
-          } else {
-            pulse=sqrt(2)*tes->I0_start-bbfb_output; // SQRT(2) needed for rms to amplitude conversion
-          }
-        } else{
-          pulse=tes->I0_start-tes->I0;
-          //pulse=tes->T1;
+    thr=malloc(nthr*sizeof(tes_propagate_thread_info));
+    tid=malloc(nthr*sizeof(pthread_t));
+    if (thr==NULL || tid==NULL) {
+      SIXT_ERROR("Memory allocation failed for threads");
+      *status=EXIT_FAILURE;
+      break;
+    }
+    int ithr=0;
+    for (int ii=0;ii<(team ? info.ngroups : 1);ii++) {
+      int nmember=(team ? info.groups[ii].nteam : nthr);
+      for (int jj=0;jj<nmember;jj++) {
+        thr[ithr].info=&info;
+        thr[ithr].group=(team ? &info.groups[ii] : NULL);
+        thr[ithr].rank=(team ? jj : 0);
+        ithr++;
+      }
+    }
+    for (ithr=0;ithr<nthr;ithr++) {
+      if (pthread_create(&tid[ithr],NULL,tes_propagate_thread,&thr[ithr])!=0) {
+        break;
+      }
+      nstarted++;
+    }
+    // release the threads. The members of an incomplete team would
+    // wait for the missing ones forever, so in that case all threads
+    // are stopped again.
+    int abort=(team && nstarted<nthr);
+    pthread_mutex_lock(&info.mutex);
+    info.start=(abort ? -1 : 1);
+    pthread_cond_broadcast(&info.startcond);
+    pthread_mutex_unlock(&info.mutex);
+    if (nstarted<nthr) {
+      SIXT_WARNING("failed to start all threads for the propagation");
+      if (abort) {
+        for (ithr=0;ithr<nstarted;ithr++) {
+          pthread_join(tid[ithr],NULL);
         }
-        if (tes->simnoise && !(tes->dobbfb)){
-          pulse += gsl_ran_gaussian(rng,tes->squid_noise);
+        nstarted=0;
+        // propagate the groups one after the other without teams
+        for (int ii=0;ii<info.ngroups;ii++) {
+          tes_pixel_group *group=&info.groups[ii];
+          if (group->nteam>1) {
+            pthread_barrier_destroy(&group->barrier);
+            group->nteam=1;
+          }
         }
+        info.start=1;
+        thr[0].group=NULL;
+      }
+      // otherwise the remaining groups are taken by the threads
+      // already running
+      if (nstarted==0) {
+        tes_propagate_thread(&thr[0]);
+      }
+    }
+  } while(0); // end of error handling loop
 
-        // write the sucker
-        // (note that we do allow NULL here. This could be used,
-        // e.g., to propagate the TES for a while without producing
-        // output)
-        if (tes->write_to_stream != NULL ) {
-          tes->write_to_stream(tes,tes->time,pulse,status);
-        }
+  for (int ithr=0;ithr<nstarted;ithr++) {
+    pthread_join(tid[ithr],NULL);
+  }
+  if (*status==EXIT_SUCCESS) {
+    *status=info.status;
+  }
+
+  // restore the impact providers and random number generators
+  for (int ii=0;ii<det->npix && impbuf!=NULL && shared_rng!=NULL;ii++) {
+    tesparams *tes=det->pix[ii].tes;
+    if (impbuf[ii]!=NULL) {
+      tes_free_impactbuffer(&impbuf[ii],status);
+      tes->photoninfo=photoninfo[ii];
+      tes->get_photon=get_photon[ii];
+    }
+    if (shared_rng[ii]!=NULL) {
+      if (tes->rng!=NULL) {
+        gsl_rng_free(tes->rng);
+      }
+      tes->rng=shared_rng[ii];
+    }
+  }
+  for (int ii=0;ii<info.ngroups;ii++) {
+    tes_pixel_group *group=&info.groups[ii];
+    if (group->nteam>1 && group->failed!=NULL) {
+      pthread_barrier_destroy(&group->barrier);
+    }
+    free(group->pixels);
+    free(group->samplestep);
+    free(group->samples);
+    free(group->step_nb);
+    free(group->failed);
+  }
+  free(info.groups);
+  pthread_cond_destroy(&info.startcond);
+  pthread_mutex_destroy(&info.mutex);
+  free(impbuf);
+  free(photoninfo);
+  free(get_photon);
+  free(shared_rng);
+  free(assigned);
+  free(thr);
+  free(tid);
+
+  return(info.ret);
+}
+
+//
+// logic problem in multiple calls: a photon read here that is
+// after tstop will get lost
+int tes_propagate(AdvDet *det, double tstop, int nthreads, int *status) {
+  CHECK_STATUS_RET(*status,-1);
+
+  // independent pixels or readout channels can be propagated in
+  // parallel
+  if (nthreads!=1) {
+    return(tes_propagate_parallel(det,tstop,nthreads,status));
+  }
+
+  // Setup
+  unsigned long samplestep[det->npix];
+  unsigned int samples[det->npix];
+  unsigned long step_nb[det->npix];
+  int crosstalk=tes_has_crosstalk(det);
+
+  // For FDM Crosstalk: Get initial conditions
+  if (crosstalk) {
+    for (int ii=0; ii<det->readout_channels->num_channels; ii++){
+      solve_FDM(&(det->readout_channels->channels[ii]));
+    }
+  }
+
+  for (int ii=0;ii<det->npix;ii++) {
+    int ret=tes_propagate_start(det->pix[ii].tes,crosstalk,tstop,status);
+    if (ret!=0) {
+      return(ret);
+    }
+    samplestep[ii]=100000;
+    samples[ii]=0;
+    step_nb[ii]=0;
+  }
+  // simulation
+  while (det->pix[0].tes->time<tstop) {
+    for (int ii=0;ii<det->npix;ii++) {
+      int ret=tes_propagate_step(det->pix[ii].tes,&samplestep[ii],&samples[ii],&step_nb[ii],tstop,status);
+      if (ret!=0) {
+        return(ret);
+      }
+    }
 
-        samples[ii]=0;
+    // Calculate FDM Crosstalk.
+    if (crosstalk) {
+      for (int ii=0; ii<det->readout_channels->num_channels; ii++){
+        solve_FDM(&(det->readout_channels->channels[ii]));
       }
+    }
 
+    for (int ii=0;ii<det->npix;ii++) {
+      tes_propagate_output(det->pix[ii].tes,crosstalk,&samples[ii],status);
     }
   }
   return(0);
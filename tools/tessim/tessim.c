@@ -309,7 +309,7 @@ int tessim_main() {
     }
 
     // Run the simulation
-    tes_propagate(det,par.tstop,&status);
+    tes_propagate(det,par.tstop,par.nthreads,&status);
 
     /** LOOP FOR MULTI TESSIM START */
     for (int ii=0;ii<det->npix;ii++) {
@@ -589,6 +589,8 @@ void tessim_getpar(tespxlparams *par, AdvDet **det, int *properties, int *status
 
   query_simput_parameter_bool("progressbar",&par->showprogress,status);
 
+  query_simput_parameter_int("nthreads",&par->nthreads,status);
+
   query_simput_parameter_bool("clobber", &par->clobber, status);
 
   // query parameter for calculating I0 via the thermal balance
@@ -42,6 +42,8 @@
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_cdf.h>
 
+#include <pthread.h>
+
 // readout modes for tessim
 #define READOUT_TOTAL 0
 #define READOUT_ICHANNEL 1
@@ -128,6 +130,8 @@ typedef struct {
 
   int readoutMode; // readout mode (total, Ichannel, Qchannel)
 
+  int nthreads; // number of threads (1: serial, 0: number of processors)
+
 } tespxlparams;
 
 
@@ -265,7 +269,14 @@ void tes_free_trigger(tes_trigger_info **data, int *status);
 
 // general functions
 tesparams *tes_init(tespxlparams *par,int *status);
-int tes_propagate(AdvDet *det, double tstop, int *status);
+// nthreads=1: serial propagation of all pixels with the common random
+// number generator; otherwise independent pixels/readout channels are
+// propagated in nthreads threads (0: number of processors) with a
+// random number generator for each pixel
+int tes_propagate(AdvDet *det, double tstop, int nthreads, int *status);
+
+// protects the output files if pixels are propagated in parallel
+extern pthread_mutex_t tessim_fits_mutex;
 void tes_free(tesparams *tes);
 void tes_print_params(tesparams *tes);
 void tes_fits_write_params(fitsfile *fptr,tesparams *tes, int *status);
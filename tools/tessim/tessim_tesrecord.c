@@ -86,7 +86,9 @@ void tes_append_tesrecord(tesparams *tes,double time,double pulse, int *status)
 
   // FIXME: should these to numbers not be of the same type by default then?
   if ((unsigned long) data->streamind==data->stream->trigger_size) {
+    pthread_mutex_lock(&tessim_fits_mutex);
     tes_write_tesrecord(tes,status);
+    pthread_mutex_unlock(&tessim_fits_mutex);
     data->streamind=0;
     // avoid roundoff
     data->stream->time+=data->stream->delta_t*data->stream->trigger_size;
@@ -296,7 +296,9 @@ void tes_append_trigger(tesparams *tes,double time,double pulse, int *status) {
     // is the buffer filled?
     if (data->streamind==data->stream->trigger_size) {
       // yes: write to file and forget this record
+      pthread_mutex_lock(&tessim_fits_mutex);
       writeRecord(data->fptr,data->stream,status);
+      pthread_mutex_unlock(&tessim_fits_mutex);
       CHECK_STATUS_VOID(*status);
 
       freeTesRecord(&(data->stream)); // also sets data->stream to NULL
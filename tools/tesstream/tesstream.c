@@ -33,17 +33,12 @@ int tesstream_main() {
   // Error status.
   int status=EXIT_SUCCESS;
 
-  int Nstreams=0;
   TESInitStruct* init=NULL;
-  TESFitsStream** fitsstream=NULL;
-  TESDataStream* stream=NULL;
   fitsfile *ofptr=NULL;
 
   int ismonoc=0;
   float monoen=0.;
 
-  int ii;
-
   // Register HEATOOL:
   set_toolname("tesstream");
   set_toolversion("0.05");
@@ -65,38 +60,6 @@ int tesstream_main() {
     tesinitialization(init,&par,&status);
     CHECK_STATUS_BREAK(status);
 
-    // Generate the data
-    stream=newTESDataStream(&status);
-    CHECK_STATUS_BREAK(status);
-
-    getTESDataStream(stream,
-		     init->impfile,
-		     init->profiles,
-		     init->det,
-		     init->tstart,
-		     init->tstop,
-		     init->det->npix,
-		     par.Nactive,
-		     init->activearray,
-		     init->Nevts,
-		     &ismonoc,
-		     &monoen,
-		     par.seed,
-		     &status);
-    CHECK_STATUS_BREAK(status);
-
-    // Get output data arrays
-    Nstreams=(par.Nactive+TESFITSMAXPIX-1)/TESFITSMAXPIX;
-    fitsstream=(TESFitsStream**)malloc(Nstreams*sizeof(TESFitsStream*));
-    if(fitsstream==NULL){
-      status=EXIT_FAILURE;
-      SIXT_ERROR("memory allocation for FITS streams failed");
-      CHECK_STATUS_BREAK(status);
-    }
-    for(ii=0; ii<Nstreams; ii++){
-      fitsstream[ii]=newTESFitsStream(&status);
-      CHECK_STATUS_BREAK(status);
-    }
     createTESFitsStreamFile(&ofptr,
 			    par.streamname,
 			    init->telescop,
@@ -114,81 +77,36 @@ int tesstream_main() {
 			    &status);
     CHECK_STATUS_BREAK(status);
 
-    // Write the output file
-
-    int restpix=par.Nactive;
-    for(ii=0; ii<Nstreams; ii++){
-      // print extension name
-      sprintf(fitsstream[ii]->name, "ADC%03d", ii+1);
-
-      // calculate number of pixels in the extension
-      int extpix=TESFITSMAXPIX;
-      if(extpix>restpix){
-	extpix=restpix;
-      }
-
-      // allocate memory for fits stream
-      allocateTESFitsStream(fitsstream[ii],
-			   stream->Ntime,
-			   extpix,
-			   &status);
-      CHECK_STATUS_BREAK(status);
-
-      // transfer values into fits stream
-      int pp, tt, ll, id;
-      // time array
-      for(tt=0; tt<stream->Ntime; tt++){
-	fitsstream[ii]->time[tt]=stream->time[tt];
-      }
-      // find the ofiginal pixel id (reverse of the activearray)
-      for(pp=0; pp<extpix; pp++){
-	id=-1;
-	for(ll=0; ll<init->det->npix; ll++){
-	  if(init->activearray[ll]==par.Nactive-restpix+pp){
-	    id=ll;
-	  }
-	}
-	if(id==-1){
-	  status=EXIT_FAILURE;
-	  SIXT_ERROR("Pixel ID not found.");
-	  CHECK_STATUS_BREAK(status);
-	}
-	CHECK_STATUS_BREAK(status);
-	fitsstream[ii]->pixID[pp]=id;
-
-	// adc_value array
-	for(tt=0; tt<stream->Ntime; tt++){
-	  fitsstream[ii]->adc_value[pp][tt]=stream->adc_value[tt][par.Nactive-restpix+pp];
-	}
-      }
-      CHECK_STATUS_BREAK(status);
-
-      double timeres=1./init->det->SampleFreq;
-      writeTESFitsStream(ofptr,
-			 fitsstream[ii],
-			 init->tstart,
-			 init->tstop,
-			 timeres,
-			 init->Nevts,
-			 ismonoc,
-			 monoen,
-			 &status);
-      CHECK_STATUS_BREAK(status);
-      restpix=restpix-TESFITSMAXPIX;
-    }
+    // Generate the data and write them to the output file chunk by
+    // chunk
+    streamTESDataStream(ofptr,
+			init->impfile,
+			init->profiles,
+			init->det,
+			init->tstart,
+			init->tstop,
+			init->det->npix,
+			par.Nactive,
+			init->activearray,
+			init->Nevts,
+			&ismonoc,
+			&monoen,
+			par.seed,
+			partmp.nthreads,
+			&status);
     CHECK_STATUS_BREAK(status);
 
     fits_close_file(ofptr, &status);
+    ofptr=NULL;
     CHECK_STATUS_BREAK(status);
 
   } while(0); // END of the error handling loop.
 
   freeTESInitStruct(&init,&status);
-  destroyTESDataStream(stream);
-  for(ii=0; ii<Nstreams; ii++){
-    destroyTESFitsStream(fitsstream[ii]);
+  if(ofptr!=NULL){
+    int fstatus=EXIT_SUCCESS;
+    fits_close_file(ofptr, &fstatus);
   }
-  free(fitsstream);
 
   if (EXIT_SUCCESS==status) {
     headas_chat(3, "finished successfully!\n\n");
@@ -272,6 +190,12 @@ int getpar(struct Parameters* const par)
     par->seed=(unsigned long int)seed;
   }
 
+  status=ape_trad_query_int("nthreads", &par->nthreads);
+  if (EXIT_SUCCESS!=status) {
+    SIXT_ERROR("failed reading the number of threads");
+    return(status);
+  }
+
   char *pix=NULL;
   status=ape_trad_query_string("pixels", &pix);
   if (EXIT_SUCCESS!=status) {
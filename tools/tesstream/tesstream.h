@@ -55,6 +55,8 @@ struct Parameters {
   char history;
 
   unsigned long int seed;
+
+  int nthreads;
 };
 
 int getpar(struct Parameters* const par);